@@ -1,12 +1,25 @@
+#include <algorithm>
 #include <cinttypes>
+#include <cstdarg>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <dlisio/dlisio.h>
+#include <dlisio/ext/eflr.hpp>
+#include <dlisio/ext/frame.hpp>
+#include <dlisio/ext/index.hpp>
+#include <dlisio/ext/io.hpp>
+#include <dlisio/ext/load.hpp>
+#include <dlisio/ext/pool.hpp>
+#include <dlisio/ext/stats.hpp>
 
 namespace {
 
@@ -15,8 +28,8 @@ struct fcloser {
 };
 
 void readf( std::vector< char >& buf, std::size_t nmemb, std::FILE* fp ) {
+    if( buf.size() < nmemb ) buf.resize( nmemb );
     auto readc = std::fread( buf.data(), 1, nmemb, fp );
-    buf.resize( nmemb );
     if( readc == nmemb ) return;
 
     if( std::feof( fp ) ) {
@@ -171,9 +184,350 @@ void describe( const char* fname ) {
     }
 }
 
+/*
+ * Read all of the file, like dlisio.load does: index it, parse the sets of
+ * every logical file and decode its frames, and count the work
+ */
+dl::counters work( dl::stream& fp ) {
+    char sul[ 80 ];
+    fp.read( sul, sizeof( sul ) );
+
+    const auto threads = int( std::thread::hardware_concurrency() );
+    const auto marks = dl::index( fp, threads );
+
+    for( const auto& range : dl::logical_files( marks ) ) {
+        std::vector< dl::bookmark > lf( marks.begin() + range.first,
+                                        marks.begin() + range.second );
+
+        std::vector< dl::bookmark > explicits;
+        for( const auto& mark : lf )
+            if( mark.isexplicit && !mark.isencrypted )
+                explicits.push_back( mark );
+
+        const auto recs = dl::catrecords( fp, explicits );
+        std::vector< dl::set > sets;
+        {
+            dl::timer t( fp.count.parse_ns );
+            for( const auto& rec : recs )
+                sets.push_back( dl::parse_set( rec ) );
+            fp.count.sets += recs.size();
+        }
+
+        /* one pass over the headers, then every frame reads its own */
+        const auto indices = dl::index_fdata( fp, lf );
+        for( auto& frame : dl::describe_frames( sets ) ) {
+            if( frame.error ) continue;
+
+            const auto index = std::find_if( indices.begin(), indices.end(),
+                [&frame]( const dl::fdata_index& x ) {
+                    return x.frame == frame.name;
+                }
+            );
+            if( index == indices.end() ) continue;
+
+            dl::decode_frame( fp, lf, *index, frame );
+        }
+    }
+
+    return dl::counted( fp );
+}
+
+void statistics( const char* fname ) {
+    dl::counters count;
+    try {
+        const auto fp = dl::open( fname );
+        count = work( *fp );
+    } catch( const std::exception& e ) {
+        std::fprintf( stderr, "%s: %s\n", fname, e.what() );
+        return;
+    }
+
+    if( !dl::stats::enabled() ) {
+        std::puts( "stats: disabled" );
+        return;
+    }
+
+    const auto seconds = []( std::uint64_t ns ) { return ns * 1e-9; };
+
+    std::printf( "bytes-read: %" PRIu64 "\n"
+                 "reads: %" PRIu64 "\n"
+                 "seeks: %" PRIu64 "\n"
+                 "segments: %" PRIu64 "\n"
+                 "records-indexed: %" PRIu64 "\n"
+                 "records-read: %" PRIu64 "\n"
+                 "records-concatenated: %" PRIu64 "\n"
+                 "sets-parsed: %" PRIu64 "\n"
+                 "frames-decoded: %" PRIu64 "\n"
+                 "index-time: %.6fs\n"
+                 "read-time: %.6fs\n"
+                 "parse-time: %.6fs\n"
+                 "decode-time: %.6fs\n",
+                 count.bytes,
+                 count.reads,
+                 count.seeks,
+                 count.segments,
+                 count.indexed,
+                 count.records,
+                 count.concatenated,
+                 count.sets,
+                 count.frames,
+                 seconds( count.index_ns ),
+                 seconds( count.read_ns ),
+                 seconds( count.parse_ns ),
+                 seconds( count.decode_ns ) );
+}
+
+/*
+ * The logical record segments of a file, added up
+ *
+ * split are the records with segments in more than one visible record, and
+ * segmented the records of more than one segment. records are counted by
+ * type, [1] for explicitly formatted and [0] for indirectly formatted. The
+ * segment lengths, without the header, are counted in buckets of powers of 2,
+ * where bucket k is the lengths in (2^(k-1), 2^k].
+ */
+struct summary {
+    long long size = 0;
+    std::uint64_t visible   = 0;
+    std::uint64_t segments  = 0;
+    std::uint64_t records   = 0;
+    std::uint64_t explicits = 0;
+    std::uint64_t encrypted = 0;
+    std::uint64_t split     = 0;
+    std::uint64_t segmented = 0;
+    std::uint64_t types[ 2 ][ 256 ] = {};
+    std::uint64_t lengths[ 32 ] = {};
+
+    dl::scanend end = dl::scanend::anomaly;
+    long long pos = 0;
+};
+
+int bucket( int length ) noexcept {
+    int k = 0;
+    while( k < 31 && (1LL << k) < length ) ++k;
+    return k;
+}
+
+/*
+ * Walk the segment headers of the memory-mapped file with the segment scanner,
+ * a window at a time, like index does, but only count what's there. A
+ * segment is the first in its visible record when its bookmark is at the
+ * visible record label, rather than at the segment itself.
+ *
+ * The scan stops at the first anomaly (anything mark would warn about), and
+ * the counts are of the file up to it.
+ */
+summary summarize( const char* base, long long size ) {
+    constexpr long long window = 1 << 24;
+
+    summary sum;
+    sum.size = size;
+
+    dl::skeleton segs;
+    segs.reserve( std::min( size, window ) / 256 );
+
+    long long pos = 80;
+    int remaining = 0;
+    bool boundary = true;
+
+    std::uint64_t nsegs = 0;
+    bool split = false;
+    int type = 0;
+
+    dl::scanstate state;
+    do {
+        segs.clear();
+        state = dl::scan( base, size, pos, remaining, boundary, segs,
+                          pos + window );
+
+        for( std::size_t i = 0; i < segs.size(); ++i ) {
+            const auto attrs = segs.attrs[ i ];
+            const bool firstinvrl = segs.tell[ i ] != segs.offset[ i ];
+            if( firstinvrl ) ++sum.visible;
+
+            if( boundary ) {
+                nsegs = 0;
+                split = false;
+                type = segs.type[ i ];
+                boundary = false;
+            } else if( firstinvrl ) {
+                split = true;
+            }
+
+            ++nsegs;
+            ++sum.lengths[ bucket( segs.length[ i ] ) ];
+
+            if( attrs & DLIS_SEGATTR_SUCCSEG ) continue;
+
+            const bool isexplicit = attrs & DLIS_SEGATTR_EXFMTLR;
+            ++sum.records;
+            ++sum.types[ isexplicit ][ type ];
+            if( isexplicit )                   ++sum.explicits;
+            if( attrs & DLIS_SEGATTR_ENCRYPT ) ++sum.encrypted;
+            if( split )                        ++sum.split;
+            if( nsegs > 1 )                    ++sum.segmented;
+            boundary = true;
+        }
+
+        sum.segments += segs.size();
+        pos = state.pos;
+        remaining = state.remaining;
+    } while( state.end == dl::scanend::stop );
+
+    sum.end = state.end;
+    sum.pos = state.pos;
+    return sum;
 }
 
+/*
+ * Print to the end of out, for lines that are short enough for the buffer
+ */
+void appendf( std::string& out, const char* fmt, ... ) {
+    char buffer[ 512 ];
+    std::va_list args;
+    va_start( args, fmt );
+    const auto n = std::vsnprintf( buffer, sizeof( buffer ), fmt, args );
+    va_end( args );
+
+    if( n <= 0 ) return;
+    out.append( buffer, std::min< std::size_t >( n, sizeof( buffer ) - 1 ) );
+}
+
+std::string format( const char* fname, const summary& sum ) {
+    std::string out = "file: " + std::string( fname ) + "\n";
+    appendf( out, "file-size: %lld\n"
+                  "visible-records: %" PRIu64 "\n"
+                  "segments: %" PRIu64 "\n"
+                  "logical-records: %" PRIu64 "\n"
+                  "explicit-records: %" PRIu64 "\n"
+                  "encrypted-records: %" PRIu64 "\n"
+                  "multi-segment-records: %" PRIu64 "\n"
+                  "split-records: %" PRIu64 "\n",
+                  sum.size,
+                  sum.visible,
+                  sum.segments,
+                  sum.records,
+                  sum.explicits,
+                  sum.encrypted,
+                  sum.segmented,
+                  sum.split );
+
+    for( int x = 1; x >= 0; --x ) {
+        for( int type = 0; type < 256; ++type ) {
+            const auto n = sum.types[ x ][ type ];
+            if( n == 0 ) continue;
+            appendf( out, "%s-type %d: %" PRIu64 "\n",
+                          x ? "eflr" : "iflr", type, n );
+        }
+    }
+
+    for( int k = 0; k < 32; ++k ) {
+        if( sum.lengths[ k ] == 0 ) continue;
+        appendf( out, "segment-len <= %lld: %" PRIu64 "\n",
+                      1LL << k, sum.lengths[ k ] );
+    }
+
+    /*
+     * The scanner leaves a last segment that runs past the end of the file to
+     * catrecord, which reports it, and stops short of a header that doesn't
+     * fit. Either way the file is cut, whether or not the scan got to the
+     * end of a logical record
+     */
+    if( sum.pos > sum.size || (sum.end != dl::scanend::eof
+                               && sum.size - sum.pos < 4) )
+        appendf( out, "scan: truncated at %lld\n", sum.size );
+    else if( sum.end == dl::scanend::eof )
+        appendf( out, "scan: complete\n" );
+    else
+        appendf( out, "scan: anomaly at %lld\n", sum.pos );
+
+    return out;
+}
+
+/*
+ * Summarize the files on a thread pool, each into a report of its own, and
+ * write the reports in order, once all are done. Returns false if any of the
+ * files couldn't be summarized
+ */
+bool summaries( const std::vector< const char* >& fnames ) {
+    std::vector< std::string > reports( fnames.size() );
+    std::vector< std::string > errors( fnames.size() );
+
+    {
+        dl::pool pool;
+        for( std::size_t i = 0; i < fnames.size(); ++i ) {
+            pool.submit( [&, i] {
+                const char* fname = fnames[ i ];
+                try {
+                    const auto fp = dl::open_mmap( fname );
+                    if( fp->size() < 80 )
+                        throw std::runtime_error( "too short for a SUL" );
+
+                    int seqnum, major, minor, layout;
+                    std::int64_t maxlen;
+                    char id[ 61 ] = {};
+                    if( dlis_sul( fp->data(), &seqnum, &major, &minor,
+                                  &layout, &maxlen, id ) )
+                        throw std::runtime_error( "unable to parse SUL" );
+
+                    reports[ i ] = format( fname, summarize( fp->data(),
+                                                             fp->size() ) );
+                } catch( const std::exception& e ) {
+                    errors[ i ] = std::string( fname ) + ": " + e.what()
+                                + "\n";
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    bool ok = true;
+    for( std::size_t i = 0; i < fnames.size(); ++i ) {
+        if( !errors[ i ].empty() ) ok = false;
+        std::fputs( errors[ i ].c_str(), stderr );
+        std::fwrite( reports[ i ].data(), 1, reports[ i ].size(), stdout );
+    }
+    return ok;
+}
+
+}
+
+/*
+ * dlis-describe [--stats] [--summary] FILE...
+ *
+ * With --stats, the files are also read like dlisio.load does, and the work
+ * done reading them, and the time spent in each phase, is printed
+ *
+ * With --summary, the files are memory-mapped and their segment headers
+ * scanned in memory, in parallel, and only the counts of records by type,
+ * the segment lengths, and the split and encrypted records are printed,
+ * instead of every label and header. The exit status is 1 if any file can't
+ * be summarized
+ */
 int main( int args, char** argv ) {
-    for( int i = 1; i < args; ++i )
-        describe( argv[ i ] );
+    bool stats = false;
+    bool summary = false;
+    std::vector< const char* > fnames;
+    for( int i = 1; i < args; ++i ) {
+        if( std::strcmp( argv[ i ], "--stats" ) == 0 )
+            stats = true;
+        else if( std::strcmp( argv[ i ], "--summary" ) == 0 )
+            summary = true;
+        else
+            fnames.push_back( argv[ i ] );
+    }
+
+    bool ok = true;
+    if( summary ) {
+        static char buffer[ 1 << 16 ];
+        std::setvbuf( stdout, buffer, _IOFBF, sizeof( buffer ) );
+        ok = summaries( fnames );
+    }
+
+    for( const auto* fname : fnames ) {
+        if( !summary ) describe( fname );
+        if( stats ) statistics( fname );
+    }
+
+    return ok ? 0 : 1;
 }
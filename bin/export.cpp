@@ -0,0 +1,565 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/api.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/properties.h>
+
+#include <dlisio/types.h>
+#include <dlisio/ext/eflr.hpp>
+#include <dlisio/ext/frame.hpp>
+#include <dlisio/ext/index.hpp>
+#include <dlisio/ext/io.hpp>
+#include <dlisio/ext/load.hpp>
+
+/*
+ * Export the curves and metadata of DLIS files to Parquet or Arrow IPC
+ * streams, batch by batch, without going through Python.
+ *
+ * Every frame of every logical file is written to a file of its own, with a
+ * column for the frame numbers and one for every channel, and all the
+ * attributes of all the objects of a file are written, flattened, to a
+ * metadata file. The frames are decoded in batches, which are handed to the
+ * writer without being copied, and the metadata is written in batches of
+ * the same number of rows, so the memory used is bounded by the batch size
+ * regardless of the size of the file.
+ */
+
+namespace {
+
+struct options {
+    std::string format = "parquet";
+    std::string outdir = ".";
+    std::size_t rows = 65536;
+    std::size_t depth = 0;
+    std::vector< std::string > paths;
+};
+
+void usage( const char* argv0 ) {
+    std::fprintf( stderr,
+        "usage: %s [-f parquet|arrow] [-n rows] [-r depth] [-o dir] file...\n"
+        "\n"
+        "  -f  output format, parquet (default) or arrow (IPC stream)\n"
+        "  -n  frames per batch (default 65536)\n"
+        "  -r  records to read ahead while decoding, for slow storage\n"
+        "      (default 0, no read-ahead)\n"
+        "  -o  output directory (default .)\n",
+        argv0 );
+}
+
+void check( const arrow::Status& status ) {
+    if( !status.ok() ) throw std::runtime_error( status.ToString() );
+}
+
+template< typename T >
+T unwrap( arrow::Result< T > result ) {
+    check( result.status() );
+    return std::move( result ).ValueOrDie();
+}
+
+/*
+ * A sink for record batches of one schema, either a Parquet file or an
+ * Arrow IPC stream
+ */
+class sink {
+public:
+    sink( const std::string& path,
+          const std::string& format,
+          const std::shared_ptr< arrow::Schema >& schema,
+          std::size_t rows ) {
+        this->out = unwrap( arrow::io::FileOutputStream::Open( path ) );
+
+        if( format == "arrow" ) {
+            this->ipc = unwrap(
+                arrow::ipc::MakeStreamWriter( this->out, schema )
+            );
+            return;
+        }
+
+        /* one row group per batch keeps the memory bounded */
+        auto props = parquet::WriterProperties::Builder()
+            .max_row_group_length( std::int64_t( rows ) )
+            ->build();
+
+        /*
+         * store the Arrow schema, or the fixed-size lists are read back as
+         * lists, and the channel metadata of the fields is lost
+         */
+        auto arrowprops = parquet::ArrowWriterProperties::Builder()
+            .store_schema()
+            ->build();
+
+        this->pq = unwrap( parquet::arrow::FileWriter::Open(
+            *schema,
+            arrow::default_memory_pool(),
+            this->out,
+            props,
+            arrowprops
+        ));
+    }
+
+    /*
+     * Every batch is written to Parquet as a table of its own, which makes
+     * a row group of it
+     */
+    void write( const std::shared_ptr< arrow::RecordBatch >& batch ) {
+        if( this->ipc ) {
+            check( this->ipc->WriteRecordBatch( *batch ) );
+            return;
+        }
+
+        const auto table = unwrap( arrow::Table::FromRecordBatches(
+            { batch }
+        ));
+        const auto rows = std::max< std::int64_t >( batch->num_rows(), 1 );
+        check( this->pq->WriteTable( *table, rows ) );
+    }
+
+    void close() {
+        if( this->ipc ) check( this->ipc->Close() );
+        else            check( this->pq->Close() );
+        check( this->out->Close() );
+    }
+
+private:
+    std::shared_ptr< arrow::io::FileOutputStream > out;
+    std::shared_ptr< arrow::ipc::RecordBatchWriter > ipc;
+    std::unique_ptr< parquet::arrow::FileWriter > pq;
+};
+
+std::shared_ptr< arrow::DataType > arrow_type( int reprc ) {
+    switch( reprc ) {
+        case DLIS_FSHORT:
+        case DLIS_FSINGL:
+        case DLIS_FSING1:
+        case DLIS_FSING2:
+        case DLIS_ISINGL:
+        case DLIS_VSINGL:
+        case DLIS_CSINGL: return arrow::float32();
+        case DLIS_FDOUBL:
+        case DLIS_FDOUB1:
+        case DLIS_FDOUB2:
+        case DLIS_CDOUBL: return arrow::float64();
+        case DLIS_SSHORT: return arrow::int8();
+        case DLIS_SNORM:  return arrow::int16();
+        case DLIS_SLONG:  return arrow::int32();
+        case DLIS_USHORT:
+        case DLIS_STATUS: return arrow::uint8();
+        case DLIS_UNORM:  return arrow::uint16();
+        case DLIS_ULONG:  return arrow::uint32();
+
+        default:
+            throw std::invalid_argument( "representation code "
+                                       + std::to_string( reprc )
+                                       + " can not be exported" );
+    }
+}
+
+/*
+ * The number of values per frame of a channel, i.e. its dimension times the
+ * components of its representation code (validated and complex values)
+ */
+std::int32_t width( int reprc, const std::vector< std::size_t >& dims ) {
+    std::size_t n = 1;
+    for( const auto dim : dims ) n *= dim;
+
+    switch( reprc ) {
+        case DLIS_FSING1:
+        case DLIS_FDOUB1:
+        case DLIS_CSINGL:
+        case DLIS_CDOUBL: n *= 2; break;
+        case DLIS_FSING2:
+        case DLIS_FDOUB2: n *= 3; break;
+        default: break;
+    }
+
+    return std::int32_t( n );
+}
+
+std::string dimstr( const std::vector< std::size_t >& dims ) {
+    std::string s;
+    for( const auto dim : dims ) {
+        if( !s.empty() ) s += ",";
+        s += std::to_string( dim );
+    }
+    return s;
+}
+
+/*
+ * The channels of the frame, as columns. Channels that are not scalar are
+ * fixed-size lists of their values, with the dimension in the field metadata
+ */
+std::shared_ptr< arrow::Schema > frame_schema( const dl::frame_columns& f ) {
+    std::vector< std::shared_ptr< arrow::Field > > fields = {
+        arrow::field( "FRAMENO", arrow::int32(), false ),
+    };
+
+    for( std::size_t i = 0; i < f.channels.size(); ++i ) {
+        auto type = arrow_type( f.reprc[ i ] );
+        const auto n = width( f.reprc[ i ], f.dims[ i ] );
+        if( n != 1 ) type = arrow::fixed_size_list( type, n );
+
+        const auto& name = f.channels[ i ];
+        auto meta = arrow::key_value_metadata(
+            { "origin", "copy", "reprc", "dimension" },
+            { std::to_string( name.origin ),
+              std::to_string( int( name.copy ) ),
+              std::to_string( f.reprc[ i ] ),
+              dimstr( f.dims[ i ] ) }
+        );
+
+        fields.push_back( arrow::field( name.id, type, false, meta ) );
+    }
+
+    return arrow::schema( fields );
+}
+
+/*
+ * A buffer that refers to, but doesn't own, the bytes of the batch, which
+ * outlive the record batch made from them
+ */
+std::shared_ptr< arrow::Buffer > view( const char* data, std::size_t size ) {
+    return std::make_shared< arrow::Buffer >(
+        reinterpret_cast< const std::uint8_t* >( data ),
+        std::int64_t( size )
+    );
+}
+
+std::shared_ptr< arrow::RecordBatch >
+frame_batch( const std::shared_ptr< arrow::Schema >& schema,
+             const dl::frame_columns& f,
+             const dl::frame_batch& batch ) {
+    const auto rows = std::int64_t( batch.size() );
+    std::vector< std::shared_ptr< arrow::Array > > columns;
+
+    const auto* numbers = reinterpret_cast< const char* >(
+        batch.numbers.data()
+    );
+    columns.push_back( arrow::MakeArray( arrow::ArrayData::Make(
+        arrow::int32(),
+        rows,
+        { nullptr, view( numbers, batch.size() * sizeof( std::int32_t ) ) },
+        0
+    )));
+
+    for( std::size_t i = 0; i < batch.columns.size(); ++i ) {
+        const auto& bytes = batch.columns[ i ];
+        const auto type = arrow_type( f.reprc[ i ] );
+        const auto n = width( f.reprc[ i ], f.dims[ i ] );
+        const auto buffer = view( bytes.data(), bytes.size() );
+
+        if( n == 1 ) {
+            columns.push_back( arrow::MakeArray( arrow::ArrayData::Make(
+                type, rows, { nullptr, buffer }, 0
+            )));
+            continue;
+        }
+
+        const auto values = arrow::ArrayData::Make(
+            type, rows * n, { nullptr, buffer }, 0
+        );
+        columns.push_back( arrow::MakeArray( arrow::ArrayData::Make(
+            arrow::fixed_size_list( type, n ),
+            rows,
+            { nullptr },
+            { values },
+            0
+        )));
+    }
+
+    return arrow::RecordBatch::Make( schema, rows, columns );
+}
+
+std::string stem( const std::string& path ) {
+    const auto slash = path.find_last_of( "/\\" );
+    auto name = slash == std::string::npos ? path : path.substr( slash + 1 );
+    const auto dot = name.find_last_of( '.' );
+    if( dot != std::string::npos && dot > 0 ) name.resize( dot );
+    return name;
+}
+
+/*
+ * The part of the output file name that identifies the frame: its origin,
+ * copy and identifier. The identifier is file content, so anything that
+ * isn't a letter, digit, '-' or '_' is replaced, which keeps names like
+ * "../x" or "a/b" from writing outside the output directory
+ */
+std::string framename( const dl::obname& name ) {
+    std::string id = name.id;
+    for( auto& c : id ) {
+        const auto u = static_cast< unsigned char >( c );
+        if( !std::isalnum( u ) && c != '-' && c != '_' ) c = '_';
+    }
+
+    return std::to_string( name.origin )
+         + "." + std::to_string( int( name.copy ) )
+         + "." + id;
+}
+
+std::string extension( const options& opts ) {
+    return opts.format == "arrow" ? ".arrows" : ".parquet";
+}
+
+/*
+ * The attributes of all objects, one row per attribute, with the values
+ * formatted as text. The rows are written to the sink whenever there are
+ * rows of them, and the rest by flush.
+ */
+class metadata {
+public:
+    metadata( sink& out, std::size_t rows ) :
+        out( out ),
+        rows( rows ),
+        values( std::make_shared< arrow::StringBuilder >() ),
+        value( arrow::default_memory_pool(), this->values )
+    {}
+
+    static std::shared_ptr< arrow::Schema > schema() {
+        return arrow::schema( {
+            arrow::field( "logical-file", arrow::int32(), false ),
+            arrow::field( "set-type",     arrow::utf8() ),
+            arrow::field( "set-name",     arrow::utf8() ),
+            arrow::field( "origin",       arrow::int32(), false ),
+            arrow::field( "copy",         arrow::uint8(), false ),
+            arrow::field( "object",       arrow::utf8(),  false ),
+            arrow::field( "label",        arrow::utf8(),  false ),
+            arrow::field( "units",        arrow::utf8() ),
+            arrow::field( "reprc",        arrow::uint8(), false ),
+            arrow::field( "value",        arrow::list( arrow::utf8() ) ),
+        });
+    }
+
+    /*
+     * The invariant attributes are shared by all objects, and are repeated
+     * for every object, after its own attributes
+     */
+    void append( int lf, const dl::set& set ) {
+        for( const auto& obj : set.objects ) {
+            for( std::size_t i = 0; i < set.tmpl.attributes.size(); ++i )
+                this->append( lf, set, obj, set.at( obj, i ) );
+
+            for( const auto& attr : set.tmpl.invariants )
+                this->append( lf, set, obj, attr );
+        }
+    }
+
+    void flush() {
+        if( this->lfs.length() == 0 ) return;
+
+        std::vector< std::shared_ptr< arrow::Array > > columns( 10 );
+        check( this->lfs.Finish(    &columns[ 0 ] ) );
+        check( this->type.Finish(   &columns[ 1 ] ) );
+        check( this->name.Finish(   &columns[ 2 ] ) );
+        check( this->origin.Finish( &columns[ 3 ] ) );
+        check( this->copy.Finish(   &columns[ 4 ] ) );
+        check( this->object.Finish( &columns[ 5 ] ) );
+        check( this->label.Finish(  &columns[ 6 ] ) );
+        check( this->units.Finish(  &columns[ 7 ] ) );
+        check( this->reprc.Finish(  &columns[ 8 ] ) );
+        check( this->value.Finish(  &columns[ 9 ] ) );
+
+        const auto rows = columns[ 0 ]->length();
+        this->out.write( arrow::RecordBatch::Make( schema(), rows, columns ) );
+    }
+
+private:
+    void append( int lf,
+                 const dl::set& set,
+                 const dl::object& obj,
+                 const dl::attribute& attr ) {
+        check( this->lfs.Append( lf ) );
+        if( set.hastype ) check( this->type.Append( set.type.str() ) );
+        else              check( this->type.AppendNull() );
+        if( set.hasname ) check( this->name.Append( set.name.str() ) );
+        else              check( this->name.AppendNull() );
+        check( this->origin.Append( obj.origin ) );
+        check( this->copy.Append( obj.copy ) );
+        check( this->object.Append( obj.id.str() ) );
+        check( this->label.Append( attr.label.str() ) );
+        if( attr.hasunits )
+            check( this->units.Append( attr.units.str() ) );
+        else
+            check( this->units.AppendNull() );
+        check( this->reprc.Append( std::uint8_t( attr.val.reprc ) ) );
+
+        if( attr.val.present ) {
+            check( this->value.Append() );
+            for( const auto& x : dl::value_strings( attr.val ) )
+                check( this->values->Append( x ) );
+        } else {
+            check( this->value.AppendNull() );
+        }
+
+        if( std::size_t( this->lfs.length() ) >= this->rows ) this->flush();
+    }
+
+    sink& out;
+    std::size_t rows;
+
+    arrow::Int32Builder lfs;
+    arrow::StringBuilder type;
+    arrow::StringBuilder name;
+    arrow::Int32Builder origin;
+    arrow::UInt8Builder copy;
+    arrow::StringBuilder object;
+    arrow::StringBuilder label;
+    arrow::StringBuilder units;
+    arrow::UInt8Builder reprc;
+    std::shared_ptr< arrow::StringBuilder > values;
+    arrow::ListBuilder value;
+};
+
+void warn( const std::string& msg ) {
+    std::fprintf( stderr, "warning: %s\n", msg.c_str() );
+}
+
+void export_frame( dl::stream& fp,
+                   const std::vector< dl::bookmark >& marks,
+                   const std::vector< dl::fdata_index >& indices,
+                   const dl::frame_columns& f,
+                   const std::string& path,
+                   const options& opts ) {
+    const auto itr = std::find_if( indices.begin(), indices.end(),
+        [&f]( const dl::fdata_index& x ) { return x.frame == f.name; }
+    );
+
+    std::vector< dl::channel_layout > layout;
+    std::vector< std::size_t > selection;
+    for( std::size_t i = 0; i < f.channels.size(); ++i ) {
+        std::size_t count = 1;
+        for( const auto dim : f.dims[ i ] ) count *= dim;
+        layout.push_back( { f.reprc[ i ], count } );
+        selection.push_back( i );
+    }
+
+    const auto schema = frame_schema( f );
+    sink out( path, opts.format, schema, opts.rows );
+
+    /* frames without records are exported as empty tables */
+    if( itr != indices.end() ) {
+        dl::decode_batches( fp, marks, *itr, 0, itr->entries.size(),
+                            layout, selection, opts.rows,
+            [&]( const dl::frame_batch& batch ) {
+                out.write( frame_batch( schema, f, batch ) );
+            },
+            warn,
+            opts.depth
+        );
+    }
+
+    out.close();
+}
+
+void export_file( const std::string& path, const options& opts ) {
+    auto fp = dl::open( path );
+
+    char sul[ 80 ];
+    fp->read( sul, sizeof( sul ) );
+    const int threads = int( std::thread::hardware_concurrency() );
+    const auto marks = dl::index( *fp, threads, warn );
+    const auto base = opts.outdir + "/" + stem( path );
+
+    sink meta( base + ".metadata" + extension( opts ),
+               opts.format,
+               metadata::schema(),
+               opts.rows );
+    metadata md( meta, opts.rows );
+
+    const auto files = dl::logical_files( marks );
+    for( std::size_t lf = 0; lf < files.size(); ++lf ) {
+        const std::vector< dl::bookmark > lfmarks(
+            marks.begin() + files[ lf ].first,
+            marks.begin() + files[ lf ].second
+        );
+
+        std::vector< dl::bookmark > explicits;
+        for( const auto& mark : lfmarks )
+            if( mark.isexplicit && !mark.isencrypted )
+                explicits.push_back( mark );
+
+        std::vector< dl::set > sets;
+        for( const auto& rec : dl::catrecords( *fp, explicits, warn ) ) {
+            sets.push_back( dl::parse_set( rec, warn ) );
+            md.append( int( lf ), sets.back() );
+        }
+
+        const auto indices = dl::index_fdata( *fp, lfmarks, warn );
+        for( const auto& f : dl::describe_frames( sets ) ) {
+            if( f.error ) {
+                try {
+                    std::rethrow_exception( f.error );
+                } catch( const std::exception& e ) {
+                    warn( "skipping frame " + f.name.id + ": " + e.what() );
+                }
+                continue;
+            }
+
+            const auto out = base + "." + std::to_string( lf )
+                           + "." + framename( f.name ) + extension( opts );
+            export_frame( *fp, lfmarks, indices, f, out, opts );
+        }
+    }
+
+    md.flush();
+    meta.close();
+}
+
+}
+
+int main( int args, char** argv ) {
+    options opts;
+    for( int i = 1; i < args; ++i ) {
+        const std::string arg = argv[ i ];
+        const bool hasvalue = i + 1 < args;
+
+        if( arg == "-h" || arg == "--help" ) {
+            usage( argv[ 0 ] );
+            return 0;
+        }
+
+        if( arg == "-f" && hasvalue ) opts.format = argv[ ++i ];
+        else if( arg == "-o" && hasvalue ) opts.outdir = argv[ ++i ];
+        else if( arg == "-n" && hasvalue ) {
+            opts.rows = std::strtoul( argv[ ++i ], nullptr, 10 );
+        }
+        else if( arg == "-r" && hasvalue ) {
+            opts.depth = std::strtoul( argv[ ++i ], nullptr, 10 );
+        }
+        else if( !arg.empty() && arg[ 0 ] == '-' ) {
+            usage( argv[ 0 ] );
+            return 2;
+        }
+        else opts.paths.push_back( arg );
+    }
+
+    if( opts.paths.empty() || opts.rows == 0
+        || (opts.format != "parquet" && opts.format != "arrow") ) {
+        usage( argv[ 0 ] );
+        return 2;
+    }
+
+    /* a broken file doesn't stop the export of the rest */
+    int status = 0;
+    for( const auto& path : opts.paths ) {
+        try {
+            export_file( path, opts );
+        } catch( const std::exception& e ) {
+            std::fprintf( stderr, "%s: %s\n", path.c_str(), e.what() );
+            status = 1;
+        }
+    }
+
+    return status;
+}
@@ -0,0 +1,660 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <dlisio/types.h>
+
+/*
+ * Generate synthetic, but valid, DLIS files of any size and shape, for
+ * benchmarks and scaling tests that need files like the ones in production
+ * without sharing them.
+ *
+ * Every logical file has a FILE-HEADER, an ORIGIN, a CHANNEL set with an
+ * index channel (DEPT, FDOUBL, increasing) and the data channels, a FRAME
+ * with all of them, optionally a PARAMETER set of many objects, and then one
+ * FDATA record per frame. The data channels cycle through the given
+ * representation codes, and their values are smooth curves, so that they
+ * make sense when plotted.
+ *
+ * Records are split into several segments at random, at the split ratio, and
+ * always where they don't fit in the visible record, so records span visible
+ * records. Segments get trailers (padding, checksum, trailing length) at the
+ * trailer ratio. The file is written as it's generated, so its size isn't
+ * bounded by memory.
+ */
+
+namespace {
+
+struct fcloser {
+    void operator()( std::FILE* fp ) { if( fp ) std::fclose( fp ); }
+};
+
+struct reprc_name {
+    const char* name;
+    int code;
+    std::size_t size;
+};
+
+const reprc_name reprcs[] = {
+    { "fshort", DLIS_FSHORT,  2 },
+    { "fsingl", DLIS_FSINGL,  4 },
+    { "fsing1", DLIS_FSING1,  8 },
+    { "fsing2", DLIS_FSING2, 12 },
+    { "isingl", DLIS_ISINGL,  4 },
+    { "vsingl", DLIS_VSINGL,  4 },
+    { "fdoubl", DLIS_FDOUBL,  8 },
+    { "fdoub1", DLIS_FDOUB1, 16 },
+    { "fdoub2", DLIS_FDOUB2, 24 },
+    { "csingl", DLIS_CSINGL,  8 },
+    { "cdoubl", DLIS_CDOUBL, 16 },
+    { "sshort", DLIS_SSHORT,  1 },
+    { "snorm",  DLIS_SNORM,   2 },
+    { "slong",  DLIS_SLONG,   4 },
+    { "ushort", DLIS_USHORT,  1 },
+    { "unorm",  DLIS_UNORM,   2 },
+    { "ulong",  DLIS_ULONG,   4 },
+    { "status", DLIS_STATUS,  1 },
+};
+
+const reprc_name* find_reprc( const std::string& name ) {
+    for( const auto& r : reprcs )
+        if( name == r.name ) return &r;
+    return nullptr;
+}
+
+struct options {
+    std::string path;
+    long long frames = 1000;
+    long long size = 0;
+    long long channels = 8;
+    long long dimension = 1;
+    long long objects = 0;
+    long long files = 1;
+    long long vrl = 8192;
+    double split = 0;
+    double trailers = 0;
+    unsigned long seed = 0;
+    std::vector< const reprc_name* > mix;
+};
+
+void usage( const char* argv0 ) {
+    std::fprintf( stderr,
+        "usage: %s [options] output\n"
+        "\n"
+        "  --frames N         frames per logical file (default 1000)\n"
+        "  --size BYTES       approximate file size, overrides --frames\n"
+        "  --channels N       data channels (default 8)\n"
+        "  --dimension N      values per channel per frame (default 1)\n"
+        "  --reprc LIST       comma-separated representation codes of the\n"
+        "                     data channels, cycled (default fsingl)\n"
+        "  --objects N        objects in the PARAMETER set (default 0)\n"
+        "  --logical-files N  logical files (default 1)\n"
+        "  --split RATIO      records split into segments (default 0)\n"
+        "  --trailers RATIO   segments with trailers (default 0)\n"
+        "  --vrl BYTES        visible record length, 32-16384 (default 8192)\n"
+        "  --seed N           random seed (default 0)\n",
+        argv0 );
+}
+
+/*
+ * Big-endian values, and the variable-length types of RP66
+ */
+void put8( std::string& out, std::uint8_t x ) {
+    out.push_back( char( x ) );
+}
+
+void put16( std::string& out, std::uint16_t x ) {
+    put8( out, std::uint8_t( x >> 8 ) );
+    put8( out, std::uint8_t( x ) );
+}
+
+void put32( std::string& out, std::uint32_t x ) {
+    put16( out, std::uint16_t( x >> 16 ) );
+    put16( out, std::uint16_t( x ) );
+}
+
+void put64( std::string& out, std::uint64_t x ) {
+    put32( out, std::uint32_t( x >> 32 ) );
+    put32( out, std::uint32_t( x ) );
+}
+
+void putf( std::string& out, double x ) {
+    const float f = float( x );
+    std::uint32_t u;
+    std::memcpy( &u, &f, sizeof( u ) );
+    put32( out, u );
+}
+
+void putd( std::string& out, double x ) {
+    std::uint64_t u;
+    std::memcpy( &u, &x, sizeof( u ) );
+    put64( out, u );
+}
+
+void uvari( std::string& out, std::uint32_t x ) {
+    if( x < 0x80 )        put8( out, std::uint8_t( x ) );
+    else if( x < 0x4000 ) put16( out, std::uint16_t( 0x8000 | x ) );
+    else                  put32( out, 0xC0000000 | x );
+}
+
+void ident( std::string& out, const std::string& s ) {
+    put8( out, std::uint8_t( s.size() ) );
+    out += s;
+}
+
+void ascii( std::string& out, const std::string& s ) {
+    uvari( out, std::uint32_t( s.size() ) );
+    out += s;
+}
+
+void obname( std::string& out, std::uint32_t origin, const std::string& id ) {
+    uvari( out, origin );
+    put8( out, 0 );
+    ident( out, id );
+}
+
+/*
+ * The 12-bit two's complement fraction, and the smallest exponent that fits
+ */
+std::uint16_t fshort( double x ) {
+    for( int exp = 0; exp < 16; ++exp ) {
+        const auto frac = std::lround( x / std::ldexp( 1.0, exp - 11 ) );
+        if( frac < -2048 || frac > 2047 ) continue;
+        return std::uint16_t( ((std::uint16_t( frac ) & 0xFFF) << 4) | exp );
+    }
+
+    return x < 0 ? 0x800F : 0x7FFF;
+}
+
+std::uint32_t isingl( double x ) {
+    if( x == 0 ) return 0;
+
+    const std::uint32_t sign = x < 0 ? 0x80000000 : 0;
+    double m = std::fabs( x );
+    int exp = 0;
+    while( m >= 1 )          { m /= 16; ++exp; }
+    while( m < 1.0 / 16.0 )  { m *= 16; --exp; }
+
+    const auto frac = std::uint32_t( m * 16777216.0 ) & 0x00FFFFFF;
+    return sign | std::uint32_t( exp + 64 ) << 24 | frac;
+}
+
+/*
+ * VAX F floats, as dlisio reads them, (0.5 + fraction) * 2^(exponent - 128),
+ * stored as two little-endian words, the high one first
+ */
+void vsingl( std::string& out, double x ) {
+    std::uint32_t u = 0;
+    if( x != 0 ) {
+        int exp;
+        const double m = std::frexp( std::fabs( x ), &exp );
+        const auto frac = std::uint32_t( std::lround( (m - 0.5) * 8388608.0 ) );
+        u = (x < 0 ? 0x80000000 : 0)
+          | std::uint32_t( exp + 128 ) << 23
+          | (frac & 0x007FFFFF);
+    }
+
+    put8( out, std::uint8_t( u >> 16 ) );
+    put8( out, std::uint8_t( u >> 24 ) );
+    put8( out, std::uint8_t( u ) );
+    put8( out, std::uint8_t( u >> 8 ) );
+}
+
+/*
+ * The value of channel ch in frame n, encoded for a representation code
+ */
+void value( std::string& out, int reprc, long long n, long long ch ) {
+    const double x = 100 * std::sin( 0.01 * double( n ) + double( ch ) );
+    const double y = 100 * std::cos( 0.01 * double( n ) + double( ch ) );
+    const auto i = std::uint64_t( n + ch );
+
+    switch( reprc ) {
+        case DLIS_FSHORT: put16( out, fshort( x ) ); break;
+        case DLIS_FSINGL: putf( out, x ); break;
+        case DLIS_FSING1: putf( out, x ); putf( out, 0.5 ); break;
+        case DLIS_FSING2: putf( out, x ); putf( out, 0.5 );
+                          putf( out, 0.25 ); break;
+        case DLIS_ISINGL: put32( out, isingl( x ) ); break;
+        case DLIS_VSINGL: vsingl( out, x ); break;
+        case DLIS_FDOUBL: putd( out, x ); break;
+        case DLIS_FDOUB1: putd( out, x ); putd( out, 0.5 ); break;
+        case DLIS_FDOUB2: putd( out, x ); putd( out, 0.5 );
+                          putd( out, 0.25 ); break;
+        case DLIS_CSINGL: putf( out, x ); putf( out, y ); break;
+        case DLIS_CDOUBL: putd( out, x ); putd( out, y ); break;
+        case DLIS_SSHORT:
+        case DLIS_USHORT: put8( out, std::uint8_t( i ) ); break;
+        case DLIS_SNORM:
+        case DLIS_UNORM:  put16( out, std::uint16_t( i ) ); break;
+        case DLIS_SLONG:
+        case DLIS_ULONG:  put32( out, std::uint32_t( i ) ); break;
+        case DLIS_STATUS: put8( out, std::uint8_t( i % 2 ) ); break;
+    }
+}
+
+/*
+ * A set, built component by component. The template has labels and
+ * representation codes, and every object sets all the attributes, with count
+ * and value
+ */
+class eflr {
+public:
+    explicit eflr( const std::string& type ) {
+        put8( this->body, 0xF0 );
+        ident( this->body, type );
+    }
+
+    void attribute( const std::string& label, int reprc ) {
+        put8( this->body, 0x34 );
+        ident( this->body, label );
+        put8( this->body, std::uint8_t( reprc ) );
+    }
+
+    void object( std::uint32_t origin, const std::string& id ) {
+        put8( this->body, 0x70 );
+        obname( this->body, origin, id );
+    }
+
+    /* the value is appended to the returned string */
+    std::string& value( std::uint32_t count ) {
+        put8( this->body, 0x29 );
+        uvari( this->body, count );
+        return this->body;
+    }
+
+    std::string body;
+};
+
+/*
+ * Writes records as segments in visible records, splitting and adding
+ * trailers as configured
+ */
+class writer {
+public:
+    writer( std::FILE* fp, const options& opts ) :
+        fp( fp ),
+        vrl( std::size_t( opts.vrl ) ),
+        split( opts.split ),
+        trailers( opts.trailers ),
+        rng( opts.seed )
+    {}
+
+    void sul() {
+        char label[ 81 ];
+        std::snprintf( label, sizeof( label ), "%4d%-5s%-6s%5d%-60s",
+                       1, "V1.00", "RECORD", int( this->vrl ),
+                       "dlisio-generate synthetic storage set" );
+        this->write( label, 80 );
+    }
+
+    void record( bool isexplicit, std::uint8_t type, const std::string& body ) {
+        /* the cut points of split records, in [1, size) */
+        std::vector< std::size_t > cuts;
+        if( body.size() > 1 && this->chance( this->split ) ) {
+            using dist = std::uniform_int_distribution< std::size_t >;
+            dist pos( 1, body.size() - 1 );
+            std::uniform_int_distribution< int > pieces( 1, 3 );
+            for( int i = pieces( this->rng ); i > 0; --i )
+                cuts.push_back( pos( this->rng ) );
+            std::sort( cuts.begin(), cuts.end() );
+        }
+        cuts.push_back( body.size() );
+
+        std::size_t first = 0;
+        for( const auto last : cuts ) {
+            if( last == first ) continue;
+            this->segments( isexplicit, type, body, first, last );
+            first = last;
+        }
+    }
+
+    void finish() {
+        this->flush();
+    }
+
+private:
+    bool chance( double p ) {
+        if( p <= 0 ) return false;
+        std::uniform_real_distribution< double > u( 0, 1 );
+        return u( this->rng ) < p;
+    }
+
+    void write( const void* src, std::size_t n ) {
+        if( std::fwrite( src, 1, n, this->fp ) != n ) {
+            std::perror( "unable to write" );
+            std::exit( 1 );
+        }
+    }
+
+    void flush() {
+        if( this->vr.empty() ) return;
+
+        std::string label;
+        put16( label, std::uint16_t( this->vr.size() + 4 ) );
+        put8( label, 0xFF );
+        put8( label, 0x01 );
+        this->write( label.data(), label.size() );
+        this->write( this->vr.data(), this->vr.size() );
+        this->vr.clear();
+    }
+
+    /*
+     * Write body[ first, last ) as one or more segments, cut where the
+     * visible record is full. Segments are at least 16 bytes and of even
+     * length, which may need padding
+     */
+    void segments( bool isexplicit,
+                   std::uint8_t type,
+                   const std::string& body,
+                   std::size_t first,
+                   std::size_t last ) {
+        while( first < last ) {
+            bool checksum = false;
+            bool trailing = false;
+            std::size_t pad = 0;
+            if( this->chance( this->trailers ) ) {
+                std::uniform_int_distribution< int > coin( 0, 1 );
+                std::uniform_int_distribution< std::size_t > padlen( 0, 8 );
+                checksum = coin( this->rng );
+                trailing = coin( this->rng );
+                pad = padlen( this->rng );
+            }
+
+            const std::size_t trailer = (checksum ? 2 : 0)
+                                      + (trailing ? 2 : 0);
+            const std::size_t room = this->vrl - 4 - this->vr.size();
+            if( room < 16 + trailer + 1 ) {
+                this->flush();
+                continue;
+            }
+
+            /* leave room for a byte of padding for the length to be even */
+            auto n = std::min( last - first, room - 4 - trailer - pad - 1 );
+            if( 4 + n + trailer + pad < 16 ) pad = 16 - 4 - n - trailer;
+            if( (4 + n + trailer + pad) % 2 ) pad += 1;
+
+            std::uint8_t attrs = 0;
+            if( isexplicit )                  attrs |= 0x80;
+            if( first != 0 )                  attrs |= 0x40;
+            if( first + n != body.size() )    attrs |= 0x20;
+            if( checksum )                    attrs |= 0x04;
+            if( trailing )                    attrs |= 0x02;
+            if( pad )                         attrs |= 0x01;
+
+            const auto len = std::uint16_t( 4 + n + trailer + pad );
+            put16( this->vr, len );
+            put8( this->vr, attrs );
+            put8( this->vr, type );
+            this->vr.append( body, first, n );
+
+            if( pad ) {
+                this->vr.append( pad - 1, '\0' );
+                put8( this->vr, std::uint8_t( pad ) );
+            }
+
+            /* a 16-bit sum of the body; dlisio doesn't verify checksums */
+            if( checksum ) {
+                std::uint16_t sum = 0;
+                for( std::size_t i = first; i < first + n; ++i )
+                    sum = std::uint16_t( sum + std::uint8_t( body[ i ] ) );
+                put16( this->vr, sum );
+            }
+
+            if( trailing ) put16( this->vr, len );
+            first += n;
+        }
+    }
+
+    std::FILE* fp;
+    std::size_t vrl;
+    double split;
+    double trailers;
+    std::mt19937 rng;
+    std::string vr;
+};
+
+struct channel {
+    std::string name;
+    const reprc_name* reprc;
+    long long count;
+};
+
+const std::uint32_t origin = 1;
+const std::string frame = "MAIN";
+
+std::vector< channel > make_channels( const options& opts ) {
+    std::vector< channel > channels = {
+        { "DEPT", find_reprc( "fdoubl" ), 1 },
+    };
+
+    for( long long i = 0; i < opts.channels; ++i ) {
+        char name[ 32 ];
+        std::snprintf( name, sizeof( name ), "CH%04lld", i + 1 );
+        const auto* reprc = opts.mix[ std::size_t( i ) % opts.mix.size() ];
+        channels.push_back( { name, reprc, opts.dimension } );
+    }
+
+    return channels;
+}
+
+std::size_t framesize( const std::vector< channel >& channels ) {
+    std::string header;
+    obname( header, origin, frame );
+    std::size_t size = header.size() + 4;
+    for( const auto& ch : channels )
+        size += ch.reprc->size * std::size_t( ch.count );
+    return size;
+}
+
+void logical_file( writer& out,
+                   const options& opts,
+                   const std::vector< channel >& channels,
+                   long long frames,
+                   long long lf ) {
+    {
+        eflr set( "FILE-HEADER" );
+        set.attribute( "SEQUENCE-NUMBER", DLIS_ASCII );
+        set.attribute( "ID", DLIS_ASCII );
+        set.object( origin, "0" );
+        ascii( set.value( 1 ), std::to_string( lf + 1 ) );
+        ascii( set.value( 1 ), "dlisio-generate" );
+        out.record( true, 0, set.body );
+    }
+
+    {
+        eflr set( "ORIGIN" );
+        set.attribute( "FILE-ID", DLIS_ASCII );
+        set.attribute( "FILE-SET-NAME", DLIS_IDENT );
+        set.attribute( "FILE-NUMBER", DLIS_ULONG );
+        set.attribute( "PRODUCER-NAME", DLIS_ASCII );
+        set.object( origin, "DLISIO-GENERATE" );
+        ascii( set.value( 1 ), "synthetic" );
+        ident( set.value( 1 ), "SYNTHETIC" );
+        put32( set.value( 1 ), std::uint32_t( lf + 1 ) );
+        ascii( set.value( 1 ), "dlisio" );
+        out.record( true, 1, set.body );
+    }
+
+    {
+        eflr set( "CHANNEL" );
+        set.attribute( "LONG-NAME", DLIS_ASCII );
+        set.attribute( "REPRESENTATION-CODE", DLIS_USHORT );
+        set.attribute( "UNITS", DLIS_IDENT );
+        set.attribute( "DIMENSION", DLIS_UVARI );
+        set.attribute( "ELEMENT-LIMIT", DLIS_UVARI );
+        for( const auto& ch : channels ) {
+            set.object( origin, ch.name );
+            ascii( set.value( 1 ), ch.name + " (" + ch.reprc->name + ")" );
+            put8( set.value( 1 ), std::uint8_t( ch.reprc->code ) );
+            ident( set.value( 1 ), ch.name == "DEPT" ? "m" : "" );
+            uvari( set.value( 1 ), std::uint32_t( ch.count ) );
+            uvari( set.value( 1 ), std::uint32_t( ch.count ) );
+        }
+        out.record( true, 3, set.body );
+    }
+
+    {
+        eflr set( "FRAME" );
+        set.attribute( "DESCRIPTION", DLIS_ASCII );
+        set.attribute( "CHANNELS", DLIS_OBNAME );
+        set.attribute( "INDEX-TYPE", DLIS_IDENT );
+        set.attribute( "SPACING", DLIS_FDOUBL );
+        set.object( origin, frame );
+        ascii( set.value( 1 ), "synthetic frame" );
+        auto& names = set.value( std::uint32_t( channels.size() ) );
+        for( const auto& ch : channels ) obname( names, origin, ch.name );
+        ident( set.value( 1 ), "BOREHOLE-DEPTH" );
+        putd( set.value( 1 ), 0.1524 );
+        out.record( true, 4, set.body );
+    }
+
+    if( opts.objects > 0 ) {
+        eflr set( "PARAMETER" );
+        set.attribute( "LONG-NAME", DLIS_ASCII );
+        set.attribute( "DIMENSION", DLIS_UVARI );
+        set.attribute( "VALUES", DLIS_FDOUBL );
+        for( long long i = 0; i < opts.objects; ++i ) {
+            char name[ 32 ];
+            std::snprintf( name, sizeof( name ), "PARAM%06lld", i + 1 );
+            set.object( origin, name );
+            ascii( set.value( 1 ), std::string( "parameter " ) + name );
+            uvari( set.value( 1 ), 1 );
+            putd( set.value( 1 ), double( i ) );
+        }
+        out.record( true, 5, set.body );
+    }
+
+    std::string fdata;
+    for( long long n = 0; n < frames; ++n ) {
+        fdata.clear();
+        obname( fdata, origin, frame );
+        uvari( fdata, std::uint32_t( n + 1 ) );
+        putd( fdata, 1000.0 + 0.1524 * double( n ) );
+
+        for( std::size_t ch = 1; ch < channels.size(); ++ch ) {
+            for( long long k = 0; k < channels[ ch ].count; ++k ) {
+                value( fdata, channels[ ch ].reprc->code,
+                       n, (long long)( ch ) + k );
+            }
+        }
+
+        out.record( false, 0, fdata );
+    }
+}
+
+bool number( const char* arg, long long& out, long long min ) {
+    char* end;
+    out = std::strtoll( arg, &end, 10 );
+    return *arg && !*end && out >= min;
+}
+
+bool ratio( const char* arg, double& out ) {
+    char* end;
+    out = std::strtod( arg, &end );
+    return *arg && !*end && out >= 0 && out <= 1;
+}
+
+bool mix( const std::string& arg, std::vector< const reprc_name* >& out ) {
+    out.clear();
+    std::size_t first = 0;
+    while( first <= arg.size() ) {
+        auto last = arg.find( ',', first );
+        if( last == std::string::npos ) last = arg.size();
+        const auto* r = find_reprc( arg.substr( first, last - first ) );
+        if( !r ) return false;
+        out.push_back( r );
+        first = last + 1;
+    }
+
+    return !out.empty();
+}
+
+}
+
+int main( int args, char** argv ) {
+    options opts;
+    opts.mix = { find_reprc( "fsingl" ) };
+
+    for( int i = 1; i < args; ++i ) {
+        const std::string arg = argv[ i ];
+        if( arg == "-h" || arg == "--help" ) {
+            usage( argv[ 0 ] );
+            return 0;
+        }
+
+        if( arg.compare( 0, 2, "--" ) != 0 ) {
+            opts.path = arg;
+            continue;
+        }
+
+        if( i + 1 == args ) {
+            usage( argv[ 0 ] );
+            return 2;
+        }
+
+        const char* val = argv[ ++i ];
+        long long seed = 0;
+        bool ok;
+        if( arg == "--frames" )        ok = number( val, opts.frames, 0 );
+        else if( arg == "--size" )     ok = number( val, opts.size, 1 );
+        else if( arg == "--channels" ) ok = number( val, opts.channels, 0 );
+        else if( arg == "--dimension" )
+            ok = number( val, opts.dimension, 1 );
+        else if( arg == "--objects" )  ok = number( val, opts.objects, 0 );
+        else if( arg == "--logical-files" )
+            ok = number( val, opts.files, 1 );
+        else if( arg == "--vrl" )
+            ok = number( val, opts.vrl, 32 ) && opts.vrl <= 16384;
+        else if( arg == "--split" )    ok = ratio( val, opts.split );
+        else if( arg == "--trailers" ) ok = ratio( val, opts.trailers );
+        else if( arg == "--reprc" )    ok = mix( val, opts.mix );
+        else if( arg == "--seed" ) {
+            ok = number( val, seed, 0 );
+            opts.seed = (unsigned long)( seed );
+        }
+        else ok = false;
+
+        if( !ok ) {
+            std::fprintf( stderr, "invalid option %s %s\n", arg.c_str(), val );
+            usage( argv[ 0 ] );
+            return 2;
+        }
+    }
+
+    if( opts.path.empty() ) {
+        usage( argv[ 0 ] );
+        return 2;
+    }
+
+    const auto channels = make_channels( opts );
+    if( opts.size > 0 ) {
+        /* FDATA dominates, with a few bytes of segment overhead per frame */
+        const auto perframe = (long long)( framesize( channels ) ) + 6;
+        opts.frames = std::max( 1LL, opts.size / opts.files / perframe );
+    }
+
+    std::unique_ptr< std::FILE, fcloser > fp( std::fopen( opts.path.c_str(),
+                                                          "wb" ) );
+    if( !fp ) {
+        std::perror( opts.path.c_str() );
+        return 1;
+    }
+
+    writer out( fp.get(), opts );
+    out.sul();
+    for( long long lf = 0; lf < opts.files; ++lf )
+        logical_file( out, opts, channels, opts.frames, lf );
+    out.finish();
+
+    if( std::fclose( fp.release() ) != 0 ) {
+        std::perror( opts.path.c_str() );
+        return 1;
+    }
+}
@@ -0,0 +1,205 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/api.h>
+#include <parquet/arrow/reader.h>
+
+#include <dlisio/ext/eflr.hpp>
+#include <dlisio/ext/load.hpp>
+
+namespace {
+
+const std::string stem = "206_05a-_3_DWL_DWL_WIRE_258276498";
+const std::string sample = DLISIO_TEST_DATA "/" + stem + ".DLIS";
+
+void check( const arrow::Status& status ) {
+    INFO( status.ToString() );
+    REQUIRE( status.ok() );
+}
+
+template< typename T >
+T unwrap( arrow::Result< T > result ) {
+    check( result.status() );
+    return std::move( result ).ValueOrDie();
+}
+
+/*
+ * Run dlis-export on the sample file, with small batches so that every output
+ * is written in several
+ */
+void run( const std::string& format, int rows ) {
+    const auto cmd = std::string( DLIS_EXPORT )
+                   + " -f " + format
+                   + " -n " + std::to_string( rows )
+                   + " " + sample;
+    REQUIRE( std::system( cmd.c_str() ) == 0 );
+}
+
+/*
+ * Read back the batches of an IPC stream, or the row groups of a Parquet file,
+ * as one table each
+ */
+std::vector< std::shared_ptr< arrow::Table > >
+batches( const std::string& path, const std::string& format ) {
+    const auto input = unwrap( arrow::io::ReadableFile::Open( path ) );
+    std::vector< std::shared_ptr< arrow::Table > > tables;
+
+    if( format == "arrow" ) {
+        const auto reader = unwrap(
+            arrow::ipc::RecordBatchStreamReader::Open( input )
+        );
+        while( true ) {
+            std::shared_ptr< arrow::RecordBatch > batch;
+            check( reader->ReadNext( &batch ) );
+            if( !batch ) break;
+            tables.push_back( unwrap( arrow::Table::FromRecordBatches(
+                { batch }
+            )));
+        }
+    } else {
+        parquet::arrow::FileReaderBuilder builder;
+        check( builder.Open( input ) );
+        std::unique_ptr< parquet::arrow::FileReader > reader;
+        check( builder.Build( &reader ) );
+        for( int i = 0; i < reader->num_row_groups(); ++i ) {
+            std::shared_ptr< arrow::Table > table;
+            check( reader->ReadRowGroup( i, &table ) );
+            tables.push_back( table );
+        }
+    }
+
+    check( input->Close() );
+    std::remove( path.c_str() );
+    return tables;
+}
+
+/*
+ * The bytes of a column of fixed-width values, or fixed-size lists of them
+ */
+void append_bytes( const arrow::Array& array, std::vector< char >& out ) {
+    if( array.type_id() == arrow::Type::FIXED_SIZE_LIST ) {
+        const auto& list = static_cast< const arrow::FixedSizeListArray& >(
+            array
+        );
+        const auto values = list.values()->Slice(
+            list.value_offset( 0 ),
+            list.length() * list.value_length()
+        );
+        append_bytes( *values, out );
+        return;
+    }
+
+    const auto& type = static_cast< const arrow::FixedWidthType& >(
+        *array.type()
+    );
+    const auto width = type.bit_width() / 8;
+    const auto* data = reinterpret_cast< const char* >(
+        array.data()->buffers[ 1 ]->data()
+    );
+    out.insert( out.end(), data + array.offset() * width,
+                           data + (array.offset() + array.length()) * width );
+}
+
+std::vector< char > column_bytes(
+        const std::vector< std::shared_ptr< arrow::Table > >& tables,
+        int column ) {
+    std::vector< char > out;
+    for( const auto& table : tables )
+        for( const auto& chunk : table->column( column )->chunks() )
+            append_bytes( *chunk, out );
+    return out;
+}
+
+std::vector< std::string > column_strings(
+        const std::vector< std::shared_ptr< arrow::Table > >& tables,
+        int column ) {
+    std::vector< std::string > out;
+    for( const auto& table : tables ) {
+        for( const auto& chunk : table->column( column )->chunks() ) {
+            const auto& strings = static_cast< const arrow::StringArray& >(
+                *chunk
+            );
+            for( std::int64_t i = 0; i < strings.length(); ++i )
+                out.push_back( strings.GetString( i ) );
+        }
+    }
+    return out;
+}
+
+}
+
+TEST_CASE("exported frames and metadata read back the same", "[export]") {
+    const auto lfs = dl::load( { sample } );
+    REQUIRE( lfs.size() == 1 );
+    const auto& lf = lfs.front();
+    REQUIRE( !lf.error );
+
+    std::vector< std::string > labels;
+    for( const auto& set : lf.sets ) {
+        for( const auto& obj : set.objects ) {
+            for( std::size_t i = 0; i < set.tmpl.attributes.size(); ++i )
+                labels.push_back( set.at( obj, i ).label.str() );
+            for( const auto& attr : set.tmpl.invariants )
+                labels.push_back( attr.label.str() );
+        }
+    }
+
+    const int rows = 100;
+    for( const std::string format : { "arrow", "parquet" } ) {
+        INFO( "format " << format );
+        const auto ext = format == "arrow" ? ".arrows" : ".parquet";
+        run( format, rows );
+
+        for( const auto& frame : lf.frames ) {
+            INFO( "frame " << frame.name.id );
+            REQUIRE( !frame.error );
+
+            const auto path = stem + ".0."
+                            + std::to_string( frame.name.origin ) + "."
+                            + std::to_string( int( frame.name.copy ) ) + "."
+                            + frame.name.id + ext;
+            const auto tables = batches( path, format );
+            REQUIRE( !tables.empty() );
+
+            CHECK( tables.size() == (frame.numbers.size() + rows - 1) / rows );
+            for( const auto& table : tables )
+                CHECK( table->num_rows() <= rows );
+
+            const auto numbers = column_bytes( tables, 0 );
+            const auto* expected = reinterpret_cast< const char* >(
+                frame.numbers.data()
+            );
+            CHECK( numbers == std::vector< char >(
+                expected,
+                expected + frame.numbers.size() * sizeof( std::int32_t )
+            ));
+
+            for( std::size_t i = 0; i < frame.columns.size(); ++i ) {
+                INFO( "channel " << frame.channels[ i ].id );
+                CHECK( column_bytes( tables, int( i ) + 1 )
+                    == frame.columns[ i ] );
+
+                const auto field = tables.front()->schema()->field( int( i ) + 1 );
+                CHECK( field->name() == frame.channels[ i ].id );
+                REQUIRE( field->metadata() );
+                CHECK( unwrap( field->metadata()->Get( "reprc" ) )
+                    == std::to_string( frame.reprc[ i ] ) );
+            }
+        }
+
+        const auto tables = batches( stem + ".metadata" + ext, format );
+        CHECK( tables.size() == (labels.size() + rows - 1) / rows );
+        for( const auto& table : tables )
+            CHECK( table->num_rows() <= rows );
+        CHECK( column_strings( tables, 6 ) == labels );
+    }
+}
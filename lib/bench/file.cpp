@@ -0,0 +1,283 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <dlisio/ext/arena.hpp>
+#include <dlisio/ext/eflr.hpp>
+#include <dlisio/ext/index.hpp>
+#include <dlisio/ext/io.hpp>
+
+/*
+ * Macro-benchmarks of indexing, reading records and parsing sets, on the
+ * sample files in python/data and on a synthetic file with the same records,
+ * split into many small segments.
+ */
+
+namespace {
+
+const std::string sample = DLISIO_BENCH_DATA
+                         "/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS";
+
+const std::string sample2 = DLISIO_BENCH_DATA
+                          "/206_05a-_3_DWL_DWL_WIRE_258276501.DLIS";
+
+using opener = std::unique_ptr< dl::stream >(*)( const std::string& );
+
+std::vector< dl::bookmark > marks( dl::stream& fp ) {
+    char sul[ 80 ];
+    fp.read( sul, sizeof( sul ) );
+    return dl::index( fp );
+}
+
+/*
+ * Write the records as visible records of at most 8192 bytes, with segment
+ * bodies of at most seglen bytes, padded to the minimum (and even) length
+ */
+std::string segmented( const std::string& sul,
+                       const std::vector< dl::bookmark >& bookmarks,
+                       const std::vector< dl::record >& records,
+                       std::size_t seglen ) {
+    std::string file = sul;
+    std::string visible;
+
+    const auto flush = [&]() {
+        if( visible.empty() ) return;
+        const auto len = visible.size() + 4;
+        file.push_back( char( len >> 8 ) );
+        file.push_back( char( len & 0xFF ) );
+        file.push_back( char( 0xFF ) );
+        file.push_back( char( 0x01 ) );
+        file += visible;
+        visible.clear();
+    };
+
+    for( std::size_t i = 0; i < records.size(); ++i ) {
+        const auto& rec = records[ i ];
+        const auto* cur = rec.begin();
+
+        do {
+            const auto left = std::size_t( rec.end() - cur );
+            const auto n = left < seglen ? left : seglen;
+
+            std::string body( cur, cur + n );
+            std::size_t pad = body.size() < 12 ? 12 - body.size() : 0;
+            if( (body.size() + pad) % 2 ) pad += 1;
+            if( pad ) {
+                body.append( pad - 1, '\0' );
+                body.push_back( char( pad ) );
+            }
+
+            std::uint8_t attrs = 0;
+            if( bookmarks[ i ].isexplicit ) attrs |= 0x80;
+            if( cur != rec.begin() )        attrs |= 0x40;
+            if( n < left )                  attrs |= 0x20;
+            if( pad )                       attrs |= 0x01;
+
+            const auto len = body.size() + 4;
+            if( visible.size() + len + 4 > 8192 ) flush();
+            visible.push_back( char( len >> 8 ) );
+            visible.push_back( char( len & 0xFF ) );
+            visible.push_back( char( attrs ) );
+            visible.push_back( char( bookmarks[ i ].type ) );
+            visible += body;
+
+            cur += n;
+        } while( cur != rec.end() );
+    }
+
+    flush();
+    return file;
+}
+
+/*
+ * The sample file, resegmented into segments of 32 bytes, which makes almost
+ * every record span several segments and visible records. It is written once,
+ * and removed on exit
+ */
+struct synthetic {
+    synthetic() {
+        auto fp = dl::open_mmap( sample );
+        char sul[ 80 ];
+        fp->read( sul, sizeof( sul ) );
+        auto bookmarks = dl::index( *fp );
+
+        std::vector< dl::bookmark > plain;
+        for( const auto& mark : bookmarks )
+            if( !mark.isencrypted ) plain.push_back( mark );
+
+        const auto records = dl::catrecords( *fp, plain );
+        const auto contents = segmented( std::string( sul, sizeof( sul ) ),
+                                         plain,
+                                         records,
+                                         32 );
+
+        std::unique_ptr< std::FILE, decltype( &std::fclose ) > out(
+            std::fopen( this->path.c_str(), "wb" ),
+            &std::fclose
+        );
+        if( !out ) throw std::runtime_error( "unable to write " + this->path );
+        std::fwrite( contents.data(), 1, contents.size(), out.get() );
+    }
+
+    ~synthetic() { std::remove( this->path.c_str() ); }
+
+    std::string path = "dlisio-bench-segmented.dlis";
+};
+
+const std::string& segmented_sample() {
+    static const synthetic file;
+    return file.path;
+}
+
+const std::string& first_sample()  { return sample; }
+const std::string& second_sample() { return sample2; }
+
+using source = const std::string& (*)();
+
+std::size_t filesize( const std::string& path ) {
+    auto fp = dl::open_mmap( path );
+    return std::size_t( fp->size() );
+}
+
+void counters( benchmark::State& state,
+               std::size_t records,
+               std::size_t bytes ) {
+    const auto iterations = std::int64_t( state.iterations() );
+    state.SetItemsProcessed( iterations * std::int64_t( records ) );
+    state.SetBytesProcessed( iterations * std::int64_t( bytes ) );
+}
+
+/*
+ * Index the file, with the stream opened by open and the number of threads
+ * in the argument
+ */
+void index( benchmark::State& state, source file, opener open ) {
+    const auto& path = file();
+    const auto threads = int( state.range( 0 ) );
+    std::size_t records = 0;
+
+    for( auto _ : state ) {
+        auto fp = open( path );
+        char sul[ 80 ];
+        fp->read( sul, sizeof( sul ) );
+        const auto bookmarks = dl::index( *fp, threads );
+        records = bookmarks.size();
+        benchmark::DoNotOptimize( bookmarks.data() );
+    }
+
+    counters( state, records, filesize( path ) );
+}
+
+void threads( benchmark::internal::Benchmark* b ) {
+    b->ArgName( "threads" )->Arg( 1 );
+    const auto cores = int( std::thread::hardware_concurrency() );
+    if( cores > 1 ) b->Arg( cores );
+}
+
+/* streams that aren't memory-backed are always indexed serially */
+void serial( benchmark::internal::Benchmark* b ) {
+    b->ArgName( "threads" )->Arg( 1 );
+}
+
+BENCHMARK_CAPTURE( index, sample/mmap,    first_sample,  dl::open_mmap  )
+    ->Apply( threads );
+BENCHMARK_CAPTURE( index, sample/pread,   first_sample,  dl::open_pread )
+    ->Apply( serial );
+BENCHMARK_CAPTURE( index, sample/stdio,   first_sample,  dl::open_stdio )
+    ->Apply( serial );
+BENCHMARK_CAPTURE( index, sample2/mmap,   second_sample, dl::open_mmap  )
+    ->Apply( threads );
+BENCHMARK_CAPTURE( index, segmented/mmap, segmented_sample, dl::open_mmap )
+    ->Apply( threads );
+BENCHMARK_CAPTURE( index, segmented/stdio, segmented_sample, dl::open_stdio )
+    ->Apply( serial );
+
+/*
+ * Read every record, one by one into a reused arena, or all at once with
+ * catrecords
+ */
+void catrecord( benchmark::State& state, source file, opener open ) {
+    const auto& path = file();
+    auto fp = open( path );
+    const auto bookmarks = marks( *fp );
+    dl::arena mem;
+
+    for( auto _ : state ) {
+        for( const auto& mark : bookmarks ) {
+            if( mark.isencrypted ) continue;
+            mem.reset();
+            fp->setpos( mark );
+            const auto rec = dl::catrecord( *fp, mark.residual, mem );
+            benchmark::DoNotOptimize( rec.data() );
+        }
+    }
+
+    counters( state, bookmarks.size(), filesize( path ) );
+}
+
+void catrecords( benchmark::State& state, source file, opener open ) {
+    const auto& path = file();
+    auto fp = open( path );
+    const auto bookmarks = marks( *fp );
+
+    std::vector< dl::bookmark > plain;
+    for( const auto& mark : bookmarks )
+        if( !mark.isencrypted ) plain.push_back( mark );
+
+    for( auto _ : state ) {
+        const auto records = dl::catrecords( *fp, plain );
+        benchmark::DoNotOptimize( records.data() );
+    }
+
+    counters( state, plain.size(), filesize( path ) );
+}
+
+BENCHMARK_CAPTURE( catrecord,  sample/mmap,      first_sample, dl::open_mmap );
+BENCHMARK_CAPTURE( catrecord,  sample/stdio,     first_sample, dl::open_stdio );
+BENCHMARK_CAPTURE( catrecord,  segmented/mmap,   segmented_sample,
+                                                 dl::open_mmap );
+BENCHMARK_CAPTURE( catrecords, sample/mmap,      first_sample, dl::open_mmap );
+BENCHMARK_CAPTURE( catrecords, sample/stdio,     first_sample, dl::open_stdio );
+BENCHMARK_CAPTURE( catrecords, segmented/stdio,  segmented_sample,
+                                                 dl::open_stdio );
+
+/*
+ * Parse all the explicitly formatted records of the file, which are read up
+ * front, into a reused arena
+ */
+void parse( benchmark::State& state, source file ) {
+    const auto& path = file();
+    auto fp = dl::open_mmap( path );
+
+    std::vector< dl::bookmark > explicits;
+    for( const auto& mark : marks( *fp ) )
+        if( mark.isexplicit && !mark.isencrypted ) explicits.push_back( mark );
+
+    const auto records = dl::catrecords( *fp, explicits );
+    std::size_t bytes = 0;
+    for( const auto& rec : records ) bytes += rec.size();
+
+    dl::arena mem;
+    for( auto _ : state ) {
+        for( const auto& rec : records ) {
+            mem.reset();
+            const auto set = dl::parse_set( rec, mem );
+            benchmark::DoNotOptimize( set.objects.size() );
+        }
+    }
+
+    counters( state, records.size(), bytes );
+}
+
+BENCHMARK_CAPTURE( parse, sample,    first_sample );
+BENCHMARK_CAPTURE( parse, sample2,   second_sample );
+BENCHMARK_CAPTURE( parse, segmented, segmented_sample );
+
+}
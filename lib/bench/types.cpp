@@ -0,0 +1,378 @@
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <dlisio/types.h>
+
+/*
+ * Micro-benchmarks of the representation code parsers, one value at a time
+ * for all of them, and in bulk for the fixed-size ones. dlis_attref and
+ * dlis_units are declared, but not implemented, and so not benchmarked.
+ *
+ * Every benchmark decodes a buffer of n values (the first argument), and
+ * reports values and bytes per second.
+ */
+
+namespace {
+
+std::vector< char > random_bytes( std::size_t n ) {
+    std::mt19937 rng( 2019 );
+    std::uniform_int_distribution< int > byte( 0, 255 );
+    std::vector< char > xs( n );
+    for( auto& x : xs ) x = char( byte( rng ) );
+    return xs;
+}
+
+void put_uvari( std::vector< char >& out, std::uint32_t x ) {
+    if( x < 0x80 ) {
+        out.push_back( char( x ) );
+    } else if( x < 0x4000 ) {
+        out.push_back( char( 0x80 | (x >> 8) ) );
+        out.push_back( char( x ) );
+    } else {
+        out.push_back( char( 0xC0 | (x >> 24) ) );
+        out.push_back( char( x >> 16 ) );
+        out.push_back( char( x >> 8 ) );
+        out.push_back( char( x ) );
+    }
+}
+
+void put_ident( std::vector< char >& out, std::mt19937& rng ) {
+    std::uniform_int_distribution< int > len( 1, 24 );
+    std::uniform_int_distribution< int > chr( 'A', 'Z' );
+    const auto n = len( rng );
+    out.push_back( char( n ) );
+    for( int i = 0; i < n; ++i ) out.push_back( char( chr( rng ) ) );
+}
+
+/*
+ * Variable-length values, with lengths and magnitudes spread like in real
+ * files: uvaris of all three widths, and short identifiers
+ */
+enum class kind { uvari, ident, ascii, obname, objref };
+
+std::vector< char > random_values( kind k, std::size_t n ) {
+    std::mt19937 rng( 2019 );
+    std::uniform_int_distribution< std::uint32_t > width( 0, 2 );
+    std::uniform_int_distribution< std::uint32_t > u1( 0, 0x7F );
+    std::uniform_int_distribution< std::uint32_t > u2( 0x80, 0x3FFF );
+    std::uniform_int_distribution< std::uint32_t > u4( 0x4000, 0x3FFFFFFF );
+    const auto uvari = [&]() {
+        switch( width( rng ) ) {
+            case 0:  return u1( rng );
+            case 1:  return u2( rng );
+            default: return u4( rng );
+        }
+    };
+
+    std::vector< char > out;
+    for( std::size_t i = 0; i < n; ++i ) {
+        switch( k ) {
+            case kind::uvari:
+                put_uvari( out, uvari() );
+                break;
+
+            case kind::ident:
+                put_ident( out, rng );
+                break;
+
+            case kind::ascii: {
+                std::vector< char > s;
+                put_ident( s, rng );
+                put_uvari( out, std::uint32_t( s.size() - 1 ) );
+                out.insert( out.end(), s.begin() + 1, s.end() );
+                break;
+            }
+
+            case kind::objref:
+                put_ident( out, rng );
+                /* fallthrough */
+            case kind::obname:
+                put_uvari( out, uvari() );
+                out.push_back( char( u1( rng ) ) );
+                put_ident( out, rng );
+                break;
+        }
+    }
+
+    return out;
+}
+
+void report( benchmark::State& state, std::size_t n, std::size_t bytes ) {
+    const auto iterations = std::int64_t( state.iterations() );
+    state.SetItemsProcessed( iterations * std::int64_t( n ) );
+    state.SetBytesProcessed( iterations * std::int64_t( bytes ) );
+}
+
+/*
+ * Fixed-size values, decoded one by one. Validated and complex values are
+ * decoded into width consecutive components, like the bulk functions do
+ */
+template< typename T >
+using single = const char* (*)( const char*, T* );
+
+const char* fsing1( const char* src, float* dst ) {
+    return dlis_fsing1( src, dst, dst + 1 );
+}
+
+const char* fsing2( const char* src, float* dst ) {
+    return dlis_fsing2( src, dst, dst + 1, dst + 2 );
+}
+
+const char* csingl( const char* src, float* dst ) {
+    return dlis_csingl( src, dst, dst + 1 );
+}
+
+const char* fdoub1( const char* src, double* dst ) {
+    return dlis_fdoub1( src, dst, dst + 1 );
+}
+
+const char* fdoub2( const char* src, double* dst ) {
+    return dlis_fdoub2( src, dst, dst + 1, dst + 2 );
+}
+
+const char* cdoubl( const char* src, double* dst ) {
+    return dlis_cdoubl( src, dst, dst + 1 );
+}
+
+template< typename T >
+void scalar( benchmark::State& state,
+             single< T > decode,
+             std::size_t size,
+             std::size_t width ) {
+    const auto n = std::size_t( state.range( 0 ) );
+    const auto src = random_bytes( n * size );
+    std::vector< T > dst( n * width );
+
+    for( auto _ : state ) {
+        const char* cur = src.data();
+        for( std::size_t i = 0; i < n; ++i )
+            cur = decode( cur, dst.data() + i * width );
+        benchmark::DoNotOptimize( cur );
+        benchmark::ClobberMemory();
+    }
+
+    report( state, n, src.size() );
+}
+
+#define SCALAR( name, T, decode, size, width ) \
+    BENCHMARK_CAPTURE( scalar, name, single< T >( decode ), size, width ) \
+        ->Arg( 4096 )
+
+SCALAR( sshort, std::int8_t,   dlis_sshort, 1, 1 );
+SCALAR( snorm,  std::int16_t,  dlis_snorm,  2, 1 );
+SCALAR( slong,  std::int32_t,  dlis_slong,  4, 1 );
+SCALAR( ushort, std::uint8_t,  dlis_ushort, 1, 1 );
+SCALAR( unorm,  std::uint16_t, dlis_unorm,  2, 1 );
+SCALAR( ulong,  std::uint32_t, dlis_ulong,  4, 1 );
+SCALAR( fshort, float,         dlis_fshort, 2, 1 );
+SCALAR( fsingl, float,         dlis_fsingl, 4, 1 );
+SCALAR( fdoubl, double,        dlis_fdoubl, 8, 1 );
+SCALAR( isingl, float,         dlis_isingl, 4, 1 );
+SCALAR( vsingl, float,         dlis_vsingl, 4, 1 );
+SCALAR( fsing1, float,         fsing1,      8, 2 );
+SCALAR( fsing2, float,         fsing2,     12, 3 );
+SCALAR( csingl, float,         csingl,      8, 2 );
+SCALAR( fdoub1, double,        fdoub1,     16, 2 );
+SCALAR( fdoub2, double,        fdoub2,     24, 3 );
+SCALAR( cdoubl, double,        cdoubl,     16, 2 );
+SCALAR( status, std::uint8_t,  dlis_status, 1, 1 );
+
+#undef SCALAR
+
+void dtime( benchmark::State& state ) {
+    const auto n = std::size_t( state.range( 0 ) );
+    const auto src = random_bytes( n * 8 );
+    int Y, TZ, M, D, H, MN, S, MS;
+
+    for( auto _ : state ) {
+        const char* cur = src.data();
+        for( std::size_t i = 0; i < n; ++i ) {
+            cur = dlis_dtime( cur, &Y, &TZ, &M, &D, &H, &MN, &S, &MS );
+            benchmark::DoNotOptimize( MS );
+        }
+        benchmark::DoNotOptimize( cur );
+    }
+
+    report( state, n, src.size() );
+}
+
+BENCHMARK( dtime )->Arg( 4096 );
+
+/*
+ * Variable-length values, which can only be decoded one by one
+ */
+template< typename F >
+void variable( benchmark::State& state, kind k, F decode ) {
+    const auto n = std::size_t( state.range( 0 ) );
+    const auto src = random_values( k, n );
+
+    for( auto _ : state ) {
+        const char* cur = src.data();
+        for( std::size_t i = 0; i < n; ++i ) cur = decode( cur );
+        benchmark::DoNotOptimize( cur );
+        benchmark::ClobberMemory();
+    }
+
+    report( state, n, src.size() );
+}
+
+const char* uvari( const char* src ) {
+    std::int32_t x;
+    src = dlis_uvari( src, &x );
+    benchmark::DoNotOptimize( x );
+    return src;
+}
+
+const char* origin( const char* src ) {
+    std::int32_t x;
+    src = dlis_origin( src, &x );
+    benchmark::DoNotOptimize( x );
+    return src;
+}
+
+const char* ident( const char* src ) {
+    std::int32_t len;
+    char out[ 256 ];
+    src = dlis_ident( src, &len, out );
+    benchmark::DoNotOptimize( out );
+    return src;
+}
+
+const char* ascii( const char* src ) {
+    std::int32_t len;
+    char out[ 256 ];
+    src = dlis_ascii( src, &len, out );
+    benchmark::DoNotOptimize( out );
+    return src;
+}
+
+const char* obname( const char* src ) {
+    std::int32_t origin, len;
+    std::uint8_t copy;
+    char id[ 256 ];
+    src = dlis_obname( src, &origin, &copy, &len, id );
+    benchmark::DoNotOptimize( id );
+    return src;
+}
+
+const char* objref( const char* src ) {
+    std::int32_t typelen, origin, len;
+    std::uint8_t copy;
+    char type[ 256 ];
+    char id[ 256 ];
+    src = dlis_objref( src, &typelen, type, &origin, &copy, &len, id );
+    benchmark::DoNotOptimize( type );
+    benchmark::DoNotOptimize( id );
+    return src;
+}
+
+/*
+ * The fused decoders, which return the identifiers as views, against the
+ * chain of uvari, ushort and ident above, which copies them out
+ */
+const char* obname_view( const char* src ) {
+    std::int32_t origin, len;
+    std::uint8_t copy;
+    const char* id;
+    src = dlis_obname_view( src, &origin, &copy, &len, &id );
+    benchmark::DoNotOptimize( id );
+    return src;
+}
+
+const char* objref_view( const char* src ) {
+    std::int32_t typelen, origin, len;
+    std::uint8_t copy;
+    const char* type;
+    const char* id;
+    src = dlis_objref_view( src, &typelen, &type, &origin, &copy, &len, &id );
+    benchmark::DoNotOptimize( type );
+    benchmark::DoNotOptimize( id );
+    return src;
+}
+
+BENCHMARK_CAPTURE( variable, uvari,  kind::uvari,  uvari  )->Arg( 4096 );
+BENCHMARK_CAPTURE( variable, origin, kind::uvari,  origin )->Arg( 4096 );
+BENCHMARK_CAPTURE( variable, ident,  kind::ident,  ident  )->Arg( 4096 );
+BENCHMARK_CAPTURE( variable, ascii,  kind::ascii,  ascii  )->Arg( 4096 );
+BENCHMARK_CAPTURE( variable, obname, kind::obname, obname )->Arg( 4096 );
+BENCHMARK_CAPTURE( variable, objref, kind::objref, objref )->Arg( 4096 );
+BENCHMARK_CAPTURE( variable, obname/view, kind::obname, obname_view )
+    ->Arg( 4096 );
+BENCHMARK_CAPTURE( variable, objref/view, kind::objref, objref_view )
+    ->Arg( 4096 );
+
+/*
+ * The bulk functions, for every instruction set the CPU supports. The
+ * arguments are the number of values, the instruction set (DLIS_SIMD_*), and
+ * the stride in values, where 1 is contiguous and anything else is a channel
+ * in a frame of stride such values
+ */
+template< typename T >
+using bulkfn = const char* (*)( const char*, std::size_t, std::size_t, T* );
+
+template< typename T >
+void bulk( benchmark::State& state,
+           bulkfn< T > decode,
+           std::size_t size,
+           std::size_t width ) {
+    const auto n = std::size_t( state.range( 0 ) );
+    const auto level = int( state.range( 1 ) );
+    const auto stride = std::size_t( state.range( 2 ) ) * size;
+    const auto src = random_bytes( n * stride );
+    std::vector< T > dst( n * width );
+
+    const auto previous = dlis_simd_level();
+    dlis_simd_set( level );
+
+    for( auto _ : state ) {
+        benchmark::DoNotOptimize( decode( src.data(), stride, n, dst.data() ) );
+        benchmark::ClobberMemory();
+    }
+
+    dlis_simd_set( previous );
+    report( state, n, n * size );
+}
+
+void levels( benchmark::internal::Benchmark* b ) {
+    b->ArgNames( { "n", "simd", "stride" } );
+
+    int best = DLIS_SIMD_SCALAR;
+    for( int level = DLIS_SIMD_SCALAR; level <= DLIS_SIMD_NEON; ++level ) {
+        if( !dlis_simd_supported( level ) ) continue;
+        b->Args( { 4096, level, 1 } );
+        best = level;
+    }
+
+    b->Args( { 4096, best, 4 } );
+}
+
+#define BULK( name, T, decode, size, width ) \
+    BENCHMARK_CAPTURE( bulk, name, bulkfn< T >( decode ), size, width ) \
+        ->Apply( levels )
+
+BULK( sshort, std::int8_t,   dlis_sshort_n, 1, 1 );
+BULK( snorm,  std::int16_t,  dlis_snorm_n,  2, 1 );
+BULK( slong,  std::int32_t,  dlis_slong_n,  4, 1 );
+BULK( ushort, std::uint8_t,  dlis_ushort_n, 1, 1 );
+BULK( unorm,  std::uint16_t, dlis_unorm_n,  2, 1 );
+BULK( ulong,  std::uint32_t, dlis_ulong_n,  4, 1 );
+BULK( fshort, float,         dlis_fshort_n, 2, 1 );
+BULK( fsingl, float,         dlis_fsingl_n, 4, 1 );
+BULK( fdoubl, double,        dlis_fdoubl_n, 8, 1 );
+BULK( isingl, float,         dlis_isingl_n, 4, 1 );
+BULK( vsingl, float,         dlis_vsingl_n, 4, 1 );
+BULK( fsing1, float,         dlis_fsing1_n, 8, 2 );
+BULK( fsing2, float,         dlis_fsing2_n, 12, 3 );
+BULK( csingl, float,         dlis_csingl_n, 8, 2 );
+BULK( fdoub1, double,        dlis_fdoub1_n, 16, 2 );
+BULK( fdoub2, double,        dlis_fdoub2_n, 24, 3 );
+BULK( cdoubl, double,        dlis_cdoubl_n, 16, 2 );
+BULK( status, std::uint8_t,  dlis_status_n, 1, 1 );
+
+#undef BULK
+
+}
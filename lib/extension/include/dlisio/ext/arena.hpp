@@ -0,0 +1,115 @@
+#ifndef DLISIO_EXT_ARENA_HPP
+#define DLISIO_EXT_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace dl {
+
+/*
+ * A monotonic buffer for short-lived parse state, e.g. the objects of a set
+ * and records that span segments. Allocating is bumping a pointer, and
+ * nothing is freed until reset(), which frees everything at once.
+ *
+ * The arena is meant to be reused, e.g. once per record when scanning a
+ * file. reset() keeps the memory, merging it into a single block if it had
+ * to grow, so that once it has seen the largest record it makes no more heap
+ * allocations.
+ *
+ * Arenas are not thread safe.
+ */
+class arena {
+public:
+    explicit arena( std::size_t blocksize = 64 * 1024 );
+
+    arena( const arena& ) = delete;
+    arena& operator=( const arena& ) = delete;
+
+    void* allocate( std::size_t size, std::size_t alignment );
+
+    /*
+     * Grow the allocation at p, in place if it is the most recent allocation
+     * and there's room, otherwise by copying it
+     */
+    void* reallocate( void* p,
+                      std::size_t size,
+                      std::size_t newsize,
+                      std::size_t alignment );
+
+    void reset() noexcept;
+
+    /*
+     * The number of blocks allocated from the heap, and their total size
+     */
+    std::size_t blocks() const noexcept;
+    std::size_t capacity() const noexcept;
+
+private:
+    struct block {
+        std::unique_ptr< char[] > mem;
+        std::size_t size;
+    };
+
+    std::vector< block > used;
+    std::size_t offset = 0;
+    std::size_t total = 0;
+    void* last = nullptr;
+
+    void grow( std::size_t size );
+};
+
+/*
+ * An allocator for standard containers, backed by an arena. Without an arena
+ * it falls back to the heap, so that containers can be used either way.
+ */
+template< typename T >
+class arena_allocator {
+public:
+    using value_type = T;
+
+    arena_allocator() noexcept = default;
+    arena_allocator( arena* mem ) noexcept : mem( mem ) {}
+
+    template< typename U >
+    arena_allocator( const arena_allocator< U >& o ) noexcept :
+        mem( o.resource() )
+    {}
+
+    T* allocate( std::size_t n ) {
+        if( !this->mem )
+            return static_cast< T* >( ::operator new( n * sizeof( T ) ) );
+
+        return static_cast< T* >(
+            this->mem->allocate( n * sizeof( T ), alignof( T ) )
+        );
+    }
+
+    void deallocate( T* p, std::size_t ) noexcept {
+        if( !this->mem ) ::operator delete( p );
+    }
+
+    arena* resource() const noexcept { return this->mem; }
+
+private:
+    arena* mem = nullptr;
+};
+
+template< typename T, typename U >
+bool operator==( const arena_allocator< T >& lhs,
+                 const arena_allocator< U >& rhs ) noexcept {
+    return lhs.resource() == rhs.resource();
+}
+
+template< typename T, typename U >
+bool operator!=( const arena_allocator< T >& lhs,
+                 const arena_allocator< U >& rhs ) noexcept {
+    return !(lhs == rhs);
+}
+
+template< typename T >
+using arena_vector = std::vector< T, arena_allocator< T > >;
+
+}
+
+#endif //DLISIO_EXT_ARENA_HPP
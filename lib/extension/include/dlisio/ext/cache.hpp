@@ -0,0 +1,80 @@
+#ifndef DLISIO_EXT_CACHE_HPP
+#define DLISIO_EXT_CACHE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <dlisio/ext/io.hpp>
+
+namespace dl {
+
+/*
+ * What identifies a version of a file, for the purpose of reusing its index:
+ * the size and modification time (in nanoseconds, but only as precise as the
+ * platform and file system), and a hash of the first few kilobytes
+ * (the storage unit label and the first records), which catches files that
+ * are replaced by other files of the same size within the timestamp
+ * resolution
+ */
+struct index_key {
+    long long size = 0;
+    long long mtime = 0;
+    std::uint64_t hash = 0;
+
+    bool operator==( const index_key& o ) const noexcept {
+        return this->size  == o.size
+            && this->mtime == o.mtime
+            && this->hash  == o.hash;
+    }
+
+    bool operator!=( const index_key& o ) const noexcept {
+        return !(*this == o);
+    }
+};
+
+/*
+ * Compute the key of the file at path. Throws io_error if the file can't be
+ * stat'd or read.
+ */
+index_key fingerprint( const std::string& path );
+
+/*
+ * A persisted index: the key of the file it was built from, the storage unit
+ * label, and the bookmarks
+ */
+struct sidecar {
+    index_key key;
+    std::string sul;
+    std::vector< bookmark > bookmarks;
+};
+
+/*
+ * A name for a temporary file next to path, to be renamed into place once
+ * it's written. The name is unique to the process and the call, so that
+ * writers of the same file, in this process or others, never write to the
+ * same temporary file.
+ */
+std::string tempname( const std::string& path );
+
+/*
+ * Write the sidecar index to path, as a compact little-endian binary file.
+ * The file is written next to path first, and renamed into place, so that
+ * readers never see a half-written index, and concurrent writers each
+ * write a whole index, one of which wins. Throws io_error on failure.
+ */
+void write_sidecar( const std::string& path, const sidecar& );
+
+/*
+ * Read the sidecar index at path into out. Returns false (and leaves out in an
+ * unspecified state) if it's missing, truncated, malformed, written by an
+ * incompatible version, or built from a different version of the file than
+ * key describes, in which case the index should be rebuilt.
+ */
+bool read_sidecar( const std::string& path,
+                   const index_key& key,
+                   sidecar& out );
+
+}
+
+#endif //DLISIO_EXT_CACHE_HPP
@@ -0,0 +1,186 @@
+#ifndef DLISIO_EXT_EFLR_HPP
+#define DLISIO_EXT_EFLR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <dlisio/types.h>
+#include <dlisio/ext/arena.hpp>
+#include <dlisio/ext/io.hpp>
+
+namespace dl {
+
+struct obname {
+    std::int32_t origin = 0;
+    std::uint8_t copy = 0;
+    std::string id;
+
+    bool operator==( const obname& o ) const noexcept {
+        return this->origin == o.origin
+            && this->copy   == o.copy
+            && this->id     == o.id;
+    }
+
+    bool operator!=( const obname& o ) const noexcept {
+        return !(*this == o);
+    }
+};
+
+/*
+ * A range of bytes in a record, e.g. the characters of an identifier
+ */
+struct span {
+    const char* first = nullptr;
+    const char* last  = nullptr;
+
+    std::size_t size() const noexcept { return this->last - this->first; }
+    bool empty() const noexcept { return this->first == this->last; }
+    std::string str() const { return std::string( this->first, this->last ); }
+};
+
+/*
+ * The value of an attribute, still encoded: count values of the
+ * representation code, in bytes. An attribute may have no value at all,
+ * which is different from having an empty value (count = 0).
+ *
+ * The count and representation code of the value are the ones it was read
+ * with, which may differ from the attribute's if an object overrides the
+ * count or representation code, but not the value.
+ */
+struct value {
+    bool present = false;
+    int count = 0;
+    int reprc = DLIS_IDENT;
+    span bytes;
+};
+
+/*
+ * An attribute, i.e. a cell in the table of objects of a set. Labels are only
+ * set in the template, and units only if explicitly given.
+ */
+struct attribute {
+    span label;
+    span units;
+    bool hasunits = false;
+
+    int count = 1;
+    int reprc = DLIS_IDENT;
+    value val;
+};
+
+/*
+ * The template is the header of the table of objects: the attributes, in
+ * order, and their defaults. Invariant attributes are shared by all objects,
+ * and can't be overridden.
+ */
+struct object_template {
+    object_template() = default;
+    explicit object_template( arena* mem ) :
+        attributes( mem ),
+        invariants( mem )
+    {}
+
+    arena_vector< attribute > attributes;
+    arena_vector< attribute > invariants;
+};
+
+/*
+ * An object is a row in the table. It only holds the attributes it sets
+ * itself, which are the first size attributes of the template, stored at
+ * set::cells[ first ... first + size ). The rest are the template defaults,
+ * and are not copied.
+ */
+struct object {
+    std::int32_t origin = 0;
+    std::uint8_t copy = 0;
+    span id;
+
+    std::size_t first = 0;
+    std::size_t size = 0;
+
+    obname name() const {
+        obname n;
+        n.origin = this->origin;
+        n.copy = this->copy;
+        n.id = this->id.str();
+        return n;
+    }
+};
+
+/*
+ * An explicitly formatted logical record, i.e. a set of objects of the same
+ * type. The type, name, labels, units and values all refer to the bytes of
+ * the record, which the set holds on to.
+ *
+ * A set parsed into an arena allocates its tables from it, and is only valid
+ * until the arena is reset.
+ */
+struct set {
+    set() = default;
+    explicit set( arena* mem ) : tmpl( mem ), objects( mem ), cells( mem ) {}
+
+    bool hastype = false;
+    bool hasname = false;
+    span type;
+    span name;
+
+    object_template tmpl;
+    arena_vector< object > objects;
+    arena_vector< attribute > cells;
+
+    record bytes;
+
+    /*
+     * The i-th (template) attribute of the object, which is the template
+     * default if the object doesn't set it
+     */
+    const attribute& at( const object& obj, std::size_t i ) const noexcept {
+        if( i < obj.size ) return this->cells[ obj.first + i ];
+        return this->tmpl.attributes[ i ];
+    }
+};
+
+/*
+ * Parse an explicitly formatted logical record, as returned by catrecord.
+ *
+ * Throws invalid_argument if the record is empty, malformed or truncated, or
+ * has values of unknown representation codes. Recoverable protocol
+ * violations, like missing labels, are reported to the warning handler.
+ */
+set parse_set( const record&, const warning_handler& = nullptr );
+set parse_set( const record&, arena&, const warning_handler& = nullptr );
+
+/*
+ * The values formatted as text, one string per value, for exports and
+ * listings where the receiving end has no notion of representation codes.
+ * Numbers are formatted so that they read back to the same value, tuples
+ * (validated and complex numbers, names and references) as (a, b, ...), and
+ * times as ISO 8601, without the time zone. The value must come from a
+ * parsed set.
+ */
+std::vector< std::string > value_strings( const value& );
+
+/*
+ * The OBNAME, or OBJREF, at cur, which must end before end, with the
+ * identifiers as views into the input. Names are decoded in one go with
+ * dlis_obname_view when there's room for it to read ahead, and piece by
+ * piece near the end. Throws invalid_argument if the name is truncated.
+ */
+const char* obname_view( const char* cur,
+                         const char* end,
+                         std::int32_t& origin,
+                         std::uint8_t& copy,
+                         span& id );
+
+const char* objref_view( const char* cur,
+                         const char* end,
+                         span& type,
+                         std::int32_t& origin,
+                         std::uint8_t& copy,
+                         span& id );
+
+}
+
+#endif //DLISIO_EXT_EFLR_HPP
@@ -0,0 +1,202 @@
+#ifndef DLISIO_EXT_FRAME_HPP
+#define DLISIO_EXT_FRAME_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dlisio/ext/eflr.hpp>
+#include <dlisio/ext/io.hpp>
+
+namespace dl {
+
+/*
+ * Parse the header of an indirectly formatted logical record, i.e. the name
+ * of the object it belongs to (the frame, for FDATA) and the frame number.
+ * Returns a pointer to the first byte after the header. Throws
+ * invalid_argument if the header doesn't fit in [begin, end).
+ */
+const char* iflr_header( const char* begin,
+                         const char* end,
+                         obname& name,
+                         std::int32_t& frameno );
+
+/*
+ * The size of one value of the representation code, in the file and once
+ * decoded. Both are 0 for representation codes that can't be decoded into
+ * fixed-size columns, e.g. strings and variable-length integers.
+ *
+ * Validated and complex values are decoded into consecutive components, e.g.
+ * FSING1 is decoded as two floats (V, A), and CSINGL as (real, imaginary).
+ */
+std::size_t sizeof_reprc( int reprc ) noexcept;
+std::size_t sizeof_native( int reprc ) noexcept;
+
+/*
+ * Decode n values of the representation code from src into dst, which must
+ * have room for n * sizeof_native( reprc ) bytes. Returns a pointer to the
+ * first byte after the values. Throws invalid_argument if the representation
+ * code isn't fixed-size.
+ */
+const char* decode( const char* src, int reprc, std::size_t n, char* dst );
+
+/*
+ * A channel in a frame: its representation code, and the number of values
+ * per frame (the product of its dimension)
+ */
+struct channel_layout {
+    int reprc;
+    std::size_t count;
+};
+
+/*
+ * Collect the FDATA records of the frame, in index order. Encrypted records,
+ * and records of other frames, are skipped.
+ */
+std::vector< record > fdata( stream&,
+                             const std::vector< bookmark >&,
+                             const obname& frame,
+                             const warning_handler& = nullptr );
+
+/*
+ * The FDATA records of a frame, by frame number: the frame number of every
+ * record, and its position in the bookmarks it was made from, in file order.
+ *
+ * Frame numbers are supposed to increase through the file, and if they do,
+ * ranges of frame numbers are found by binary search. Otherwise, frame
+ * numbers are found by scanning the entries, which is still done without
+ * reading the records, and there are no ranges.
+ */
+struct fdata_entry {
+    std::int32_t frameno;
+    std::size_t mark;
+};
+
+struct fdata_index {
+    obname frame;
+    std::vector< fdata_entry > entries;
+    bool ascending = true;
+};
+
+/*
+ * Index the FDATA records of all frames, in one pass over the records. Only
+ * the IFLR header of every record is read, and the frame data is skipped.
+ * The frames are in order of their first record.
+ */
+std::vector< fdata_index > index_fdata( stream&,
+                                        const std::vector< bookmark >&,
+                                        const warning_handler& = nullptr );
+
+/*
+ * The range [begin, end) of entries with frame numbers in [first, last].
+ * Throws invalid_argument if the frame numbers are out of order, as the
+ * matching entries aren't a range then.
+ */
+std::pair< std::size_t, std::size_t >
+frame_range( const fdata_index&, std::int32_t first, std::int32_t last );
+
+/*
+ * The position of the entry of the frame number, or entries.size() if there
+ * is none. If frame numbers are repeated, the first is found.
+ */
+std::size_t find_frame( const fdata_index&, std::int32_t frameno );
+
+/*
+ * The range [begin, end) of entries where the index channel, which is the
+ * first channel of the frame, is in [lo, hi]. The index is assumed monotonic,
+ * either increasing or decreasing, as the standard requires, and the range is
+ * found by binary search, reading only the records it probes.
+ *
+ * Throws invalid_argument if the index channel can't be read as a number.
+ */
+std::pair< std::size_t, std::size_t >
+index_range( stream&,
+             const std::vector< bookmark >&,
+             const fdata_index&,
+             int reprc,
+             double lo,
+             double hi,
+             const warning_handler& = nullptr );
+
+/*
+ * Collect the FDATA records of the entries [begin, end) of the index, in
+ * index order. Records outside the range are not read.
+ */
+std::vector< record > fdata( stream&,
+                             const std::vector< bookmark >&,
+                             const fdata_index&,
+                             std::size_t begin,
+                             std::size_t end,
+                             const warning_handler& = nullptr );
+
+/*
+ * Decode the frames (one per FDATA record) into columns, structure-of-arrays
+ * style. numbers must have room for fdata.size() frame numbers, and
+ * columns[ i ] for fdata.size() * channels[ i ].count values of channel i.
+ *
+ * Throws invalid_argument if the channels are not fixed-size, or a record is
+ * too short for the frame.
+ */
+void decode_frames( const std::vector< record >& fdata,
+                    const std::vector< channel_layout >& channels,
+                    std::int32_t* numbers,
+                    char* const* columns );
+
+/*
+ * decode_frames, but only for the selected channels, which are positions in
+ * channels. columns[ i ] gets the values of channel selection[ i ], and the
+ * other channels are skipped without being decoded, by their offset in the
+ * frame. Records must still hold the whole frame.
+ */
+void decode_frames( const std::vector< record >& fdata,
+                    const std::vector< channel_layout >& channels,
+                    const std::vector< std::size_t >& selection,
+                    std::int32_t* numbers,
+                    char* const* columns );
+
+/*
+ * A batch of decoded frames: the frame numbers, and one column per selected
+ * channel, laid out like decode_frames does. first is the position of the
+ * first frame in the index.
+ */
+struct frame_batch {
+    std::size_t first = 0;
+    std::vector< std::int32_t > numbers;
+    std::vector< std::vector< char > > columns;
+
+    std::size_t size() const noexcept { return this->numbers.size(); }
+};
+
+using batch_handler = std::function< void( const frame_batch& ) >;
+
+/*
+ * Decode the frames of the entries [begin, end) of the index in batches of
+ * at most rows frames, and pass every batch to the handler, in order. Only
+ * one batch of records and columns is in memory at a time, so the memory
+ * used is bounded by the batch size and not the size of the frame.
+ *
+ * The batch is reused, and is only valid until the handler returns. Throws
+ * like fdata and decode_frames, and passes on what the handler throws.
+ *
+ * With a depth > 0, the records of the upcoming batches are read ahead, at
+ * most depth records at a time, while the current batch is decoded and
+ * handled, see readahead.
+ */
+void decode_batches( stream&,
+                     const std::vector< bookmark >&,
+                     const fdata_index&,
+                     std::size_t begin,
+                     std::size_t end,
+                     const std::vector< channel_layout >& channels,
+                     const std::vector< std::size_t >& selection,
+                     std::size_t rows,
+                     const batch_handler&,
+                     const warning_handler& = nullptr,
+                     std::size_t depth = 0 );
+
+}
+
+#endif //DLISIO_EXT_FRAME_HPP
@@ -0,0 +1,135 @@
+#ifndef DLISIO_EXT_FRAMECACHE_HPP
+#define DLISIO_EXT_FRAMECACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dlisio/ext/frame.hpp>
+#include <dlisio/ext/io.hpp>
+
+namespace dl {
+
+/*
+ * Write the decoded frames of the entries [begin, end) of the index to a
+ * frame cache at path: a chunked, compressed, columnar copy of the curves,
+ * for reading them again without going back to the DLIS file.
+ *
+ * The frames are decoded with decode_batches, rows frames at a time, and
+ * every batch is a chunk. The frame numbers and every channel of a chunk are
+ * filtered and compressed on their own, and a table of the chunks, with the
+ * range of frame numbers and index values (the first value of the first
+ * channel) of every chunk, is written at the end. dims are the dimensions of
+ * the channels, and if empty, every channel is one-dimensional (of its
+ * count).
+ *
+ * The cache is written next to path first, and renamed into place, like the
+ * sidecar index. Throws io_error if it can't be written, and like
+ * decode_batches.
+ */
+void write_framecache( const std::string& path,
+                       stream&,
+                       const std::vector< bookmark >&,
+                       const fdata_index&,
+                       std::size_t begin,
+                       std::size_t end,
+                       const std::vector< channel_layout >& channels,
+                       const std::vector< std::vector< std::size_t > >& dims,
+                       std::size_t rows = 8192,
+                       const warning_handler& = nullptr );
+
+/*
+ * A frame cache, opened for reading. Only the chunk table is read up front,
+ * and reads decompress only the chunks, and the channels, they need. Ranges
+ * of frame numbers and index values are found from the chunk table, and by
+ * decompressing the frame numbers or index channel of at most two chunks.
+ *
+ * Values are stored in the byte order of the machine that wrote them, and
+ * caches from machines of the other byte order are rejected.
+ *
+ * Like a stream, a frame cache is only used by one thread at a time.
+ */
+class framecache {
+public:
+    /*
+     * Throws io_error if the file can't be opened, and invalid_argument if
+     * it's not a frame cache, truncated, or malformed
+     */
+    explicit framecache( const std::string& path );
+
+    std::size_t size() const noexcept;
+    std::size_t chunks() const noexcept;
+    const std::vector< channel_layout >& channels() const noexcept;
+    const std::vector< std::vector< std::size_t > >& dims() const noexcept;
+
+    /*
+     * Like frame_range and index_range of fdata_index, the range [begin,
+     * end) of frames with frame numbers in [first, last], or index values in
+     * [lo, hi]. frame_range throws invalid_argument if the frame numbers
+     * are out of order. index_range assumes the index is monotonic, and
+     * throws invalid_argument if the first channel can't be read as a
+     * number.
+     */
+    std::pair< std::size_t, std::size_t >
+    frame_range( std::int32_t first, std::int32_t last );
+
+    std::pair< std::size_t, std::size_t >
+    index_range( double lo, double hi );
+
+    /*
+     * Decompress the frames [begin, end) of the selected channels, laid out
+     * like decode_frames does. numbers may be nullptr, to skip the frame
+     * numbers. Throws invalid_argument if the range or selection is out of
+     * bounds, or a chunk is corrupt.
+     */
+    void read( std::size_t begin,
+               std::size_t end,
+               const std::vector< std::size_t >& selection,
+               std::int32_t* numbers,
+               char* const* columns );
+
+    /*
+     * The stream the cache is read through, which counts the work done
+     */
+    const stream& file() const noexcept;
+
+private:
+    struct column {
+        long long offset = 0;
+        std::size_t stored = 0;
+        std::uint32_t codec = 0;
+    };
+
+    /*
+     * A chunk holds the frames [first, first + rows). columns[ 0 ] are the
+     * frame numbers, and columns[ i + 1 ] channel i
+     */
+    struct chunk {
+        std::size_t first = 0;
+        std::size_t rows = 0;
+        std::int32_t firstno = 0;
+        std::int32_t lastno = 0;
+        double lo = 0;
+        double hi = 0;
+        std::vector< column > columns;
+    };
+
+    std::unique_ptr< stream > fp;
+    std::vector< channel_layout > layout;
+    std::vector< std::vector< std::size_t > > shape;
+    std::vector< chunk > table;
+    std::size_t frames = 0;
+    bool ascending = true;
+    bool indexed = false;
+
+    void unpack( const chunk&, std::size_t column, std::vector< char >& );
+    std::size_t partition( bool frameno, bool (*pred)( double, double ),
+                           double x );
+};
+
+}
+
+#endif //DLISIO_EXT_FRAMECACHE_HPP
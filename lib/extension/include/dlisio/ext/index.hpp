@@ -0,0 +1,94 @@
+#ifndef DLISIO_EXT_INDEX_HPP
+#define DLISIO_EXT_INDEX_HPP
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <dlisio/ext/io.hpp>
+
+namespace dl {
+
+/*
+ * The skeleton of (a part of) a memory-backed file: its logical record
+ * segments, as found by walking the visible record labels and segment
+ * headers in memory, as a structure of arrays. The has-successor bit in attrs
+ * groups the segments into logical records, which only touches the
+ * attributes.
+ *
+ * offset is the position of the segment header, and length the length of the
+ * segment body, without the header. tell and residual are the bookmark a
+ * record starting with the segment would get, which is at the visible record
+ * label if the segment is the first in its visible record.
+ */
+struct skeleton {
+    std::vector< long long > tell;
+    std::vector< int > residual;
+    std::vector< long long > offset;
+    std::vector< int > length;
+    std::vector< std::uint8_t > attrs;
+    std::vector< std::uint8_t > type;
+
+    std::size_t size() const noexcept { return this->attrs.size(); }
+    void clear() noexcept;
+    void reserve( std::size_t );
+};
+
+enum class scanend { stop, records, eof, anomaly };
+
+struct scanstate {
+    long long pos = 0;
+    int remaining = 0;
+    scanend end = scanend::anomaly;
+};
+
+/*
+ * Scan the memory-backed file [base, base + size) from pos in one pass, and
+ * append its segments to the skeleton. remaining is the number of bytes left
+ * in the current visible record, like for mark, and boundary is true if pos
+ * is at the start of a logical record. The scan ends
+ *
+ *  - stop, when it's about to read a visible record label at or after stop
+ *  - records, after maxrecords complete logical records
+ *  - eof, at the end of the file, after a complete logical record
+ *  - anomaly, right at anything mark would warn about or fail on, or doesn't
+ *    handle gracefully. That is left to mark and catrecord, which report it
+ *
+ * The headers ahead of the scan are prefetched, as they are far enough apart
+ * that the hardware doesn't always see them coming.
+ */
+scanstate scan( const char* base,
+                long long size,
+                long long pos,
+                int remaining,
+                bool boundary,
+                skeleton&,
+                long long stop = LLONG_MAX,
+                std::size_t maxrecords = SIZE_MAX );
+
+/*
+ * Index all logical records from the current position of the stream (past
+ * the storage unit label) to the end, i.e.
+ *
+ *  while( !fp.eof() ) bookmarks.push_back( mark( fp, remaining ) );
+ *
+ * If the stream is memory-backed, it's scanned in memory, with scan, rather
+ * than record by record with mark. The file is split into chunks of at least
+ * chunksize bytes, which are indexed by up to threads threads. Chunks start
+ * at the first plausible visible record label after the split point, and
+ * results are stitched together and verified on the calling thread, which
+ * also re-indexes serially from the last verified record if it runs into
+ * anything out of the ordinary. The bookmarks, and the warnings and
+ * exceptions, are the same as the serial loop's.
+ *
+ * warn is only ever invoked from the calling thread.
+ */
+std::vector< bookmark > index( stream& fp,
+                               int threads = 1,
+                               const warning_handler& warn = nullptr,
+                               long long chunksize = 1 << 24 );
+
+}
+
+#endif //DLISIO_EXT_INDEX_HPP
@@ -0,0 +1,62 @@
+#ifndef DLISIO_EXT_INTERN_HPP
+#define DLISIO_EXT_INTERN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dl {
+
+/*
+ * An interning table for identifiers and object names. The same labels,
+ * units and names repeat across thousands of objects in a file, and interning
+ * maps each distinct one to a small integer handle, so that it only has to be
+ * stored (and converted to e.g. a Python str) once.
+ *
+ * Handles are dense, starting at zero, and are never invalidated, so they can
+ * index side tables of converted values. Strings and names have separate
+ * handle spaces.
+ *
+ * Looking up an identifier that is already interned doesn't allocate.
+ *
+ * The table is not thread safe.
+ */
+class symbols {
+public:
+    using handle = std::uint32_t;
+
+    struct name {
+        std::int32_t origin;
+        std::uint8_t copy;
+        handle id;
+    };
+
+    handle intern( const char* first, const char* last );
+    handle intern( const std::string& );
+    handle intern( std::int32_t origin, std::uint8_t copy, handle id );
+
+    const std::string& str( handle ) const noexcept;
+    const name& obname( handle ) const noexcept;
+
+    std::size_t strings() const noexcept;
+    std::size_t names() const noexcept;
+
+    void clear() noexcept;
+
+private:
+    /*
+     * Open-addressed, linearly probed hash tables of handle + 1, so that
+     * zero is an empty slot
+     */
+    std::vector< std::string > strtab;
+    std::vector< std::uint64_t > strhash;
+    std::vector< handle > strslots;
+
+    std::vector< name > nametab;
+    std::vector< handle > nameslots;
+};
+
+}
+
+#endif //DLISIO_EXT_INTERN_HPP
@@ -0,0 +1,318 @@
+#ifndef DLISIO_EXT_IO_HPP
+#define DLISIO_EXT_IO_HPP
+
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dlisio/ext/stats.hpp>
+
+namespace dl {
+
+class arena;
+
+/*
+ * I/O errors are reported with regular-looking exceptions, so that the host
+ * (e.g. the python extension) can translate them into its native errors
+ */
+struct io_error : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+    explicit io_error( int no );
+};
+
+struct eof_error : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+/*
+ * Some protocol violations are not fatal, but should be reported. The
+ * functions that can emit them take a handler, which may be empty
+ */
+using warning_handler = std::function< void( const std::string& ) >;
+
+struct bookmark {
+    /*
+     * the remaining bytes of the "previous" visible record. if 0, the current
+     * object is the visible record label
+     */
+    int residual = 0;
+
+    int isexplicit = 0;
+    int isencrypted = 0;
+
+    /*
+     * the logical record type, from the header of the first segment
+     */
+    int type = 0;
+
+    /*
+     * the sum of the segment body lengths, i.e. the size of the record
+     * including segment trailers. It is an upper bound on the size of the
+     * record as returned by catrecord, and exact when there are no trailers
+     */
+    int length = 0;
+
+    /*
+     * the offset of the bookmark from the start of the file, which all
+     * backends reposition with. Plain offsets, unlike fpos_t, can be persisted
+     * and used to reopen the file later
+     */
+    long long tell = 0;
+};
+
+/*
+ * A byte stream backing a DLIS file. It's essentially the handful of
+ * operations mark and catrecord need from a FILE*, so that a file can be read
+ * either through stdio or straight off memory-mapped pages.
+ *
+ * read() either reads exactly n bytes or throws, eof_error if the stream
+ * ends before n bytes are available. skip() moves relative to the current
+ * position, like fseek( SEEK_CUR ).
+ *
+ * A stream is only used by one thread at a time, and counts the work done on
+ * it in count. The counts are added to the totals, which the stream shares
+ * with its cursors, when it's destroyed.
+ */
+class stream {
+public:
+    stream();
+    virtual ~stream();
+
+    virtual void read( char* dst, std::size_t n ) = 0;
+    virtual void skip( long long n ) = 0;
+    virtual bool eof() = 0;
+
+    virtual void getpos( bookmark& ) = 0;
+    virtual void setpos( const bookmark& ) = 0;
+
+    /*
+     * Memory-backed streams can hand out the next n bytes without copying.
+     * view() returns a pointer to them and moves past them, or nullptr (and
+     * doesn't move) if the stream can't. The memory stays valid for as long as
+     * something holds on to owner(), even after the stream itself is
+     * destroyed.
+     */
+    virtual const char* view( std::size_t ) { return nullptr; }
+    virtual std::shared_ptr< const void > owner() const { return nullptr; }
+
+    /*
+     * All the bytes of a memory-backed stream, for bulk processing, or nullptr
+     * if the stream is not memory-backed
+     */
+    virtual const char* data() const noexcept { return nullptr; }
+    virtual long long size() const noexcept { return -1; }
+
+    /*
+     * A new stream over the same file, with a position of its own, starting
+     * at the beginning. Cursors share the underlying handle or mapping, and
+     * can be read from different threads at the same time, also after the
+     * stream they came from is destroyed. Returns nullptr if the stream
+     * can't, which is the case for stdio.
+     */
+    virtual std::unique_ptr< stream > cursor() const { return nullptr; }
+
+    counters count;
+    const std::shared_ptr< stats >& totals() const noexcept {
+        return this->shared;
+    }
+
+protected:
+    /*
+     * A stream that adds to the totals of another, e.g. a cursor
+     */
+    explicit stream( std::shared_ptr< stats > totals );
+
+private:
+    std::shared_ptr< stats > shared;
+};
+
+/*
+ * The work done on the stream, and on its cursors that have been destroyed
+ */
+counters counted( const stream& );
+
+/*
+ * A logical record, with the segment headers and trailers stripped.
+ *
+ * The record is a view of its bytes, and keeps them alive on its own. A
+ * single-segment record from a memory-backed stream points straight into the
+ * file, and only records that span several segments are copied and
+ * concatenated.
+ */
+class record {
+public:
+    record() = default;
+    record( const char* begin,
+            const char* end,
+            std::shared_ptr< const void > owner ) :
+        first( begin ), last( end ), mem( std::move( owner ) )
+    {}
+
+    const char* data()  const noexcept { return this->first; }
+    const char* begin() const noexcept { return this->first; }
+    const char* end()   const noexcept { return this->last; }
+    std::size_t size()  const noexcept { return this->last - this->first; }
+    bool empty()        const noexcept { return this->first == this->last; }
+
+private:
+    const char* first = nullptr;
+    const char* last  = nullptr;
+    std::shared_ptr< const void > mem;
+};
+
+/*
+ * Open the file at path with stdio. Throws io_error if it can't be opened.
+ */
+std::unique_ptr< stream > open_stdio( const std::string& path );
+
+/*
+ * Memory-map the file at path, read-only and shared, so that the page cache
+ * is shared by all processes reading the same file. Throws io_error if the
+ * file can't be mapped, which is the case for empty files and most
+ * non-regular files (pipes, sockets). Callers that want it should fall back to
+ * open_stdio.
+ */
+std::unique_ptr< stream > open_mmap( const std::string& path );
+
+/*
+ * Open the file at path for positional reads (pread, or ReadFile with an
+ * offset on Windows), which don't share a file position, so that cursors can
+ * be used from many threads at once. Reads are buffered for each cursor.
+ * Throws io_error if the file can't be opened, or isn't a regular file, as
+ * pipes and sockets can't be read by offset.
+ */
+std::unique_ptr< stream > open_pread( const std::string& path );
+
+/*
+ * Open the file at path with the first backend that can: memory-mapped
+ * (unless mmap is false), then positional reads, and then stdio, which also
+ * reads pipes. Throws io_error if it can't be opened at all.
+ */
+std::unique_ptr< stream > open( const std::string& path, bool mmap = true );
+
+/*
+ * Mark the start of the next logical record, and move the stream to the start
+ * of the record after it. remaining is the number of bytes left in the
+ * current visible record, and is updated.
+ */
+bookmark mark( stream&, int& remaining, const warning_handler& = nullptr );
+
+/*
+ * Read the logical record starting at the current position of the stream and
+ * concatenate its segments, stripping segment headers and trailers.
+ */
+record catrecord( stream&, int remaining, const warning_handler& = nullptr );
+
+/*
+ * catrecord, but records that span segments are concatenated into the arena,
+ * rather than a buffer of their own. Those records don't keep their bytes
+ * alive, and are only valid until the arena is reset.
+ */
+record catrecord( stream&,
+                  int remaining,
+                  arena&,
+                  const warning_handler& = nullptr );
+
+/*
+ * Read at most the first n bytes of the logical record, like catrecord, but
+ * without reading the rest, for when only its header is interesting. The
+ * prefix is shorter than n only if the record is.
+ */
+record catprefix( stream&,
+                  int remaining,
+                  std::size_t n,
+                  const warning_handler& = nullptr );
+
+/*
+ * Read the records at the bookmarks, like catrecord, in the same order.
+ *
+ * The records are read in file order. For streams that aren't memory-backed,
+ * records that are close together are read by one large, sequential read,
+ * and split in memory, which saves a seek and a read per record. Records read
+ * this way may be views into the shared block, and keep it alive. Records in
+ * memory-backed streams are assembled from the segments found by scan (see
+ * index.hpp), and the position of the stream is left as it was.
+ */
+std::vector< record > catrecords( stream&,
+                                  const std::vector< bookmark >&,
+                                  const warning_handler& = nullptr );
+
+/*
+ * An incremental reader, for files that are still being written or that
+ * arrive over a pipe or socket, and can't be indexed up front.
+ *
+ * Bytes are fed in as they arrive, in chunks of any size, starting with the
+ * storage unit label. Every byte is consumed. Segment bodies are copied
+ * straight into the record they belong to, so the reader only holds on to
+ * the record being assembled and the complete records that haven't been
+ * taken with next() yet.
+ *
+ * The bookmarks of the records are the ones index() would make for the whole
+ * file, so a record can be found again once the file is complete.
+ *
+ * feed() throws invalid_argument on malformed labels and segment headers.
+ * After that the reader is in an unspecified state, and must not be fed
+ * again.
+ */
+class record_reader {
+public:
+    void feed( const char* data,
+               std::size_t size,
+               const warning_handler& = nullptr );
+
+    /*
+     * Take the next complete record, if there is one, in file order
+     */
+    bool next( bookmark&, record& );
+
+    /*
+     * The storage unit label, or empty if it hasn't arrived yet
+     */
+    const std::string& sul() const noexcept;
+
+    /*
+     * The number of complete records not yet taken, the number of bytes fed
+     * so far, and whether the reader is in the middle of a record. At the
+     * end of input, partial() means the last record is truncated.
+     */
+    std::size_t pending() const noexcept;
+    long long tell() const noexcept;
+    bool partial() const noexcept;
+
+private:
+    enum class state { sul, vrl, lrsh, body };
+
+    state st = state::sul;
+    long long offset = 0;
+    int remaining = 0;
+
+    /* labels and headers, which may be split across feeds */
+    char header[ 80 ];
+    std::size_t have = 0;
+    std::string label;
+
+    bookmark current;
+    bool inrecord = false;
+    std::shared_ptr< std::vector< char > > cat;
+
+    /* the segment being read, and its attributes */
+    int segleft = 0;
+    std::size_t segstart = 0;
+    std::uint8_t segattrs = 0;
+
+    std::deque< std::pair< bookmark, record > > done;
+
+    bool collect( const char*& data, std::size_t& size, std::size_t n );
+    void visible_label( const warning_handler& );
+    void segment_header();
+    void finish_segment();
+};
+
+}
+
+#endif //DLISIO_EXT_IO_HPP
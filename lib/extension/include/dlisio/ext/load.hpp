@@ -0,0 +1,104 @@
+#ifndef DLISIO_EXT_LOAD_HPP
+#define DLISIO_EXT_LOAD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dlisio/ext/eflr.hpp>
+#include <dlisio/ext/frame.hpp>
+#include <dlisio/ext/io.hpp>
+
+namespace dl {
+
+/*
+ * The logical files of a storage unit, as ranges [first, last) of its
+ * bookmarks. Every explicit FILE-HEADER record starts a new logical file, and
+ * records before the first FILE-HEADER, if any, make a logical file of their
+ * own.
+ */
+std::vector< std::pair< std::size_t, std::size_t > >
+logical_files( const std::vector< bookmark >& );
+
+/*
+ * The curves of a frame, decoded like decode_frames does: the frame numbers,
+ * and one column per channel, in frame order. dims are the dimensions of the
+ * channels, as in the CHANNEL objects.
+ *
+ * Frames with channels that can't be decoded into columns are not decoded,
+ * and have error set, as do frames that fail to decode.
+ */
+struct frame_columns {
+    obname name;
+    std::vector< obname > channels;
+    std::vector< int > reprc;
+    std::vector< std::vector< std::size_t > > dims;
+
+    std::vector< std::int32_t > numbers;
+    std::vector< std::vector< char > > columns;
+
+    std::exception_ptr error;
+};
+
+/*
+ * Describe the frames of a logical file from its FRAME and CHANNEL sets, the
+ * same way dlis.curves does: the channels of every frame, and their
+ * representation codes and dimensions. The curves are left empty. If more
+ * than one channel has the same name, the frames refer to the last one.
+ */
+std::vector< frame_columns > describe_frames( const std::vector< set >& );
+
+/*
+ * Read the FDATA records of the frame in the index, and decode them into the
+ * numbers and columns of the frame, which must have been described by
+ * describe_frames. The decoded frames are counted in the stream counters.
+ *
+ * Throws invalid_argument if the records can't be decoded.
+ */
+void decode_frame( stream&,
+                   const std::vector< bookmark >&,
+                   const fdata_index&,
+                   frame_columns&,
+                   const warning_handler& = nullptr );
+
+/*
+ * A loaded logical file: its bookmarks, its explicitly formatted records
+ * parsed into sets (in file order, encrypted records are skipped), and the
+ * curves of its frames.
+ *
+ * Failures are per logical file, and are recorded in error rather than
+ * thrown, so that one broken file doesn't fail the rest. A file that can't
+ * be opened or indexed is a single logical file with error set.
+ */
+struct logical_file {
+    std::string path;
+    std::size_t index = 0;
+    std::string sul;
+
+    std::vector< bookmark > bookmarks;
+    std::vector< set > sets;
+    std::vector< frame_columns > frames;
+
+    std::vector< std::string > warnings;
+    std::exception_ptr error;
+};
+
+/*
+ * Load the files at paths: index them, split them into logical files, parse
+ * the sets and decode the frames. The work is split into tasks per file,
+ * logical file and frame, and run on a work-stealing pool of threads
+ * (threads = 0 means one per core), so that the cores stay busy even when
+ * the files are of very different sizes.
+ *
+ * The logical files are returned in order, by path and then by position in
+ * the file.
+ */
+std::vector< logical_file > load( const std::vector< std::string >& paths,
+                                  int threads = 0 );
+
+}
+
+#endif //DLISIO_EXT_LOAD_HPP
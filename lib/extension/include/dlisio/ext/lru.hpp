@@ -0,0 +1,110 @@
+#ifndef DLISIO_EXT_LRU_HPP
+#define DLISIO_EXT_LRU_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <dlisio/ext/eflr.hpp>
+#include <dlisio/ext/io.hpp>
+
+namespace dl {
+
+/*
+ * The lookups of a record cache, and what's in it. hits and misses are
+ * counted per lookup, of records and sets alike, and evictions are the
+ * entries dropped to stay within the budget.
+ */
+struct cache_counts {
+    std::uint64_t hits      = 0;
+    std::uint64_t misses    = 0;
+    std::uint64_t evictions = 0;
+    std::size_t bytes   = 0;
+    std::size_t entries = 0;
+};
+
+/*
+ * A bounded cache of the logical records of one file, assembled by
+ * catrecord, and optionally parsed, keyed by the position of their bookmark.
+ * It's for reading the same few records (like the origin and channels) again
+ * and again, without re-reading and re-parsing them every time.
+ *
+ * When the records and sets in the cache take up more than budget bytes, the
+ * least recently used are evicted. A set is charged for its tables and the
+ * bytes of its record, which it shares with the cached record, if any, so
+ * caching both costs little more than caching the set. Anything larger than
+ * the budget on its own is not cached, and a budget of 0 disables the cache,
+ * which then counts neither hits nor misses.
+ *
+ * The cached records are shared, and a record that's evicted stays valid for
+ * as long as someone holds on to it. All members lock, so the cache can be
+ * used from many threads at the same time.
+ */
+class record_cache {
+public:
+    explicit record_cache( std::size_t budget = 0 );
+
+    record_cache( const record_cache& ) = delete;
+    record_cache& operator=( const record_cache& ) = delete;
+
+    /*
+     * Look up the record, or the set, at the bookmark, and make it the most
+     * recently used. find() returns false and findset() nullptr if it isn't
+     * cached.
+     */
+    bool find( const bookmark&, record& );
+    std::shared_ptr< const set > findset( const bookmark& );
+
+    /*
+     * Look up the set, and if it isn't cached, the record, at the bookmark,
+     * in one lookup which counts as one hit or miss. hasrecord is set if the
+     * set isn't cached but the record is, which is then copied into rec.
+     */
+    std::shared_ptr< const set > findset( const bookmark&,
+                                          record& rec,
+                                          bool& hasrecord );
+
+    void insert( const bookmark&, const record& );
+    void insert( const bookmark&, std::shared_ptr< const set > );
+
+    /*
+     * Change the budget, and evict down to it right away
+     */
+    void resize( std::size_t budget );
+    void clear();
+
+    std::size_t budget() const;
+    cache_counts counts() const;
+    void reset_counts();
+
+private:
+    struct entry {
+        long long tell = 0;
+        bool hasrecord = false;
+        record rec;
+        std::shared_ptr< const set > parsed;
+        std::size_t bytes = 0;
+    };
+
+    using iterator = std::list< entry >::iterator;
+
+    /*
+     * The entries in order of use, the most recently used first
+     */
+    mutable std::mutex mutex;
+    std::size_t limit;
+    std::list< entry > lru;
+    std::unordered_map< long long, iterator > entries;
+    cache_counts count;
+
+    entry* lookup( const bookmark& );
+    void store( entry );
+    void evict();
+};
+
+}
+
+#endif //DLISIO_EXT_LRU_HPP
@@ -0,0 +1,82 @@
+#ifndef DLISIO_EXT_POOL_HPP
+#define DLISIO_EXT_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dl {
+
+/*
+ * A work-stealing thread pool, for work that fans out unevenly, like loading
+ * many files of very different sizes.
+ *
+ * Every worker has a queue of its own. Tasks submitted from a worker go to
+ * its own queue, and the worker takes its most recently submitted task first,
+ * while idle workers steal the oldest tasks from the others. A large task that
+ * splits itself into many small ones keeps all the workers busy, and tasks
+ * mostly run on the thread (and cache) that made them.
+ *
+ * If a task throws, the exception is rethrown by wait(), after all tasks have
+ * completed. Only the first exception is kept.
+ */
+class pool {
+public:
+    /*
+     * threads = 0 means one per core, if it can be determined
+     */
+    explicit pool( int threads = 0 );
+
+    /*
+     * Run all submitted tasks to completion, and join the workers
+     */
+    ~pool();
+
+    pool( const pool& ) = delete;
+    pool& operator=( const pool& ) = delete;
+
+    void submit( std::function< void() > task );
+
+    /*
+     * Block until all tasks, including the ones submitted by other tasks,
+     * have completed. Must not be called from a task.
+     */
+    void wait();
+
+    std::size_t size() const noexcept;
+
+private:
+    struct queue {
+        std::mutex mutex;
+        std::deque< std::function< void() > > tasks;
+    };
+
+    std::vector< std::unique_ptr< queue > > queues;
+    std::vector< std::thread > workers;
+
+    /*
+     * queued are the submitted tasks not yet taken by a worker, and pending
+     * the submitted tasks not yet completed
+     */
+    std::mutex mutex;
+    std::condition_variable available;
+    std::condition_variable idle;
+    std::size_t queued = 0;
+    std::size_t pending = 0;
+    std::size_t rr = 0;
+    bool stop = false;
+    std::exception_ptr error;
+
+    void run( std::size_t self );
+    bool take( std::size_t self, std::function< void() >& task );
+};
+
+}
+
+#endif //DLISIO_EXT_POOL_HPP
@@ -0,0 +1,96 @@
+#ifndef DLISIO_EXT_READAHEAD_HPP
+#define DLISIO_EXT_READAHEAD_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dlisio/ext/io.hpp>
+
+namespace dl {
+
+/*
+ * Read the records at the bookmarks, in order, with the reads issued ahead of
+ * time, so that the I/O of upcoming records overlaps with the parsing of the
+ * current ones. This is for files on slow or high-latency storage, like
+ * spinning disks and network file systems, where every read otherwise waits.
+ *
+ * Reader threads, each with a cursor of its own, claim runs of depth /
+ * threads records and read them with catrecords, which coalesces the reads.
+ * At most depth records are in flight or waiting to be taken at any time, so
+ * the memory used is bounded by the depth. next() hands out the records in
+ * the order of the bookmarks, like catrecords would, and the warnings and
+ * exceptions of a record are reported by the next() that takes it, on the
+ * calling thread.
+ *
+ * Streams that have no cursors (stdio), and a depth of 0, read every record
+ * synchronously in next() instead.
+ */
+class readahead {
+public:
+    readahead( stream&,
+               std::vector< bookmark >,
+               std::size_t depth,
+               int threads = 1,
+               const warning_handler& = nullptr );
+
+    /*
+     * Stop the readers, and wait for the reads in flight
+     */
+    ~readahead();
+
+    readahead( const readahead& ) = delete;
+    readahead& operator=( const readahead& ) = delete;
+
+    /*
+     * The number of records, and the number handed out by next()
+     */
+    std::size_t size() const noexcept;
+    std::size_t taken() const noexcept;
+    bool done() const noexcept;
+
+    /*
+     * The next record. Throws std::out_of_range when all records are taken,
+     * and rethrows what reading the record threw.
+     */
+    record next();
+
+private:
+    struct slot {
+        record rec;
+        std::vector< std::string > warnings;
+        std::exception_ptr error;
+        bool ready = false;
+    };
+
+    stream& fp;
+    std::vector< bookmark > marks;
+    std::size_t depth;
+    std::size_t run;
+    warning_handler warn;
+
+    /*
+     * Records are read into the slot of their position modulo depth. issued
+     * is the first record not yet claimed by a reader, and consumed the first
+     * not yet taken by next()
+     */
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable space;
+    std::vector< slot > slots;
+    std::size_t issued = 0;
+    std::size_t consumed = 0;
+    bool stop = false;
+
+    std::vector< std::thread > readers;
+
+    void read( stream& cursor );
+};
+
+}
+
+#endif //DLISIO_EXT_READAHEAD_HPP
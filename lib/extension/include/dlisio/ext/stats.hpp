@@ -0,0 +1,87 @@
+#ifndef DLISIO_EXT_STATS_HPP
+#define DLISIO_EXT_STATS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace dl {
+
+/*
+ * Counters of the work done reading a file, for attributing time to I/O or
+ * parsing without a profiler.
+ *
+ * bytes are the bytes read, copied or viewed, from the file, and reads the
+ * reads that go to the operating system (fread and pread calls, memory-mapped
+ * files have none). seeks are repositionings, which only cost a system call
+ * with stdio. segments are the logical record segments visited, records the
+ * records read and concatenated those of them that span segments. indexed,
+ * sets and frames are the records bookmarked, the sets parsed and the frames
+ * decoded.
+ *
+ * The times are the nanoseconds spent indexing, reading records, parsing sets
+ * and decoding frames. A phase that runs inside another, e.g. the records
+ * read by fdata, is only timed as the outer phase.
+ */
+struct counters {
+    std::uint64_t bytes        = 0;
+    std::uint64_t reads        = 0;
+    std::uint64_t seeks        = 0;
+    std::uint64_t segments     = 0;
+    std::uint64_t indexed      = 0;
+    std::uint64_t records      = 0;
+    std::uint64_t concatenated = 0;
+    std::uint64_t sets         = 0;
+    std::uint64_t frames       = 0;
+
+    std::uint64_t index_ns  = 0;
+    std::uint64_t read_ns   = 0;
+    std::uint64_t parse_ns  = 0;
+    std::uint64_t decode_ns = 0;
+
+    counters& operator+=( const counters& ) noexcept;
+};
+
+/*
+ * The totals of a file, shared by the stream and its cursors. Streams count
+ * in counters of their own, and add them to the totals when they're
+ * destroyed, so the totals are only locked once per stream, and can be added
+ * to and read from many threads.
+ *
+ * Counting is compiled in with DLISIO_STATS, and without it the totals stay
+ * 0, and enabled() is false.
+ */
+class stats {
+public:
+    void add( const counters& );
+    counters get() const;
+    void reset();
+
+    static bool enabled() noexcept;
+
+private:
+    mutable std::mutex mutex;
+    counters total;
+};
+
+/*
+ * Time the scope, and add the nanoseconds to ns when it ends. Only the
+ * outermost timer of a thread counts, so phases that are built from other
+ * phases aren't timed twice
+ */
+class timer {
+public:
+    explicit timer( std::uint64_t& ns ) noexcept;
+    ~timer();
+
+    timer( const timer& ) = delete;
+    timer& operator=( const timer& ) = delete;
+
+private:
+    std::uint64_t* ns = nullptr;
+    std::chrono::steady_clock::time_point start;
+};
+
+}
+
+#endif //DLISIO_EXT_STATS_HPP
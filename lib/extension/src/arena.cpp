@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include <dlisio/ext/arena.hpp>
+
+namespace {
+
+std::size_t align_up( std::size_t x, std::size_t alignment ) noexcept {
+    return (x + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+namespace dl {
+
+arena::arena( std::size_t blocksize ) {
+    this->grow( std::max( blocksize, std::size_t( 64 ) ) );
+}
+
+void arena::grow( std::size_t size ) {
+    /* blocks at least double, so growing is amortised o(1) */
+    size = std::max( size, this->total );
+    block b;
+    b.mem.reset( new char[ size ] );
+    b.size = size;
+    this->used.push_back( std::move( b ) );
+    this->offset = 0;
+    this->total += size;
+}
+
+void* arena::allocate( std::size_t size, std::size_t alignment ) {
+    /*
+     * new char[] is aligned for any fundamental type, so aligning the offset
+     * aligns the pointer
+     */
+    auto& current = this->used.back();
+    auto begin = align_up( this->offset, alignment );
+
+    if( begin + size > current.size ) {
+        this->grow( size + alignment );
+        begin = 0;
+    }
+
+    auto* p = this->used.back().mem.get() + begin;
+    this->offset = begin + size;
+    this->last = p;
+    return p;
+}
+
+void* arena::reallocate( void* p,
+                         std::size_t size,
+                         std::size_t newsize,
+                         std::size_t alignment ) {
+    if( !p ) return this->allocate( newsize, alignment );
+
+    /* the most recent allocation is always in the last block */
+    if( p == this->last ) {
+        const auto& current = this->used.back();
+        const std::size_t begin = static_cast< char* >( p ) - current.mem.get();
+        if( begin + newsize <= current.size ) {
+            this->offset = begin + newsize;
+            return p;
+        }
+    }
+
+    auto* q = this->allocate( newsize, alignment );
+    std::memcpy( q, p, std::min( size, newsize ) );
+    return q;
+}
+
+void arena::reset() noexcept {
+    this->offset = 0;
+    this->last = nullptr;
+    if( this->used.size() == 1 ) return;
+
+    /*
+     * replace the blocks with a single one that fits everything that was
+     * allocated since the last reset. If that fails the blocks are kept
+     * as-is, and the arena starts over in the last, largest one
+     */
+    try {
+        block b;
+        b.mem.reset( new char[ this->total ] );
+        b.size = this->total;
+        this->used.clear();
+        this->used.push_back( std::move( b ) );
+    } catch( ... ) {
+        auto b = std::move( this->used.back() );
+        this->used.clear();
+        this->total = b.size;
+        this->used.push_back( std::move( b ) );
+    }
+}
+
+std::size_t arena::blocks() const noexcept {
+    return this->used.size();
+}
+
+std::size_t arena::capacity() const noexcept {
+    return this->total;
+}
+
+}
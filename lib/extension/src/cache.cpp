@@ -0,0 +1,249 @@
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+    #include <process.h>
+#else
+    #include <unistd.h>
+#endif
+
+#include <dlisio/dlisio.h>
+#include <dlisio/ext/cache.hpp>
+#include <dlisio/ext/io.hpp>
+
+namespace {
+
+/*
+ * The sidecar layout, all integers little-endian:
+ *
+ *  magic       8   "DLISIDX\0"
+ *  version     4
+ *  reserved    4
+ *  size        8   \
+ *  mtime       8    | index_key
+ *  hash        8   /
+ *  count       8
+ *  sul         80
+ *  bookmarks   count * 20:
+ *      tell        8
+ *      residual    4
+ *      length      4
+ *      type        1
+ *      flags       1   (1 = explicit, 2 = encrypted)
+ *      reserved    2
+ */
+const char magic[ 8 ] = { 'D', 'L', 'I', 'S', 'I', 'D', 'X', '\0' };
+const std::uint32_t version = 3;
+
+constexpr std::size_t header_size   = 8 + 4 + 4 + 8 + 8 + 8 + 8;
+constexpr std::size_t sul_size      = 80;
+constexpr std::size_t bookmark_size = 20;
+
+/* how much of the file is hashed for the key */
+constexpr std::size_t hashed_size = 4096;
+
+struct fcloser {
+    void operator()( std::FILE* x ) {
+        if( x ) std::fclose( x );
+    }
+};
+
+using ufile = std::unique_ptr< std::FILE, fcloser >;
+
+void put( std::string& out, std::uint64_t x, int n ) {
+    for( int i = 0; i < n; ++i )
+        out.push_back( char( (x >> (8 * i)) & 0xFF ) );
+}
+
+std::uint64_t get( const char* xs, int n ) {
+    std::uint64_t x = 0;
+    for( int i = 0; i < n; ++i )
+        x |= std::uint64_t( static_cast< unsigned char >( xs[ i ] ) ) << (8 * i);
+    return x;
+}
+
+/* 64-bit FNV-1a */
+std::uint64_t fnv1a( const char* xs, std::size_t n ) {
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for( std::size_t i = 0; i < n; ++i ) {
+        hash ^= static_cast< unsigned char >( xs[ i ] );
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+}
+
+namespace dl {
+
+index_key fingerprint( const std::string& path ) {
+    index_key key;
+
+#ifdef _WIN32
+    struct _stat64 st;
+    if( _stat64( path.c_str(), &st ) ) throw io_error( errno );
+#else
+    struct stat st;
+    if( stat( path.c_str(), &st ) ) throw io_error( errno );
+#endif
+
+    /*
+     * The modification time in nanoseconds, where the platform has it, so
+     * that a file rewritten within the same second is not mistaken for the
+     * one that was indexed
+     */
+    constexpr long long ns = 1000000000;
+    key.size  = st.st_size;
+#if defined( _WIN32 )
+    key.mtime = st.st_mtime * ns;
+#elif defined( __APPLE__ )
+    key.mtime = st.st_mtimespec.tv_sec * ns + st.st_mtimespec.tv_nsec;
+#else
+    key.mtime = st.st_mtim.tv_sec * ns + st.st_mtim.tv_nsec;
+#endif
+
+    ufile fp( std::fopen( path.c_str(), "rb" ) );
+    if( !fp ) throw io_error( errno );
+
+    char buffer[ hashed_size ];
+    const auto n = std::fread( buffer, 1, sizeof( buffer ), fp.get() );
+    if( std::ferror( fp.get() ) ) throw io_error( errno );
+
+    key.hash = fnv1a( buffer, n );
+    return key;
+}
+
+std::string tempname( const std::string& path ) {
+    static std::atomic< unsigned long > counter( 0 );
+
+#ifdef _WIN32
+    const auto pid = _getpid();
+#else
+    const auto pid = getpid();
+#endif
+
+    return path + ".tmp."
+         + std::to_string( pid ) + "."
+         + std::to_string( counter++ );
+}
+
+void write_sidecar( const std::string& path, const sidecar& sc ) {
+    if( sc.sul.size() != sul_size )
+        throw std::invalid_argument( "storage unit label must be "
+                                     + std::to_string( sul_size ) + " bytes" );
+
+    std::string out;
+    out.reserve( header_size + sul_size
+               + sc.bookmarks.size() * bookmark_size );
+
+    out.append( magic, sizeof( magic ) );
+    put( out, version, 4 );
+    put( out, 0, 4 );
+    put( out, sc.key.size, 8 );
+    put( out, sc.key.mtime, 8 );
+    put( out, sc.key.hash, 8 );
+    put( out, sc.bookmarks.size(), 8 );
+    out += sc.sul;
+
+    for( const auto& mark : sc.bookmarks ) {
+        const int flags = (mark.isexplicit  ? 1 : 0)
+                        | (mark.isencrypted ? 2 : 0);
+        put( out, mark.tell, 8 );
+        put( out, std::uint32_t( mark.residual ), 4 );
+        put( out, std::uint32_t( mark.length ), 4 );
+        put( out, mark.type, 1 );
+        put( out, flags, 1 );
+        put( out, 0, 2 );
+    }
+
+    const auto tmp = tempname( path );
+    {
+        ufile fp( std::fopen( tmp.c_str(), "wb" ) );
+        if( !fp ) throw io_error( errno );
+
+        const auto n = std::fwrite( out.data(), 1, out.size(), fp.get() );
+        if( n != out.size() ) {
+            const auto err = errno;
+            fp.reset();
+            std::remove( tmp.c_str() );
+            throw io_error( err );
+        }
+
+        if( std::fclose( fp.release() ) ) {
+            const auto err = errno;
+            std::remove( tmp.c_str() );
+            throw io_error( err );
+        }
+    }
+
+#ifdef _WIN32
+    /* rename does not replace existing files on Windows */
+    std::remove( path.c_str() );
+#endif
+
+    if( std::rename( tmp.c_str(), path.c_str() ) ) {
+        const auto err = errno;
+        std::remove( tmp.c_str() );
+        throw io_error( err );
+    }
+}
+
+bool read_sidecar( const std::string& path,
+                   const index_key& key,
+                   sidecar& out ) {
+    ufile fp( std::fopen( path.c_str(), "rb" ) );
+    if( !fp ) return false;
+
+    char header[ header_size + sul_size ];
+    if( std::fread( header, 1, sizeof( header ), fp.get() ) != sizeof( header ) )
+        return false;
+
+    if( std::memcmp( header, magic, sizeof( magic ) ) ) return false;
+    if( get( header + 8, 4 ) != version ) return false;
+
+    out.key.size  = get( header + 16, 8 );
+    out.key.mtime = get( header + 24, 8 );
+    out.key.hash  = get( header + 32, 8 );
+    if( out.key != key ) return false;
+
+    const auto count = get( header + 40, 8 );
+    /*
+     * a sane upper bound. Visible records are shared by many records, so the
+     * only size every record has is its 4-byte LRSH
+     */
+    if( count > std::uint64_t( key.size ) / 4 ) return false;
+
+    out.sul.assign( header + header_size, sul_size );
+
+    std::vector< char > body( count * bookmark_size + 1 );
+    const auto n = std::fread( body.data(), 1, body.size(), fp.get() );
+    if( n != count * bookmark_size ) return false;
+
+    out.bookmarks.resize( count );
+    const char* xs = body.data();
+    for( auto& mark : out.bookmarks ) {
+        mark.tell        = get( xs, 8 );
+        mark.residual    = std::int32_t( get( xs + 8, 4 ) );
+        mark.length      = std::int32_t( get( xs + 12, 4 ) );
+        mark.type        = get( xs + 16, 1 );
+        /* restore the flags as mark sets them */
+        const auto flags = get( xs + 17, 1 );
+        mark.isexplicit  = flags & 1 ? DLIS_SEGATTR_EXFMTLR : 0;
+        mark.isencrypted = flags & 2 ? DLIS_SEGATTR_ENCRYPT : 0;
+        xs += bookmark_size;
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,609 @@
+#include <bitset>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dlisio/dlisio.h>
+#include <dlisio/types.h>
+#include <dlisio/ext/eflr.hpp>
+#include <dlisio/ext/frame.hpp>
+#include <dlisio/ext/io.hpp>
+
+#include "uvari.hpp"
+
+namespace {
+
+using dl::uvari;
+
+std::invalid_argument truncated( const char* where ) {
+    return std::invalid_argument( std::string( "unexpected end-of-record " )
+                                + where );
+}
+
+void report( const dl::warning_handler& warn, const std::string& msg ) {
+    if( warn ) warn( msg );
+}
+
+const char* readushort( const char* cur, const char* end, int& out ) {
+    if( cur >= end ) throw truncated( "in USHORT" );
+    std::uint8_t x;
+    cur = dlis_ushort( cur, &x );
+    out = x;
+    return cur;
+}
+
+/*
+ * The characters of the identifier at cur, without copying them
+ */
+const char* ident( const char* cur, const char* end, dl::span& out ) {
+    if( cur >= end ) throw truncated( "in IDENT" );
+
+    std::int32_t len;
+    dlis_ident( cur, &len, nullptr );
+    if( end - cur < len + 1 ) throw truncated( "in IDENT" );
+
+    out.first = cur + 1;
+    out.last  = cur + 1 + len;
+    return out.last;
+}
+
+/*
+ * The OBNAME at cur, with the identifier as a view into the record. Names
+ * are decoded in one go, and only those near or past the end of the record
+ * are decoded piece by piece, which reports where they're truncated.
+ * dlis_obname_view reads up to 6 bytes before it knows the length of the
+ * name, so it's only used when that many are left
+ */
+const char* obname( const char* cur,
+                    const char* end,
+                    std::int32_t& origin,
+                    std::uint8_t& copy,
+                    dl::span& id ) {
+    if( end - cur >= 6 ) {
+        std::int32_t len;
+        const auto* next = dlis_obname_view( cur, &origin,
+                                                  &copy,
+                                                  &len,
+                                                  &id.first );
+        id.last = next;
+        if( next - cur <= end - cur ) return next;
+    }
+
+    cur = uvari( cur, end, origin );
+
+    int x;
+    cur = readushort( cur, end, x );
+    copy = std::uint8_t( x );
+    return ident( cur, end, id );
+}
+
+/*
+ * Move past count values of the representation code, without decoding them
+ */
+const char* skip( const char* cur, const char* end, int count, int reprc ) {
+    const auto size = dl::sizeof_reprc( reprc );
+    if( size > 0 ) {
+        if( std::size_t( end - cur ) / size < std::size_t( count ) )
+            throw truncated( "in attribute value" );
+        return cur + size * count;
+    }
+
+    std::int32_t len;
+    std::uint8_t copy;
+    dl::span str;
+    for( int i = 0; i < count; ++i ) {
+        switch( reprc ) {
+            case DLIS_DTIME:
+                if( end - cur < 8 ) throw truncated( "in DTIME" );
+                cur += 8;
+                break;
+
+            case DLIS_UVARI:
+            case DLIS_ORIGIN:
+                cur = uvari( cur, end, len );
+                break;
+
+            case DLIS_IDENT:
+            case DLIS_UNITS:
+                cur = ident( cur, end, str );
+                break;
+
+            case DLIS_ASCII:
+                cur = uvari( cur, end, len );
+                if( end - cur < len ) throw truncated( "in ASCII" );
+                cur += len;
+                break;
+
+            case DLIS_OBNAME:
+                cur = obname( cur, end, len, copy, str );
+                break;
+
+            case DLIS_OBJREF:
+                cur = ident( cur, end, str );
+                cur = obname( cur, end, len, copy, str );
+                break;
+
+            case DLIS_ATTREF:
+                cur = ident( cur, end, str );
+                cur = obname( cur, end, len, copy, str );
+                cur = ident( cur, end, str );
+                break;
+
+            default:
+                throw std::invalid_argument( "unknown representation code "
+                                           + std::to_string( reprc ) );
+        }
+    }
+
+    return cur;
+}
+
+const char* readvalue( const char* cur,
+                       const char* end,
+                       int count,
+                       int reprc,
+                       dl::value& out ) {
+    out.present = true;
+    out.count = count;
+    out.reprc = reprc;
+    out.bytes.first = cur;
+    out.bytes.last = skip( cur, end, count, reprc );
+    return out.bytes.last;
+}
+
+struct setattr {
+    int type, name;
+};
+
+setattr set_attributes( const char*& cur, const dl::warning_handler& warn ) {
+    std::uint8_t attr;
+    std::memcpy( &attr, cur, sizeof( std::uint8_t ) );
+    cur += sizeof( std::uint8_t );
+
+    int role;
+    dlis_component( attr, &role );
+
+    switch( role ) {
+        case DLIS_ROLE_RDSET:
+        case DLIS_ROLE_RSET:
+        case DLIS_ROLE_SET:
+            break;
+
+        default:
+            throw std::invalid_argument(
+                std::string("first item in EFLR not SET, RSET or RDSET, was ")
+                + dlis_component_str( role )
+                + "(" + std::bitset< sizeof( attr ) >( role ).to_string() + ")"
+            );
+    }
+
+    setattr flags;
+    const auto err = dlis_component_set( attr, role, &flags.type, &flags.name );
+
+    switch( err ) {
+        case DLIS_OK:
+            break;
+
+        case DLIS_INCONSISTENT:
+            report( warn, "SET:type not set, but must be non-null." );
+            flags.type = 1;
+            break;
+
+        default:
+            throw std::runtime_error( "unhandled error in dlis_component_set" );
+    }
+
+    return flags;
+}
+
+struct attribattr {
+    int label;
+    int count;
+    int reprc;
+    int units;
+    int value;
+    int object = 0;
+    int absent = 0;
+    int invariant = 0;
+};
+
+attribattr attrib_attributes( const char*& cur ) {
+    std::uint8_t attr;
+    std::memcpy( &attr, cur, sizeof( std::uint8_t ) );
+
+    int role;
+    dlis_component( attr, &role );
+
+    attribattr flags;
+    switch( role ) {
+        case DLIS_ROLE_ABSATR:
+            flags.absent= 1;
+            break;
+
+        case DLIS_ROLE_OBJECT:
+            flags.object = 1;
+            break;
+
+        case DLIS_ROLE_INVATR:
+            flags.invariant = 1;
+
+        case DLIS_ROLE_ATTRIB:
+            break;
+
+        default:
+            throw std::invalid_argument(
+                std::string("expected ATTRIB, INVATR, or OBJECT, was ")
+                + dlis_component_str( role )
+                + "(" + std::bitset< sizeof( attr ) >( role ).to_string() + ")"
+            );
+    }
+
+    /*
+     * only consume the component tag if it is not object, because if it is
+     * then the next function assumes its there
+     */
+    if( role != DLIS_ROLE_OBJECT )
+        cur += sizeof( std::uint8_t );
+
+    if( flags.object || flags.absent ) return flags;
+
+    const auto err = dlis_component_attrib( attr, role, &flags.label,
+                                                        &flags.count,
+                                                        &flags.reprc,
+                                                        &flags.units,
+                                                        &flags.value );
+
+    if( !err ) return flags;
+
+    // all sources for this error should've been checked, so
+    // something is REALLY wrong if we end up here
+    throw std::runtime_error( "unhandled error in dlis_component_attrib" );
+}
+
+void object_attributes( const char*& cur, const dl::warning_handler& warn ) {
+    std::uint8_t attr;
+    std::memcpy( &attr, cur, sizeof( std::uint8_t ) );
+
+    cur += sizeof( std::uint8_t );
+
+    int role;
+    dlis_component( attr, &role );
+
+    if( role != DLIS_ROLE_OBJECT )
+        throw std::invalid_argument( std::string("expected OBJECT, was ")
+                                   + dlis_component_str( role ) );
+
+    int obname;
+    const auto err = dlis_component_object( attr, role, &obname );
+
+    if( err ) report( warn, "OBJECT:name not set, but must be non-null" );
+}
+
+void explicit_template( const char*& cur,
+                        const char* end,
+                        const dl::warning_handler& warn,
+                        dl::object_template& tmpl ) {
+    while( true ) {
+        if( cur >= end ) throw truncated( "in template" );
+
+        auto flags = attrib_attributes( cur );
+
+        if( flags.object ) return;
+
+        if( flags.absent ) {
+            report( warn, "ABSATR in object template - skipping" );
+            continue;
+        }
+
+        if( !flags.label ) {
+            report( warn, "ATTRIB:label not set, but must be non-null" );
+            flags.label = 1;
+        }
+
+        /* the global defaults apply unless the template says otherwise */
+        dl::attribute attr;
+                          cur = ident( cur, end, attr.label );
+        if( flags.count ) cur = uvari( cur, end, attr.count );
+        if( flags.reprc ) cur = readushort( cur, end, attr.reprc );
+        if( flags.units ) cur = ident( cur, end, attr.units );
+        if( flags.value ) cur = readvalue( cur, end, attr.count,
+                                                     attr.reprc,
+                                                     attr.val );
+        attr.hasunits = flags.units;
+
+        if( flags.invariant ) tmpl.invariants.push_back( attr );
+        else                  tmpl.attributes.push_back( attr );
+    }
+}
+
+}
+
+namespace dl {
+
+namespace {
+
+set parse( const record& rec, arena* mem, const warning_handler& warn ) {
+    const auto* cur = rec.begin();
+    const auto* end = rec.end();
+
+    if( cur == end )
+        throw std::invalid_argument( "eflr must be non-empty" );
+
+    set s( mem );
+    s.bytes = rec;
+
+    const auto flags = set_attributes( cur, warn );
+    if( cur >= end ) throw truncated( "after SET component" );
+
+    if( flags.type ) {
+        cur = ident( cur, end, s.type );
+        s.hastype = true;
+    }
+
+    if( flags.name ) {
+        cur = ident( cur, end, s.name );
+        s.hasname = true;
+    }
+
+    explicit_template( cur, end, warn, s.tmpl );
+    if( cur >= end ) throw truncated( "after template" );
+
+    while( cur != end ) {
+        object_attributes( cur, warn );
+
+        /*
+         * just assume obname. objects have to specify it, and if it is unset
+         * then a warning has already been emitted
+         */
+        object obj;
+        cur = ::obname( cur, end, obj.origin, obj.copy, obj.id );
+        obj.first = s.cells.size();
+
+        /*
+         * The object overrides the template attributes in order, until it is
+         * cut short (terminated by a new object, or the end of the record).
+         * Overriding the count or representation code doesn't reset the
+         * value
+         */
+        for( const auto& defaults : s.tmpl.attributes ) {
+            if( cur == end ) break;
+
+            const auto attrflags = attrib_attributes( cur );
+            if( attrflags.object ) break;
+
+            attribute cell = defaults;
+            if( attrflags.absent ) {
+                cell.val = value();
+                s.cells.push_back( cell );
+                continue;
+            }
+
+            if( attrflags.label ) {
+                span str;
+                cur = ident( cur, end, str );
+                report( warn, "ATTRIB:label set, but must be null - was "
+                            + str.str() );
+            }
+
+            if( attrflags.count ) cur = uvari( cur, end, cell.count );
+            if( attrflags.reprc ) cur = readushort( cur, end, cell.reprc );
+            if( attrflags.units ) cur = ident( cur, end, cell.units );
+            if( attrflags.value ) cur = readvalue( cur, end, cell.count,
+                                                             cell.reprc,
+                                                             cell.val );
+            if( attrflags.units ) cell.hasunits = true;
+            s.cells.push_back( cell );
+        }
+
+        obj.size = s.cells.size() - obj.first;
+        s.objects.push_back( std::move( obj ) );
+    }
+
+    return s;
+}
+
+}
+
+set parse_set( const record& rec, const warning_handler& warn ) {
+    return parse( rec, nullptr, warn );
+}
+
+set parse_set( const record& rec, arena& mem, const warning_handler& warn ) {
+    return parse( rec, &mem, warn );
+}
+
+const char* obname_view( const char* cur,
+                         const char* end,
+                         std::int32_t& origin,
+                         std::uint8_t& copy,
+                         span& id ) {
+    return ::obname( cur, end, origin, copy, id );
+}
+
+const char* objref_view( const char* cur,
+                         const char* end,
+                         span& type,
+                         std::int32_t& origin,
+                         std::uint8_t& copy,
+                         span& id ) {
+    cur = ::ident( cur, end, type );
+    return ::obname( cur, end, origin, copy, id );
+}
+
+std::vector< std::string > value_strings( const value& v ) {
+    std::vector< std::string > xs;
+    if( !v.present ) return xs;
+
+    const char* cur = v.bytes.first;
+    const auto idstr = [&cur] {
+        std::int32_t len;
+        const auto* end = dlis_ident( cur, &len, nullptr );
+        std::string s( end - len, end );
+        cur = end;
+        return s;
+    };
+
+    /* uvaris are read with the padded reader, as for parsing */
+    const auto* last = v.bytes.last;
+    const auto asciistr = [&cur, last] {
+        std::int32_t len;
+        cur = uvari( cur, last, len );
+        std::string s( cur, cur + len );
+        cur += len;
+        return s;
+    };
+
+    const auto name = [&cur, last] {
+        std::int32_t origin;
+        std::uint8_t copy;
+        dl::span id;
+        cur = ::obname( cur, last, origin, copy, id );
+        return std::to_string( origin ) + ", "
+             + std::to_string( int( copy ) ) + ", "
+             + id.str();
+    };
+
+    char buffer[ 64 ];
+    const auto f = [&buffer]( double x ) -> std::string {
+        std::snprintf( buffer, sizeof( buffer ), "%.9g", x );
+        return buffer;
+    };
+    const auto d = [&buffer]( double x ) -> std::string {
+        std::snprintf( buffer, sizeof( buffer ), "%.17g", x );
+        return buffer;
+    };
+
+    for( int i = 0; i < v.count; ++i ) {
+        float  fa, fb, fc;
+        double da, db, dc;
+        std::int8_t   s8;
+        std::int16_t  s16;
+        std::int32_t  s32;
+        std::uint8_t  u8;
+        std::uint16_t u16;
+        std::uint32_t u32;
+
+        switch( v.reprc ) {
+            case DLIS_FSHORT:
+                cur = dlis_fshort( cur, &fa );
+                xs.push_back( f( fa ) );
+                break;
+            case DLIS_FSINGL:
+                cur = dlis_fsingl( cur, &fa );
+                xs.push_back( f( fa ) );
+                break;
+            case DLIS_ISINGL:
+                cur = dlis_isingl( cur, &fa );
+                xs.push_back( f( fa ) );
+                break;
+            case DLIS_VSINGL:
+                cur = dlis_vsingl( cur, &fa );
+                xs.push_back( f( fa ) );
+                break;
+            case DLIS_FSING1:
+                cur = dlis_fsing1( cur, &fa, &fb );
+                xs.push_back( "(" + f( fa ) + ", " + f( fb ) + ")" );
+                break;
+            case DLIS_FSING2:
+                cur = dlis_fsing2( cur, &fa, &fb, &fc );
+                xs.push_back( "(" + f( fa ) + ", " + f( fb ) + ", "
+                                  + f( fc ) + ")" );
+                break;
+            case DLIS_CSINGL:
+                cur = dlis_csingl( cur, &fa, &fb );
+                xs.push_back( "(" + f( fa ) + ", " + f( fb ) + ")" );
+                break;
+            case DLIS_FDOUBL:
+                cur = dlis_fdoubl( cur, &da );
+                xs.push_back( d( da ) );
+                break;
+            case DLIS_FDOUB1:
+                cur = dlis_fdoub1( cur, &da, &db );
+                xs.push_back( "(" + d( da ) + ", " + d( db ) + ")" );
+                break;
+            case DLIS_FDOUB2:
+                cur = dlis_fdoub2( cur, &da, &db, &dc );
+                xs.push_back( "(" + d( da ) + ", " + d( db ) + ", "
+                                  + d( dc ) + ")" );
+                break;
+            case DLIS_CDOUBL:
+                cur = dlis_cdoubl( cur, &da, &db );
+                xs.push_back( "(" + d( da ) + ", " + d( db ) + ")" );
+                break;
+            case DLIS_SSHORT:
+                cur = dlis_sshort( cur, &s8 );
+                xs.push_back( std::to_string( int( s8 ) ) );
+                break;
+            case DLIS_SNORM:
+                cur = dlis_snorm( cur, &s16 );
+                xs.push_back( std::to_string( s16 ) );
+                break;
+            case DLIS_SLONG:
+                cur = dlis_slong( cur, &s32 );
+                xs.push_back( std::to_string( s32 ) );
+                break;
+            case DLIS_USHORT:
+                cur = dlis_ushort( cur, &u8 );
+                xs.push_back( std::to_string( int( u8 ) ) );
+                break;
+            case DLIS_UNORM:
+                cur = dlis_unorm( cur, &u16 );
+                xs.push_back( std::to_string( u16 ) );
+                break;
+            case DLIS_ULONG:
+                cur = dlis_ulong( cur, &u32 );
+                xs.push_back( std::to_string( u32 ) );
+                break;
+            case DLIS_UVARI:
+            case DLIS_ORIGIN:
+                cur = uvari( cur, last, s32 );
+                xs.push_back( std::to_string( s32 ) );
+                break;
+            case DLIS_IDENT:
+            case DLIS_UNITS:
+                xs.push_back( idstr() );
+                break;
+            case DLIS_ASCII:
+                xs.push_back( asciistr() );
+                break;
+            case DLIS_DTIME: {
+                int Y, TZ, M, D, H, MN, S, MS;
+                cur = dlis_dtime( cur, &Y, &TZ, &M, &D, &H, &MN, &S, &MS );
+                std::snprintf( buffer, sizeof( buffer ),
+                               "%04d-%02d-%02dT%02d:%02d:%02d.%03d",
+                               dlis_year( Y ), M, D, H, MN, S, MS );
+                xs.push_back( buffer );
+                break;
+            }
+            case DLIS_STATUS:
+                cur = dlis_status( cur, &u8 );
+                xs.push_back( std::to_string( int( u8 ) ) );
+                break;
+            case DLIS_OBNAME:
+                xs.push_back( "(" + name() + ")" );
+                break;
+            case DLIS_OBJREF: {
+                const auto type = idstr();
+                xs.push_back( "(" + type + ", " + name() + ")" );
+                break;
+            }
+            case DLIS_ATTREF: {
+                const auto type = idstr();
+                const auto obj = name();
+                xs.push_back( "(" + type + ", " + obj + ", " + idstr() + ")" );
+                break;
+            }
+
+            default:
+                throw std::invalid_argument( "unknown representation code "
+                                           + std::to_string( v.reprc ) );
+        }
+    }
+
+    return xs;
+}
+
+}
@@ -0,0 +1,661 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dlisio/dlisio.h>
+#include <dlisio/types.h>
+#include <dlisio/ext/frame.hpp>
+#include <dlisio/ext/io.hpp>
+#include <dlisio/ext/readahead.hpp>
+#include <dlisio/ext/stats.hpp>
+
+#include "uvari.hpp"
+
+namespace {
+
+/*
+ * The bulk decoders take typed output pointers, and the columns are assumed
+ * suitably aligned for their type
+ */
+template< typename T >
+const char* values( const char* (*F)( const char*, size_t, size_t, T* ),
+                    const char* src,
+                    std::size_t size,
+                    std::size_t n,
+                    char* dst ) {
+    return F( src, size, n, reinterpret_cast< T* >( dst ) );
+}
+
+/*
+ * The first value of the first channel of the frame, as a number. Validated
+ * values are read by their value, and complex values are not numbers
+ */
+double index_value( const dl::record& rec, int reprc ) {
+    dl::obname name;
+    std::int32_t frameno;
+    const auto* cur = dl::iflr_header( rec.begin(), rec.end(), name, frameno );
+
+    const auto size = dl::sizeof_reprc( reprc );
+    if( size == 0 || reprc == DLIS_CSINGL || reprc == DLIS_CDOUBL ) {
+        throw std::invalid_argument( "representation code "
+                                   + std::to_string( reprc )
+                                   + " can not be used as an index" );
+    }
+
+    if( std::size_t( rec.end() - cur ) < size ) {
+        throw std::invalid_argument( "frame " + std::to_string( frameno )
+                                   + " is too short for its index" );
+    }
+
+    /* large and aligned enough for any single value, e.g. FDOUB2 */
+    double buffer[ 3 ];
+    auto* dst = reinterpret_cast< char* >( buffer );
+    dl::decode( cur, reprc, 1, dst );
+
+    switch( reprc ) {
+        case DLIS_FDOUBL:
+        case DLIS_FDOUB1:
+        case DLIS_FDOUB2: return buffer[ 0 ];
+        case DLIS_SSHORT: return *reinterpret_cast< std::int8_t*   >( dst );
+        case DLIS_SNORM:  return *reinterpret_cast< std::int16_t*  >( dst );
+        case DLIS_SLONG:  return *reinterpret_cast< std::int32_t*  >( dst );
+        case DLIS_USHORT:
+        case DLIS_STATUS: return *reinterpret_cast< std::uint8_t*  >( dst );
+        case DLIS_UNORM:  return *reinterpret_cast< std::uint16_t* >( dst );
+        case DLIS_ULONG:  return *reinterpret_cast< std::uint32_t* >( dst );
+        default:          return *reinterpret_cast< float* >( dst );
+    }
+}
+
+/*
+ * The word size of the representation codes that are decoded by byte
+ * swapping alone, i.e. IEEE floats and two's complement integers, and their
+ * validated and complex tuples, or 0 for representation codes that need a
+ * proper conversion
+ */
+std::size_t swap_word( int reprc ) noexcept {
+    switch( reprc ) {
+        case DLIS_SSHORT:
+        case DLIS_USHORT:
+        case DLIS_STATUS: return 1;
+        case DLIS_SNORM:
+        case DLIS_UNORM:  return 2;
+        case DLIS_FSINGL:
+        case DLIS_FSING1:
+        case DLIS_FSING2:
+        case DLIS_CSINGL:
+        case DLIS_SLONG:
+        case DLIS_ULONG:  return 4;
+        case DLIS_FDOUBL:
+        case DLIS_FDOUB1:
+        case DLIS_FDOUB2:
+        case DLIS_CDOUBL: return 8;
+        default:          return 0;
+    }
+}
+
+/*
+ * A big-endian word. Compilers recognise this as a load and a byte swap, and
+ * it works the same regardless of the host byte order
+ */
+template< typename W >
+W load_be( const char* src ) noexcept {
+    unsigned char bytes[ sizeof( W ) ];
+    std::memcpy( bytes, src, sizeof( W ) );
+
+    W x = 0;
+    for( std::size_t i = 0; i < sizeof( W ); ++i )
+        x = W( (std::uint64_t( x ) << 8) | bytes[ i ] );
+    return x;
+}
+
+/*
+ * Parse the IFLR header of the record, and check that the rest of it holds a
+ * frame of framesize bytes. Returns a pointer to the start of the frame.
+ */
+const char* frame_body( const dl::record& rec,
+                        std::size_t framesize,
+                        dl::obname& name,
+                        std::int32_t& frameno ) {
+    const auto* cur = dl::iflr_header( rec.begin(), rec.end(), name, frameno );
+
+    if( std::size_t( rec.end() - cur ) < framesize ) {
+        throw std::invalid_argument(
+            "frame " + std::to_string( frameno ) + " is "
+            + std::to_string( rec.end() - cur ) + " bytes, expected "
+            + std::to_string( framesize )
+        );
+    }
+
+    return cur;
+}
+
+/*
+ * The decoder for frames where all the selected channels have the same
+ * byte-swapped representation code, which covers the vast majority of files
+ * (all FSINGL or all FDOUBL). Values are words of W, and decoding a value is
+ * a swap and a store, with no dispatch on the representation code. Scalar
+ * means that every selected channel is a single word per frame, and the inner
+ * loop over the words of a channel goes away.
+ */
+template< typename W, bool Scalar >
+void swap_frames( const std::vector< dl::record >& fdata,
+                  std::size_t framesize,
+                  const std::vector< std::size_t >& offsets,
+                  const std::vector< std::size_t >& words,
+                  std::int32_t* numbers,
+                  char* const* columns ) {
+    constexpr auto size = sizeof( W );
+    const auto n = offsets.size();
+
+    dl::obname name;
+    for( std::size_t row = 0; row < fdata.size(); ++row ) {
+        const auto* cur = frame_body( fdata[ row ],
+                                      framesize,
+                                      name,
+                                      numbers[ row ] );
+
+        for( std::size_t k = 0; k < n; ++k ) {
+            const auto* src = cur + offsets[ k ];
+
+            if( Scalar ) {
+                const auto x = load_be< W >( src );
+                std::memcpy( columns[ k ] + row * size, &x, size );
+                continue;
+            }
+
+            auto* dst = columns[ k ] + row * words[ k ] * size;
+            for( std::size_t i = 0; i < words[ k ]; ++i ) {
+                const auto x = load_be< W >( src + i * size );
+                std::memcpy( dst + i * size, &x, size );
+            }
+        }
+    }
+}
+
+template< typename W >
+void swap_frames( const std::vector< dl::record >& fdata,
+                  std::size_t framesize,
+                  const std::vector< std::size_t >& offsets,
+                  const std::vector< std::size_t >& words,
+                  std::int32_t* numbers,
+                  char* const* columns ) {
+    const bool scalar = std::all_of( words.begin(), words.end(),
+        []( std::size_t x ) { return x == 1; }
+    );
+
+    if( scalar )
+        swap_frames< W, true >( fdata, framesize, offsets, words,
+                                numbers, columns );
+    else
+        swap_frames< W, false >( fdata, framesize, offsets, words,
+                                 numbers, columns );
+}
+
+/*
+ * The first position in [0, n) where pred is false, assuming pred is true for
+ * a (possibly empty) prefix, like std::partition_point
+ */
+template< typename Pred >
+std::size_t bisect( std::size_t n, Pred pred ) {
+    std::size_t first = 0;
+    while( n > 0 ) {
+        const auto half = n / 2;
+        if( pred( first + half ) ) {
+            first += half + 1;
+            n -= half + 1;
+        } else {
+            n = half;
+        }
+    }
+    return first;
+}
+
+}
+
+namespace dl {
+
+const char* iflr_header( const char* begin,
+                         const char* end,
+                         obname& name,
+                         std::int32_t& frameno ) {
+    const auto* cur = begin;
+    const auto short_header = [&] {
+        return std::invalid_argument( "unexpected end-of-record in "
+                                      "IFLR header" );
+    };
+
+    /*
+     * The name is decoded in one go when the 6 bytes dlis_obname_view reads
+     * ahead fit, and piece by piece near the end of the record
+     */
+    std::int32_t len;
+    const char* id = nullptr;
+    const char* next = nullptr;
+    if( end - cur >= 6 )
+        next = dlis_obname_view( cur, &name.origin, &name.copy, &len, &id );
+
+    if( next && next - cur <= end - cur ) {
+        name.id.assign( id, len );
+        cur = next;
+    } else {
+        if( cur >= end ) throw short_header();
+        cur = uvari( cur, end, name.origin );
+
+        if( end - cur < 2 ) throw short_header();
+        cur = dlis_ushort( cur, &name.copy );
+
+        dlis_ident( cur, &len, nullptr );
+        if( end - cur < len + 1 ) throw short_header();
+        name.id.resize( len );
+        cur = dlis_ident( cur, &len, &name.id[ 0 ] );
+    }
+
+    if( cur >= end ) throw short_header();
+    cur = uvari( cur, end, frameno );
+    if( cur > end ) throw short_header();
+
+    return cur;
+}
+
+std::size_t sizeof_reprc( int reprc ) noexcept {
+    switch( reprc ) {
+        case DLIS_FSHORT: return 2;
+        case DLIS_FSINGL: return 4;
+        case DLIS_FSING1: return 8;
+        case DLIS_FSING2: return 12;
+        case DLIS_ISINGL: return 4;
+        case DLIS_VSINGL: return 4;
+        case DLIS_FDOUBL: return 8;
+        case DLIS_FDOUB1: return 16;
+        case DLIS_FDOUB2: return 24;
+        case DLIS_CSINGL: return 8;
+        case DLIS_CDOUBL: return 16;
+        case DLIS_SSHORT: return 1;
+        case DLIS_SNORM:  return 2;
+        case DLIS_SLONG:  return 4;
+        case DLIS_USHORT: return 1;
+        case DLIS_UNORM:  return 2;
+        case DLIS_ULONG:  return 4;
+        case DLIS_STATUS: return 1;
+        default:          return 0;
+    }
+}
+
+std::size_t sizeof_native( int reprc ) noexcept {
+    switch( reprc ) {
+        case DLIS_FSHORT: return sizeof( float );
+        case DLIS_FSINGL: return sizeof( float );
+        case DLIS_FSING1: return sizeof( float ) * 2;
+        case DLIS_FSING2: return sizeof( float ) * 3;
+        case DLIS_ISINGL: return sizeof( float );
+        case DLIS_VSINGL: return sizeof( float );
+        case DLIS_FDOUBL: return sizeof( double );
+        case DLIS_FDOUB1: return sizeof( double ) * 2;
+        case DLIS_FDOUB2: return sizeof( double ) * 3;
+        case DLIS_CSINGL: return sizeof( float ) * 2;
+        case DLIS_CDOUBL: return sizeof( double ) * 2;
+        case DLIS_SSHORT: return sizeof( std::int8_t );
+        case DLIS_SNORM:  return sizeof( std::int16_t );
+        case DLIS_SLONG:  return sizeof( std::int32_t );
+        case DLIS_USHORT: return sizeof( std::uint8_t );
+        case DLIS_UNORM:  return sizeof( std::uint16_t );
+        case DLIS_ULONG:  return sizeof( std::uint32_t );
+        case DLIS_STATUS: return sizeof( std::uint8_t );
+        default:          return 0;
+    }
+}
+
+const char* decode( const char* src, int reprc, std::size_t n, char* dst ) {
+    const auto size = sizeof_reprc( reprc );
+    switch( reprc ) {
+        case DLIS_FSHORT: return values( dlis_fshort_n, src, size, n, dst );
+        case DLIS_FSINGL: return values( dlis_fsingl_n, src, size, n, dst );
+        case DLIS_FSING1: return values( dlis_fsing1_n, src, size, n, dst );
+        case DLIS_FSING2: return values( dlis_fsing2_n, src, size, n, dst );
+        case DLIS_ISINGL: return values( dlis_isingl_n, src, size, n, dst );
+        case DLIS_VSINGL: return values( dlis_vsingl_n, src, size, n, dst );
+        case DLIS_FDOUBL: return values( dlis_fdoubl_n, src, size, n, dst );
+        case DLIS_FDOUB1: return values( dlis_fdoub1_n, src, size, n, dst );
+        case DLIS_FDOUB2: return values( dlis_fdoub2_n, src, size, n, dst );
+        case DLIS_CSINGL: return values( dlis_csingl_n, src, size, n, dst );
+        case DLIS_CDOUBL: return values( dlis_cdoubl_n, src, size, n, dst );
+        case DLIS_SSHORT: return values( dlis_sshort_n, src, size, n, dst );
+        case DLIS_SNORM:  return values( dlis_snorm_n,  src, size, n, dst );
+        case DLIS_SLONG:  return values( dlis_slong_n,  src, size, n, dst );
+        case DLIS_USHORT: return values( dlis_ushort_n, src, size, n, dst );
+        case DLIS_UNORM:  return values( dlis_unorm_n,  src, size, n, dst );
+        case DLIS_ULONG:  return values( dlis_ulong_n,  src, size, n, dst );
+        case DLIS_STATUS: return values( dlis_status_n, src, size, n, dst );
+
+        default:
+            throw std::invalid_argument( "representation code "
+                                       + std::to_string( reprc )
+                                       + " can not be decoded into a column" );
+    }
+}
+
+std::vector< record > fdata( stream& fp,
+                             const std::vector< bookmark >& marks,
+                             const obname& frame,
+                             const warning_handler& warn ) {
+    timer t( fp.count.read_ns );
+    std::vector< record > recs;
+
+    obname name;
+    std::int32_t frameno;
+    for( const auto& mark : marks ) {
+        /* FDATA are indirectly formatted records of type 0 */
+        if( mark.isexplicit || mark.isencrypted || mark.type != 0 ) continue;
+
+        fp.setpos( mark );
+        auto rec = catrecord( fp, mark.residual, warn );
+        iflr_header( rec.begin(), rec.end(), name, frameno );
+        if( name != frame ) continue;
+
+        recs.push_back( std::move( rec ) );
+    }
+
+    return recs;
+}
+
+std::vector< fdata_index > index_fdata( stream& fp,
+                                        const std::vector< bookmark >& marks,
+                                        const warning_handler& warn ) {
+    /*
+     * The longest possible IFLR header: origin (uvari), copy, identifier,
+     * and frame number (uvari)
+     */
+    constexpr std::size_t maxheader = 4 + 1 + 1 + 255 + 4;
+    timer t( fp.count.read_ns );
+
+    std::vector< fdata_index > frames;
+
+    obname name;
+    std::int32_t frameno;
+    for( std::size_t i = 0; i < marks.size(); ++i ) {
+        const auto& mark = marks[ i ];
+        if( mark.isexplicit || mark.isencrypted || mark.type != 0 ) continue;
+
+        fp.setpos( mark );
+        const auto rec = catprefix( fp, mark.residual, maxheader, warn );
+        iflr_header( rec.begin(), rec.end(), name, frameno );
+
+        /* there are only a handful of frames, so a linear search will do */
+        auto itr = std::find_if( frames.begin(), frames.end(),
+            [&name]( const fdata_index& x ) { return x.frame == name; }
+        );
+
+        if( itr == frames.end() ) {
+            frames.emplace_back();
+            frames.back().frame = name;
+            itr = frames.end() - 1;
+        }
+
+        auto& entries = itr->entries;
+        if( !entries.empty() && entries.back().frameno > frameno )
+            itr->ascending = false;
+        entries.push_back( { frameno, i } );
+    }
+
+    return frames;
+}
+
+std::pair< std::size_t, std::size_t >
+frame_range( const fdata_index& index, std::int32_t first, std::int32_t last ) {
+    const auto& entries = index.entries;
+
+    if( index.ascending ) {
+        const auto begin = bisect( entries.size(), [&]( std::size_t i ) {
+            return entries[ i ].frameno < first;
+        });
+        const auto end = bisect( entries.size(), [&]( std::size_t i ) {
+            return entries[ i ].frameno <= last;
+        });
+        return { begin, std::max( begin, end ) };
+    }
+
+    throw std::invalid_argument( "frame numbers of " + index.frame.id
+                               + " are out of order, and can't be a range" );
+}
+
+std::size_t find_frame( const fdata_index& index, std::int32_t frameno ) {
+    if( index.ascending ) {
+        const auto range = frame_range( index, frameno, frameno );
+        if( range.first == range.second ) return index.entries.size();
+        return range.first;
+    }
+
+    const auto& entries = index.entries;
+    const auto itr = std::find_if( entries.begin(), entries.end(),
+        [frameno]( const fdata_entry& x ) { return x.frameno == frameno; }
+    );
+    return std::size_t( itr - entries.begin() );
+}
+
+std::pair< std::size_t, std::size_t >
+index_range( stream& fp,
+             const std::vector< bookmark >& marks,
+             const fdata_index& index,
+             int reprc,
+             double lo,
+             double hi,
+             const warning_handler& warn ) {
+    const auto& entries = index.entries;
+    const auto n = entries.size();
+    if( n == 0 ) return { 0, 0 };
+    timer t( fp.count.read_ns );
+
+    const auto value = [&]( std::size_t i ) {
+        const auto& mark = marks.at( entries[ i ].mark );
+        fp.setpos( mark );
+        return index_value( catrecord( fp, mark.residual, warn ), reprc );
+    };
+
+    const bool increasing = value( 0 ) <= value( n - 1 );
+
+    std::size_t begin, end;
+    if( increasing ) {
+        begin = bisect( n, [&]( std::size_t i ) { return value( i ) <  lo; } );
+        end   = bisect( n, [&]( std::size_t i ) { return value( i ) <= hi; } );
+    } else {
+        begin = bisect( n, [&]( std::size_t i ) { return value( i ) >  hi; } );
+        end   = bisect( n, [&]( std::size_t i ) { return value( i ) >= lo; } );
+    }
+
+    return { begin, std::max( begin, end ) };
+}
+
+std::vector< record > fdata( stream& fp,
+                             const std::vector< bookmark >& marks,
+                             const fdata_index& index,
+                             std::size_t begin,
+                             std::size_t end,
+                             const warning_handler& warn ) {
+    if( begin > end || end > index.entries.size() )
+        throw std::invalid_argument( "fdata range out of bounds" );
+
+    std::vector< bookmark > selected;
+    selected.reserve( end - begin );
+    for( auto i = begin; i < end; ++i )
+        selected.push_back( marks.at( index.entries[ i ].mark ) );
+
+    return catrecords( fp, selected, warn );
+}
+
+void decode_frames( const std::vector< record >& fdata,
+                    const std::vector< channel_layout >& channels,
+                    std::int32_t* numbers,
+                    char* const* columns ) {
+    std::vector< std::size_t > all( channels.size() );
+    for( std::size_t i = 0; i < all.size(); ++i ) all[ i ] = i;
+    decode_frames( fdata, channels, all, numbers, columns );
+}
+
+void decode_frames( const std::vector< record >& fdata,
+                    const std::vector< channel_layout >& channels,
+                    const std::vector< std::size_t >& selection,
+                    std::int32_t* numbers,
+                    char* const* columns ) {
+    std::size_t framesize = 0;
+    std::vector< std::size_t > offsets;
+    offsets.reserve( channels.size() );
+
+    for( const auto& ch : channels ) {
+        const auto size = sizeof_reprc( ch.reprc );
+        if( size == 0 ) {
+            throw std::invalid_argument( "representation code "
+                                       + std::to_string( ch.reprc )
+                                       + " can not be decoded into a column" );
+        }
+
+        offsets.push_back( framesize );
+        framesize += size * ch.count;
+    }
+
+    std::vector< std::size_t > rowsize;
+    rowsize.reserve( selection.size() );
+    for( const auto i : selection ) {
+        if( i >= channels.size() )
+            throw std::invalid_argument( "selected channel out of range" );
+
+        const auto& ch = channels[ i ];
+        rowsize.push_back( sizeof_native( ch.reprc ) * ch.count );
+    }
+
+    /*
+     * Homogeneous layouts of byte-swapped values go to the specialised
+     * decoders, and everything else to the generic one, which dispatches on
+     * the representation code for every channel in every frame
+     */
+    const auto word = selection.empty()
+                    ? 0
+                    : swap_word( channels[ selection.front() ].reprc );
+    const bool homogeneous = word != 0
+        && std::all_of( selection.begin(), selection.end(),
+            [&]( std::size_t i ) {
+                return channels[ i ].reprc
+                    == channels[ selection.front() ].reprc;
+            }
+        );
+
+    if( homogeneous ) {
+        std::vector< std::size_t > offs;
+        std::vector< std::size_t > words;
+        for( const auto i : selection ) {
+            const auto& ch = channels[ i ];
+            offs.push_back( offsets[ i ] );
+            words.push_back( ch.count * sizeof_reprc( ch.reprc ) / word );
+        }
+
+        switch( word ) {
+            case 1:
+                swap_frames< std::uint8_t >( fdata, framesize, offs, words,
+                                             numbers, columns );
+                return;
+            case 2:
+                swap_frames< std::uint16_t >( fdata, framesize, offs, words,
+                                              numbers, columns );
+                return;
+            case 4:
+                swap_frames< std::uint32_t >( fdata, framesize, offs, words,
+                                              numbers, columns );
+                return;
+            default:
+                swap_frames< std::uint64_t >( fdata, framesize, offs, words,
+                                              numbers, columns );
+                return;
+        }
+    }
+
+    obname name;
+    for( std::size_t row = 0; row < fdata.size(); ++row ) {
+        const auto* cur = frame_body( fdata[ row ],
+                                      framesize,
+                                      name,
+                                      numbers[ row ] );
+
+        for( std::size_t k = 0; k < selection.size(); ++k ) {
+            const auto& ch = channels[ selection[ k ] ];
+            auto* dst = columns[ k ] + row * rowsize[ k ];
+            decode( cur + offsets[ selection[ k ] ], ch.reprc, ch.count, dst );
+        }
+    }
+}
+
+void decode_batches( stream& fp,
+                     const std::vector< bookmark >& marks,
+                     const fdata_index& index,
+                     std::size_t begin,
+                     std::size_t end,
+                     const std::vector< channel_layout >& channels,
+                     const std::vector< std::size_t >& selection,
+                     std::size_t rows,
+                     const batch_handler& handler,
+                     const warning_handler& warn,
+                     std::size_t depth ) {
+    if( rows == 0 ) throw std::invalid_argument( "batch size must be > 0" );
+    if( begin > end || end > index.entries.size() )
+        throw std::invalid_argument( "fdata range out of bounds" );
+
+    std::unique_ptr< readahead > ahead;
+    if( depth > 0 ) {
+        std::vector< bookmark > selected;
+        selected.reserve( end - begin );
+        for( auto i = begin; i < end; ++i )
+            selected.push_back( marks.at( index.entries[ i ].mark ) );
+
+        ahead.reset( new readahead( fp, std::move( selected ), depth, 1,
+                                    warn ) );
+    }
+
+    std::vector< std::size_t > rowsize;
+    for( const auto i : selection ) {
+        if( i >= channels.size() )
+            throw std::invalid_argument( "selected channel out of range" );
+
+        const auto& ch = channels[ i ];
+        rowsize.push_back( sizeof_native( ch.reprc ) * ch.count );
+    }
+
+    frame_batch batch;
+    batch.columns.resize( selection.size() );
+    std::vector< char* > dsts( selection.size() );
+
+    std::vector< record > recs;
+    for( auto first = begin; first < end; first += rows ) {
+        const auto last = std::min( end, first + rows );
+        if( ahead ) {
+            recs.clear();
+            while( begin + ahead->taken() < last )
+                recs.push_back( ahead->next() );
+        } else {
+            recs = fdata( fp, marks, index, first, last, warn );
+        }
+
+        batch.first = first;
+        batch.numbers.resize( recs.size() );
+        for( std::size_t k = 0; k < selection.size(); ++k ) {
+            batch.columns[ k ].resize( recs.size() * rowsize[ k ] );
+            dsts[ k ] = batch.columns[ k ].data();
+        }
+
+        {
+            timer t( fp.count.decode_ns );
+            decode_frames( recs,
+                           channels,
+                           selection,
+                           batch.numbers.data(),
+                           dsts.data() );
+            fp.count.frames += recs.size();
+        }
+        handler( batch );
+    }
+}
+
+}
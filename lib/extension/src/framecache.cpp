@@ -0,0 +1,768 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dlisio/dlisio.h>
+#include <dlisio/ext/cache.hpp>
+#include <dlisio/ext/frame.hpp>
+#include <dlisio/ext/framecache.hpp>
+#include <dlisio/ext/io.hpp>
+#include <dlisio/ext/stats.hpp>
+
+namespace {
+
+/*
+ * The frame cache layout, all integers little-endian:
+ *
+ *  magic       8   "DLISFRM\0"
+ *  version     4
+ *  order       4   0x01020304, in the byte order of the values
+ *  channels    4
+ *  rows        4   (most) frames per chunk
+ *  frames      8
+ *  chunks      8
+ *  flags       4   (1 = frame numbers ascending, 2 = index values are set)
+ *  reserved    4
+ *  table       8   offset of the chunk table
+ *  channels:
+ *      reprc       4
+ *      ndims       4
+ *      dims        ndims * 8
+ *  the chunk data
+ *  chunk table, chunks * (32 + (1 + channels) * 24):
+ *      rows        4
+ *      reserved    4
+ *      first       4   frame number of the first frame
+ *      last        4   frame number of the last frame
+ *      lo          8   index value of the first frame, as a double
+ *      hi          8   index value of the last frame, as a double
+ *                      (the index is the first value of the first channel)
+ *      columns, the frame numbers and then every channel:
+ *          offset  8
+ *          stored  8   size in the file
+ *          codec   4
+ *          reserved 4
+ */
+const char magic[ 8 ] = { 'D', 'L', 'I', 'S', 'F', 'R', 'M', '\0' };
+const std::uint32_t version = 1;
+const std::uint32_t order = 0x01020304;
+
+constexpr std::size_t header_size = 8 + 4 + 4 + 4 + 4 + 8 + 8 + 4 + 4 + 8;
+constexpr std::size_t chunk_size  = 32;
+constexpr std::size_t column_size = 24;
+
+constexpr std::uint32_t ascending_flag = 1;
+constexpr std::uint32_t indexed_flag   = 2;
+
+/*
+ * Columns are either stored as they are, or filtered and run-length encoded,
+ * whichever is smaller
+ */
+constexpr std::uint32_t raw    = 0;
+constexpr std::uint32_t packed = 1;
+
+struct fcloser {
+    void operator()( std::FILE* x ) {
+        if( x ) std::fclose( x );
+    }
+};
+
+using ufile = std::unique_ptr< std::FILE, fcloser >;
+
+void put( std::string& out, std::uint64_t x, int n ) {
+    for( int i = 0; i < n; ++i )
+        out.push_back( char( (x >> (8 * i)) & 0xFF ) );
+}
+
+std::uint64_t get( const char* xs, int n ) {
+    std::uint64_t x = 0;
+    for( int i = 0; i < n; ++i ) {
+        const auto byte = static_cast< unsigned char >( xs[ i ] );
+        x |= std::uint64_t( byte ) << (8 * i);
+    }
+    return x;
+}
+
+void putdouble( std::string& out, double x ) {
+    std::uint64_t bits;
+    std::memcpy( &bits, &x, sizeof( bits ) );
+    put( out, bits, 8 );
+}
+
+double getdouble( const char* xs ) {
+    const auto bits = get( xs, 8 );
+    double x;
+    std::memcpy( &x, &bits, sizeof( x ) );
+    return x;
+}
+
+void write( std::FILE* fp, const std::string& xs ) {
+    const auto n = std::fwrite( xs.data(), 1, xs.size(), fp );
+    if( n != xs.size() ) throw dl::io_error( errno );
+}
+
+/*
+ * The size of the scalars the values of the representation code are made
+ * of, e.g. 4 for the (V, A) floats of FSING1
+ */
+std::size_t scalar_size( int reprc ) noexcept {
+    switch( reprc ) {
+        case DLIS_FDOUBL:
+        case DLIS_FDOUB1:
+        case DLIS_FDOUB2:
+        case DLIS_CDOUBL: return 8;
+        default:          return std::min< std::size_t >(
+                                     4, dl::sizeof_native( reprc ) );
+    }
+}
+
+/*
+ * The decoded value as a double, for the index bounds. Complex values can't
+ * be an index, and validated values are indexed by their value V
+ */
+bool numeric( int reprc ) noexcept {
+    return dl::sizeof_native( reprc ) != 0
+        && reprc != DLIS_CSINGL
+        && reprc != DLIS_CDOUBL;
+}
+
+template< typename T >
+double as( const char* xs ) noexcept {
+    T x;
+    std::memcpy( &x, xs, sizeof( x ) );
+    return double( x );
+}
+
+double scalar( const char* xs, int reprc ) noexcept {
+    switch( reprc ) {
+        case DLIS_FDOUBL:
+        case DLIS_FDOUB1:
+        case DLIS_FDOUB2: return as< double >( xs );
+        case DLIS_SSHORT: return as< std::int8_t >( xs );
+        case DLIS_SNORM:  return as< std::int16_t >( xs );
+        case DLIS_SLONG:  return as< std::int32_t >( xs );
+        case DLIS_USHORT: return as< std::uint8_t >( xs );
+        case DLIS_UNORM:  return as< std::uint16_t >( xs );
+        case DLIS_ULONG:  return as< std::uint32_t >( xs );
+        case DLIS_STATUS: return as< std::uint8_t >( xs );
+        default:          return as< float >( xs );
+    }
+}
+
+/*
+ * The filters. Every scalar is replaced by its difference from the same
+ * scalar in the previous frame, stride scalars back, as an unsigned integer.
+ * The differences are small for smooth curves, and constant for regularly
+ * sampled indices. The bytes are then shuffled, so that byte i of all the
+ * scalars come together, and the high bytes, which barely change, make long
+ * runs for the run-length encoding.
+ */
+template< typename T >
+void delta( const char* src, char* dst, std::size_t n, std::size_t stride ) {
+    for( std::size_t i = 0; i < n; ++i ) {
+        T cur;
+        T prev = 0;
+        std::memcpy( &cur, src + i * sizeof( T ), sizeof( T ) );
+        if( i >= stride )
+            std::memcpy( &prev, src + (i - stride) * sizeof( T ), sizeof( T ) );
+        cur = T( cur - prev );
+        std::memcpy( dst + i * sizeof( T ), &cur, sizeof( T ) );
+    }
+}
+
+template< typename T >
+void undelta( char* xs, std::size_t n, std::size_t stride ) {
+    for( std::size_t i = stride; i < n; ++i ) {
+        T cur;
+        T prev;
+        std::memcpy( &cur,  xs + i * sizeof( T ), sizeof( T ) );
+        std::memcpy( &prev, xs + (i - stride) * sizeof( T ), sizeof( T ) );
+        cur = T( cur + prev );
+        std::memcpy( xs + i * sizeof( T ), &cur, sizeof( T ) );
+    }
+}
+
+void delta( std::size_t width,
+            const char* src,
+            char* dst,
+            std::size_t n,
+            std::size_t stride ) {
+    switch( width ) {
+        case 1: return delta< std::uint8_t  >( src, dst, n, stride );
+        case 2: return delta< std::uint16_t >( src, dst, n, stride );
+        case 4: return delta< std::uint32_t >( src, dst, n, stride );
+        case 8: return delta< std::uint64_t >( src, dst, n, stride );
+    }
+}
+
+void undelta( std::size_t width, char* xs, std::size_t n, std::size_t stride ) {
+    switch( width ) {
+        case 1: return undelta< std::uint8_t  >( xs, n, stride );
+        case 2: return undelta< std::uint16_t >( xs, n, stride );
+        case 4: return undelta< std::uint32_t >( xs, n, stride );
+        case 8: return undelta< std::uint64_t >( xs, n, stride );
+    }
+}
+
+void shuffle( const char* src, char* dst, std::size_t n, std::size_t width ) {
+    for( std::size_t i = 0; i < n; ++i )
+        for( std::size_t b = 0; b < width; ++b )
+            dst[ b * n + i ] = src[ i * width + b ];
+}
+
+void unshuffle( const char* src, char* dst, std::size_t n, std::size_t width ) {
+    for( std::size_t i = 0; i < n; ++i )
+        for( std::size_t b = 0; b < width; ++b )
+            dst[ i * width + b ] = src[ b * n + i ];
+}
+
+/*
+ * Run-length encoding, PackBits style: a control byte c < 128 is followed by
+ * c + 1 literal bytes, and c >= 128 by one byte, repeated c - 125 times
+ */
+void rle( const char* xs, std::size_t n, std::string& out ) {
+    constexpr std::size_t maxliteral = 128;
+    constexpr std::size_t minrun = 3;
+    constexpr std::size_t maxrun = 130;
+
+    std::size_t literals = 0;
+    const auto flush = [&]( std::size_t end ) {
+        auto start = end - literals;
+        while( start < end ) {
+            const auto k = std::min( maxliteral, end - start );
+            out.push_back( char( k - 1 ) );
+            out.append( xs + start, k );
+            start += k;
+        }
+        literals = 0;
+    };
+
+    std::size_t i = 0;
+    while( i < n ) {
+        std::size_t run = 1;
+        while( i + run < n && run < maxrun && xs[ i + run ] == xs[ i ] )
+            ++run;
+
+        if( run >= minrun ) {
+            flush( i );
+            out.push_back( char( 128 + run - minrun ) );
+            out.push_back( xs[ i ] );
+        } else {
+            literals += run;
+        }
+        i += run;
+    }
+    flush( n );
+}
+
+/*
+ * Decode exactly size bytes, or return false if the input is malformed
+ */
+bool unrle( const char* xs, std::size_t n, char* dst, std::size_t size ) {
+    std::size_t i = 0;
+    std::size_t out = 0;
+    while( i < n ) {
+        const auto c = std::size_t( static_cast< unsigned char >( xs[ i++ ] ) );
+        if( c < 128 ) {
+            const auto k = c + 1;
+            if( i + k > n || out + k > size ) return false;
+            std::memcpy( dst + out, xs + i, k );
+            i += k;
+            out += k;
+        } else {
+            const auto k = c - 125;
+            if( i >= n || out + k > size ) return false;
+            std::memset( dst + out, xs[ i++ ], k );
+            out += k;
+        }
+    }
+    return out == size;
+}
+
+/*
+ * Filter and encode the n scalars of width bytes, or keep them as they are,
+ * if that's smaller
+ */
+std::string pack( const char* xs,
+                  std::size_t n,
+                  std::size_t width,
+                  std::size_t stride,
+                  std::uint32_t& codec ) {
+    const auto size = n * width;
+    std::vector< char > filtered( size );
+    std::vector< char > planes( size );
+    delta( width, xs, filtered.data(), n, stride );
+    shuffle( filtered.data(), planes.data(), n, width );
+
+    std::string out;
+    out.reserve( size / 2 );
+    rle( planes.data(), size, out );
+    if( out.size() < size ) {
+        codec = packed;
+        return out;
+    }
+
+    codec = raw;
+    return std::string( xs, size );
+}
+
+bool ge( double x, double y ) { return x >= y; }
+bool gt( double x, double y ) { return x >  y; }
+bool le( double x, double y ) { return x <= y; }
+bool lt( double x, double y ) { return x <  y; }
+
+}
+
+namespace dl {
+
+void write_framecache( const std::string& path,
+                       stream& fp,
+                       const std::vector< bookmark >& marks,
+                       const fdata_index& index,
+                       std::size_t begin,
+                       std::size_t end,
+                       const std::vector< channel_layout >& channels,
+                       const std::vector< std::vector< std::size_t > >& dims,
+                       std::size_t rows,
+                       const warning_handler& warn ) {
+    if( rows == 0 || rows > 0xFFFFFFFF )
+        throw std::invalid_argument( "rows per chunk must be in [1, 2^32)" );
+
+    if( !dims.empty() && dims.size() != channels.size() )
+        throw std::invalid_argument( "dims and channels must be the same "
+                                     "length" );
+
+    std::string meta( header_size, '\0' );
+    for( std::size_t i = 0; i < channels.size(); ++i ) {
+        const auto& ch = channels[ i ];
+        if( sizeof_native( ch.reprc ) == 0 )
+            throw std::invalid_argument( "representation code "
+                                       + std::to_string( ch.reprc )
+                                       + " can not be cached" );
+
+        const std::vector< std::size_t > shape = dims.empty()
+            ? std::vector< std::size_t >{ ch.count }
+            : dims[ i ];
+
+        std::size_t count = 1;
+        for( const auto dim : shape ) count *= dim;
+        if( count != ch.count )
+            throw std::invalid_argument( "dims don't match the channel count" );
+
+        put( meta, std::uint32_t( ch.reprc ), 4 );
+        put( meta, shape.size(), 4 );
+        for( const auto dim : shape ) put( meta, dim, 8 );
+    }
+
+    std::vector< std::size_t > all( channels.size() );
+    std::vector< std::size_t > rowsize( channels.size() );
+    for( std::size_t i = 0; i < all.size(); ++i ) {
+        all[ i ] = i;
+        rowsize[ i ] = sizeof_native( channels[ i ].reprc )
+                     * channels[ i ].count;
+    }
+
+    const bool indexed = !channels.empty()
+                      && channels.front().count > 0
+                      && numeric( channels.front().reprc );
+
+    const auto tmp = tempname( path );
+    ufile out( std::fopen( tmp.c_str(), "wb" ) );
+    if( !out ) throw io_error( errno );
+
+    try {
+        write( out.get(), meta );
+        long long offset = meta.size();
+
+        std::string table;
+        std::size_t chunks = 0;
+        std::size_t frames = 0;
+        bool ascending = true;
+        std::int32_t lastno = 0;
+
+        const auto column = [&]( const char* xs,
+                                 std::size_t n,
+                                 std::size_t width,
+                                 std::size_t stride ) {
+            std::uint32_t codec;
+            const auto stored = pack( xs, n, width, stride, codec );
+            write( out.get(), stored );
+            put( table, offset, 8 );
+            put( table, stored.size(), 8 );
+            put( table, codec, 4 );
+            put( table, 0, 4 );
+            offset += stored.size();
+        };
+
+        decode_batches( fp, marks, index, begin, end, channels, all, rows,
+            [&]( const frame_batch& batch ) {
+                const auto n = batch.size();
+                const auto& numbers = batch.numbers;
+                for( const auto no : numbers ) {
+                    if( frames > 0 && no < lastno ) ascending = false;
+                    lastno = no;
+                    ++frames;
+                }
+
+                double lo = 0;
+                double hi = 0;
+                if( indexed ) {
+                    const auto& xs = batch.columns.front();
+                    const auto reprc = channels.front().reprc;
+                    lo = scalar( xs.data(), reprc );
+                    hi = scalar( xs.data() + (n - 1) * rowsize.front(),
+                                 reprc );
+                }
+
+                put( table, n, 4 );
+                put( table, 0, 4 );
+                put( table, std::uint32_t( numbers.front() ), 4 );
+                put( table, std::uint32_t( numbers.back() ), 4 );
+                putdouble( table, lo );
+                putdouble( table, hi );
+
+                column( reinterpret_cast< const char* >( numbers.data() ),
+                        n, sizeof( std::int32_t ), 1 );
+
+                for( std::size_t i = 0; i < channels.size(); ++i ) {
+                    const auto width = scalar_size( channels[ i ].reprc );
+                    const auto stride = rowsize[ i ] / width;
+                    column( batch.columns[ i ].data(), n * stride, width,
+                            stride );
+                }
+                ++chunks;
+            },
+            warn
+        );
+
+        write( out.get(), table );
+
+        std::uint32_t flags = 0;
+        if( ascending ) flags |= ascending_flag;
+        if( indexed )   flags |= indexed_flag;
+
+        std::string header( magic, sizeof( magic ) );
+        put( header, version, 4 );
+        char mark[ 4 ];
+        std::memcpy( mark, &order, sizeof( mark ) );
+        header.append( mark, sizeof( mark ) );
+        put( header, channels.size(), 4 );
+        put( header, rows, 4 );
+        put( header, frames, 8 );
+        put( header, chunks, 8 );
+        put( header, flags, 4 );
+        put( header, 0, 4 );
+        put( header, offset, 8 );
+
+        if( std::fseek( out.get(), 0, SEEK_SET ) ) throw io_error( errno );
+        write( out.get(), header );
+
+        if( std::fclose( out.release() ) ) throw io_error( errno );
+    } catch( ... ) {
+        out.reset();
+        std::remove( tmp.c_str() );
+        throw;
+    }
+
+#ifdef _WIN32
+    /* rename does not replace existing files on Windows */
+    std::remove( path.c_str() );
+#endif
+
+    if( std::rename( tmp.c_str(), path.c_str() ) ) {
+        const auto err = errno;
+        std::remove( tmp.c_str() );
+        throw io_error( err );
+    }
+}
+
+framecache::framecache( const std::string& path ) : fp( dl::open( path ) ) {
+    try {
+        char header[ header_size ];
+        this->fp->read( header, sizeof( header ) );
+
+        if( std::memcmp( header, magic, sizeof( magic ) ) )
+            throw std::invalid_argument( "not a frame cache" );
+        if( get( header + 8, 4 ) != version )
+            throw std::invalid_argument( "unsupported frame cache version" );
+
+        std::uint32_t mark;
+        std::memcpy( &mark, header + 12, sizeof( mark ) );
+        if( mark != order )
+            throw std::invalid_argument( "frame cache is of another byte "
+                                         "order" );
+
+        const auto channels = get( header + 16, 4 );
+        const auto rows     = get( header + 20, 4 );
+        const auto frames   = get( header + 24, 8 );
+        const auto chunks   = get( header + 32, 8 );
+        const auto flags    = get( header + 40, 4 );
+        const auto offset   = get( header + 48, 8 );
+
+        if( chunks > frames || (frames > 0 && rows == 0) )
+            throw std::invalid_argument( "malformed frame cache header" );
+
+        this->frames = frames;
+        this->ascending = flags & ascending_flag;
+        this->indexed = flags & indexed_flag;
+
+        long long data = header_size;
+        for( std::uint64_t i = 0; i < channels; ++i ) {
+            char xs[ 8 ];
+            this->fp->read( xs, 8 );
+            const auto reprc = int( get( xs, 4 ) );
+            const auto ndims = get( xs + 4, 4 );
+            if( sizeof_native( reprc ) == 0 || ndims > 64 )
+                throw std::invalid_argument( "malformed frame cache channel" );
+
+            std::vector< std::size_t > dims;
+            std::size_t count = 1;
+            for( std::uint64_t k = 0; k < ndims; ++k ) {
+                this->fp->read( xs, 8 );
+                dims.push_back( get( xs, 8 ) );
+                count *= dims.back();
+            }
+
+            this->layout.push_back( { reprc, count } );
+            this->shape.push_back( std::move( dims ) );
+            data += 8 + ndims * 8;
+        }
+
+        if( offset < std::uint64_t( data ) )
+            throw std::invalid_argument( "malformed frame cache header" );
+
+        bookmark at;
+        at.tell = offset;
+        this->fp->setpos( at );
+
+        const auto columns = 1 + this->layout.size();
+        std::vector< char > entry( chunk_size + columns * column_size );
+        std::size_t first = 0;
+        for( std::uint64_t i = 0; i < chunks; ++i ) {
+            this->fp->read( entry.data(), entry.size() );
+
+            chunk c;
+            c.first   = first;
+            c.rows    = get( entry.data(), 4 );
+            c.firstno = std::int32_t( get( entry.data() +  8, 4 ) );
+            c.lastno  = std::int32_t( get( entry.data() + 12, 4 ) );
+            c.lo      = getdouble( entry.data() + 16 );
+            c.hi      = getdouble( entry.data() + 24 );
+            if( c.rows == 0 || c.rows > rows )
+                throw std::invalid_argument( "malformed frame cache chunk" );
+
+            const char* xs = entry.data() + chunk_size;
+            for( std::size_t k = 0; k < columns; ++k ) {
+                column col;
+                col.offset = get( xs, 8 );
+                col.stored = get( xs + 8, 8 );
+                col.codec  = get( xs + 16, 4 );
+                if( col.offset < data
+                 || col.stored > offset
+                 || std::uint64_t( col.offset ) > offset - col.stored )
+                    throw std::invalid_argument( "malformed frame cache "
+                                                 "chunk" );
+                c.columns.push_back( col );
+                xs += column_size;
+            }
+
+            first += c.rows;
+            this->table.push_back( std::move( c ) );
+        }
+
+        if( first != frames )
+            throw std::invalid_argument( "malformed frame cache chunk table" );
+    } catch( const eof_error& ) {
+        throw std::invalid_argument( "frame cache is truncated" );
+    }
+}
+
+std::size_t framecache::size() const noexcept {
+    return this->frames;
+}
+
+std::size_t framecache::chunks() const noexcept {
+    return this->table.size();
+}
+
+const std::vector< channel_layout >& framecache::channels() const noexcept {
+    return this->layout;
+}
+
+const std::vector< std::vector< std::size_t > >&
+framecache::dims() const noexcept {
+    return this->shape;
+}
+
+const stream& framecache::file() const noexcept {
+    return *this->fp;
+}
+
+void framecache::unpack( const chunk& c,
+                         std::size_t col,
+                         std::vector< char >& out ) {
+    const auto& entry = c.columns[ col ];
+    const auto width = col == 0
+                     ? sizeof( std::int32_t )
+                     : scalar_size( this->layout[ col - 1 ].reprc );
+    const auto rowsize = col == 0
+                       ? sizeof( std::int32_t )
+                       : sizeof_native( this->layout[ col - 1 ].reprc )
+                         * this->layout[ col - 1 ].count;
+    const auto size = c.rows * rowsize;
+
+    std::vector< char > stored( entry.stored );
+    try {
+        bookmark at;
+        at.tell = entry.offset;
+        this->fp->setpos( at );
+        this->fp->read( stored.data(), stored.size() );
+    } catch( const eof_error& ) {
+        throw std::invalid_argument( "frame cache is truncated" );
+    }
+
+    out.resize( size );
+    if( entry.codec == raw ) {
+        if( stored.size() != size )
+            throw std::invalid_argument( "corrupt chunk in frame cache" );
+        std::memcpy( out.data(), stored.data(), size );
+        return;
+    }
+
+    if( entry.codec != packed )
+        throw std::invalid_argument( "unknown codec in frame cache" );
+
+    std::vector< char > planes( size );
+    if( !unrle( stored.data(), stored.size(), planes.data(), size ) )
+        throw std::invalid_argument( "corrupt chunk in frame cache" );
+
+    const auto n = size / width;
+    unshuffle( planes.data(), out.data(), n, width );
+    undelta( width, out.data(), n, rowsize / width );
+}
+
+/*
+ * The first frame where pred( value, x ) holds, for predicates that are
+ * false and then true through the frames. The chunk is found by the value of
+ * its last frame, and only that chunk is decompressed
+ */
+std::size_t framecache::partition( bool frameno,
+                                   bool (*pred)( double, double ),
+                                   double x ) {
+    const auto itr = std::partition_point( this->table.begin(),
+                                           this->table.end(),
+        [=]( const chunk& c ) {
+            return !pred( frameno ? double( c.lastno ) : c.hi, x );
+        }
+    );
+
+    if( itr == this->table.end() ) return this->frames;
+
+    std::vector< char > xs;
+    this->unpack( *itr, frameno ? 0 : 1, xs );
+
+    const auto reprc = frameno ? DLIS_SLONG : this->layout.front().reprc;
+    const auto rowsize = xs.size() / itr->rows;
+    std::size_t lo = 0;
+    std::size_t hi = itr->rows;
+    while( lo < hi ) {
+        const auto mid = lo + (hi - lo) / 2;
+        if( pred( scalar( xs.data() + mid * rowsize, reprc ), x ) ) hi = mid;
+        else lo = mid + 1;
+    }
+
+    return itr->first + lo;
+}
+
+std::pair< std::size_t, std::size_t >
+framecache::frame_range( std::int32_t first, std::int32_t last ) {
+    if( this->ascending ) {
+        const auto begin = this->partition( true, ge, first );
+        const auto end   = this->partition( true, gt, last );
+        return { begin, std::max( begin, end ) };
+    }
+
+    throw std::invalid_argument( "frame numbers are out of order, and can't "
+                                 "be a range" );
+}
+
+std::pair< std::size_t, std::size_t >
+framecache::index_range( double lo, double hi ) {
+    if( !this->indexed )
+        throw std::invalid_argument( "index channel can not be read as a "
+                                     "number" );
+
+    if( this->table.empty() ) return { 0, 0 };
+
+    const bool increasing = this->table.front().lo <= this->table.back().hi;
+
+    std::size_t begin, end;
+    if( increasing ) {
+        begin = this->partition( false, ge, lo );
+        end   = this->partition( false, gt, hi );
+    } else {
+        begin = this->partition( false, le, hi );
+        end   = this->partition( false, lt, lo );
+    }
+
+    return { begin, std::max( begin, end ) };
+}
+
+void framecache::read( std::size_t begin,
+                       std::size_t end,
+                       const std::vector< std::size_t >& selection,
+                       std::int32_t* numbers,
+                       char* const* columns ) {
+    if( begin > end || end > this->frames )
+        throw std::invalid_argument( "frame range out of bounds" );
+
+    for( const auto i : selection ) {
+        if( i >= this->layout.size() )
+            throw std::invalid_argument( "selected channel out of range" );
+    }
+
+    /*
+     * An empty range needs no chunks, and the columns may well be nullptr
+     */
+    if( begin == end ) return;
+
+    timer t( this->fp->count.decode_ns );
+
+    auto itr = std::partition_point( this->table.begin(),
+                                     this->table.end(),
+        [=]( const chunk& c ) { return c.first + c.rows <= begin; }
+    );
+
+    std::vector< char > xs;
+    for( ; itr != this->table.end() && itr->first < end; ++itr ) {
+        const auto& c = *itr;
+        const auto lo = std::max( begin, c.first );
+        const auto hi = std::min( end, c.first + c.rows );
+
+        if( numbers ) {
+            this->unpack( c, 0, xs );
+            std::memcpy( numbers + (lo - begin),
+                         xs.data() + (lo - c.first) * sizeof( std::int32_t ),
+                         (hi - lo) * sizeof( std::int32_t ) );
+        }
+
+        for( std::size_t k = 0; k < selection.size(); ++k ) {
+            const auto i = selection[ k ];
+            const auto rowsize = sizeof_native( this->layout[ i ].reprc )
+                               * this->layout[ i ].count;
+            this->unpack( c, i + 1, xs );
+            std::memcpy( columns[ k ] + (lo - begin) * rowsize,
+                         xs.data() + (lo - c.first) * rowsize,
+                         (hi - lo) * rowsize );
+        }
+    }
+}
+
+}
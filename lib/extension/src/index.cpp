@@ -0,0 +1,393 @@
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <dlisio/dlisio.h>
+#include <dlisio/ext/index.hpp>
+#include <dlisio/ext/io.hpp>
+#include <dlisio/ext/stats.hpp>
+
+namespace {
+
+/*
+ * A chunk of the file, as scanned by a worker
+ */
+struct walkresult {
+    dl::skeleton segments;
+    dl::scanstate state;
+    bool valid = false;
+};
+
+unsigned int be16( const char* xs ) noexcept {
+    const auto* u = reinterpret_cast< const unsigned char* >( xs );
+    return (unsigned int)( u[ 0 ] ) << 8 | u[ 1 ];
+}
+
+void prefetch( const char* p ) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch( p );
+#else
+    (void)p;
+#endif
+}
+
+/*
+ * Check if there is a plausible visible record label at p: FF 01 in the
+ * version bytes, segments that add up to exactly the record length, and at
+ * either end-of-file or another label right after it. This is only a
+ * heuristic for where to start a chunk - the stitching verifies that the
+ * chunk actually starts where the previous one ended.
+ */
+bool plausible_vrl( const char* base, long long size, long long p ) {
+    const auto isvrl = [base, size]( long long x ) {
+        return size - x >= 4
+            && static_cast< unsigned char >( base[ x + 2 ] ) == 0xFF
+            && static_cast< unsigned char >( base[ x + 3 ] ) == 0x01;
+    };
+
+    if( !isvrl( p ) ) return false;
+
+    const long long len = be16( base + p );
+    const long long end = p + len;
+    if( len < 8 || end > size ) return false;
+
+    long long q = p + 4;
+    while( q < end ) {
+        if( end - q < 4 ) return false;
+        const long long seglen = be16( base + q );
+        if( seglen < 4 ) return false;
+        q += seglen;
+    }
+
+    if( q != end ) return false;
+    return end == size || isvrl( end );
+}
+
+long long resync( const char* base, long long size, long long from ) {
+    for( long long p = from; size - p >= 4; ++p ) {
+        const void* ff = std::memchr( base + p + 2, 0xFF, size - p - 2 );
+        if( !ff ) return -1;
+
+        p = static_cast< const char* >( ff ) - base - 2;
+        if( plausible_vrl( base, size, p ) ) return p;
+    }
+
+    return -1;
+}
+
+}
+
+namespace dl {
+
+void skeleton::clear() noexcept {
+    this->tell.clear();
+    this->residual.clear();
+    this->offset.clear();
+    this->length.clear();
+    this->attrs.clear();
+    this->type.clear();
+}
+
+void skeleton::reserve( std::size_t n ) {
+    this->tell.reserve( n );
+    this->residual.reserve( n );
+    this->offset.reserve( n );
+    this->length.reserve( n );
+    this->attrs.reserve( n );
+    this->type.reserve( n );
+}
+
+/*
+ * An in-memory replay of the serial index loop (mark until eof), as it would
+ * run on a memory-backed stream. Anything that would make the serial loop
+ * warn or fail ends the scan as an anomaly.
+ */
+scanstate scan( const char* base,
+                long long size,
+                long long pos,
+                int remaining,
+                bool boundary,
+                skeleton& segs,
+                long long stop,
+                std::size_t maxrecords ) {
+    /*
+     * Far enough ahead to hide the latency, close enough to still be in the
+     * cache when the scan gets there
+     */
+    constexpr long long lookahead = 2048;
+
+    scanstate res;
+
+    /*
+     * A record that starts as the first segment of a visible record is
+     * bookmarked at the visible record label, and with the residual left
+     * before the label
+     */
+    long long vrltell = 0;
+    int vrlresidual = 0;
+    bool firstinvrl = false;
+    std::size_t complete = 0;
+
+    if( boundary && pos >= size ) {
+        res.end = scanend::eof;
+        res.pos = pos;
+        res.remaining = remaining;
+        return res;
+    }
+
+    while( true ) {
+        if( pos + lookahead < size ) prefetch( base + pos + lookahead );
+
+        if( remaining <= 0 ) {
+            if( pos >= stop ) {
+                res.end = scanend::stop;
+                break;
+            }
+
+            if( size - pos < 4 ) break;
+
+            int len, version;
+            dlis_vrl( base + pos, &len, &version );
+            if( version != 1 ) break;
+
+            if( !firstinvrl ) {
+                vrltell = pos;
+                vrlresidual = remaining;
+                firstinvrl = true;
+            }
+
+            pos += 4;
+            remaining = len - 4;
+            continue;
+        }
+
+        if( size - pos < 4 ) break;
+
+        int len, type;
+        std::uint8_t attrs;
+        dlis_lrsh( base + pos, &len, &attrs, &type );
+        if( len < 4 ) break;
+
+        segs.tell.push_back( firstinvrl ? vrltell : pos );
+        segs.residual.push_back( firstinvrl ? vrlresidual : remaining );
+        segs.offset.push_back( pos );
+        segs.length.push_back( len - 4 );
+        segs.attrs.push_back( attrs );
+        segs.type.push_back( std::uint8_t( type ) );
+        firstinvrl = false;
+
+        pos += len;
+        remaining -= len;
+        if( remaining < 0 ) break;
+
+        if( attrs & DLIS_SEGATTR_SUCCSEG ) continue;
+
+        if( pos >= size ) {
+            res.end = scanend::eof;
+            break;
+        }
+
+        if( ++complete >= maxrecords ) {
+            res.end = scanend::records;
+            break;
+        }
+    }
+
+    res.pos = pos;
+    res.remaining = remaining;
+    return res;
+}
+
+std::vector< bookmark > index( stream& fp,
+                               int threads,
+                               const warning_handler& warn,
+                               long long chunksize ) {
+    constexpr long long window = 1 << 24;
+
+    timer t( fp.count.index_ns );
+    std::vector< bookmark > bookmarks;
+    int remaining = 0;
+
+    bookmark start;
+    fp.getpos( start );
+
+    const char* base = fp.data();
+    const long long size = fp.size();
+    const long long len = size - start.tell;
+    const long long chunks = std::min< long long >(
+        std::max( threads, 1 ),
+        len / std::max( chunksize, 1LL )
+    );
+
+    if( !base ) {
+        while( !fp.eof() )
+            bookmarks.push_back( mark( fp, remaining, warn ) );
+        return bookmarks;
+    }
+
+    std::vector< long long > starts = { start.tell };
+    for( long long k = 1; k < chunks; ++k ) {
+        const auto from = start.tell + len / chunks * k;
+        const auto p = resync( base, size, std::max( from, starts.back() + 1 ) );
+        if( p == -1 ) break;
+        starts.push_back( p );
+    }
+
+    /*
+     * The first chunk is walked by the calling thread during stitching, so
+     * only start workers for the others. If a worker can't be started, or
+     * fails, the chunk is walked during stitching instead.
+     */
+    std::vector< walkresult > results( starts.size() );
+    std::vector< std::thread > workers;
+    for( std::size_t k = 1; k < starts.size(); ++k ) {
+        const auto from = starts[ k ];
+        const auto stop = k + 1 < starts.size() ? starts[ k + 1 ] : LLONG_MAX;
+        auto* result = &results[ k ];
+
+        try {
+            workers.emplace_back( [=] {
+                try {
+                    result->state = scan( base,
+                                          size,
+                                          from,
+                                          0,
+                                          false,
+                                          result->segments,
+                                          stop );
+                    result->valid = true;
+                } catch( ... ) {
+                    result->valid = false;
+                }
+            });
+        } catch( const std::system_error& ) {
+            break;
+        }
+    }
+
+    for( auto& worker : workers ) worker.join();
+
+    long long pos = start.tell;
+    bool boundary = true;
+    bookmark open;
+    std::size_t k = 0;
+    std::size_t segments = 0;
+
+    /*
+     * The windows scanned by the calling thread reuse the same skeleton, so
+     * its arrays are only grown once
+     */
+    walkresult r;
+    r.segments.reserve( std::min( len, window ) / 256 );
+    scanend end;
+    do {
+        while( k + 1 < starts.size() && starts[ k + 1 ] <= pos ) ++k;
+
+        r.segments.clear();
+        if( k > 0 && results[ k ].valid
+                  && starts[ k ] == pos
+                  && remaining <= 0 ) {
+            /*
+             * the chunk starts exactly where the last one ended, so it's good,
+             * except the residual of its first record, which is from before
+             * its first visible record label
+             */
+            r = std::move( results[ k ] );
+            auto& residual = r.segments.residual;
+            if( !residual.empty() ) residual.front() = remaining;
+        } else {
+            /*
+             * the calling thread scans in windows, so that the skeleton of a
+             * large file isn't all in memory at once
+             */
+            const auto next = k + 1 < starts.size()
+                            ? starts[ k + 1 ]
+                            : LLONG_MAX;
+            const auto stop = std::min( next, pos + window );
+            r.state = scan( base,
+                            size,
+                            pos,
+                            remaining,
+                            boundary,
+                            r.segments,
+                            stop );
+        }
+
+        const auto& segs = r.segments;
+        segments += segs.size();
+
+        /*
+         * every segment could be a record, so make room for them all up
+         * front, but still grow geometrically over many windows
+         */
+        const auto wanted = bookmarks.size() + segs.size();
+        if( wanted > bookmarks.capacity() )
+            bookmarks.reserve( std::max( wanted, 2 * bookmarks.capacity() ) );
+        for( std::size_t i = 0; i < segs.size(); ++i ) {
+            const auto attrs = segs.attrs[ i ];
+            if( boundary ) {
+                open = bookmark();
+                open.tell = segs.tell[ i ];
+                open.residual = segs.residual[ i ];
+                open.type = segs.type[ i ];
+                boundary = false;
+            }
+
+            open.length += segs.length[ i ];
+            open.isexplicit  = attrs & DLIS_SEGATTR_EXFMTLR;
+            open.isencrypted = attrs & DLIS_SEGATTR_ENCRYPT;
+
+            if( !(attrs & DLIS_SEGATTR_SUCCSEG) ) {
+                bookmarks.push_back( open );
+                boundary = true;
+            }
+        }
+
+        pos = r.state.pos;
+        remaining = r.state.remaining;
+        end = r.state.end;
+    } while( end == scanend::stop );
+
+    /*
+     * The chunks are scanned in memory, not by mark, so count what they found
+     * here. Segments of a record that the serial loop picks up are counted
+     * again, as they're visited again
+     */
+#ifdef DLISIO_STATS
+    fp.count.segments += segments;
+    fp.count.indexed += bookmarks.size();
+#else
+    (void)segments;
+#endif
+
+    if( end == scanend::eof ) {
+        bookmark last;
+        last.tell = pos;
+        fp.setpos( last );
+        return bookmarks;
+    }
+
+    /*
+     * Something unusual is going on, so let the serial loop take it from the
+     * start of the last record that isn't completely indexed
+     */
+    if( boundary ) {
+        open = bookmark();
+        open.tell = pos;
+        open.residual = remaining;
+    }
+
+    fp.setpos( open );
+    remaining = open.residual;
+    while( !fp.eof() )
+        bookmarks.push_back( mark( fp, remaining, warn ) );
+
+    return bookmarks;
+}
+
+}
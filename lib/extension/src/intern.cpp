@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dlisio/ext/intern.hpp>
+
+namespace {
+
+/* fnv-1a, which is plenty for short identifiers */
+std::uint64_t hash( const char* first, const char* last ) noexcept {
+    std::uint64_t h = 0xcbf29ce484222325;
+    for( ; first != last; ++first ) {
+        h ^= static_cast< unsigned char >( *first );
+        h *= 0x100000001b3;
+    }
+    return h;
+}
+
+std::uint64_t hash( const dl::symbols::name& n ) noexcept {
+    std::uint64_t h = std::uint32_t( n.origin );
+    h = (h << 8) | n.copy;
+    h ^= std::uint64_t( n.id ) << 40;
+    /* finalizer from murmur3, so that the low bits depend on all of the key */
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccd;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53;
+    h ^= h >> 33;
+    return h;
+}
+
+/*
+ * Keep the tables at most half full, so that probe sequences stay short
+ */
+bool crowded( std::size_t size,
+              const std::vector< dl::symbols::handle >& slots ) {
+    return (size + 1) * 2 > slots.size();
+}
+
+template< typename Hash >
+void rehash( std::vector< dl::symbols::handle >& slots,
+             std::size_t size,
+             Hash hashof ) {
+    std::vector< dl::symbols::handle > grown(
+        std::max( std::size_t( 64 ), slots.size() * 2 )
+    );
+    const auto mask = grown.size() - 1;
+
+    for( std::size_t i = 0; i < size; ++i ) {
+        auto slot = hashof( i ) & mask;
+        while( grown[ slot ] ) slot = (slot + 1) & mask;
+        grown[ slot ] = dl::symbols::handle( i + 1 );
+    }
+
+    slots.swap( grown );
+}
+
+}
+
+namespace dl {
+
+symbols::handle symbols::intern( const char* first, const char* last ) {
+    if( crowded( this->strtab.size(), this->strslots ) ) {
+        const auto& hashes = this->strhash;
+        const auto hashof = [&hashes]( std::size_t i ) { return hashes[ i ]; };
+        rehash( this->strslots, this->strtab.size(), hashof );
+    }
+
+    const auto h = hash( first, last );
+    const auto len = std::size_t( last - first );
+    const auto mask = this->strslots.size() - 1;
+
+    auto slot = h & mask;
+    while( const auto x = this->strslots[ slot ] ) {
+        const auto& s = this->strtab[ x - 1 ];
+        if( this->strhash[ x - 1 ] == h
+            && s.size() == len
+            && std::memcmp( s.data(), first, len ) == 0 )
+            return x - 1;
+
+        slot = (slot + 1) & mask;
+    }
+
+    const auto id = handle( this->strtab.size() );
+    this->strtab.emplace_back( first, last );
+    this->strhash.push_back( h );
+    this->strslots[ slot ] = id + 1;
+    return id;
+}
+
+symbols::handle symbols::intern( const std::string& s ) {
+    return this->intern( s.data(), s.data() + s.size() );
+}
+
+symbols::handle symbols::intern( std::int32_t origin,
+                                 std::uint8_t copy,
+                                 handle id ) {
+    if( crowded( this->nametab.size(), this->nameslots ) ) {
+        const auto& names = this->nametab;
+        const auto hashof = [&names]( std::size_t i ) {
+            return hash( names[ i ] );
+        };
+        rehash( this->nameslots, this->nametab.size(), hashof );
+    }
+
+    const name key = { origin, copy, id };
+    const auto mask = this->nameslots.size() - 1;
+
+    auto slot = hash( key ) & mask;
+    while( const auto x = this->nameslots[ slot ] ) {
+        const auto& n = this->nametab[ x - 1 ];
+        if( n.origin == origin && n.copy == copy && n.id == id )
+            return x - 1;
+
+        slot = (slot + 1) & mask;
+    }
+
+    const auto h = handle( this->nametab.size() );
+    this->nametab.push_back( key );
+    this->nameslots[ slot ] = h + 1;
+    return h;
+}
+
+const std::string& symbols::str( handle h ) const noexcept {
+    return this->strtab[ h ];
+}
+
+const symbols::name& symbols::obname( handle h ) const noexcept {
+    return this->nametab[ h ];
+}
+
+std::size_t symbols::strings() const noexcept {
+    return this->strtab.size();
+}
+
+std::size_t symbols::names() const noexcept {
+    return this->nametab.size();
+}
+
+void symbols::clear() noexcept {
+    this->strtab.clear();
+    this->strhash.clear();
+    this->strslots.clear();
+    this->nametab.clear();
+    this->nameslots.clear();
+}
+
+}
@@ -0,0 +1,1290 @@
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+    #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include <dlisio/dlisio.h>
+#include <dlisio/types.h>
+#include <dlisio/ext/arena.hpp>
+#include <dlisio/ext/index.hpp>
+#include <dlisio/ext/io.hpp>
+#include <dlisio/ext/stats.hpp>
+
+namespace dl {
+
+io_error::io_error( int no ) : runtime_error( std::strerror( no ) ) {}
+
+stream::stream() : shared( std::make_shared< stats >() ) {}
+
+stream::stream( std::shared_ptr< stats > totals ) :
+    shared( std::move( totals ) )
+{}
+
+stream::~stream() {
+    this->shared->add( this->count );
+}
+
+counters counted( const stream& fp ) {
+    auto total = fp.totals()->get();
+    if( stats::enabled() ) total += fp.count;
+    return total;
+}
+
+}
+
+namespace {
+
+/*
+ * Count n for the statistics of a stream, if counting is compiled in
+ */
+inline void tally( std::uint64_t& counter, std::uint64_t n = 1 ) noexcept {
+#ifdef DLISIO_STATS
+    counter += n;
+#else
+    (void)counter;
+    (void)n;
+#endif
+}
+
+/*
+ * 64-bit seek and tell, so that files larger than 2G can be indexed on
+ * platforms with a 32-bit long
+ */
+int seek64( std::FILE* fp, long long offset, int whence ) {
+#ifdef _WIN32
+    return _fseeki64( fp, offset, whence );
+#else
+    return fseeko( fp, offset, whence );
+#endif
+}
+
+long long tell64( std::FILE* fp ) {
+#ifdef _WIN32
+    return _ftelli64( fp );
+#else
+    return ftello( fp );
+#endif
+}
+
+class stdio_stream : public dl::stream {
+public:
+    explicit stdio_stream( const std::string& path );
+
+    void read( char* dst, std::size_t n ) override;
+    void skip( long long n ) override;
+    bool eof() override;
+
+    void getpos( dl::bookmark& ) override;
+    void setpos( const dl::bookmark& ) override;
+
+private:
+    struct fcloser {
+        void operator()( std::FILE* x ) {
+            if( x ) std::fclose( x );
+        }
+    };
+
+    std::unique_ptr< std::FILE, fcloser > fp;
+};
+
+stdio_stream::stdio_stream( const std::string& path ) :
+    fp( std::fopen( path.c_str(), "rb" ) ) {
+
+    if( !this->fp ) throw dl::io_error( errno );
+}
+
+/*
+ * automate the read-bytes-throw-if-fails, at least for now. file error
+ * reporting isn't very sophisticated, but doesn't have to be yet.
+ */
+void stdio_stream::read( char* buffer, std::size_t nmemb ) {
+    auto* fd = this->fp.get();
+    const auto read = std::fread( buffer, 1, nmemb, fd );
+    tally( this->count.reads );
+    tally( this->count.bytes, read );
+    if( read != nmemb ) {
+        if( std::feof( fd ) ) throw dl::eof_error( "unexpected EOF" );
+        throw dl::io_error( errno );
+    }
+}
+
+void stdio_stream::skip( long long n ) {
+    tally( this->count.seeks );
+    const auto err = seek64( this->fp.get(), n, SEEK_CUR );
+    if( err ) throw dl::io_error( errno );
+}
+
+bool stdio_stream::eof() {
+    auto* fd = this->fp.get();
+    int c = std::fgetc( fd );
+
+    if( c == EOF ) return true;
+    else c = std::ungetc( c, fd );
+
+    if( c == EOF ) return true;
+    return std::feof( fd );
+}
+
+void stdio_stream::getpos( dl::bookmark& mark ) {
+    mark.tell = tell64( this->fp.get() );
+    if( mark.tell == -1 ) throw dl::io_error( errno );
+}
+
+void stdio_stream::setpos( const dl::bookmark& mark ) {
+    tally( this->count.seeks );
+    const auto err = seek64( this->fp.get(), mark.tell, SEEK_SET );
+    if( err ) throw dl::io_error( errno );
+}
+
+/*
+ * A read-only mapping of a whole file. The file handle is closed as soon as
+ * the mapping is established - the mapping keeps the pages alive on its own
+ */
+class mapping {
+public:
+    explicit mapping( const std::string& path );
+    ~mapping();
+
+    mapping( const mapping& ) = delete;
+    mapping& operator=( const mapping& ) = delete;
+
+    const char* data() const noexcept { return this->addr; }
+    long long size() const noexcept { return this->len; }
+
+private:
+    const char* addr = nullptr;
+    long long len = 0;
+};
+
+#ifdef _WIN32
+
+mapping::mapping( const std::string& path ) {
+    HANDLE fd = CreateFileA( path.c_str(),
+                             GENERIC_READ,
+                             FILE_SHARE_READ,
+                             nullptr,
+                             OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL,
+                             nullptr );
+
+    if( fd == INVALID_HANDLE_VALUE ) throw dl::io_error( "unable to open file" );
+
+    LARGE_INTEGER size;
+    if( !GetFileSizeEx( fd, &size ) || size.QuadPart == 0 ) {
+        CloseHandle( fd );
+        throw dl::io_error( "unable to map file" );
+    }
+
+    HANDLE m = CreateFileMappingA( fd, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    CloseHandle( fd );
+    if( !m ) throw dl::io_error( "unable to map file" );
+
+    const void* p = MapViewOfFile( m, FILE_MAP_READ, 0, 0, 0 );
+    CloseHandle( m );
+    if( !p ) throw dl::io_error( "unable to map file" );
+
+    this->addr = static_cast< const char* >( p );
+    this->len = size.QuadPart;
+}
+
+mapping::~mapping() {
+    UnmapViewOfFile( this->addr );
+}
+
+#else
+
+mapping::mapping( const std::string& path ) {
+    const int fd = ::open( path.c_str(), O_RDONLY );
+    if( fd == -1 ) throw dl::io_error( errno );
+
+    struct stat st;
+    if( ::fstat( fd, &st ) == -1 ) {
+        const auto err = errno;
+        ::close( fd );
+        throw dl::io_error( err );
+    }
+
+    if( !S_ISREG( st.st_mode ) || st.st_size == 0 ) {
+        ::close( fd );
+        throw dl::io_error( "unable to map file: "
+                            "not a regular, non-empty file" );
+    }
+
+    void* p = ::mmap( nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+    const auto err = errno;
+    ::close( fd );
+    if( p == MAP_FAILED ) throw dl::io_error( err );
+
+    this->addr = static_cast< const char* >( p );
+    this->len = st.st_size;
+}
+
+mapping::~mapping() {
+    ::munmap( const_cast< char* >( this->addr ), this->len );
+}
+
+#endif
+
+class mmap_stream : public dl::stream {
+public:
+    explicit mmap_stream( const std::string& path );
+    mmap_stream( std::shared_ptr< const mapping > map,
+                 std::shared_ptr< dl::stats > totals ) :
+        dl::stream( std::move( totals ) ),
+        map( std::move( map ) )
+    {}
+
+    void read( char* dst, std::size_t n ) override;
+    void skip( long long n ) override;
+    bool eof() override;
+
+    void getpos( dl::bookmark& ) override;
+    void setpos( const dl::bookmark& ) override;
+
+    const char* view( std::size_t n ) override;
+    std::shared_ptr< const void > owner() const override;
+
+    const char* data() const noexcept override { return this->map->data(); }
+    long long size() const noexcept override { return this->map->size(); }
+
+    std::unique_ptr< dl::stream > cursor() const override {
+        return std::unique_ptr< dl::stream >(
+            new mmap_stream( this->map, this->totals() )
+        );
+    }
+
+private:
+    std::shared_ptr< const mapping > map;
+    long long pos = 0;
+};
+
+mmap_stream::mmap_stream( const std::string& path ) :
+    map( std::make_shared< mapping >( path ) )
+{}
+
+void mmap_stream::read( char* dst, std::size_t n ) {
+    /*
+     * like fread, a short read moves the position to the end
+     */
+    const auto size = this->map->size();
+    const auto avail = this->pos < size ? size - this->pos : 0;
+    if( (unsigned long long)avail < n ) {
+        this->pos = size;
+        throw dl::eof_error( "unexpected EOF" );
+    }
+
+    std::memcpy( dst, this->map->data() + this->pos, n );
+    this->pos += n;
+    tally( this->count.bytes, n );
+}
+
+void mmap_stream::skip( long long n ) {
+    /*
+     * like fseek, seeking past the end is fine (reads from there on fail),
+     * but seeking to before the start is not
+     */
+    if( this->pos + n < 0 ) throw dl::io_error( EINVAL );
+    this->pos += n;
+    tally( this->count.seeks );
+}
+
+bool mmap_stream::eof() {
+    return this->pos >= this->map->size();
+}
+
+void mmap_stream::getpos( dl::bookmark& mark ) {
+    mark.tell = this->pos;
+}
+
+void mmap_stream::setpos( const dl::bookmark& mark ) {
+    this->pos = mark.tell;
+    tally( this->count.seeks );
+}
+
+const char* mmap_stream::view( std::size_t n ) {
+    const auto size = this->map->size();
+    const auto avail = this->pos < size ? size - this->pos : 0;
+    if( (unsigned long long)avail < n ) {
+        this->pos = size;
+        throw dl::eof_error( "unexpected EOF" );
+    }
+
+    const char* p = this->map->data() + this->pos;
+    this->pos += n;
+    tally( this->count.bytes, n );
+    return p;
+}
+
+std::shared_ptr< const void > mmap_stream::owner() const {
+    return this->map;
+}
+
+/*
+ * A read-only handle for positional reads, which is shared by all the
+ * cursors of a pread_stream. Positional reads don't move a shared file
+ * position, so the handle can be read from many threads at once
+ */
+class handle {
+public:
+    explicit handle( const std::string& path );
+    ~handle();
+
+    handle( const handle& ) = delete;
+    handle& operator=( const handle& ) = delete;
+
+    /*
+     * Read up to n bytes at offset, and return the number of bytes read,
+     * which is only less than n at the end of the file
+     */
+    std::size_t pread( char* dst, std::size_t n, long long offset ) const;
+
+private:
+#ifdef _WIN32
+    HANDLE fd = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+};
+
+#ifdef _WIN32
+
+handle::handle( const std::string& path ) {
+    this->fd = CreateFileA( path.c_str(),
+                            GENERIC_READ,
+                            FILE_SHARE_READ,
+                            nullptr,
+                            OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL,
+                            nullptr );
+
+    if( this->fd == INVALID_HANDLE_VALUE )
+        throw dl::io_error( "unable to open file" );
+
+    if( GetFileType( this->fd ) != FILE_TYPE_DISK ) {
+        CloseHandle( this->fd );
+        throw dl::io_error( "unable to open file for positional reads: "
+                            "not a regular file" );
+    }
+}
+
+handle::~handle() {
+    CloseHandle( this->fd );
+}
+
+std::size_t handle::pread( char* dst, std::size_t n, long long offset ) const {
+    std::size_t total = 0;
+    while( total < n ) {
+        OVERLAPPED ov = {};
+        const auto at = offset + (long long)total;
+        ov.Offset     = DWORD( at & 0xFFFFFFFF );
+        ov.OffsetHigh = DWORD( at >> 32 );
+
+        const auto want = DWORD( std::min< std::size_t >( n - total,
+                                                          1 << 30 ) );
+        DWORD got = 0;
+        if( !ReadFile( this->fd, dst + total, want, &got, &ov ) ) {
+            if( GetLastError() == ERROR_HANDLE_EOF ) break;
+            throw dl::io_error( "unable to read file" );
+        }
+
+        if( got == 0 ) break;
+        total += got;
+    }
+
+    return total;
+}
+
+#else
+
+handle::handle( const std::string& path ) {
+    this->fd = ::open( path.c_str(), O_RDONLY );
+    if( this->fd == -1 ) throw dl::io_error( errno );
+
+    struct stat st;
+    if( ::fstat( this->fd, &st ) == -1 ) {
+        const auto err = errno;
+        ::close( this->fd );
+        throw dl::io_error( err );
+    }
+
+    if( !S_ISREG( st.st_mode ) ) {
+        ::close( this->fd );
+        throw dl::io_error( "unable to open file for positional reads: "
+                            "not a regular file" );
+    }
+}
+
+handle::~handle() {
+    ::close( this->fd );
+}
+
+std::size_t handle::pread( char* dst, std::size_t n, long long offset ) const {
+    std::size_t total = 0;
+    while( total < n ) {
+        const auto got = ::pread( this->fd,
+                                  dst + total,
+                                  n - total,
+                                  off_t( offset + (long long)total ) );
+        if( got == -1 ) {
+            if( errno == EINTR ) continue;
+            throw dl::io_error( errno );
+        }
+
+        if( got == 0 ) break;
+        total += std::size_t( got );
+    }
+
+    return total;
+}
+
+#endif
+
+/*
+ * A cursor over a handle. mark() reads the file a few bytes at a time, so
+ * like stdio the cursor reads ahead into a buffer of its own
+ */
+class pread_stream : public dl::stream {
+public:
+    explicit pread_stream( std::shared_ptr< const handle > fd ) :
+        fd( std::move( fd ) )
+    {}
+
+    pread_stream( std::shared_ptr< const handle > fd,
+                  std::shared_ptr< dl::stats > totals ) :
+        dl::stream( std::move( totals ) ),
+        fd( std::move( fd ) )
+    {}
+
+    void read( char* dst, std::size_t n ) override;
+    void skip( long long n ) override;
+    bool eof() override;
+
+    void getpos( dl::bookmark& mark ) override { mark.tell = this->pos; }
+    void setpos( const dl::bookmark& mark ) override {
+        this->pos = mark.tell;
+        tally( this->count.seeks );
+    }
+
+    std::unique_ptr< dl::stream > cursor() const override {
+        return std::unique_ptr< dl::stream >(
+            new pread_stream( this->fd, this->totals() )
+        );
+    }
+
+private:
+    static constexpr std::size_t bufsize = 64 * 1024;
+
+    std::shared_ptr< const handle > fd;
+    long long pos = 0;
+
+    /* the buffered bytes are [bufpos, bufpos + buffered) of the file */
+    std::unique_ptr< char[] > buffer;
+    long long bufpos = 0;
+    std::size_t buffered = 0;
+
+    std::size_t fill();
+};
+
+/*
+ * Read ahead from pos, and return the number of bytes available from pos
+ */
+std::size_t pread_stream::fill() {
+    if( this->pos >= this->bufpos
+     && this->pos < this->bufpos + (long long)this->buffered )
+        return std::size_t( this->bufpos + this->buffered - this->pos );
+
+    if( !this->buffer ) this->buffer.reset( new char[ bufsize ] );
+    this->bufpos = this->pos;
+    this->buffered = this->fd->pread( this->buffer.get(), bufsize, this->pos );
+    tally( this->count.reads );
+    return this->buffered;
+}
+
+void pread_stream::read( char* dst, std::size_t n ) {
+    if( this->pos < 0 ) throw dl::io_error( EINVAL );
+
+    while( n > 0 ) {
+        /* large reads go straight to the destination */
+        if( n >= bufsize ) {
+            const auto got = this->fd->pread( dst, n, this->pos );
+            this->pos += got;
+            tally( this->count.reads );
+            tally( this->count.bytes, got );
+            if( got < n ) throw dl::eof_error( "unexpected EOF" );
+            return;
+        }
+
+        const auto avail = this->fill();
+        if( avail == 0 ) throw dl::eof_error( "unexpected EOF" );
+
+        const auto take = std::min( avail, n );
+        const auto offset = std::size_t( this->pos - this->bufpos );
+        std::memcpy( dst, this->buffer.get() + offset, take );
+        this->pos += take;
+        tally( this->count.bytes, take );
+        dst += take;
+        n -= take;
+    }
+}
+
+void pread_stream::skip( long long n ) {
+    /* like fseek, seeking past the end is fine, but before the start is not */
+    if( this->pos + n < 0 ) throw dl::io_error( EINVAL );
+    this->pos += n;
+    tally( this->count.seeks );
+}
+
+bool pread_stream::eof() {
+    return this->fill() == 0;
+}
+
+/*
+ * A stream over a block of a file that has been read into memory, for
+ * splitting the records in it. Positions are offsets in the file, so that
+ * the bookmarks of the file can be used as-is. The block was counted when it
+ * was read, so only the segments and records are counted again
+ */
+class block_stream : public dl::stream {
+public:
+    block_stream( std::shared_ptr< const std::vector< char > > block,
+                  long long base,
+                  std::shared_ptr< dl::stats > totals ) :
+        dl::stream( std::move( totals ) ),
+        block( std::move( block ) ),
+        base( base )
+    {}
+
+    void read( char* dst, std::size_t n ) override {
+        std::memcpy( dst, this->view( n ), n );
+    }
+
+    void skip( long long n ) override { this->pos += n; }
+    bool eof() override { return this->pos >= this->size(); }
+
+    void getpos( dl::bookmark& mark ) override {
+        mark.tell = this->base + this->pos;
+    }
+
+    void setpos( const dl::bookmark& mark ) override {
+        this->pos = mark.tell - this->base;
+    }
+
+    const char* view( std::size_t n ) override {
+        const auto size = this->size();
+        const auto avail = this->pos < size ? size - this->pos : 0;
+        if( this->pos < 0 || (unsigned long long)avail < n )
+            throw dl::eof_error( "record extends past the block" );
+
+        const char* p = this->block->data() + this->pos;
+        this->pos += n;
+        return p;
+    }
+
+    std::shared_ptr< const void > owner() const override {
+        return this->block;
+    }
+
+    const char* data() const noexcept override {
+        return this->block->data();
+    }
+
+    long long size() const noexcept override {
+        return (long long)this->block->size();
+    }
+
+private:
+    std::shared_ptr< const std::vector< char > > block;
+    long long base;
+    long long pos = 0;
+};
+
+struct segheader {
+    std::uint8_t attrs;
+    int len;
+    int type;
+};
+
+segheader segment_header( dl::stream& fp ) {
+    char buffer[ 4 ];
+    fp.read( buffer, 4 );
+
+    segheader seg;
+    const auto err = dlis_lrsh( buffer, &seg.len, &seg.attrs, &seg.type );
+    if( err ) throw std::invalid_argument( "unable to parse "
+                                           "logical record segment header" );
+    return seg;
+}
+
+/*
+ * The segment attributes, as dlis_segment_attributes gives them
+ */
+struct segment_flags {
+    int isexplicit = 0;
+    int predecessor = 0;
+    int successor = 0;
+    int encrypted = 0;
+    int encryption_packet = 0;
+    int checksum = 0;
+    int trailing_length = 0;
+    int padding = 0;
+};
+
+segment_flags segment_attributes( std::uint8_t attrs ) noexcept {
+    segment_flags f;
+    dlis_segment_attributes( attrs, &f.isexplicit,
+                                    &f.predecessor,
+                                    &f.successor,
+                                    &f.encrypted,
+                                    &f.encryption_packet,
+                                    &f.checksum,
+                                    &f.trailing_length,
+                                    &f.padding );
+    return f;
+}
+
+/*
+ * The length of the trailer (padding, checksum and trailing length) of the
+ * segment body of seglen bytes that ends at segend. The padding length is
+ * the last byte before the checksum and trailing length. Throws
+ * invalid_argument if the trailer is longer than the segment.
+ */
+int trailer_length( const char* segend, int seglen, std::uint8_t attrs ) {
+    int trailer = 0;
+    if( attrs & DLIS_SEGATTR_TRAILEN ) trailer += 2;
+    if( attrs & DLIS_SEGATTR_CHCKSUM ) trailer += 2;
+    if( attrs & DLIS_SEGATTR_PADDING ) {
+        if( trailer >= seglen )
+            throw std::invalid_argument( "segment trailer longer "
+                                         "than segment" );
+        std::uint8_t padbytes = 0;
+        dlis_ushort( segend - trailer - 1, &padbytes );
+        trailer += padbytes;
+    }
+
+    if( trailer > seglen )
+        throw std::invalid_argument( "segment trailer longer than segment" );
+
+    return trailer;
+}
+
+int visible_length( dl::stream& fp, const dl::warning_handler& warn ) {
+    char buffer[ 4 ];
+    fp.read( buffer, 4 );
+
+    int len, version;
+    const auto err = dlis_vrl( buffer, &len, &version );
+    if( err ) throw std::invalid_argument( "unable to parse "
+                                           "visible record label" );
+
+    if( version != 1 && warn ) {
+        warn( "VRL DLIS not v1, was " + std::to_string( version ) );
+    }
+
+    return len;
+}
+
+/*
+ * catrecord concatenates records that span segments either into a vector of
+ * its own, which the record then holds on to, or into an arena
+ */
+struct heap_buffer {
+    std::shared_ptr< std::vector< char > > cat;
+
+    bool empty() const noexcept { return !this->cat; }
+    const char* end() const noexcept {
+        return this->cat->data() + this->cat->size();
+    }
+
+    char* extend( std::size_t n ) {
+        if( !this->cat ) {
+            this->cat = std::make_shared< std::vector< char > >();
+            this->cat->reserve( 8192 );
+        }
+
+        const auto prevsize = this->cat->size();
+        this->cat->resize( prevsize + n );
+        return this->cat->data() + prevsize;
+    }
+
+    void shrink( std::size_t n ) {
+        this->cat->resize( this->cat->size() - n );
+    }
+
+    dl::record finish() {
+        const auto* begin = this->cat->data();
+        const auto* end = begin + this->cat->size();
+        return dl::record( begin, end, std::move( this->cat ) );
+    }
+};
+
+struct arena_buffer {
+    dl::arena& mem;
+    char* cat = nullptr;
+    std::size_t size = 0;
+    std::size_t capacity = 0;
+
+    explicit arena_buffer( dl::arena& mem ) : mem( mem ) {}
+
+    bool empty() const noexcept { return !this->cat; }
+    const char* end() const noexcept { return this->cat + this->size; }
+
+    char* extend( std::size_t n ) {
+        if( this->size + n > this->capacity ) {
+            const auto newcap = std::max( { this->size + n,
+                                            this->capacity * 2,
+                                            std::size_t( 8192 ) } );
+            this->cat = static_cast< char* >(
+                this->mem.reallocate( this->cat, this->size, newcap, 1 )
+            );
+            this->capacity = newcap;
+        }
+
+        auto* dst = this->cat + this->size;
+        this->size += n;
+        return dst;
+    }
+
+    void shrink( std::size_t n ) noexcept {
+        this->size -= n;
+    }
+
+    dl::record finish() const {
+        return dl::record( this->cat, this->cat + this->size, nullptr );
+    }
+};
+
+template< typename Buffer >
+dl::record concatenate( dl::stream& fp,
+                        int remaining,
+                        const dl::warning_handler& warn,
+                        Buffer& cat ) {
+    /*
+     * The vast majority of records are a single segment, and when the stream
+     * is memory-backed those are handed out as views, uncopied. Records that
+     * span segments (and all records from non-memory-backed streams) are
+     * concatenated
+     */
+    tally( fp.count.records );
+    int segments = 0;
+
+    while( true ) {
+
+        while( remaining > 0 ) {
+
+            auto seg = segment_header( fp );
+            remaining -= seg.len;
+            tally( fp.count.segments );
+            if( ++segments == 2 ) tally( fp.count.concatenated );
+
+            const auto flags = segment_attributes( seg.attrs );
+
+            seg.len -= 4; // size of LRSH
+            if( seg.len < 0 )
+                throw std::invalid_argument( "segment shorter than its "
+                                             "header" );
+
+            const char* view = nullptr;
+            if( cat.empty() && !flags.successor ) view = fp.view( seg.len );
+
+            if( view ) {
+                const auto* end = view + seg.len;
+                end -= trailer_length( end, seg.len, seg.attrs );
+                return dl::record( view, end, fp.owner() );
+            }
+
+            fp.read( cat.extend( seg.len ), seg.len );
+            cat.shrink( trailer_length( cat.end(), seg.len, seg.attrs ) );
+
+            if( !flags.successor ) return cat.finish();
+        }
+
+        remaining = visible_length( fp, warn ) - 4;
+    }
+}
+
+/*
+ * Assemble the record at the bookmark from the skeleton of the memory-backed
+ * stream, without going through the stream. Returns false if the record
+ * isn't plain enough to assemble from its skeleton, and is left to
+ * catrecord, which reports whatever is wrong with it
+ */
+bool assemble( dl::stream& fp,
+               const dl::bookmark& mark,
+               dl::skeleton& segs,
+               dl::record& out ) {
+    const auto* base = fp.data();
+    segs.clear();
+    const auto state = dl::scan( base,
+                                 fp.size(),
+                                 mark.tell,
+                                 mark.residual,
+                                 true,
+                                 segs,
+                                 LLONG_MAX,
+                                 1 );
+
+    if( state.end != dl::scanend::records && state.end != dl::scanend::eof )
+        return false;
+
+    const auto bodylen = [&]( std::size_t i, int& len ) {
+        len = segs.length[ i ];
+        const auto* end = base + segs.offset[ i ] + 4 + len;
+        try {
+            len -= trailer_length( end, len, segs.attrs[ i ] );
+        } catch( const std::invalid_argument& ) {
+            return false;
+        }
+        return true;
+    };
+
+    const auto n = segs.size();
+    if( n == 1 ) {
+        int len;
+        if( !bodylen( 0, len ) ) return false;
+        const auto* body = base + segs.offset[ 0 ] + 4;
+        out = dl::record( body, body + len, fp.owner() );
+        tally( fp.count.records );
+        tally( fp.count.segments );
+        tally( fp.count.bytes, segs.length[ 0 ] );
+        return true;
+    }
+
+    auto cat = std::make_shared< std::vector< char > >();
+    std::uint64_t bytes = 0;
+    for( std::size_t i = 0; i < n; ++i ) {
+        int len;
+        if( !bodylen( i, len ) ) return false;
+        const auto* body = base + segs.offset[ i ] + 4;
+        cat->insert( cat->end(), body, body + len );
+        bytes += segs.length[ i ];
+    }
+
+    const auto* begin = cat->data();
+    const auto* end = begin + cat->size();
+    out = dl::record( begin, end, std::move( cat ) );
+    tally( fp.count.records );
+    tally( fp.count.segments, n );
+    tally( fp.count.concatenated );
+    tally( fp.count.bytes, bytes );
+    return true;
+}
+
+}
+
+namespace dl {
+
+std::unique_ptr< stream > open_stdio( const std::string& path ) {
+    return std::unique_ptr< stream >( new stdio_stream( path ) );
+}
+
+std::unique_ptr< stream > open_mmap( const std::string& path ) {
+    return std::unique_ptr< stream >( new mmap_stream( path ) );
+}
+
+std::unique_ptr< stream > open_pread( const std::string& path ) {
+    auto fd = std::make_shared< const handle >( path );
+    return std::unique_ptr< stream >( new pread_stream( std::move( fd ) ) );
+}
+
+std::unique_ptr< stream > open( const std::string& path, bool mmap ) {
+    /*
+     * memory-mapping fails for empty files and non-regular files like pipes,
+     * and positional reads for non-regular files, and then plain stdio reports
+     * if it couldn't be opened at all
+     */
+    if( mmap ) {
+        try {
+            return open_mmap( path );
+        } catch( const io_error& ) {}
+    }
+
+    try {
+        return open_pread( path );
+    } catch( const io_error& ) {}
+
+    return open_stdio( path );
+}
+
+bookmark mark( stream& fp, int& remaining, const warning_handler& warn ) {
+    bookmark mark;
+    mark.residual = remaining;
+    fp.getpos( mark );
+    bool first = true;
+
+    while( true ) {
+
+        /*
+         * if remaining = 0 this is at the VRL, skip the inner-loop and read it
+         */
+        while( remaining > 0 ) {
+            auto seg = segment_header( fp );
+            remaining -= seg.len;
+            tally( fp.count.segments );
+
+            if( first ) mark.type = seg.type;
+            first = false;
+
+            const auto flags = segment_attributes( seg.attrs );
+            mark.isexplicit = flags.isexplicit;
+            mark.isencrypted = flags.encrypted;
+
+            seg.len -= 4; // size of LRSH
+            if( seg.len < 0 )
+                throw std::invalid_argument( "segment shorter than its "
+                                             "header" );
+            mark.length += seg.len;
+            fp.skip( seg.len );
+
+            if( !flags.successor ) {
+                tally( fp.count.indexed );
+                return mark;
+            }
+        }
+
+        /* if remaining is 0, then we're at a VRL */
+        remaining = visible_length( fp, warn ) - 4;
+    }
+}
+
+record catrecord( stream& fp, int remaining, const warning_handler& warn ) {
+    timer t( fp.count.read_ns );
+    heap_buffer cat;
+    return concatenate( fp, remaining, warn, cat );
+}
+
+record catrecord( stream& fp,
+                  int remaining,
+                  arena& mem,
+                  const warning_handler& warn ) {
+    timer t( fp.count.read_ns );
+    arena_buffer cat( mem );
+    return concatenate( fp, remaining, warn, cat );
+}
+
+record catprefix( stream& fp,
+                  int remaining,
+                  std::size_t n,
+                  const warning_handler& warn ) {
+    timer t( fp.count.read_ns );
+    tally( fp.count.records );
+    int segments = 0;
+
+    auto cat = std::make_shared< std::vector< char > >();
+    cat->reserve( n );
+
+    while( true ) {
+        while( remaining > 0 ) {
+            auto seg = segment_header( fp );
+            remaining -= seg.len;
+            tally( fp.count.segments );
+            if( ++segments == 2 ) tally( fp.count.concatenated );
+
+            const auto flags = segment_attributes( seg.attrs );
+
+            seg.len -= 4; // size of LRSH
+            if( seg.len < 0 )
+                throw std::invalid_argument( "segment shorter than its "
+                                             "header" );
+
+            /*
+             * The trailer is at the end of the segment, and its size is only
+             * known from its last bytes. If the bytes wanted end well before
+             * any trailer could start, the rest of the segment is never read
+             */
+            const std::size_t want = n - cat->size();
+            std::size_t maxtrailer = 0;
+            if( flags.trailing_length ) maxtrailer += 2;
+            if( flags.checksum )        maxtrailer += 2;
+            if( flags.padding )         maxtrailer += 255;
+
+            if( want + maxtrailer <= std::size_t( seg.len ) ) {
+                const auto prevsize = cat->size();
+                cat->resize( prevsize + want );
+                fp.read( cat->data() + prevsize, want );
+                const auto* begin = cat->data();
+                const auto* end = begin + cat->size();
+                return record( begin, end, std::move( cat ) );
+            }
+
+            const auto prevsize = cat->size();
+            cat->resize( prevsize + seg.len );
+            fp.read( cat->data() + prevsize, seg.len );
+
+            const auto* segend = cat->data() + cat->size();
+            const auto trailer = trailer_length( segend, seg.len, seg.attrs );
+            cat->resize( cat->size() - trailer );
+
+            if( cat->size() >= n || !flags.successor ) {
+                cat->resize( std::min( cat->size(), n ) );
+                const auto* begin = cat->data();
+                const auto* end = begin + cat->size();
+                return record( begin, end, std::move( cat ) );
+            }
+        }
+
+        remaining = visible_length( fp, warn ) - 4;
+    }
+}
+
+std::vector< record > catrecords( stream& fp,
+                                  const std::vector< bookmark >& marks,
+                                  const warning_handler& warn ) {
+    /*
+     * Records are coalesced into one read as long as the gap between them is
+     * small, up to a maximum block size. The length of a record is a lower
+     * bound on its size in the file (which includes segment headers and
+     * visible record labels), so the gap estimate is conservative
+     */
+    constexpr long long maxgap = 64 * 1024;
+    constexpr long long maxblock = 4 * 1024 * 1024;
+    timer t( fp.count.read_ns );
+
+    std::vector< std::size_t > order( marks.size() );
+    for( std::size_t i = 0; i < order.size(); ++i ) order[ i ] = i;
+    std::stable_sort( order.begin(), order.end(),
+        [&marks]( std::size_t lhs, std::size_t rhs ) {
+            return marks[ lhs ].tell < marks[ rhs ].tell;
+        }
+    );
+
+    std::vector< record > recs( marks.size() );
+    const auto read = [&]( stream& src, std::size_t i ) {
+        src.setpos( marks[ i ] );
+        recs[ i ] = catrecord( src, marks[ i ].residual, warn );
+    };
+
+    /*
+     * memory-backed streams have no reads to save, only seeks, and records
+     * are assembled from the skeleton of the segments in memory
+     */
+    if( fp.data() ) {
+        skeleton segs;
+        for( const auto i : order ) {
+            if( !assemble( fp, marks[ i ], segs, recs[ i ] ) ) read( fp, i );
+        }
+        return recs;
+    }
+
+    std::size_t first = 0;
+    while( first < order.size() ) {
+        const auto base = marks[ order[ first ] ].tell;
+
+        auto last = first;
+        while( last + 1 < order.size() ) {
+            const auto& cur  = marks[ order[ last ] ];
+            const auto& next = marks[ order[ last + 1 ] ];
+            if( next.tell - (cur.tell + cur.length) > maxgap ) break;
+            if( next.tell - base > maxblock ) break;
+            ++last;
+        }
+
+        /*
+         * The records up to the last one end before the next one starts, so
+         * the block [first, last) contains them all. The last record is read
+         * straight from the stream, right after the block
+         */
+        const auto end = marks[ order[ last ] ].tell;
+        if( end > base ) {
+            auto block = std::make_shared< std::vector< char > >( end - base );
+            fp.setpos( marks[ order[ first ] ] );
+            fp.read( block->data(), block->size() );
+
+            block_stream blk( block, base, fp.totals() );
+            for( auto k = first; k < last; ++k ) {
+                const auto i = order[ k ];
+                if( marks[ i ].tell == end ) {
+                    read( fp, i );
+                    continue;
+                }
+
+                /*
+                 * bookmarks that aren't at the start of records could make
+                 * records that overlap the next, read those on their own
+                 */
+                try {
+                    read( blk, i );
+                } catch( const eof_error& ) {
+                    read( fp, i );
+                }
+            }
+        } else {
+            for( auto k = first; k < last; ++k ) read( fp, order[ k ] );
+        }
+
+        read( fp, order[ last ] );
+        first = last + 1;
+    }
+
+    return recs;
+}
+
+/*
+ * Buffer the first n bytes of a label or header in this->header, and report
+ * if all of them have arrived
+ */
+bool record_reader::collect( const char*& data,
+                             std::size_t& size,
+                             std::size_t n ) {
+    const auto take = std::min( n - this->have, size );
+    std::memcpy( this->header + this->have, data, take );
+    this->have += take;
+    this->offset += take;
+    data += take;
+    size -= take;
+
+    if( this->have < n ) return false;
+    this->have = 0;
+    return true;
+}
+
+void record_reader::visible_label( const warning_handler& warn ) {
+    int len, version;
+    const auto err = dlis_vrl( this->header, &len, &version );
+    if( err ) throw std::invalid_argument( "unable to parse "
+                                           "visible record label" );
+
+    if( version != 1 && warn ) {
+        warn( "VRL DLIS not v1, was " + std::to_string( version ) );
+    }
+
+    this->remaining = len - 4;
+}
+
+void record_reader::segment_header() {
+    int len, type;
+    std::uint8_t attrs;
+    const auto err = dlis_lrsh( this->header, &len, &attrs, &type );
+    if( err || len < 4 )
+        throw std::invalid_argument( "unable to parse "
+                                     "logical record segment header" );
+
+    this->remaining -= len;
+    this->segattrs = attrs;
+
+    if( !this->inrecord ) {
+        const auto flags = segment_attributes( attrs );
+        this->current.type = type;
+        this->current.isexplicit = flags.isexplicit;
+        this->current.isencrypted = flags.encrypted;
+        this->cat = std::make_shared< std::vector< char > >();
+        this->inrecord = true;
+    }
+
+    this->segleft = len - 4; // size of LRSH
+    this->segstart = this->cat->size();
+    this->current.length += this->segleft;
+}
+
+void record_reader::finish_segment() {
+    auto& cat = *this->cat;
+    const auto seglen = int( cat.size() - this->segstart );
+    const auto* segend = cat.data() + cat.size();
+    cat.resize( cat.size() - trailer_length( segend, seglen, this->segattrs ) );
+    if( segment_attributes( this->segattrs ).successor ) return;
+
+    const auto* begin = cat.data();
+    const auto* end = begin + cat.size();
+    this->done.emplace_back( this->current,
+                             record( begin, end, std::move( this->cat ) ) );
+
+    /* the next record starts right here, like after mark() */
+    this->current = bookmark();
+    this->current.residual = this->remaining;
+    this->current.tell = this->offset;
+    this->inrecord = false;
+}
+
+void record_reader::feed( const char* data,
+                          std::size_t size,
+                          const warning_handler& warn ) {
+    while( size > 0 || (this->st == state::body && this->segleft == 0) ) {
+        switch( this->st ) {
+            case state::sul:
+                if( !this->collect( data, size, 80 ) ) return;
+                this->label.assign( this->header, 80 );
+                this->current.residual = 0;
+                this->current.tell = this->offset;
+                this->st = state::vrl;
+                break;
+
+            case state::vrl:
+                if( !this->collect( data, size, 4 ) ) return;
+                this->visible_label( warn );
+                this->st = state::lrsh;
+                break;
+
+            case state::lrsh:
+                /* if remaining is 0, then we're at a VRL */
+                if( this->remaining <= 0 ) {
+                    this->st = state::vrl;
+                    break;
+                }
+
+                if( !this->collect( data, size, 4 ) ) return;
+                this->segment_header();
+                this->st = state::body;
+                break;
+
+            case state::body: {
+                const auto take = std::min( std::size_t( this->segleft ),
+                                            size );
+                auto& cat = *this->cat;
+                cat.insert( cat.end(), data, data + take );
+                this->segleft -= int( take );
+                this->offset += take;
+                data += take;
+                size -= take;
+
+                if( this->segleft > 0 ) return;
+                this->finish_segment();
+                this->st = state::lrsh;
+                break;
+            }
+        }
+    }
+}
+
+bool record_reader::next( bookmark& mark, record& rec ) {
+    if( this->done.empty() ) return false;
+
+    mark = this->done.front().first;
+    rec = std::move( this->done.front().second );
+    this->done.pop_front();
+    return true;
+}
+
+const std::string& record_reader::sul() const noexcept {
+    return this->label;
+}
+
+std::size_t record_reader::pending() const noexcept {
+    return this->done.size();
+}
+
+long long record_reader::tell() const noexcept {
+    return this->offset;
+}
+
+bool record_reader::partial() const noexcept {
+    return this->inrecord || this->have > 0;
+}
+
+}
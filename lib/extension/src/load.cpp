@@ -0,0 +1,421 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <dlisio/types.h>
+#include <dlisio/ext/eflr.hpp>
+#include <dlisio/ext/frame.hpp>
+#include <dlisio/ext/index.hpp>
+#include <dlisio/ext/io.hpp>
+#include <dlisio/ext/load.hpp>
+#include <dlisio/ext/pool.hpp>
+#include <dlisio/ext/stats.hpp>
+
+namespace {
+
+/*
+ * Collect warnings, possibly from several tasks at once
+ */
+struct warnings {
+    std::mutex mutex;
+    std::vector< std::string > msgs;
+
+    dl::warning_handler handler() {
+        return [this]( const std::string& msg ) {
+            std::lock_guard< std::mutex > guard( this->mutex );
+            this->msgs.push_back( msg );
+        };
+    }
+};
+
+/*
+ * A stream for a task. Streams with cursors give every task a cursor of its
+ * own, so tasks on the same file run in parallel, while stdio streams are
+ * shared, and only used serially
+ */
+std::shared_ptr< dl::stream >
+task_stream( const std::shared_ptr< dl::stream >& fp ) {
+    std::shared_ptr< dl::stream > cursor = fp->cursor();
+    if( cursor ) return cursor;
+    return fp;
+}
+
+/*
+ * The (template) attribute of the object with the label, or nullptr
+ */
+const dl::attribute* find( const dl::set& set,
+                           const dl::object& obj,
+                           const char* label ) {
+    const auto len = std::strlen( label );
+    const auto& attrs = set.tmpl.attributes;
+    for( std::size_t i = 0; i < attrs.size(); ++i ) {
+        const auto& l = attrs[ i ].label;
+        if( l.size() == len && std::memcmp( l.first, label, len ) == 0 )
+            return &set.at( obj, i );
+    }
+
+    return nullptr;
+}
+
+struct obnamehash {
+    std::size_t operator()( const dl::obname& name ) const noexcept {
+        auto h = std::hash< std::string >()( name.id );
+        h ^= std::size_t( name.origin ) + 0x9E3779B9 + (h << 6) + (h >> 2);
+        h ^= std::size_t( name.copy )   + 0x9E3779B9 + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
+std::vector< dl::obname > obnames( const dl::value& v ) {
+    std::vector< dl::obname > names;
+    if( !v.present || v.reprc != DLIS_OBNAME ) return names;
+
+    const char* cur = v.bytes.first;
+    for( int i = 0; i < v.count; ++i ) {
+        dl::span id;
+        dl::obname name;
+        cur = dl::obname_view( cur, v.bytes.last, name.origin, name.copy, id );
+        name.id = id.str();
+        names.push_back( std::move( name ) );
+    }
+
+    return names;
+}
+
+template< typename T >
+long long readint( const char*& cur, const char* (*f)( const char*, T* ) ) {
+    T x;
+    cur = f( cur, &x );
+    return x;
+}
+
+std::vector< std::size_t > integers( const dl::value& v ) {
+    std::vector< std::size_t > xs;
+    if( !v.present ) return xs;
+
+    const char* cur = v.bytes.first;
+    for( int i = 0; i < v.count; ++i ) {
+        long long x;
+        switch( v.reprc ) {
+            case DLIS_USHORT: x = readint( cur, dlis_ushort ); break;
+            case DLIS_UNORM:  x = readint( cur, dlis_unorm );  break;
+            case DLIS_ULONG:  x = readint( cur, dlis_ulong );  break;
+            case DLIS_SSHORT: x = readint( cur, dlis_sshort ); break;
+            case DLIS_SNORM:  x = readint( cur, dlis_snorm );  break;
+            case DLIS_SLONG:  x = readint( cur, dlis_slong );  break;
+            case DLIS_UVARI:
+            case DLIS_ORIGIN: x = readint( cur, dlis_uvari );  break;
+
+            default:
+                throw std::invalid_argument( "expected integer, was "
+                                             "representation code "
+                                           + std::to_string( v.reprc ) );
+        }
+
+        if( x < 0 ) throw std::invalid_argument( "negative integer in "
+                                                 "channel description" );
+        xs.push_back( std::size_t( x ) );
+    }
+
+    return xs;
+}
+
+/*
+ * Parse the sets of a logical file, and submit the frames to be decoded.
+ * Frames of streams without cursors are decoded right away
+ */
+void load_logical( dl::pool& workers,
+                   const std::shared_ptr< dl::stream >& file,
+                   dl::logical_file& lf,
+                   warnings& warn ) {
+    auto fp = task_stream( file );
+
+    std::vector< dl::bookmark > explicits;
+    for( const auto& mark : lf.bookmarks )
+        if( mark.isexplicit && !mark.isencrypted ) explicits.push_back( mark );
+
+    const auto handler = warn.handler();
+    const auto recs = dl::catrecords( *fp, explicits, handler );
+    {
+        dl::timer t( fp->count.parse_ns );
+        for( const auto& rec : recs )
+            lf.sets.push_back( dl::parse_set( rec, handler ) );
+        fp->count.sets += recs.size();
+    }
+
+    lf.frames = dl::describe_frames( lf.sets );
+
+    /*
+     * Index the FDATA of all frames in one pass, which only reads the record
+     * headers, so that every frame then reads only its own records. Frames
+     * without records get an empty index
+     */
+    std::vector< dl::fdata_index > indices;
+    try {
+        indices = dl::index_fdata( *fp, lf.bookmarks, handler );
+    } catch( ... ) {
+        for( auto& frame : lf.frames )
+            if( !frame.error ) frame.error = std::current_exception();
+        return;
+    }
+
+    auto byframe = std::make_shared< std::vector< dl::fdata_index > >(
+        lf.frames.size()
+    );
+    for( std::size_t i = 0; i < lf.frames.size(); ++i ) {
+        for( auto& index : indices ) {
+            if( index.frame != lf.frames[ i ].name ) continue;
+            (*byframe)[ i ] = std::move( index );
+            break;
+        }
+    }
+
+    for( std::size_t i = 0; i < lf.frames.size(); ++i ) {
+        auto& frame = lf.frames[ i ];
+        if( frame.error ) continue;
+
+        auto* f = &frame;
+        auto* marks = &lf.bookmarks;
+        const auto run = [file, f, marks, byframe, i, handler] {
+            try {
+                const auto fp = task_stream( file );
+                dl::decode_frame( *fp, *marks, (*byframe)[ i ], *f,
+                                  handler );
+            } catch( ... ) {
+                f->error = std::current_exception();
+            }
+        };
+
+        if( fp == file ) run();
+        else             workers.submit( run );
+    }
+}
+
+/*
+ * Open and index the file, split it into logical files, and submit them
+ */
+void load_file( dl::pool& workers,
+                const std::string& path,
+                std::vector< dl::logical_file >& out,
+                std::vector< std::unique_ptr< warnings > >& warns ) {
+    std::shared_ptr< dl::stream > fp;
+    std::string sul;
+    std::vector< dl::bookmark > bookmarks;
+    auto w = std::unique_ptr< warnings >( new warnings() );
+
+    try {
+        fp = dl::open( path );
+        char buffer[ 80 ];
+        fp->read( buffer, sizeof( buffer ) );
+        sul.assign( buffer, sizeof( buffer ) );
+
+        /* the pool already runs the files in parallel */
+        bookmarks = dl::index( *fp, 1, w->handler() );
+    } catch( ... ) {
+        dl::logical_file lf;
+        lf.path = path;
+        lf.error = std::current_exception();
+        out.push_back( std::move( lf ) );
+        warns.push_back( std::move( w ) );
+        return;
+    }
+
+    auto ranges = dl::logical_files( bookmarks );
+    if( ranges.empty() ) ranges.emplace_back( 0, 0 );
+    for( std::size_t i = 0; i < ranges.size(); ++i ) {
+        dl::logical_file lf;
+        lf.path = path;
+        lf.index = i;
+        lf.sul = sul;
+        lf.bookmarks.assign( bookmarks.begin() + ranges[ i ].first,
+                             bookmarks.begin() + ranges[ i ].second );
+        out.push_back( std::move( lf ) );
+        warns.emplace_back( new warnings() );
+    }
+
+    /* warnings from indexing go with the first logical file */
+    warns.front()->msgs = std::move( w->msgs );
+
+    /* out is not resized from here on, so the tasks can hold on to it */
+    for( std::size_t i = 0; i < out.size(); ++i ) {
+        auto* lf = &out[ i ];
+        auto* warn = warns[ i ].get();
+        const auto run = [&workers, fp, lf, warn] {
+            try {
+                load_logical( workers, fp, *lf, *warn );
+            } catch( ... ) {
+                lf->error = std::current_exception();
+            }
+        };
+
+        if( fp->cursor() ) workers.submit( run );
+        else               run();
+    }
+}
+
+}
+
+namespace dl {
+
+std::vector< frame_columns >
+describe_frames( const std::vector< set >& sets ) {
+    struct channel {
+        int reprc;
+        std::vector< std::size_t > dims;
+    };
+
+    /*
+     * Channels are looked up by name, and if a name is used by more than one
+     * channel in the logical file, the last one wins
+     */
+    std::unordered_map< obname, channel, obnamehash > channels;
+    std::vector< frame_columns > frames;
+
+    for( const auto& set : sets ) {
+        const auto type = set.type.str();
+        if( type != "FRAME" && type != "CHANNEL" ) continue;
+
+        for( const auto& obj : set.objects ) {
+            if( type == "FRAME" ) {
+                frame_columns frame;
+                frame.name = obj.name();
+                const auto* attr = find( set, obj, "CHANNELS" );
+                if( attr ) frame.channels = obnames( attr->val );
+                frames.push_back( std::move( frame ) );
+                continue;
+            }
+
+            channel ch;
+            ch.reprc = -1;
+            const auto* reprc = find( set, obj, "REPRESENTATION-CODE" );
+            const auto* dims = find( set, obj, "DIMENSION" );
+
+            try {
+                const auto r = reprc ? integers( reprc->val )
+                                     : std::vector< std::size_t >();
+                if( !r.empty() ) ch.reprc = int( r.front() );
+                if( dims ) ch.dims = integers( dims->val );
+            } catch( const std::invalid_argument& ) {
+                ch.reprc = -1;
+            }
+
+            if( ch.dims.empty() ) ch.dims = { 1 };
+            channels[ obj.name() ] = std::move( ch );
+        }
+    }
+
+    for( auto& frame : frames ) {
+        try {
+            for( const auto& name : frame.channels ) {
+                const auto itr = channels.find( name );
+                if( itr == channels.end() )
+                    throw std::invalid_argument( "no channel " + name.id
+                                               + " (in frame "
+                                               + frame.name.id + ")" );
+
+                const auto& ch = itr->second;
+                if( ch.reprc < 0 || sizeof_reprc( ch.reprc ) == 0 )
+                    throw std::invalid_argument(
+                        "channel " + name.id
+                        + " can not be decoded into a column" );
+
+                frame.reprc.push_back( ch.reprc );
+                frame.dims.push_back( ch.dims );
+            }
+        } catch( ... ) {
+            frame.error = std::current_exception();
+        }
+    }
+
+    return frames;
+}
+
+void decode_frame( stream& fp,
+                   const std::vector< bookmark >& marks,
+                   const fdata_index& index,
+                   frame_columns& frame,
+                   const warning_handler& warn ) {
+    const auto n = index.entries.size();
+    const auto recs = fdata( fp, marks, index, 0, n, warn );
+
+    std::vector< channel_layout > layout;
+    std::vector< char* > dsts;
+    frame.numbers.resize( recs.size() );
+    frame.columns.resize( frame.reprc.size() );
+
+    for( std::size_t i = 0; i < frame.reprc.size(); ++i ) {
+        std::size_t count = 1;
+        for( const auto dim : frame.dims[ i ] ) count *= dim;
+
+        const auto native = sizeof_native( frame.reprc[ i ] );
+        frame.columns[ i ].resize( recs.size() * count * native );
+        dsts.push_back( frame.columns[ i ].data() );
+        layout.push_back( { frame.reprc[ i ], count } );
+    }
+
+    timer t( fp.count.decode_ns );
+    decode_frames( recs, layout, frame.numbers.data(), dsts.data() );
+    fp.count.frames += recs.size();
+}
+
+std::vector< std::pair< std::size_t, std::size_t > >
+logical_files( const std::vector< bookmark >& marks ) {
+    std::vector< std::pair< std::size_t, std::size_t > > files;
+
+    /* FILE-HEADER is the explicitly formatted record of type 0 */
+    std::size_t first = 0;
+    for( std::size_t i = 0; i < marks.size(); ++i ) {
+        const auto& m = marks[ i ];
+        const bool header = m.isexplicit && m.type == 0;
+        if( header && i > first ) {
+            files.emplace_back( first, i );
+            first = i;
+        }
+    }
+
+    if( first < marks.size() ) files.emplace_back( first, marks.size() );
+    return files;
+}
+
+std::vector< logical_file > load( const std::vector< std::string >& paths,
+                                  int threads ) {
+    std::vector< std::vector< logical_file > > files( paths.size() );
+    std::vector< std::vector< std::unique_ptr< warnings > > > warns(
+        paths.size()
+    );
+
+    {
+        pool workers( threads );
+        for( std::size_t i = 0; i < paths.size(); ++i ) {
+            auto* out = &files[ i ];
+            auto* w = &warns[ i ];
+            const auto& path = paths[ i ];
+            workers.submit( [&workers, &path, out, w] {
+                load_file( workers, path, *out, *w );
+            });
+        }
+
+        workers.wait();
+    }
+
+    std::vector< logical_file > result;
+    for( std::size_t i = 0; i < files.size(); ++i ) {
+        for( std::size_t k = 0; k < files[ i ].size(); ++k ) {
+            auto& lf = files[ i ][ k ];
+            lf.warnings = std::move( warns[ i ][ k ]->msgs );
+            result.push_back( std::move( lf ) );
+        }
+    }
+
+    return result;
+}
+
+}
@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include <dlisio/ext/eflr.hpp>
+#include <dlisio/ext/io.hpp>
+#include <dlisio/ext/lru.hpp>
+
+namespace {
+
+/*
+ * The memory taken up by a parsed set, not counting the bytes of its record
+ */
+std::size_t tables( const dl::set& set ) noexcept {
+    const auto attributes = set.tmpl.attributes.size()
+                          + set.tmpl.invariants.size()
+                          + set.cells.size();
+    return sizeof( dl::set )
+         + attributes * sizeof( dl::attribute )
+         + set.objects.size() * sizeof( dl::object );
+}
+
+}
+
+namespace dl {
+
+record_cache::record_cache( std::size_t budget ) : limit( budget ) {}
+
+record_cache::entry* record_cache::lookup( const bookmark& mark ) {
+    const auto itr = this->entries.find( mark.tell );
+    if( itr == this->entries.end() ) return nullptr;
+
+    this->lru.splice( this->lru.begin(), this->lru, itr->second );
+    return &*itr->second;
+}
+
+bool record_cache::find( const bookmark& mark, record& out ) {
+    std::lock_guard< std::mutex > guard( this->mutex );
+    if( this->limit == 0 ) return false;
+
+    const auto* e = this->lookup( mark );
+    if( !e || !e->hasrecord ) {
+        ++this->count.misses;
+        return false;
+    }
+
+    ++this->count.hits;
+    out = e->rec;
+    return true;
+}
+
+std::shared_ptr< const set > record_cache::findset( const bookmark& mark ) {
+    std::lock_guard< std::mutex > guard( this->mutex );
+    if( this->limit == 0 ) return nullptr;
+
+    const auto* e = this->lookup( mark );
+    if( !e || !e->parsed ) {
+        ++this->count.misses;
+        return nullptr;
+    }
+
+    ++this->count.hits;
+    return e->parsed;
+}
+
+std::shared_ptr< const set > record_cache::findset( const bookmark& mark,
+                                                    record& rec,
+                                                    bool& hasrecord ) {
+    hasrecord = false;
+    std::lock_guard< std::mutex > guard( this->mutex );
+    if( this->limit == 0 ) return nullptr;
+
+    const auto* e = this->lookup( mark );
+    if( e && e->parsed ) {
+        ++this->count.hits;
+        return e->parsed;
+    }
+
+    ++this->count.misses;
+    if( e && e->hasrecord ) {
+        hasrecord = true;
+        rec = e->rec;
+    }
+    return nullptr;
+}
+
+/*
+ * Merge the new entry with the cached one at the same position, if any
+ * (which must be unlinked), and make it the most recently used
+ */
+void record_cache::store( entry e ) {
+    const auto itr = this->entries.find( e.tell );
+    if( itr != this->entries.end() ) {
+        auto& old = *itr->second;
+        if( !e.hasrecord && old.hasrecord ) {
+            e.hasrecord = true;
+            e.rec = std::move( old.rec );
+        }
+        if( !e.parsed ) e.parsed = std::move( old.parsed );
+
+        this->count.bytes -= old.bytes;
+        this->lru.erase( itr->second );
+        this->entries.erase( itr );
+    }
+
+    std::size_t bytes = e.hasrecord ? e.rec.size() : 0;
+    if( e.parsed ) {
+        bytes = std::max( bytes, e.parsed->bytes.size() );
+        bytes += tables( *e.parsed );
+    }
+    e.bytes = bytes;
+
+    if( e.bytes > this->limit ) {
+        this->count.entries = this->entries.size();
+        return;
+    }
+
+    this->lru.push_front( std::move( e ) );
+    this->entries.emplace( this->lru.front().tell, this->lru.begin() );
+    this->count.bytes += this->lru.front().bytes;
+    this->evict();
+}
+
+void record_cache::insert( const bookmark& mark, const record& rec ) {
+    std::lock_guard< std::mutex > guard( this->mutex );
+    if( this->limit == 0 ) return;
+
+    entry e;
+    e.tell = mark.tell;
+    e.hasrecord = true;
+    e.rec = rec;
+    this->store( std::move( e ) );
+}
+
+void record_cache::insert( const bookmark& mark,
+                           std::shared_ptr< const set > parsed ) {
+    std::lock_guard< std::mutex > guard( this->mutex );
+    if( this->limit == 0 || !parsed ) return;
+
+    entry e;
+    e.tell = mark.tell;
+    e.parsed = std::move( parsed );
+    this->store( std::move( e ) );
+}
+
+void record_cache::evict() {
+    while( this->count.bytes > this->limit ) {
+        const auto& last = this->lru.back();
+        this->count.bytes -= last.bytes;
+        this->entries.erase( last.tell );
+        this->lru.pop_back();
+        ++this->count.evictions;
+    }
+    this->count.entries = this->entries.size();
+}
+
+void record_cache::resize( std::size_t budget ) {
+    std::lock_guard< std::mutex > guard( this->mutex );
+    this->limit = budget;
+    this->evict();
+}
+
+void record_cache::clear() {
+    std::lock_guard< std::mutex > guard( this->mutex );
+    this->lru.clear();
+    this->entries.clear();
+    this->count.bytes = 0;
+    this->count.entries = 0;
+}
+
+std::size_t record_cache::budget() const {
+    std::lock_guard< std::mutex > guard( this->mutex );
+    return this->limit;
+}
+
+cache_counts record_cache::counts() const {
+    std::lock_guard< std::mutex > guard( this->mutex );
+    return this->count;
+}
+
+void record_cache::reset_counts() {
+    std::lock_guard< std::mutex > guard( this->mutex );
+    this->count.hits = 0;
+    this->count.misses = 0;
+    this->count.evictions = 0;
+}
+
+}
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include <dlisio/ext/pool.hpp>
+
+namespace {
+
+/*
+ * The pool and queue of the worker running on this thread, if any, so that
+ * tasks submitted from tasks go to the submitting worker's own queue
+ */
+thread_local const void* current_pool = nullptr;
+thread_local std::size_t current_queue = 0;
+
+}
+
+namespace dl {
+
+pool::pool( int threads ) {
+    if( threads <= 0 )
+        threads = std::max( 1u, std::thread::hardware_concurrency() );
+
+    for( int i = 0; i < threads; ++i )
+        this->queues.emplace_back( new queue() );
+
+    /*
+     * If not all the workers can be started, go on with the ones that are.
+     * Their queues are drained by stealing, so no task is left behind
+     */
+    for( int i = 0; i < threads; ++i ) {
+        try {
+            this->workers.emplace_back( &pool::run, this, std::size_t( i ) );
+        } catch( const std::system_error& ) {
+            if( this->workers.empty() ) throw;
+            break;
+        }
+    }
+}
+
+pool::~pool() {
+    {
+        std::lock_guard< std::mutex > guard( this->mutex );
+        this->stop = true;
+    }
+    this->available.notify_all();
+
+    for( auto& worker : this->workers ) worker.join();
+}
+
+void pool::submit( std::function< void() > task ) {
+    std::size_t target;
+    {
+        std::lock_guard< std::mutex > guard( this->mutex );
+        ++this->queued;
+        ++this->pending;
+
+        if( current_pool == this ) target = current_queue;
+        else target = this->rr++ % this->workers.size();
+    }
+
+    {
+        auto& q = *this->queues[ target ];
+        std::lock_guard< std::mutex > guard( q.mutex );
+        q.tasks.push_back( std::move( task ) );
+    }
+
+    this->available.notify_one();
+}
+
+void pool::wait() {
+    std::unique_lock< std::mutex > lock( this->mutex );
+    this->idle.wait( lock, [this] { return this->pending == 0; } );
+
+    if( this->error ) {
+        auto e = this->error;
+        this->error = nullptr;
+        std::rethrow_exception( e );
+    }
+}
+
+std::size_t pool::size() const noexcept {
+    return this->workers.size();
+}
+
+/*
+ * Take the newest task of the own queue, or else steal the oldest task of
+ * another queue
+ */
+bool pool::take( std::size_t self, std::function< void() >& task ) {
+    const auto n = this->queues.size();
+    for( std::size_t k = 0; k < n; ++k ) {
+        auto& q = *this->queues[ (self + k) % n ];
+        std::lock_guard< std::mutex > guard( q.mutex );
+        if( q.tasks.empty() ) continue;
+
+        if( k == 0 ) {
+            task = std::move( q.tasks.back() );
+            q.tasks.pop_back();
+        } else {
+            task = std::move( q.tasks.front() );
+            q.tasks.pop_front();
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+void pool::run( std::size_t self ) {
+    current_pool = this;
+    current_queue = self;
+
+    std::function< void() > task;
+    while( true ) {
+        {
+            std::unique_lock< std::mutex > lock( this->mutex );
+            this->available.wait( lock, [this] {
+                return this->stop || this->queued > 0;
+            });
+
+            if( this->queued == 0 ) return;
+        }
+
+        /*
+         * A task counted as queued might not be pushed to its queue yet, in
+         * which case just try again
+         */
+        if( !this->take( self, task ) ) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        {
+            std::lock_guard< std::mutex > guard( this->mutex );
+            --this->queued;
+        }
+
+        std::exception_ptr failed;
+        try {
+            task();
+        } catch( ... ) {
+            failed = std::current_exception();
+        }
+        task = nullptr;
+
+        std::lock_guard< std::mutex > guard( this->mutex );
+        if( failed && !this->error ) this->error = failed;
+        if( --this->pending == 0 ) this->idle.notify_all();
+    }
+}
+
+}
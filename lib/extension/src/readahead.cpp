@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <dlisio/ext/io.hpp>
+#include <dlisio/ext/readahead.hpp>
+
+namespace dl {
+
+readahead::readahead( stream& fp,
+                      std::vector< bookmark > marks,
+                      std::size_t depth,
+                      int threads,
+                      const warning_handler& warn ) :
+    fp( fp ),
+    marks( std::move( marks ) ),
+    depth( depth ),
+    run( 1 ),
+    warn( warn ) {
+
+    if( depth == 0 || this->marks.empty() ) return;
+
+    threads = std::max( 1, threads );
+    this->run = std::max< std::size_t >( 1, depth / std::size_t( threads ) );
+    this->slots.resize( depth );
+
+    /*
+     * Every reader needs a cursor. If there are none, or no reader can be
+     * started, the records are read synchronously by next()
+     */
+    for( int i = 0; i < threads; ++i ) {
+        std::shared_ptr< stream > cursor = fp.cursor();
+        if( !cursor ) break;
+
+        try {
+            this->readers.emplace_back( [this, cursor] {
+                this->read( *cursor );
+            });
+        } catch( const std::system_error& ) {
+            break;
+        }
+    }
+}
+
+readahead::~readahead() {
+    {
+        std::lock_guard< std::mutex > guard( this->mutex );
+        this->stop = true;
+    }
+    this->space.notify_all();
+
+    for( auto& reader : this->readers ) reader.join();
+}
+
+std::size_t readahead::size() const noexcept {
+    return this->marks.size();
+}
+
+std::size_t readahead::taken() const noexcept {
+    return this->consumed;
+}
+
+bool readahead::done() const noexcept {
+    return this->consumed == this->marks.size();
+}
+
+void readahead::read( stream& cursor ) {
+    const auto n = this->marks.size();
+
+    while( true ) {
+        std::size_t first;
+        std::size_t last;
+        {
+            std::unique_lock< std::mutex > lock( this->mutex );
+            this->space.wait( lock, [this, n] {
+                return this->stop
+                    || this->issued == n
+                    || this->issued < this->consumed + this->depth;
+            });
+
+            if( this->stop || this->issued == n ) return;
+
+            /*
+             * Claim a run of records, but no more than there are free slots,
+             * so the slot of every claimed record has been taken
+             */
+            first = this->issued;
+            last = std::min( { n,
+                               first + this->run,
+                               this->consumed + this->depth } );
+            this->issued = last;
+        }
+
+        std::vector< slot > got( last - first );
+        bool retry = false;
+        const auto collect = [&retry]( const std::string& ) {
+            retry = true;
+        };
+
+        try {
+            const std::vector< bookmark > claimed(
+                this->marks.begin() + first,
+                this->marks.begin() + last
+            );
+            auto recs = catrecords( cursor, claimed, collect );
+            for( std::size_t k = 0; k < got.size(); ++k )
+                got[ k ].rec = std::move( recs[ k ] );
+        } catch( ... ) {
+            retry = true;
+        }
+
+        if( retry ) {
+            /*
+             * One of the records is broken, or warns, so read them one by
+             * one, to pin the error and the warnings on the right ones, and
+             * read the rest of them. This is rare, and only costs the
+             * coalescing of this run
+             */
+            for( auto& s : got ) s = slot();
+            for( std::size_t k = 0; k < got.size(); ++k ) {
+                auto& s = got[ k ];
+                const auto& mark = this->marks[ first + k ];
+                try {
+                    cursor.setpos( mark );
+                    s.rec = catrecord( cursor, mark.residual,
+                        [&s]( const std::string& msg ) {
+                            s.warnings.push_back( msg );
+                        }
+                    );
+                } catch( ... ) {
+                    s.error = std::current_exception();
+                }
+            }
+        }
+
+        {
+            std::lock_guard< std::mutex > guard( this->mutex );
+            for( std::size_t k = 0; k < got.size(); ++k ) {
+                auto& s = this->slots[ (first + k) % this->depth ];
+                s = std::move( got[ k ] );
+                s.ready = true;
+            }
+        }
+        this->ready.notify_all();
+    }
+}
+
+record readahead::next() {
+    if( this->done() )
+        throw std::out_of_range( "no more records to read ahead" );
+
+    const auto i = this->consumed;
+    if( this->readers.empty() ) {
+        const auto& mark = this->marks[ i ];
+        this->fp.setpos( mark );
+        ++this->consumed;
+        return catrecord( this->fp, mark.residual, this->warn );
+    }
+
+    slot s;
+    {
+        std::unique_lock< std::mutex > lock( this->mutex );
+        auto& target = this->slots[ i % this->depth ];
+        this->ready.wait( lock, [&target] { return target.ready; } );
+        s = std::move( target );
+        target = slot();
+        ++this->consumed;
+    }
+    this->space.notify_all();
+
+    if( this->warn ) {
+        for( const auto& msg : s.warnings ) this->warn( msg );
+    }
+
+    if( s.error ) std::rethrow_exception( s.error );
+    return std::move( s.rec );
+}
+
+}
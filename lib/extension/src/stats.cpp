@@ -0,0 +1,87 @@
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+#include <dlisio/ext/stats.hpp>
+
+#ifdef DLISIO_STATS
+namespace {
+
+/*
+ * The number of timers running on this thread
+ */
+thread_local int running = 0;
+
+}
+#endif
+
+namespace dl {
+
+counters& counters::operator+=( const counters& x ) noexcept {
+    this->bytes        += x.bytes;
+    this->reads        += x.reads;
+    this->seeks        += x.seeks;
+    this->segments     += x.segments;
+    this->indexed      += x.indexed;
+    this->records      += x.records;
+    this->concatenated += x.concatenated;
+    this->sets         += x.sets;
+    this->frames       += x.frames;
+    this->index_ns     += x.index_ns;
+    this->read_ns      += x.read_ns;
+    this->parse_ns     += x.parse_ns;
+    this->decode_ns    += x.decode_ns;
+    return *this;
+}
+
+void stats::add( const counters& x ) {
+#ifdef DLISIO_STATS
+    std::lock_guard< std::mutex > guard( this->mutex );
+    this->total += x;
+#else
+    (void)x;
+#endif
+}
+
+counters stats::get() const {
+    std::lock_guard< std::mutex > guard( this->mutex );
+    return this->total;
+}
+
+void stats::reset() {
+    std::lock_guard< std::mutex > guard( this->mutex );
+    this->total = counters();
+}
+
+bool stats::enabled() noexcept {
+#ifdef DLISIO_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+timer::timer( std::uint64_t& ns ) noexcept {
+#ifdef DLISIO_STATS
+    if( running++ > 0 ) return;
+    this->ns = &ns;
+    this->start = std::chrono::steady_clock::now();
+#else
+    (void)ns;
+#endif
+}
+
+timer::~timer() {
+#ifdef DLISIO_STATS
+    --running;
+    if( !this->ns ) return;
+
+    const auto elapsed = std::chrono::steady_clock::now() - this->start;
+    *this->ns += std::uint64_t(
+        std::chrono::duration_cast< std::chrono::nanoseconds >( elapsed )
+            .count()
+    );
+#endif
+}
+
+}
@@ -0,0 +1,39 @@
+#ifndef DLISIO_EXT_UVARI_HPP
+#define DLISIO_EXT_UVARI_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <dlisio/dlisio.h>
+
+namespace dl {
+
+/*
+ * The UVARI at cur, which must end before end. dlis_uvari always reads 4
+ * bytes, so near the end of a record, decode from a padded copy instead.
+ * Throws invalid_argument if the UVARI is cut short by end.
+ *
+ * This is private to the extension, and shared by the parsers of EFLRs and
+ * IFLRs.
+ */
+inline const char* uvari( const char* cur,
+                          const char* end,
+                          std::int32_t& out ) {
+    const auto truncated = [] {
+        return std::invalid_argument( "unexpected end-of-record in UVARI" );
+    };
+
+    if( cur >= end ) throw truncated();
+    if( end - cur >= 4 ) return dlis_uvari( cur, &out );
+
+    char buffer[ 4 ] = {};
+    std::memcpy( buffer, cur, end - cur );
+    const auto* next = dlis_uvari( buffer, &out );
+    if( next - buffer > end - cur ) throw truncated();
+    return cur + (next - buffer);
+}
+
+}
+
+#endif //DLISIO_EXT_UVARI_HPP
@@ -1,6 +1,7 @@
 #ifndef DLISIO_TYPES_H
 #define DLISIO_TYPES_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -79,6 +80,28 @@ const char* dlis_objref( const char*, int32_t* ident_len,
                                       int32_t* objname_len,
                                       char* identifier );
 
+/*
+ * obname and objref without copying: the identifiers are pointers into the
+ * input, and not written anywhere. The origin and its length are decoded from
+ * a single 4-byte window, without branching on the length bits, and the copy
+ * number and identifier length are read right after the origin, which is up
+ * to 4 bytes wide. The name is read before anything is checked, so these
+ * read up to 6 bytes (after the type identifier of objref) even if the name
+ * is shorter, and the caller must make sure that 6 bytes can be read, and
+ * check that the value fits once it's decoded.
+ */
+const char* dlis_obname_view( const char*, int32_t* origin,
+                                           uint8_t* copy_number,
+                                           int32_t* idlen,
+                                           const char** identifier );
+
+const char* dlis_objref_view( const char*, int32_t* ident_len,
+                                           const char** ident,
+                                           int32_t* origin,
+                                           uint8_t* copy_number,
+                                           int32_t* objname_len,
+                                           const char** identifier );
+
 /* attref = { ident, obname, ident } */
 const char* dlis_attref( const char*, int32_t* ident1_len,
                                       char* ident1,
@@ -91,6 +114,60 @@ const char* dlis_attref( const char*, int32_t* ident1_len,
 const char* dlis_status( const char*, uint8_t* );
 const char* dlis_units( const char*, uint8_t*, char* );
 
+/*
+ * Bulk versions of the fixed-size parsers, for decoding many values at once,
+ * e.g. a channel across frames. Value i is read from src + i * stride and
+ * written to dst[ i ]. Validated and complex values are written as
+ * consecutive components, i.e. dst[ 2i ] = V and dst[ 2i + 1 ] = A for
+ * fsing1. They return src + n * stride.
+ *
+ * Contiguous values (stride equal to the size of the type) are decoded with
+ * SIMD instructions where the CPU supports it. The results are identical to
+ * the scalar functions.
+ */
+const char* dlis_sshort_n( const char* src, size_t stride, size_t n, int8_t* );
+const char* dlis_snorm_n(  const char* src, size_t stride, size_t n, int16_t* );
+const char* dlis_slong_n(  const char* src, size_t stride, size_t n, int32_t* );
+
+const char* dlis_ushort_n( const char* src, size_t stride, size_t n, uint8_t* );
+const char* dlis_unorm_n(  const char* src, size_t stride, size_t n, uint16_t* );
+const char* dlis_ulong_n(  const char* src, size_t stride, size_t n, uint32_t* );
+
+const char* dlis_fshort_n( const char* src, size_t stride, size_t n, float* );
+const char* dlis_fsingl_n( const char* src, size_t stride, size_t n, float* );
+const char* dlis_fdoubl_n( const char* src, size_t stride, size_t n, double* );
+
+const char* dlis_isingl_n( const char* src, size_t stride, size_t n, float* );
+const char* dlis_vsingl_n( const char* src, size_t stride, size_t n, float* );
+
+const char* dlis_fsing1_n( const char* src, size_t stride, size_t n, float* );
+const char* dlis_fsing2_n( const char* src, size_t stride, size_t n, float* );
+const char* dlis_csingl_n( const char* src, size_t stride, size_t n, float* );
+
+const char* dlis_fdoub1_n( const char* src, size_t stride, size_t n, double* );
+const char* dlis_fdoub2_n( const char* src, size_t stride, size_t n, double* );
+const char* dlis_cdoubl_n( const char* src, size_t stride, size_t n, double* );
+
+const char* dlis_status_n( const char* src, size_t stride, size_t n, uint8_t* );
+
+/*
+ * The instruction set used by the bulk functions. On x86, the widest one the
+ * CPU supports is selected on first use. dlis_simd_set overrides the
+ * selection, e.g. for benchmarking or to work around a faulty machine, and
+ * returns DLIS_UNEXPECTED_VALUE if the level is not supported. It is safe to
+ * call concurrently with the bulk functions.
+ */
+#define DLIS_SIMD_SCALAR 0
+#define DLIS_SIMD_SSE2   1
+#define DLIS_SIMD_SSSE3  2
+#define DLIS_SIMD_AVX2   3
+#define DLIS_SIMD_AVX512 4 // AVX-512F and AVX-512BW
+#define DLIS_SIMD_NEON   5
+
+int dlis_simd_supported( int level );
+int dlis_simd_level( void );
+int dlis_simd_set( int level );
+
 #define DLIS_FSHORT 1  // Low precision floating point
 #define DLIS_FSINGL 2  // IEEE single precision floating point
 #define DLIS_FSING1 3  // Validated single precision floating point
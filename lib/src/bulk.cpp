@@ -0,0 +1,927 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include <dlisio/dlisio.h>
+#include <dlisio/types.h>
+
+#include "byteorder.hpp"
+
+/*
+ * The SIMD kernels are compiled for their instruction set with target
+ * attributes, rather than for the whole library, and the widest one the CPU
+ * supports is selected at runtime. That way the same build runs at full speed
+ * on any x86 machine. NEON is part of the baseline of the ARM targets, and is
+ * selected at compile time. The kernels all assume a little-endian host, so
+ * big-endian hosts always use the scalar code.
+ */
+#ifndef HOST_BIG_ENDIAN
+    #if defined(__x86_64__) || defined(__i386__) \
+     || defined(_M_X64) || defined(_M_IX86)
+        #define DLISIO_X86
+    #endif
+
+    #if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        #define DLISIO_NEON
+    #endif
+#endif
+
+#ifdef DLISIO_X86
+    #include <immintrin.h>
+
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        /* msvc allows any intrinsic anywhere, and needs no annotation */
+        #define DLISIO_TARGET(isa)
+    #else
+        #include <cpuid.h>
+        #define DLISIO_TARGET(isa) __attribute__((target(isa)))
+    #endif
+#endif
+
+#ifdef DLISIO_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace {
+
+/*
+ * Scalar, branch-free conversions. These are the reference for the vectorised
+ * versions, and handle the values that don't fill a vector
+ */
+
+/*
+ * IBM System/360 single precision to IEEE 754, based on the table conversion
+ * in the original dlis_isingl. The mantissa is normalised by shifting it up
+ * by 3, 2, 1 or 0 bits depending on its 3 high bits, which is computed with
+ * comparisons rather than table lookups
+ */
+std::uint32_t ibm2ieee( std::uint32_t u ) noexcept {
+    const std::uint32_t manthi = u & 0x00FFFFFF;
+    const std::uint32_t ix     = manthi >> 21;
+    const std::uint32_t s      = (ix < 1) + (ix < 2) + (ix < 4);
+    const std::uint32_t iexp   = ( ( u & 0x7F000000 ) - ( 0x20C00000 + (s << 22) ) ) << 1;
+    const std::uint32_t inabs  = u & 0x7FFFFFFF;
+
+    std::uint32_t m = (manthi << s) + iexp;
+    m = inabs > 0x611FFFFF ? 0x7FFFFFFF : m;
+    m |= u & 0x80000000;
+    return inabs < 0x21200000 ? 0 : m;
+}
+
+/*
+ * VAX F-floating to IEEE 754. v is the VAX float with its 16-bit words
+ * swapped, i.e. sign, exponent and fraction in the usual order.
+ *
+ * The value is (0.5 + fraction) * 2^(exponent - 128). The scale is an exact
+ * power of two in double precision, built straight from the exponent bits,
+ * so the product is exact and rounded only once, when converted to float.
+ * Exponent 0 is zero, or NaN (reserved operand) if the sign is set.
+ */
+std::uint32_t vax2ieee( std::uint32_t v ) noexcept {
+    const std::uint32_t sign = v & 0x80000000;
+    const std::uint32_t frac = v & 0x007FFFFF;
+    const std::uint32_t exp  = (v >> 23) & 0xFF;
+
+    const std::uint64_t scalebits = std::uint64_t( exp + 1023 - 128 ) << 52;
+    double scale;
+    std::memcpy( &scale, &scalebits, sizeof( scale ) );
+
+    const float x = float( (0.5 + frac * (1.0 / 8388608.0)) * scale );
+    std::uint32_t u;
+    std::memcpy( &u, &x, sizeof( u ) );
+
+    const std::uint32_t special = (sign >> 31) * 0x7FC00000;
+    return exp ? (u | sign) : special;
+}
+
+/*
+ * The 12-bit two's complement fraction, scaled by 2^(exponent - 11)
+ */
+float fshort2ieee( std::uint16_t v ) noexcept {
+    const int frac = int( v >> 4 ) - int( (v & 0x8000) >> 3 );
+    const std::uint32_t exp = v & 0x000F;
+
+    const std::uint32_t scalebits = (exp - 11 + 127) << 23;
+    float scale;
+    std::memcpy( &scale, &scalebits, sizeof( scale ) );
+
+    return float( frac ) * scale;
+}
+
+/*
+ * Contiguous values are decoded by kernels, one per instruction set, which
+ * take n values of Size bytes. Vector kernels handle whatever doesn't fill a
+ * vector by passing it on to a narrower kernel.
+ */
+template< int Size > struct word;
+template<> struct word< 2 > { using type = std::uint16_t; };
+template<> struct word< 4 > { using type = std::uint32_t; };
+template<> struct word< 8 > { using type = std::uint64_t; };
+
+template< int Size >
+void swap_scalar( const char* src, std::size_t n, char* dst ) noexcept {
+    using T = typename word< Size >::type;
+    for( std::size_t i = 0; i < n; ++i ) {
+        T x;
+        std::memcpy( &x, src + i * Size, Size );
+        x = ntoh( x );
+        std::memcpy( dst + i * Size, &x, Size );
+    }
+}
+
+void isingl_scalar( const char* src, std::size_t n, float* dst ) noexcept {
+    for( std::size_t i = 0; i < n; ++i ) {
+        std::uint32_t u;
+        std::memcpy( &u, src + i * 4, sizeof( u ) );
+        u = ibm2ieee( ntoh( u ) );
+        std::memcpy( dst + i, &u, sizeof( u ) );
+    }
+}
+
+std::uint32_t vaxword( const char* src ) noexcept {
+    std::uint8_t x[ 4 ];
+    std::memcpy( x, src, sizeof( x ) );
+
+    return std::uint32_t( x[ 1 ] ) << 24
+         | std::uint32_t( x[ 0 ] ) << 16
+         | std::uint32_t( x[ 3 ] ) << 8
+         | std::uint32_t( x[ 2 ] ) << 0
+         ;
+}
+
+void vsingl_scalar( const char* src, std::size_t n, float* dst ) noexcept {
+    for( std::size_t i = 0; i < n; ++i ) {
+        const auto u = vax2ieee( vaxword( src + i * 4 ) );
+        std::memcpy( dst + i, &u, sizeof( u ) );
+    }
+}
+
+#ifdef DLISIO_X86
+
+template< int Size >
+DLISIO_TARGET("sse2")
+__m128i bswap_sse2( __m128i x ) noexcept {
+    /* reorder the 16-bit words, then swap the bytes in each word */
+    if( Size == 4 )
+        x = _mm_shufflehi_epi16( _mm_shufflelo_epi16( x, 0xB1 ), 0xB1 );
+    if( Size == 8 )
+        x = _mm_shufflehi_epi16( _mm_shufflelo_epi16( x, 0x1B ), 0x1B );
+    return _mm_or_si128( _mm_slli_epi16( x, 8 ), _mm_srli_epi16( x, 8 ) );
+}
+
+/*
+ * The pshufb mask that reverses the bytes of every Size-byte lane
+ */
+template< int Size >
+DLISIO_TARGET("sse2")
+__m128i bswap_mask() noexcept {
+    return Size == 2
+        ? _mm_setr_epi8(  1,  0,  3,  2,  5,  4,  7,  6,
+                          9,  8, 11, 10, 13, 12, 15, 14 )
+        : Size == 4
+        ? _mm_setr_epi8(  3,  2,  1,  0,  7,  6,  5,  4,
+                         11, 10,  9,  8, 15, 14, 13, 12 )
+        : _mm_setr_epi8(  7,  6,  5,  4,  3,  2,  1,  0,
+                         15, 14, 13, 12, 11, 10,  9,  8 );
+}
+
+template< int Size >
+DLISIO_TARGET("ssse3")
+__m128i bswap_ssse3( __m128i x ) noexcept {
+    return _mm_shuffle_epi8( x, bswap_mask< Size >() );
+}
+
+DLISIO_TARGET("sse2")
+__m128i ibm2ieee( __m128i u ) noexcept {
+    const __m128i manthi = _mm_and_si128( u, _mm_set1_epi32( 0x00FFFFFF ) );
+    const __m128i ix = _mm_srli_epi32( manthi, 21 );
+
+    /* comparisons are -1 when true, and ix < 1 => ix < 2 => ix < 4 */
+    const __m128i c1 = _mm_cmpgt_epi32( _mm_set1_epi32( 1 ), ix );
+    const __m128i c2 = _mm_cmpgt_epi32( _mm_set1_epi32( 2 ), ix );
+    const __m128i c4 = _mm_cmpgt_epi32( _mm_set1_epi32( 4 ), ix );
+    const __m128i s = _mm_sub_epi32( _mm_setzero_si128(),
+                      _mm_add_epi32( _mm_add_epi32( c1, c2 ), c4 ) );
+
+    /* manthi << s, by doubling once for every comparison that holds */
+    __m128i m = manthi;
+    m = _mm_add_epi32( m, _mm_and_si128( m, c4 ) );
+    m = _mm_add_epi32( m, _mm_and_si128( m, c2 ) );
+    m = _mm_add_epi32( m, _mm_and_si128( m, c1 ) );
+
+    const __m128i bias = _mm_add_epi32( _mm_set1_epi32( 0x20C00000 ),
+                                        _mm_slli_epi32( s, 22 ) );
+    const __m128i exp = _mm_and_si128( u, _mm_set1_epi32( 0x7F000000 ) );
+    m = _mm_add_epi32( m, _mm_slli_epi32( _mm_sub_epi32( exp, bias ), 1 ) );
+
+    const __m128i inabs = _mm_and_si128( u, _mm_set1_epi32( 0x7FFFFFFF ) );
+    const __m128i big = _mm_cmpgt_epi32( inabs, _mm_set1_epi32( 0x611FFFFF ) );
+    m = _mm_or_si128( _mm_andnot_si128( big, m ),
+                      _mm_and_si128( big, _mm_set1_epi32( 0x7FFFFFFF ) ) );
+
+    const __m128i signbit = _mm_set1_epi32( -0x7FFFFFFF - 1 );
+    m = _mm_or_si128( m, _mm_and_si128( u, signbit ) );
+
+    const __m128i small = _mm_cmpgt_epi32( _mm_set1_epi32( 0x21200000 ), inabs );
+    return _mm_andnot_si128( small, m );
+}
+
+/*
+ * x is 4 VAX floats, as loaded from the file (little-endian words)
+ */
+DLISIO_TARGET("sse2")
+__m128i vax2ieee( __m128i x ) noexcept {
+    const __m128i v = _mm_or_si128( _mm_slli_epi32( x, 16 ),
+                                    _mm_srli_epi32( x, 16 ) );
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i signbit = _mm_set1_epi32( -0x7FFFFFFF - 1 );
+    const __m128i sign = _mm_and_si128( v, signbit );
+    const __m128i frac = _mm_and_si128( v, _mm_set1_epi32( 0x007FFFFF ) );
+    const __m128i exp  = _mm_and_si128( _mm_srli_epi32( v, 23 ),
+                                        _mm_set1_epi32( 0xFF ) );
+
+    const __m128i eb = _mm_add_epi32( exp, _mm_set1_epi32( 1023 - 128 ) );
+    const __m128d scalelo = _mm_castsi128_pd(
+        _mm_slli_epi64( _mm_unpacklo_epi32( eb, zero ), 52 ) );
+    const __m128d scalehi = _mm_castsi128_pd(
+        _mm_slli_epi64( _mm_unpackhi_epi32( eb, zero ), 52 ) );
+
+    const __m128d half = _mm_set1_pd( 0.5 );
+    const __m128d ulp  = _mm_set1_pd( 1.0 / 8388608.0 );
+    const __m128d fraclo = _mm_cvtepi32_pd( frac );
+    const __m128d frachi = _mm_cvtepi32_pd( _mm_srli_si128( frac, 8 ) );
+
+    const __m128d lo = _mm_mul_pd( _mm_add_pd( half, _mm_mul_pd( fraclo, ulp ) ),
+                                   scalelo );
+    const __m128d hi = _mm_mul_pd( _mm_add_pd( half, _mm_mul_pd( frachi, ulp ) ),
+                                   scalehi );
+
+    const __m128i u = _mm_or_si128(
+        _mm_castps_si128( _mm_movelh_ps( _mm_cvtpd_ps( lo ),
+                                         _mm_cvtpd_ps( hi ) ) ),
+        sign );
+
+    const __m128i ez = _mm_cmpeq_epi32( exp, zero );
+    const __m128i nan = _mm_and_si128( _mm_cmpeq_epi32( sign, signbit ),
+                                       _mm_set1_epi32( 0x7FC00000 ) );
+    return _mm_or_si128( _mm_andnot_si128( ez, u ), _mm_and_si128( ez, nan ) );
+}
+
+template< int Size >
+DLISIO_TARGET("avx2")
+__m256i bswap_avx2( __m256i x ) noexcept {
+    const __m128i mask = bswap_mask< Size >();
+    return _mm256_shuffle_epi8( x, _mm256_broadcastsi128_si256( mask ) );
+}
+
+DLISIO_TARGET("avx2")
+__m256i ibm2ieee( __m256i u ) noexcept {
+    const __m256i manthi = _mm256_and_si256( u, _mm256_set1_epi32( 0x00FFFFFF ) );
+    const __m256i ix = _mm256_srli_epi32( manthi, 21 );
+
+    const __m256i c1 = _mm256_cmpgt_epi32( _mm256_set1_epi32( 1 ), ix );
+    const __m256i c2 = _mm256_cmpgt_epi32( _mm256_set1_epi32( 2 ), ix );
+    const __m256i c4 = _mm256_cmpgt_epi32( _mm256_set1_epi32( 4 ), ix );
+    const __m256i s = _mm256_sub_epi32( _mm256_setzero_si256(),
+                      _mm256_add_epi32( _mm256_add_epi32( c1, c2 ), c4 ) );
+
+    const __m256i m0 = _mm256_sllv_epi32( manthi, s );
+    const __m256i bias = _mm256_add_epi32( _mm256_set1_epi32( 0x20C00000 ),
+                                           _mm256_slli_epi32( s, 22 ) );
+    const __m256i exp = _mm256_and_si256( u, _mm256_set1_epi32( 0x7F000000 ) );
+    __m256i m = _mm256_add_epi32( m0,
+                _mm256_slli_epi32( _mm256_sub_epi32( exp, bias ), 1 ) );
+
+    const __m256i inabs = _mm256_and_si256( u, _mm256_set1_epi32( 0x7FFFFFFF ) );
+    const __m256i big = _mm256_cmpgt_epi32( inabs,
+                                            _mm256_set1_epi32( 0x611FFFFF ) );
+    m = _mm256_blendv_epi8( m, _mm256_set1_epi32( 0x7FFFFFFF ), big );
+
+    const __m256i signbit = _mm256_set1_epi32( -0x7FFFFFFF - 1 );
+    m = _mm256_or_si256( m, _mm256_and_si256( u, signbit ) );
+
+    const __m256i small = _mm256_cmpgt_epi32( _mm256_set1_epi32( 0x21200000 ),
+                                              inabs );
+    return _mm256_andnot_si256( small, m );
+}
+
+DLISIO_TARGET("avx2")
+__m256i vax2ieee( __m256i x ) noexcept {
+    const __m256i v = _mm256_or_si256( _mm256_slli_epi32( x, 16 ),
+                                       _mm256_srli_epi32( x, 16 ) );
+
+    const __m256i signbit = _mm256_set1_epi32( -0x7FFFFFFF - 1 );
+    const __m256i sign = _mm256_and_si256( v, signbit );
+    const __m256i frac = _mm256_and_si256( v, _mm256_set1_epi32( 0x007FFFFF ) );
+    const __m256i exp  = _mm256_and_si256( _mm256_srli_epi32( v, 23 ),
+                                           _mm256_set1_epi32( 0xFF ) );
+
+    const __m256i eb = _mm256_add_epi32( exp, _mm256_set1_epi32( 1023 - 128 ) );
+    const __m256d scalelo = _mm256_castsi256_pd( _mm256_slli_epi64(
+        _mm256_cvtepu32_epi64( _mm256_castsi256_si128( eb ) ), 52 ) );
+    const __m256d scalehi = _mm256_castsi256_pd( _mm256_slli_epi64(
+        _mm256_cvtepu32_epi64( _mm256_extracti128_si256( eb, 1 ) ), 52 ) );
+
+    const __m256d half = _mm256_set1_pd( 0.5 );
+    const __m256d ulp  = _mm256_set1_pd( 1.0 / 8388608.0 );
+    const __m256d fraclo = _mm256_cvtepi32_pd( _mm256_castsi256_si128( frac ) );
+    const __m256d frachi = _mm256_cvtepi32_pd( _mm256_extracti128_si256( frac, 1 ) );
+
+    const __m256d lo = _mm256_mul_pd(
+        _mm256_add_pd( half, _mm256_mul_pd( fraclo, ulp ) ), scalelo );
+    const __m256d hi = _mm256_mul_pd(
+        _mm256_add_pd( half, _mm256_mul_pd( frachi, ulp ) ), scalehi );
+
+    const __m256 f = _mm256_insertf128_ps(
+        _mm256_castps128_ps256( _mm256_cvtpd_ps( lo ) ),
+        _mm256_cvtpd_ps( hi ),
+        1 );
+    const __m256i u = _mm256_or_si256( _mm256_castps_si256( f ), sign );
+
+    const __m256i ez = _mm256_cmpeq_epi32( exp, _mm256_setzero_si256() );
+    const __m256i nan = _mm256_and_si256( _mm256_cmpeq_epi32( sign, signbit ),
+                                          _mm256_set1_epi32( 0x7FC00000 ) );
+    return _mm256_blendv_epi8( u, nan, ez );
+}
+
+template< int Size >
+DLISIO_TARGET("avx512f,avx512bw")
+__m512i bswap_avx512( __m512i x ) noexcept {
+    /* bswap_mask, as 64-bit words, repeated in every 128-bit lane */
+    const long long lo = Size == 2 ? 0x0607040502030001LL
+                       : Size == 4 ? 0x0405060700010203LL
+                       :             0x0001020304050607LL;
+    const long long hi = lo + 0x0808080808080808LL;
+    return _mm512_shuffle_epi8( x, _mm512_set4_epi64( hi, lo, hi, lo ) );
+}
+
+template< int Size >
+DLISIO_TARGET("sse2")
+void swap_sse2( const char* src, std::size_t n, char* dst ) noexcept {
+    const std::size_t bytes = n * Size;
+    std::size_t i = 0;
+    for( ; i + 16 <= bytes; i += 16 ) {
+        const auto x = _mm_loadu_si128( (const __m128i*)( src + i ) );
+        _mm_storeu_si128( (__m128i*)( dst + i ), bswap_sse2< Size >( x ) );
+    }
+
+    swap_scalar< Size >( src + i, n - i / Size, dst + i );
+}
+
+template< int Size >
+DLISIO_TARGET("ssse3")
+void swap_ssse3( const char* src, std::size_t n, char* dst ) noexcept {
+    const std::size_t bytes = n * Size;
+    std::size_t i = 0;
+    for( ; i + 16 <= bytes; i += 16 ) {
+        const auto x = _mm_loadu_si128( (const __m128i*)( src + i ) );
+        _mm_storeu_si128( (__m128i*)( dst + i ), bswap_ssse3< Size >( x ) );
+    }
+
+    swap_scalar< Size >( src + i, n - i / Size, dst + i );
+}
+
+template< int Size >
+DLISIO_TARGET("avx2")
+void swap_avx2( const char* src, std::size_t n, char* dst ) noexcept {
+    const std::size_t bytes = n * Size;
+    std::size_t i = 0;
+    for( ; i + 32 <= bytes; i += 32 ) {
+        const auto x = _mm256_loadu_si256( (const __m256i*)( src + i ) );
+        _mm256_storeu_si256( (__m256i*)( dst + i ), bswap_avx2< Size >( x ) );
+    }
+
+    swap_ssse3< Size >( src + i, n - i / Size, dst + i );
+}
+
+template< int Size >
+DLISIO_TARGET("avx512f,avx512bw")
+void swap_avx512( const char* src, std::size_t n, char* dst ) noexcept {
+    const std::size_t bytes = n * Size;
+    std::size_t i = 0;
+    for( ; i + 64 <= bytes; i += 64 ) {
+        const auto x = _mm512_loadu_si512( (const void*)( src + i ) );
+        _mm512_storeu_si512( (void*)( dst + i ), bswap_avx512< Size >( x ) );
+    }
+
+    swap_avx2< Size >( src + i, n - i / Size, dst + i );
+}
+
+DLISIO_TARGET("sse2")
+void isingl_sse2( const char* src, std::size_t n, float* dst ) noexcept {
+    std::size_t i = 0;
+    for( ; i + 4 <= n; i += 4 ) {
+        auto x = _mm_loadu_si128( (const __m128i*)( src + i * 4 ) );
+        x = ibm2ieee( bswap_sse2< 4 >( x ) );
+        _mm_storeu_si128( (__m128i*)( dst + i ), x );
+    }
+
+    isingl_scalar( src + i * 4, n - i, dst + i );
+}
+
+DLISIO_TARGET("ssse3")
+void isingl_ssse3( const char* src, std::size_t n, float* dst ) noexcept {
+    std::size_t i = 0;
+    for( ; i + 4 <= n; i += 4 ) {
+        auto x = _mm_loadu_si128( (const __m128i*)( src + i * 4 ) );
+        x = ibm2ieee( bswap_ssse3< 4 >( x ) );
+        _mm_storeu_si128( (__m128i*)( dst + i ), x );
+    }
+
+    isingl_scalar( src + i * 4, n - i, dst + i );
+}
+
+DLISIO_TARGET("avx2")
+void isingl_avx2( const char* src, std::size_t n, float* dst ) noexcept {
+    std::size_t i = 0;
+    for( ; i + 8 <= n; i += 8 ) {
+        auto x = _mm256_loadu_si256( (const __m256i*)( src + i * 4 ) );
+        x = ibm2ieee( bswap_avx2< 4 >( x ) );
+        _mm256_storeu_si256( (__m256i*)( dst + i ), x );
+    }
+
+    isingl_ssse3( src + i * 4, n - i, dst + i );
+}
+
+DLISIO_TARGET("sse2")
+void vsingl_sse2( const char* src, std::size_t n, float* dst ) noexcept {
+    std::size_t i = 0;
+    for( ; i + 4 <= n; i += 4 ) {
+        const auto x = _mm_loadu_si128( (const __m128i*)( src + i * 4 ) );
+        _mm_storeu_si128( (__m128i*)( dst + i ), vax2ieee( x ) );
+    }
+
+    vsingl_scalar( src + i * 4, n - i, dst + i );
+}
+
+DLISIO_TARGET("avx2")
+void vsingl_avx2( const char* src, std::size_t n, float* dst ) noexcept {
+    std::size_t i = 0;
+    for( ; i + 8 <= n; i += 8 ) {
+        const auto x = _mm256_loadu_si256( (const __m256i*)( src + i * 4 ) );
+        _mm256_storeu_si256( (__m256i*)( dst + i ), vax2ieee( x ) );
+    }
+
+    vsingl_sse2( src + i * 4, n - i, dst + i );
+}
+
+#endif // DLISIO_X86
+
+#ifdef DLISIO_NEON
+
+template< int Size >
+uint8x16_t bswap_neon( uint8x16_t x ) noexcept {
+    return Size == 2 ? vrev16q_u8( x )
+         : Size == 4 ? vrev32q_u8( x )
+         :             vrev64q_u8( x );
+}
+
+uint32x4_t ibm2ieee( uint32x4_t u ) noexcept {
+    const uint32x4_t manthi = vandq_u32( u, vdupq_n_u32( 0x00FFFFFF ) );
+    const uint32x4_t ix = vshrq_n_u32( manthi, 21 );
+
+    const uint32x4_t c1 = vcltq_u32( ix, vdupq_n_u32( 1 ) );
+    const uint32x4_t c2 = vcltq_u32( ix, vdupq_n_u32( 2 ) );
+    const uint32x4_t c4 = vcltq_u32( ix, vdupq_n_u32( 4 ) );
+    const uint32x4_t s = vsubq_u32( vdupq_n_u32( 0 ),
+                         vaddq_u32( vaddq_u32( c1, c2 ), c4 ) );
+
+    const uint32x4_t m0 = vshlq_u32( manthi, vreinterpretq_s32_u32( s ) );
+    const uint32x4_t bias = vaddq_u32( vdupq_n_u32( 0x20C00000 ),
+                                       vshlq_n_u32( s, 22 ) );
+    const uint32x4_t exp = vandq_u32( u, vdupq_n_u32( 0x7F000000 ) );
+    uint32x4_t m = vaddq_u32( m0, vshlq_n_u32( vsubq_u32( exp, bias ), 1 ) );
+
+    const uint32x4_t inabs = vandq_u32( u, vdupq_n_u32( 0x7FFFFFFF ) );
+    const uint32x4_t big = vcgtq_u32( inabs, vdupq_n_u32( 0x611FFFFF ) );
+    m = vbslq_u32( big, vdupq_n_u32( 0x7FFFFFFF ), m );
+    m = vorrq_u32( m, vandq_u32( u, vdupq_n_u32( 0x80000000 ) ) );
+
+    const uint32x4_t small = vcltq_u32( inabs, vdupq_n_u32( 0x21200000 ) );
+    return vbicq_u32( m, small );
+}
+
+template< int Size >
+void swap_neon( const char* src, std::size_t n, char* dst ) noexcept {
+    const std::size_t bytes = n * Size;
+    std::size_t i = 0;
+    for( ; i + 16 <= bytes; i += 16 ) {
+        const auto x = vld1q_u8( (const std::uint8_t*)( src + i ) );
+        vst1q_u8( (std::uint8_t*)( dst + i ), bswap_neon< Size >( x ) );
+    }
+
+    swap_scalar< Size >( src + i, n - i / Size, dst + i );
+}
+
+void isingl_neon( const char* src, std::size_t n, float* dst ) noexcept {
+    std::size_t i = 0;
+    for( ; i + 4 <= n; i += 4 ) {
+        const auto x = vld1q_u8( (const std::uint8_t*)( src + i * 4 ) );
+        const auto u = ibm2ieee( vreinterpretq_u32_u8( bswap_neon< 4 >( x ) ) );
+        vst1q_u8( (std::uint8_t*)( dst + i ), vreinterpretq_u8_u32( u ) );
+    }
+
+    isingl_scalar( src + i * 4, n - i, dst + i );
+}
+
+#endif // DLISIO_NEON
+
+/*
+ * The kernels for each level. Levels are ordered, so that a CPU that supports
+ * one x86 level supports all the ones below it
+ */
+using swap_kernel = void (*)( const char*, std::size_t, char* );
+using float_kernel = void (*)( const char*, std::size_t, float* );
+
+struct kernels {
+    int level;
+    swap_kernel swap2;
+    swap_kernel swap4;
+    swap_kernel swap8;
+    float_kernel isingl;
+    float_kernel vsingl;
+};
+
+const kernels scalar_kernels = {
+    DLIS_SIMD_SCALAR,
+    swap_scalar< 2 >, swap_scalar< 4 >, swap_scalar< 8 >,
+    isingl_scalar, vsingl_scalar,
+};
+
+#ifdef DLISIO_X86
+const kernels sse2_kernels = {
+    DLIS_SIMD_SSE2,
+    swap_sse2< 2 >, swap_sse2< 4 >, swap_sse2< 8 >,
+    isingl_sse2, vsingl_sse2,
+};
+
+const kernels ssse3_kernels = {
+    DLIS_SIMD_SSSE3,
+    swap_ssse3< 2 >, swap_ssse3< 4 >, swap_ssse3< 8 >,
+    isingl_ssse3, vsingl_sse2,
+};
+
+const kernels avx2_kernels = {
+    DLIS_SIMD_AVX2,
+    swap_avx2< 2 >, swap_avx2< 4 >, swap_avx2< 8 >,
+    isingl_avx2, vsingl_avx2,
+};
+
+const kernels avx512_kernels = {
+    DLIS_SIMD_AVX512,
+    swap_avx512< 2 >, swap_avx512< 4 >, swap_avx512< 8 >,
+    isingl_avx2, vsingl_avx2,
+};
+
+void cpuid( unsigned leaf, unsigned subleaf, unsigned regs[ 4 ] ) noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int r[ 4 ];
+    __cpuidex( r, int( leaf ), int( subleaf ) );
+    for( int i = 0; i < 4; ++i ) regs[ i ] = unsigned( r[ i ] );
+#else
+    __cpuid_count( leaf, subleaf, regs[ 0 ], regs[ 1 ], regs[ 2 ], regs[ 3 ] );
+#endif
+}
+
+/*
+ * The register state the OS saves on context switches (XCR0). Only valid if
+ * cpuid reports OSXSAVE
+ */
+std::uint64_t xgetbv() noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return _xgetbv( 0 );
+#else
+    unsigned eax, edx;
+    __asm__ __volatile__( "xgetbv" : "=a"( eax ), "=d"( edx ) : "c"( 0 ) );
+    return std::uint64_t( edx ) << 32 | eax;
+#endif
+}
+
+/*
+ * The widest level both the CPU and the OS support. The wide registers are
+ * only usable if the OS saves them, which is what xgetbv tells
+ */
+int detect() noexcept {
+    unsigned regs[ 4 ];
+    cpuid( 0, 0, regs );
+    const unsigned maxleaf = regs[ 0 ];
+
+    cpuid( 1, 0, regs );
+    const unsigned ecx1 = regs[ 2 ];
+    const unsigned edx1 = regs[ 3 ];
+
+    if( !(edx1 & (1u << 26)) ) return DLIS_SIMD_SCALAR;
+    if( !(ecx1 & (1u <<  9)) ) return DLIS_SIMD_SSE2;
+
+    const bool osxsave = ecx1 & (1u << 27);
+    const bool avx     = ecx1 & (1u << 28);
+    if( !osxsave || !avx || maxleaf < 7 ) return DLIS_SIMD_SSSE3;
+
+    const std::uint64_t xcr0 = xgetbv();
+    if( (xcr0 & 0x06) != 0x06 ) return DLIS_SIMD_SSSE3;
+
+    cpuid( 7, 0, regs );
+    const unsigned ebx7 = regs[ 1 ];
+    if( !(ebx7 & (1u << 5)) ) return DLIS_SIMD_SSSE3;
+
+    const bool avx512f  = ebx7 & (1u << 16);
+    const bool avx512bw = ebx7 & (1u << 30);
+    if( !avx512f || !avx512bw || (xcr0 & 0xE6) != 0xE6 )
+        return DLIS_SIMD_AVX2;
+
+    return DLIS_SIMD_AVX512;
+}
+#endif // DLISIO_X86
+
+#ifdef DLISIO_NEON
+const kernels neon_kernels = {
+    DLIS_SIMD_NEON,
+    swap_neon< 2 >, swap_neon< 4 >, swap_neon< 8 >,
+    isingl_neon, vsingl_scalar,
+};
+#endif
+
+int best() noexcept {
+#if defined(DLISIO_X86)
+    static const int level = detect();
+    return level;
+#elif defined(DLISIO_NEON)
+    return DLIS_SIMD_NEON;
+#else
+    return DLIS_SIMD_SCALAR;
+#endif
+}
+
+const kernels* kernels_for( int level ) noexcept {
+    switch( level ) {
+#ifdef DLISIO_X86
+        case DLIS_SIMD_SSE2:   return &sse2_kernels;
+        case DLIS_SIMD_SSSE3:  return &ssse3_kernels;
+        case DLIS_SIMD_AVX2:   return &avx2_kernels;
+        case DLIS_SIMD_AVX512: return &avx512_kernels;
+#endif
+#ifdef DLISIO_NEON
+        case DLIS_SIMD_NEON:   return &neon_kernels;
+#endif
+        default:               return &scalar_kernels;
+    }
+}
+
+std::atomic< const kernels* >& active() noexcept {
+    static std::atomic< const kernels* > current( kernels_for( best() ) );
+    return current;
+}
+
+const kernels& dispatch() noexcept {
+    return *active().load( std::memory_order_relaxed );
+}
+
+template< int Size >
+swap_kernel swapper( const kernels& k ) noexcept {
+    return Size == 2 ? k.swap2 : Size == 4 ? k.swap4 : k.swap8;
+}
+
+template< typename T >
+const char* swap_n( const char* src,
+                    std::size_t stride,
+                    std::size_t n,
+                    T* dst ) noexcept {
+    if( stride == sizeof( T ) ) {
+        swapper< sizeof( T ) >( dispatch() )( src, n, (char*)dst );
+        return src + n * stride;
+    }
+
+    for( std::size_t i = 0; i < n; ++i ) {
+        T x;
+        std::memcpy( &x, src + i * stride, sizeof( T ) );
+        dst[ i ] = ntoh( x );
+    }
+
+    return src + n * stride;
+}
+
+template< typename T >
+const char* copy_n( const char* src,
+                    std::size_t stride,
+                    std::size_t n,
+                    T* dst ) noexcept {
+    static_assert( sizeof( T ) == 1, "copy_n is for single bytes" );
+
+    if( stride == 1 ) {
+        if( n > 0 ) std::memcpy( dst, src, n );
+        return src + n;
+    }
+
+    for( std::size_t i = 0; i < n; ++i )
+        std::memcpy( dst + i, src + i * stride, 1 );
+
+    return src + n * stride;
+}
+
+/*
+ * Validated and complex values are Components consecutive values of the same
+ * type, and contiguous runs of them are just longer runs of the simple type
+ */
+template< int Components, typename T, typename F >
+const char* tuple_n( const char* src,
+                     std::size_t stride,
+                     std::size_t n,
+                     T* dst,
+                     F simple ) noexcept {
+    if( stride == Components * sizeof( T ) ) {
+        simple( src, sizeof( T ), n * Components, dst );
+        return src + n * stride;
+    }
+
+    for( std::size_t i = 0; i < n; ++i )
+        simple( src + i * stride, sizeof( T ), Components, dst + i * Components );
+
+    return src + n * stride;
+}
+
+}
+
+const char* dlis_sshort_n( const char* src,
+                           size_t stride,
+                           size_t n,
+                           std::int8_t* dst ) {
+    return copy_n( src, stride, n, dst );
+}
+
+const char* dlis_snorm_n( const char* src,
+                          size_t stride,
+                          size_t n,
+                          std::int16_t* dst ) {
+    return swap_n( src, stride, n, dst );
+}
+
+const char* dlis_slong_n( const char* src,
+                          size_t stride,
+                          size_t n,
+                          std::int32_t* dst ) {
+    return swap_n( src, stride, n, dst );
+}
+
+const char* dlis_ushort_n( const char* src,
+                           size_t stride,
+                           size_t n,
+                           std::uint8_t* dst ) {
+    return copy_n( src, stride, n, dst );
+}
+
+const char* dlis_unorm_n( const char* src,
+                          size_t stride,
+                          size_t n,
+                          std::uint16_t* dst ) {
+    return swap_n( src, stride, n, dst );
+}
+
+const char* dlis_ulong_n( const char* src,
+                          size_t stride,
+                          size_t n,
+                          std::uint32_t* dst ) {
+    return swap_n( src, stride, n, dst );
+}
+
+const char* dlis_fshort_n( const char* src,
+                           size_t stride,
+                           size_t n,
+                           float* dst ) {
+    for( std::size_t i = 0; i < n; ++i ) {
+        std::uint16_t v;
+        std::memcpy( &v, src + i * stride, sizeof( v ) );
+        dst[ i ] = fshort2ieee( ntoh( v ) );
+    }
+
+    return src + n * stride;
+}
+
+const char* dlis_fsingl_n( const char* src,
+                           size_t stride,
+                           size_t n,
+                           float* dst ) {
+    static_assert(
+        std::numeric_limits< float >::is_iec559 && sizeof( float ) == 4,
+        "Function assumes IEEE 754 32-bit float" );
+
+    return swap_n( src, stride, n, dst );
+}
+
+const char* dlis_fdoubl_n( const char* src,
+                           size_t stride,
+                           size_t n,
+                           double* dst ) {
+    static_assert(
+        std::numeric_limits< double >::is_iec559 && sizeof( double ) == 8,
+        "Function assumes IEEE 754 64-bit float" );
+
+    return swap_n( src, stride, n, dst );
+}
+
+const char* dlis_isingl_n( const char* src,
+                           size_t stride,
+                           size_t n,
+                           float* dst ) {
+    if( stride == sizeof( std::uint32_t ) ) {
+        dispatch().isingl( src, n, dst );
+        return src + n * stride;
+    }
+
+    for( std::size_t i = 0; i < n; ++i )
+        isingl_scalar( src + i * stride, 1, dst + i );
+
+    return src + n * stride;
+}
+
+const char* dlis_vsingl_n( const char* src,
+                           size_t stride,
+                           size_t n,
+                           float* dst ) {
+    if( stride == sizeof( std::uint32_t ) ) {
+        dispatch().vsingl( src, n, dst );
+        return src + n * stride;
+    }
+
+    for( std::size_t i = 0; i < n; ++i )
+        vsingl_scalar( src + i * stride, 1, dst + i );
+
+    return src + n * stride;
+}
+
+const char* dlis_fsing1_n( const char* src,
+                           size_t stride,
+                           size_t n,
+                           float* dst ) {
+    return tuple_n< 2 >( src, stride, n, dst, dlis_fsingl_n );
+}
+
+const char* dlis_fsing2_n( const char* src,
+                           size_t stride,
+                           size_t n,
+                           float* dst ) {
+    return tuple_n< 3 >( src, stride, n, dst, dlis_fsingl_n );
+}
+
+const char* dlis_csingl_n( const char* src,
+                           size_t stride,
+                           size_t n,
+                           float* dst ) {
+    return tuple_n< 2 >( src, stride, n, dst, dlis_fsingl_n );
+}
+
+const char* dlis_fdoub1_n( const char* src,
+                           size_t stride,
+                           size_t n,
+                           double* dst ) {
+    return tuple_n< 2 >( src, stride, n, dst, dlis_fdoubl_n );
+}
+
+const char* dlis_fdoub2_n( const char* src,
+                           size_t stride,
+                           size_t n,
+                           double* dst ) {
+    return tuple_n< 3 >( src, stride, n, dst, dlis_fdoubl_n );
+}
+
+const char* dlis_cdoubl_n( const char* src,
+                           size_t stride,
+                           size_t n,
+                           double* dst ) {
+    return tuple_n< 2 >( src, stride, n, dst, dlis_fdoubl_n );
+}
+
+const char* dlis_status_n( const char* src,
+                           size_t stride,
+                           size_t n,
+                           std::uint8_t* dst ) {
+    return copy_n( src, stride, n, dst );
+}
+
+int dlis_simd_supported( int level ) {
+    if( level == DLIS_SIMD_SCALAR ) return 1;
+
+#ifdef DLISIO_X86
+    if( level >= DLIS_SIMD_SSE2 && level <= DLIS_SIMD_AVX512 )
+        return level <= best();
+#endif
+
+#ifdef DLISIO_NEON
+    if( level == DLIS_SIMD_NEON ) return 1;
+#endif
+
+    return 0;
+}
+
+int dlis_simd_level() {
+    return dispatch().level;
+}
+
+int dlis_simd_set( int level ) {
+    if( !dlis_simd_supported( level ) ) return DLIS_UNEXPECTED_VALUE;
+    active().store( kernels_for( level ) );
+    return DLIS_OK;
+}
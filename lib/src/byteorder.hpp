@@ -0,0 +1,84 @@
+#ifndef DLISIO_BYTEORDER_HPP
+#define DLISIO_BYTEORDER_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/*
+ * Private to the library - shared by the scalar and bulk type parsers
+ */
+namespace {
+
+/*
+ * Until the scope of network <-> host transformation is known, just copy the
+ * implementation into the test program to avoid hassle with linking winsock
+ */
+#ifdef HOST_BIG_ENDIAN
+
+template< typename T > T hton( T value ) noexcept { return value; }
+template< typename T > T ntoh( T value ) noexcept { return value; }
+
+#else
+
+template< typename T >
+typename std::enable_if< sizeof(T) == 1, T >::type
+hton( T value ) noexcept {
+    return value;
+}
+
+template< typename T >
+typename std::enable_if< sizeof(T) == 2, T >::type
+hton( T value ) noexcept {
+    std::uint16_t v;
+    std::memcpy( &v, &value, sizeof( T ) );
+    v = ((v & 0x00FF) << 8)
+      | ((v & 0xFF00) >> 8)
+      ;
+    std::memcpy( &value, &v, sizeof( T ) );
+    return value;
+}
+
+template< typename T >
+typename std::enable_if< sizeof(T) == 4, T >::type
+hton( T value ) noexcept {
+    std::uint32_t v;
+    std::memcpy( &v, &value, sizeof( T ) );
+    v = ((v & 0x000000FF) << 24)
+      | ((v & 0x0000FF00) <<  8)
+      | ((v & 0x00FF0000) >>  8)
+      | ((v & 0xFF000000) >> 24)
+      ;
+    std::memcpy( &value, &v, sizeof( T ) );
+    return value;
+}
+
+template< typename T >
+typename std::enable_if< sizeof(T) == 8, T >::type
+hton( T value ) noexcept {
+    std::uint64_t v;
+    std::memcpy( &v, &value, sizeof( T ) );
+    v = ((v & 0xFF00000000000000ull) >> 56)
+      | ((v & 0x00FF000000000000ull) >> 40)
+      | ((v & 0x0000FF0000000000ull) >> 24)
+      | ((v & 0x000000FF00000000ull) >>  8)
+      | ((v & 0x00000000FF000000ull) <<  8)
+      | ((v & 0x0000000000FF0000ull) << 24)
+      | ((v & 0x000000000000FF00ull) << 40)
+      | ((v & 0x00000000000000FFull) << 56)
+      ;
+    std::memcpy( &value, &v, sizeof( T ) );
+    return value;
+}
+
+// preserve the ntoh name for symmetry
+template< typename T >
+T ntoh( T value ) noexcept {
+    return hton( value );
+}
+
+#endif
+
+}
+
+#endif //DLISIO_BYTEORDER_HPP
@@ -4,81 +4,15 @@
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
+#include <limits>
 #include <string>
 
 #include <dlisio/dlisio.h>
 #include <dlisio/types.h>
 
-namespace {
+#include "byteorder.hpp"
 
-/*
- * Until the scope of network <-> host transformation is known, just copy the
- * implementation into the test program to avoid hassle with linking winsock
- */
-#ifdef HOST_BIG_ENDIAN
-
-template< typename T > T hton( T value ) noexcept { return value; }
-template< typename T > T ntoh( T value ) noexcept { return value; }
-
-#else
-
-template< typename T >
-typename std::enable_if< sizeof(T) == 1, T >::type
-hton( T value ) noexcept {
-    return value;
-}
-
-template< typename T >
-typename std::enable_if< sizeof(T) == 2, T >::type
-hton( T value ) noexcept {
-    std::uint16_t v;
-    std::memcpy( &v, &value, sizeof( T ) );
-    v = ((v & 0x00FF) << 8)
-      | ((v & 0xFF00) >> 8)
-      ;
-    std::memcpy( &value, &v, sizeof( T ) );
-    return value;
-}
-
-template< typename T >
-typename std::enable_if< sizeof(T) == 4, T >::type
-hton( T value ) noexcept {
-    std::uint32_t v;
-    std::memcpy( &v, &value, sizeof( T ) );
-    v = ((v & 0x000000FF) << 24)
-      | ((v & 0x0000FF00) <<  8)
-      | ((v & 0x00FF0000) >>  8)
-      | ((v & 0xFF000000) >> 24)
-      ;
-    std::memcpy( &value, &v, sizeof( T ) );
-    return value;
-}
-
-template< typename T >
-typename std::enable_if< sizeof(T) == 8, T >::type
-hton( T value ) noexcept {
-    std::uint64_t v;
-    std::memcpy( &v, &value, sizeof( T ) );
-    v = ((v & 0xFF00000000000000ull) >> 56)
-      | ((v & 0x00FF000000000000ull) >> 40)
-      | ((v & 0x0000FF0000000000ull) >> 24)
-      | ((v & 0x000000FF00000000ull) >>  8)
-      | ((v & 0x00000000FF000000ull) <<  8)
-      | ((v & 0x0000000000FF0000ull) << 24)
-      | ((v & 0x000000000000FF00ull) << 40)
-      | ((v & 0x00000000000000FFull) << 56)
-      ;
-    std::memcpy( &value, &v, sizeof( T ) );
-    return value;
-}
-
-// preserve the ntoh name for symmetry
-template< typename T >
-T ntoh( T value ) noexcept {
-    return hton( value );
-}
-
-#endif
+namespace {
 
 bool is_zero_string( const char* xs ) noexcept {
     /*
@@ -677,22 +611,54 @@ const char* dlis_objref( const char* xs, int32_t* ident_len,
     return dlis_obname( xs, origin, copy_number, objname_len, identifier );
 }
 
-const char* dlis_fshort( const char* xs, float* out ) {
-    std::uint16_t v;
-    const char* newptr = dlis_unorm( xs, &v );
+const char* dlis_obname_view( const char* xs, std::int32_t* origin,
+                                              std::uint8_t* copy_number,
+                                              std::int32_t* idlen,
+                                              const char** identifier ) {
+    /*
+     * The high bits of the first byte select the width of the origin (see
+     * dlis_uvari), which is then shifted out of the big-endian window and
+     * masked, rather than switched on. The copy number and identifier follow
+     * the origin, and can be read once its width is known
+     */
+    static const std::uint8_t widths[ 4 ] = { 1, 1, 2, 4 };
+    static const std::uint32_t masks[ 4 ] = {
+        0xFF, 0xFF, 0x3FFF, 0x3FFFFFFF
+    };
 
-    std::uint16_t sign_bit = v & 0x8000;
-    std::uint16_t exp_bits = v & 0x000F;
-    std::uint16_t frac_bits = (v & 0xFFF0) >> 4;
-    if( sign_bit )
-        frac_bits = (~frac_bits & 0x0FFF) + 1;
+    std::uint32_t window;
+    std::memcpy( &window, xs, sizeof( window ) );
+    window = ntoh( window );
 
-    float sign = sign_bit ? -1.0 : 1.0;
-    float exponent = float( exp_bits );
-    float fractional = frac_bits / float( 0x0800 );
+    const auto high = window >> 30;
+    const auto width = widths[ high ];
+    *origin = std::int32_t( (window >> (32 - 8 * width)) & masks[ high ] );
 
-    *out = sign * fractional * std::pow( 2.0f, exponent );
-    return newptr;
+    const auto* cur = reinterpret_cast< const unsigned char* >( xs ) + width;
+    *copy_number = cur[ 0 ];
+    *idlen = cur[ 1 ];
+    *identifier = xs + width + 2;
+    return *identifier + *idlen;
+}
+
+const char* dlis_objref_view( const char* xs, std::int32_t* ident_len,
+                                              const char** ident,
+                                              std::int32_t* origin,
+                                              std::uint8_t* copy_number,
+                                              std::int32_t* objname_len,
+                                              const char** identifier ) {
+    const auto len = static_cast< unsigned char >( xs[ 0 ] );
+    *ident_len = len;
+    *ident = xs + 1;
+    return dlis_obname_view( xs + 1 + len, origin,
+                                           copy_number,
+                                           objname_len,
+                                           identifier );
+}
+
+const char* dlis_fshort( const char* xs, float* out ) {
+    /* the conversion lives with the bulk version, see bulk.cpp */
+    return dlis_fshort_n( xs, 2, 1, out );
 }
 
 const char* dlis_fsingl( const char* xs, float* out ) {
@@ -716,60 +682,13 @@ const char* dlis_fdoubl( const char* xs, double* out ) {
 }
 
 const char* dlis_isingl( const char* xs, float* out ) {
-    static const std::uint32_t ieeemax = 0x7FFFFFFF;
-    static const std::uint32_t iemaxib = 0x611FFFFF;
-    static const std::uint32_t ieminib = 0x21200000;
-
-    static const std::uint32_t it[8] = {
-        0x21800000, 0x21400000, 0x21000000, 0x21000000,
-        0x20c00000, 0x20c00000, 0x20c00000, 0x20c00000 };
-    static const std::uint32_t mt[8] = { 8, 4, 2, 2, 1, 1, 1, 1 };
-    std::uint32_t manthi, iexp, inabs;
-    std::uint32_t ix;
-    std::uint32_t u;
-
-    std::memcpy( &u, xs, sizeof( std::uint32_t ) );
-    u = ntoh( u );
-
-    manthi = u & 0X00FFFFFF;
-    ix     = manthi >> 21;
-    iexp   = ( ( u & 0x7f000000 ) - it[ix] ) << 1;
-    manthi = manthi * mt[ix] + iexp;
-    inabs  = u & 0X7FFFFFFF;
-    if ( inabs > iemaxib ) manthi = ieeemax;
-    manthi = manthi | ( u & 0x80000000 );
-    u = ( inabs < ieminib ) ? 0 : manthi;
-
-    std::memcpy( out, &u, sizeof( std::uint32_t ) );
-    return xs + sizeof( std::uint32_t );
+    /* the conversion lives with the bulk version, see bulk.cpp */
+    return dlis_isingl_n( xs, 4, 1, out );
 }
 
 const char* dlis_vsingl( const char* xs, float* out ) {
-    std::uint8_t x[4];
-    std::memcpy( &x, xs, 4 );
-
-    std::uint32_t v = std::uint32_t(x[1]) << 24
-                    | std::uint32_t(x[0]) << 16
-                    | std::uint32_t(x[3]) << 8
-                    | std::uint32_t(x[2]) << 0
-                    ;
-
-    std::uint32_t sign_bit = v & 0x80000000;
-    std::uint32_t frac_bits = v & 0x007FFFFF;
-    std::uint32_t exp_bits = (v & 0x7F800000) >> 23;
-
-    float sign = sign_bit ? -1.0 : 1.0;
-    float exponent = float( exp_bits );
-    float significand = frac_bits / float( 0x00800000 );
-
-    if (exp_bits)
-        *out = sign * (0.5 + significand) * std::pow(2.0f, exponent - 128.0f);
-    else if (!sign_bit)
-        *out = 0;
-    else
-        *out = std::nanf("");
-
-    return xs + sizeof( std::uint32_t );
+    /* the conversion lives with the bulk version, see bulk.cpp */
+    return dlis_vsingl_n( xs, 4, 1, out );
 }
 
 const char* dlis_fsing1( const char* xs, float* V, float* A ) {
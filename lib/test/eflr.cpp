@@ -0,0 +1,519 @@
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <dlisio/types.h>
+#include <dlisio/ext/arena.hpp>
+#include <dlisio/ext/eflr.hpp>
+#include <dlisio/ext/index.hpp>
+#include <dlisio/ext/intern.hpp>
+#include <dlisio/ext/io.hpp>
+
+#include "helpers.hpp"
+
+namespace {
+
+const std::string sample = DLISIO_TEST_DATA
+                         "/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS";
+
+/*
+ * The example CHANNEL set from the specification, without segment headers
+ */
+const std::vector< unsigned char > stdrecord = {
+    0xF8,
+    0x07, 'C', 'H', 'A', 'N', 'N', 'E', 'L',
+    0x01, '0',
+
+    0x34,
+    0x09, 'L', 'O', 'N', 'G', '-', 'N', 'A', 'M', 'E',
+    0x17,
+
+    0x35,
+    0x0D, 'E', 'L', 'E', 'M', 'E', 'N', 'T', '-', 'L', 'I', 'M', 'I', 'T',
+    0x12,
+    0x01,
+
+    0x35,
+    0x13, 'R', 'E', 'P', 'R', 'E', 'S', 'E', 'N', 'T', 'A', 'T', 'I', 'O',
+          'N', '-', 'C', 'O', 'D', 'E',
+    0x0F,
+    0x02,
+
+    0x30,
+    0x05, 'U', 'N', 'I', 'T', 'S',
+
+    0x35,
+    0x09, 'D', 'I', 'M', 'E', 'N', 'S', 'I', 'O', 'N',
+    0x12,
+    0x01,
+
+    0x70,
+    0x00, 0x00, 0x04, 'T', 'I', 'M', 'E',
+    0x21, 0x00, 0x00, 0x01, '1',
+    0x20,
+    0x20,
+    0x21, 0x01, 's',
+
+    0x70,
+    0x01, 0x00, 0x08, 'P', 'R', 'E', 'S', 'S', 'U', 'R', 'E',
+    0x21, 0x00, 0x00, 0x01, '2',
+    0x20,
+    0x21, 0x07,
+    0x21, 0x03, 'p', 's', 'i',
+
+    0x70,
+    0x00, 0x01, 0x09, 'P', 'A', 'D', '-', 'A', 'R', 'R', 'A', 'Y',
+    0x21, 0x00, 0x00, 0x01, '3',
+    0x29, 0x02, 0x08, 0x14,
+    0x21, 0x0D,
+    0x00,
+    0x29, 0x02, 0x08, 0x0A,
+};
+
+std::vector< std::uint8_t > uvaris( const dl::value& v ) {
+    std::vector< std::uint8_t > xs;
+    for( auto* cur = v.bytes.first; cur != v.bytes.last; ++cur )
+        xs.push_back( std::uint8_t( *cur ) );
+    return xs;
+}
+
+}
+
+TEST_CASE("the example set from the specification is parsed", "[eflr]") {
+    const auto set = dl::parse_set( make_record( stdrecord ) );
+
+    CHECK( set.hastype );
+    CHECK( set.hasname );
+    CHECK( set.type.str() == "CHANNEL" );
+    CHECK( set.name.str() == "0" );
+
+    REQUIRE( set.tmpl.attributes.size() == 5 );
+    CHECK( set.tmpl.invariants.empty() );
+    CHECK( set.tmpl.attributes[ 0 ].label.str() == "LONG-NAME" );
+    CHECK( set.tmpl.attributes[ 0 ].reprc == DLIS_OBNAME );
+    CHECK( !set.tmpl.attributes[ 0 ].val.present );
+    CHECK( set.tmpl.attributes[ 4 ].label.str() == "DIMENSION" );
+
+    REQUIRE( set.objects.size() == 3 );
+    const auto& time     = set.objects[ 0 ];
+    const auto& pressure = set.objects[ 1 ];
+    const auto& pad      = set.objects[ 2 ];
+
+    CHECK( time.origin == 0 );
+    CHECK( time.copy == 0 );
+    CHECK( time.id.str() == "TIME" );
+    CHECK( pressure.id.str() == "PRESSURE" );
+    CHECK( pad.copy == 1 );
+    CHECK( pad.id.str() == "PAD-ARRAY" );
+
+    SECTION("objects that are cut short refer to the template") {
+        CHECK( time.size == 4 );
+        CHECK( &set.at( time, 4 ) == &set.tmpl.attributes[ 4 ] );
+        CHECK( uvaris( set.at( time, 4 ).val ) == std::vector< std::uint8_t >{ 1 } );
+
+        const auto& units = set.at( time, 3 );
+        CHECK( units.val.reprc == DLIS_IDENT );
+        CHECK( units.val.bytes.size() == 2 );
+    }
+
+    SECTION("values follow the overridden count and representation code") {
+        const auto& limit = set.at( pad, 1 );
+        CHECK( limit.count == 2 );
+        CHECK( limit.val.count == 2 );
+        CHECK( uvaris( limit.val ) == std::vector< std::uint8_t >{ 8, 20 } );
+
+        const auto& reprc = set.at( pressure, 2 );
+        CHECK( reprc.reprc == DLIS_USHORT );
+        CHECK( uvaris( reprc.val ) == std::vector< std::uint8_t >{ 7 } );
+    }
+
+    SECTION("absent attributes have no value") {
+        const auto& units = set.at( pad, 3 );
+        CHECK( !units.val.present );
+        CHECK( units.label.str() == "UNITS" );
+    }
+
+    SECTION("the set refers to, and keeps alive, the record") {
+        const auto& label = set.tmpl.attributes[ 1 ].label;
+        CHECK( label.first >= set.bytes.begin() );
+        CHECK( label.last <= set.bytes.end() );
+    }
+}
+
+TEST_CASE("values are formatted as text", "[eflr]") {
+    const auto set = dl::parse_set( make_record( stdrecord ) );
+    const auto& time     = set.objects[ 0 ];
+    const auto& pressure = set.objects[ 1 ];
+    const auto& pad      = set.objects[ 2 ];
+
+    using strings = std::vector< std::string >;
+    CHECK( dl::value_strings( set.at( time, 3 ).val ) == strings{ "s" } );
+    CHECK( dl::value_strings( set.at( pressure, 3 ).val )
+        == strings{ "psi" } );
+    CHECK( dl::value_strings( set.at( pressure, 2 ).val ) == strings{ "7" } );
+    CHECK( dl::value_strings( set.at( pad, 1 ).val )
+        == strings{ "8", "20" } );
+    CHECK( dl::value_strings( set.at( pad, 3 ).val ).empty() );
+
+    const auto make_value = []( int reprc,
+                                int count,
+                                const std::string& bytes ) {
+        dl::value v;
+        v.present = true;
+        v.reprc = reprc;
+        v.count = count;
+        v.bytes.first = bytes.data();
+        v.bytes.last = bytes.data() + bytes.size();
+        return v;
+    };
+
+    const std::string fsingl = { 0x3F, char( 0xC0 ), 0, 0,
+                                 char( 0xC0 ), 0x20, 0, 0 };
+    CHECK( dl::value_strings( make_value( DLIS_FSINGL, 2, fsingl ) )
+        == strings{ "1.5", "-2.5" } );
+    CHECK( dl::value_strings( make_value( DLIS_FSING1, 1, fsingl ) )
+        == strings{ "(1.5, -2.5)" } );
+
+    const std::string obname = { 0x02, 0x00, 0x04, '8', '0', '0', 'T' };
+    CHECK( dl::value_strings( make_value( DLIS_OBNAME, 1, obname ) )
+        == strings{ "(2, 0, 800T)" } );
+
+    const std::string objref = std::string( { 0x05, 'F', 'R', 'A', 'M', 'E' } )
+                             + obname;
+    CHECK( dl::value_strings( make_value( DLIS_OBJREF, 1, objref ) )
+        == strings{ "(FRAME, 2, 0, 800T)" } );
+
+    /* 1987-04-19 21:20:15.620, GMT, from the specification */
+    const std::string dtime = { 87, 0x24, 19, 21, 20, 15, 0x02, 0x6C };
+    CHECK( dl::value_strings( make_value( DLIS_DTIME, 1, dtime ) )
+        == strings{ "1987-04-19T21:20:15.620" } );
+
+    /* a 1-byte uvari at the very end of the value */
+    const std::string ascii = { 0x02, 'o', 'k' };
+    CHECK( dl::value_strings( make_value( DLIS_ASCII, 1, ascii ) )
+        == strings{ "ok" } );
+}
+
+TEST_CASE("attribute references are parsed and formatted", "[eflr]") {
+    const std::vector< unsigned char > record = {
+        0xF0,
+        0x04, 'T', 'E', 'S', 'T',
+
+        0x35,
+        0x03, 'R', 'E', 'F',
+        DLIS_ATTREF,
+        0x07, 'C', 'H', 'A', 'N', 'N', 'E', 'L',
+        0x02, 0x00, 0x04, '8', '0', '0', 'T',
+        0x05, 'U', 'N', 'I', 'T', 'S',
+
+        0x70,
+        0x00, 0x00, 0x01, 'A',
+    };
+
+    const auto set = dl::parse_set( make_record( record ) );
+    REQUIRE( set.tmpl.attributes.size() == 1 );
+    REQUIRE( set.objects.size() == 1 );
+
+    const auto& ref = set.at( set.objects[ 0 ], 0 );
+    CHECK( ref.reprc == DLIS_ATTREF );
+    CHECK( ref.val.bytes.size() == 8 + 7 + 6 );
+    CHECK( dl::value_strings( ref.val )
+        == std::vector< std::string >{ "(CHANNEL, 2, 0, 800T, UNITS)" } );
+
+    /* the trailing label is part of the value, and must be in the record */
+    const std::vector< unsigned char > truncated( record.begin(),
+                                                  record.end() - 5 - 1 );
+    CHECK_THROWS( dl::parse_set( make_record( truncated ) ) );
+}
+
+TEST_CASE("names are decoded up to the end of the value", "[eflr]") {
+    const std::vector< std::string > origins = {
+        "\x7F",
+        std::string( "\x80\x80", 2 ),
+        std::string( "\xC0\x00\x40\x00", 4 ),
+    };
+
+    for( const auto& origin : origins ) {
+        for( const std::string id : { "", "A", "800T" } ) {
+            INFO( "origin width " << origin.size() << ", id '" << id << "'" );
+            const auto name = origin + "\x02" + char( id.size() ) + id;
+            const auto ref = std::string( "\x05" "FRAME" ) + name;
+
+            /*
+             * Exactly as large as the name, so reading past it is reading
+             * past the allocation
+             */
+            const std::vector< char > xs( name.begin(), name.end() );
+            const std::vector< char > ys( ref.begin(), ref.end() );
+            const auto* end = xs.data() + xs.size();
+
+            std::int32_t orig;
+            std::uint8_t copy;
+            dl::span str, type;
+            CHECK( dl::obname_view( xs.data(), end, orig, copy, str ) == end );
+            CHECK( copy == 2 );
+            CHECK( str.str() == id );
+
+            const auto* refend = ys.data() + ys.size();
+            CHECK( dl::objref_view( ys.data(), refend, type, orig, copy, str )
+                == refend );
+            CHECK( type.str() == "FRAME" );
+            CHECK( str.str() == id );
+
+            CHECK_THROWS_AS(
+                dl::obname_view( xs.data(), end - 1, orig, copy, str ),
+                std::invalid_argument
+            );
+            CHECK_THROWS_AS(
+                dl::objref_view( ys.data(), refend - 1, type, orig, copy, str ),
+                std::invalid_argument
+            );
+        }
+    }
+}
+
+TEST_CASE("values in the sample file are formatted", "[eflr]") {
+    auto fp = dl::open_mmap( sample );
+    char sul[ 80 ];
+    fp->read( sul, sizeof( sul ) );
+    const auto marks = dl::index( *fp );
+
+    for( const auto& mark : marks ) {
+        if( !mark.isexplicit || mark.isencrypted ) continue;
+
+        fp->setpos( mark );
+        const auto set = dl::parse_set( dl::catrecord( *fp, mark.residual ) );
+        for( const auto& obj : set.objects ) {
+            for( std::size_t i = 0; i < set.tmpl.attributes.size(); ++i ) {
+                const auto& val = set.at( obj, i ).val;
+                const auto xs = dl::value_strings( val );
+                CHECK( xs.size() == std::size_t( val.present ? val.count
+                                                             : 0 ) );
+            }
+        }
+    }
+}
+
+TEST_CASE("invariant attributes are shared by all objects", "[eflr]") {
+    const std::vector< unsigned char > record = {
+        0xF0,
+        0x04, 'T', 'E', 'S', 'T',
+
+        0x30,
+        0x01, 'A',
+
+        0x55,
+        0x03, 'I', 'N', 'V',
+        DLIS_USHORT,
+        0x07,
+
+        0x70,
+        0x00, 0x00, 0x01, 'X',
+        0x21, 0x01, 'a',
+
+        0x70,
+        0x00, 0x00, 0x01, 'Y',
+    };
+
+    const auto set = dl::parse_set( make_record( record ) );
+    REQUIRE( set.tmpl.attributes.size() == 1 );
+    REQUIRE( set.tmpl.invariants.size() == 1 );
+    REQUIRE( set.objects.size() == 2 );
+
+    const auto& inv = set.tmpl.invariants[ 0 ];
+    CHECK( inv.label.str() == "INV" );
+    CHECK( inv.reprc == DLIS_USHORT );
+    CHECK( dl::value_strings( inv.val ) == std::vector< std::string >{ "7" } );
+
+    /* the invariant is not one of the cells the objects override */
+    CHECK( set.objects[ 0 ].size == 1 );
+    CHECK( set.objects[ 1 ].size == 0 );
+    CHECK( dl::value_strings( set.at( set.objects[ 0 ], 0 ).val )
+        == std::vector< std::string >{ "a" } );
+}
+
+TEST_CASE("truncated sets are rejected", "[eflr]") {
+    for( std::size_t n = 0; n < 80; ++n ) {
+        INFO( "set of " << n << " bytes" );
+        const auto begin = stdrecord.begin();
+        CHECK_THROWS_AS(
+            dl::parse_set( make_record( std::string( begin, begin + n ) ) ),
+            std::invalid_argument
+        );
+    }
+}
+
+TEST_CASE("missing labels are reported, not fatal", "[eflr]") {
+    auto xs = stdrecord;
+    /* ATTRIB:LR without label, i.e. ATTRIB:R, but the label still follows */
+    xs[ 11 ] = 0x24;
+
+    std::vector< std::string > warnings;
+    const auto set = dl::parse_set( make_record( xs ),
+        [&]( const std::string& msg ) { warnings.push_back( msg ); }
+    );
+
+    CHECK( set.objects.size() == 3 );
+    REQUIRE( warnings.size() == 1 );
+    CHECK( warnings[ 0 ] == "ATTRIB:label not set, but must be non-null" );
+}
+
+TEST_CASE("sets in the sample file are parsed", "[eflr]") {
+    auto fp = dl::open_mmap( sample );
+    char sul[ 80 ];
+    fp->read( sul, sizeof( sul ) );
+    const auto marks = dl::index( *fp );
+
+    dl::arena mem;
+    std::size_t channels = 0;
+    for( const auto& mark : marks ) {
+        if( !mark.isexplicit || mark.isencrypted ) continue;
+
+        mem.reset();
+        fp->setpos( mark );
+        const auto rec = dl::catrecord( *fp, mark.residual, mem );
+        const auto set = dl::parse_set( rec, mem );
+        if( set.type.str() == "CHANNEL" ) channels += set.objects.size();
+    }
+
+    CHECK( channels > 0 );
+    CHECK( mem.blocks() == 1 );
+}
+
+TEST_CASE("sets parsed into an arena are the same", "[eflr][arena]") {
+    dl::arena mem( 256 );
+    const auto rec = make_record( stdrecord );
+    const auto heap = dl::parse_set( rec );
+
+    for( int i = 0; i < 3; ++i ) {
+        mem.reset();
+        const auto set = dl::parse_set( rec, mem );
+        CHECK( set.objects.get_allocator().resource() == &mem );
+
+        REQUIRE( set.objects.size() == heap.objects.size() );
+        REQUIRE( set.cells.size() == heap.cells.size() );
+        for( std::size_t k = 0; k < set.objects.size(); ++k ) {
+            CHECK( set.objects[ k ].name() == heap.objects[ k ].name() );
+            CHECK( set.objects[ k ].size == heap.objects[ k ].size );
+        }
+    }
+
+    /* the arena grew on the first parse, and is a single block after */
+    CHECK( mem.blocks() == 1 );
+}
+
+TEST_CASE("arena allocations are aligned and reused", "[arena]") {
+    dl::arena mem( 64 );
+
+    auto* c = mem.allocate( 1, 1 );
+    auto* d = mem.allocate( sizeof( double ), alignof( double ) );
+    CHECK( c != d );
+    CHECK( reinterpret_cast< std::uintptr_t >( d ) % alignof( double ) == 0 );
+
+    /* growing the most recent allocation is in-place, if it fits */
+    auto* p = mem.allocate( 16, 1 );
+    CHECK( mem.reallocate( p, 16, 24, 1 ) == p );
+
+    /* allocations larger than the block grow the arena */
+    auto* big = static_cast< char* >( mem.allocate( 1000, 1 ) );
+    big[ 999 ] = 0;
+    CHECK( mem.blocks() == 2 );
+
+    const auto capacity = mem.capacity();
+    mem.reset();
+    CHECK( mem.blocks() == 1 );
+    CHECK( mem.capacity() == capacity );
+
+    /* and after reset the same allocations make no new blocks */
+    mem.allocate( 1, 1 );
+    mem.allocate( sizeof( double ), alignof( double ) );
+    mem.allocate( 24, 1 );
+    mem.allocate( 1000, 1 );
+    CHECK( mem.blocks() == 1 );
+}
+
+TEST_CASE("records are concatenated into the arena", "[arena]") {
+    auto fp = dl::open_stdio( sample );
+    char sul[ 80 ];
+    fp->read( sul, sizeof( sul ) );
+    const auto marks = dl::index( *fp );
+
+    dl::arena mem;
+    for( std::size_t i = 0; i < marks.size(); i += 97 ) {
+        INFO( "record " << i );
+        fp->setpos( marks[ i ] );
+        const auto expected = dl::catrecord( *fp, marks[ i ].residual );
+
+        mem.reset();
+        fp->setpos( marks[ i ] );
+        const auto rec = dl::catrecord( *fp, marks[ i ].residual, mem );
+
+        CHECK( std::string( rec.begin(), rec.end() )
+            == std::string( expected.begin(), expected.end() ) );
+    }
+}
+
+TEST_CASE("identifiers are interned", "[intern]") {
+    dl::symbols syms;
+
+    const auto time = syms.intern( "TIME" );
+    const auto pres = syms.intern( "PRESSURE" );
+    CHECK( time != pres );
+    CHECK( syms.intern( "TIME" ) == time );
+    CHECK( syms.intern( "" ) == syms.intern( "" ) );
+    CHECK( syms.str( pres ) == "PRESSURE" );
+    CHECK( syms.strings() == 3 );
+
+    const auto a = syms.intern( 0, 0, time );
+    const auto b = syms.intern( 0, 1, time );
+    const auto c = syms.intern( 1, 0, time );
+    CHECK( a != b );
+    CHECK( a != c );
+    CHECK( b != c );
+    CHECK( syms.intern( 0, 1, time ) == b );
+    CHECK( syms.obname( c ).origin == 1 );
+    CHECK( syms.obname( b ).copy == 1 );
+    CHECK( syms.obname( a ).id == time );
+    CHECK( syms.names() == 3 );
+
+    /* growing the table keeps the handles */
+    for( int i = 0; i < 1000; ++i ) {
+        const auto id = syms.intern( std::to_string( i ) );
+        CHECK( syms.intern( i, 0, id ) == syms.intern( i, 0, id ) );
+    }
+
+    CHECK( syms.intern( "TIME" ) == time );
+    CHECK( syms.intern( 0, 1, time ) == b );
+    CHECK( syms.strings() == 1003 );
+    CHECK( syms.names() == 1003 );
+}
+
+TEST_CASE("labels in the sample file are few", "[eflr][intern]") {
+    auto fp = dl::open_stdio( sample );
+    char sul[ 80 ];
+    fp->read( sul, sizeof( sul ) );
+    const auto marks = dl::index( *fp );
+
+    dl::symbols syms;
+    std::size_t labels = 0;
+    for( const auto& mark : marks ) {
+        if( !mark.isexplicit || mark.isencrypted ) continue;
+
+        fp->setpos( mark );
+        const auto set = dl::parse_set( dl::catrecord( *fp, mark.residual ) );
+        for( const auto& obj : set.objects ) {
+            for( std::size_t i = 0; i < set.tmpl.attributes.size(); ++i ) {
+                const auto& label = set.at( obj, i ).label;
+                syms.intern( label.first, label.last );
+                ++labels;
+            }
+        }
+    }
+
+    CHECK( syms.strings() > 0 );
+    CHECK( syms.strings() * 10 < labels );
+}
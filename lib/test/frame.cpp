@@ -0,0 +1,590 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <dlisio/types.h>
+#include <dlisio/ext/frame.hpp>
+#include <dlisio/ext/framecache.hpp>
+#include <dlisio/ext/index.hpp>
+#include <dlisio/ext/io.hpp>
+
+#include "helpers.hpp"
+
+namespace {
+
+const std::string sample = DLISIO_TEST_DATA
+                         "/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS";
+
+/* frame F (origin 1, copy 0) */
+const std::string header = { 0x01, 0x00, 0x01, 'F' };
+
+}
+
+TEST_CASE("IFLR header is parsed", "[frame]") {
+    const auto rec = make_record( header + std::string( { char( 0x80 ), 0x7F } ) );
+
+    dl::obname name;
+    std::int32_t frameno;
+    const auto* cur = dl::iflr_header( rec.begin(), rec.end(), name, frameno );
+
+    CHECK( cur == rec.end() );
+    CHECK( name.origin == 1 );
+    CHECK( name.copy == 0 );
+    CHECK( name.id == "F" );
+    CHECK( frameno == 0x7F );
+}
+
+TEST_CASE("truncated IFLR headers are rejected", "[frame]") {
+    /* frame numbers of 1 and 4 bytes, the latter decoded from a copy */
+    const std::string fulls[] = {
+        header + std::string( 1, 0x01 ),
+        header + std::string( { char( 0xC0 ), 0x00, 0x00, 0x01 } ),
+    };
+
+    dl::obname name;
+    std::int32_t frameno;
+    for( const auto& full : fulls ) {
+        for( std::size_t n = 0; n < full.size(); ++n ) {
+            INFO( "header of " << n << " of " << full.size() << " bytes" );
+            const auto rec = make_record( full.substr( 0, n ) );
+            CHECK_THROWS_AS(
+                dl::iflr_header( rec.begin(), rec.end(), name, frameno ),
+                std::invalid_argument
+            );
+        }
+    }
+}
+
+TEST_CASE("frames are decoded into columns", "[frame]") {
+    const std::string frame1 = {
+        0x01,                                   // frame number
+        char( 0xFF ), char( 0xFE ),             // snorm -2
+        0x3F, char( 0xF8 ), 0, 0, 0, 0, 0, 0,   // fdoub1 value 1.5
+        0x3F, char( 0xD0 ), 0, 0, 0, 0, 0, 0,   //        error 0.25
+        0x03, 0x04,                             // 2x ushort
+    };
+
+    const std::string frame2 = {
+        0x02,
+        0x00, 0x07,
+        0x40, 0x00, 0, 0, 0, 0, 0, 0,           // 2.0
+        0x00, 0x00, 0, 0, 0, 0, 0, 0,           // 0.0
+        0x05, 0x06,
+    };
+
+    const std::vector< dl::record > recs = {
+        make_record( header + frame1 ),
+        make_record( header + frame2 ),
+    };
+
+    const std::vector< dl::channel_layout > channels = {
+        { DLIS_SNORM,  1 },
+        { DLIS_FDOUB1, 1 },
+        { DLIS_USHORT, 2 },
+    };
+
+    std::int32_t numbers[ 2 ];
+    std::int16_t snorm[ 2 ];
+    double fdoub1[ 4 ];
+    std::uint8_t ushort[ 4 ];
+    char* const columns[] = {
+        reinterpret_cast< char* >( snorm ),
+        reinterpret_cast< char* >( fdoub1 ),
+        reinterpret_cast< char* >( ushort ),
+    };
+
+    dl::decode_frames( recs, channels, numbers, columns );
+
+    CHECK( numbers[ 0 ] == 1 );
+    CHECK( numbers[ 1 ] == 2 );
+
+    CHECK( snorm[ 0 ] == -2 );
+    CHECK( snorm[ 1 ] ==  7 );
+
+    CHECK( fdoub1[ 0 ] == 1.5 );
+    CHECK( fdoub1[ 1 ] == 0.25 );
+    CHECK( fdoub1[ 2 ] == 2.0 );
+    CHECK( fdoub1[ 3 ] == 0.0 );
+
+    CHECK( ushort[ 0 ] == 3 );
+    CHECK( ushort[ 1 ] == 4 );
+    CHECK( ushort[ 2 ] == 5 );
+    CHECK( ushort[ 3 ] == 6 );
+
+    SECTION("selected channels are decoded, in selection order") {
+        std::int32_t nums[ 2 ];
+        std::uint8_t us[ 4 ] = {};
+        std::int16_t sn[ 2 ] = {};
+        char* const selected[] = {
+            reinterpret_cast< char* >( us ),
+            reinterpret_cast< char* >( sn ),
+        };
+
+        dl::decode_frames( recs, channels, { 2, 0 }, nums, selected );
+        CHECK( nums[ 0 ] == 1 );
+        CHECK( nums[ 1 ] == 2 );
+        CHECK( us[ 0 ] == 3 );
+        CHECK( us[ 3 ] == 6 );
+        CHECK( sn[ 0 ] == -2 );
+        CHECK( sn[ 1 ] ==  7 );
+
+        CHECK_THROWS_AS(
+            dl::decode_frames( recs, channels, { 3 }, nums, selected ),
+            std::invalid_argument
+        );
+    }
+
+    SECTION("short frames are rejected") {
+        const std::vector< dl::record > shortrec = {
+            make_record( header + frame1.substr( 0, frame1.size() - 1 ) ),
+        };
+        CHECK_THROWS_AS(
+            dl::decode_frames( shortrec, channels, numbers, columns ),
+            std::invalid_argument
+        );
+    }
+
+    SECTION("variable-size channels are rejected") {
+        const std::vector< dl::channel_layout > ascii = { { DLIS_ASCII, 1 } };
+        CHECK_THROWS_AS(
+            dl::decode_frames( recs, ascii, numbers, columns ),
+            std::invalid_argument
+        );
+    }
+}
+
+TEST_CASE("homogeneous frames decode like single values", "[frame]") {
+    const int reprcs[] = {
+        DLIS_FSINGL, DLIS_FDOUBL, DLIS_FDOUB1, DLIS_CSINGL,
+        DLIS_SNORM,  DLIS_USHORT, DLIS_ULONG,
+    };
+
+    const std::vector< std::vector< std::size_t > > layouts = {
+        { 1, 1, 1 },
+        { 1, 3, 2 },
+    };
+
+    const std::vector< std::vector< std::size_t > > selections = {
+        { 0, 1, 2 },
+        { 2, 0 },
+    };
+
+    for( const auto reprc : reprcs )
+    for( const auto& counts : layouts )
+    for( const auto& selection : selections ) {
+        INFO( "reprc " << reprc << ", selection of " << selection.size() );
+
+        std::vector< dl::channel_layout > channels;
+        std::size_t framesize = 0;
+        for( const auto count : counts ) {
+            channels.push_back( { reprc, count } );
+            framesize += dl::sizeof_reprc( reprc ) * count;
+        }
+
+        /* arbitrary, but deterministic, bytes */
+        std::vector< dl::record > recs;
+        std::vector< std::string > bodies;
+        for( std::size_t row = 0; row < 5; ++row ) {
+            std::string body;
+            for( std::size_t i = 0; i < framesize; ++i )
+                body.push_back( char( (row * 131 + i * 17 + 3) & 0x7F ) );
+            bodies.push_back( body );
+            recs.push_back( make_record( header
+                                       + std::string( 1, char( row + 1 ) )
+                                       + body ) );
+        }
+
+        std::vector< std::int32_t > numbers( recs.size() );
+        std::vector< std::vector< char > > cols;
+        std::vector< char* > dsts;
+        for( const auto i : selection ) {
+            const auto size = dl::sizeof_native( reprc ) * counts[ i ];
+            cols.emplace_back( recs.size() * size );
+        }
+        for( auto& col : cols ) dsts.push_back( col.data() );
+
+        dl::decode_frames( recs, channels, selection, numbers.data(),
+                           dsts.data() );
+
+        for( std::size_t row = 0; row < recs.size(); ++row ) {
+            CHECK( numbers[ row ] == std::int32_t( row + 1 ) );
+
+            for( std::size_t k = 0; k < selection.size(); ++k ) {
+                const auto ch = selection[ k ];
+                std::size_t offset = 0;
+                for( std::size_t i = 0; i < ch; ++i )
+                    offset += dl::sizeof_reprc( reprc ) * counts[ i ];
+
+                const auto size = dl::sizeof_native( reprc ) * counts[ ch ];
+                std::vector< char > expected( size );
+                dl::decode( bodies[ row ].data() + offset,
+                            reprc,
+                            counts[ ch ],
+                            expected.data() );
+
+                CHECK( std::memcmp( expected.data(),
+                                    cols[ k ].data() + row * size,
+                                    size ) == 0 );
+            }
+        }
+    }
+}
+
+TEST_CASE("FDATA records are collected by frame", "[frame]") {
+    auto fp = dl::open_mmap( sample );
+    char sul[ 80 ];
+    fp->read( sul, sizeof( sul ) );
+    const auto marks = dl::index( *fp );
+
+    dl::obname frame;
+    frame.origin = 2;
+    frame.copy = 0;
+    frame.id = "800T";
+    CHECK( dl::fdata( *fp, marks, frame ).size() == 2301 );
+
+    frame.id = "2000T";
+    const auto recs = dl::fdata( *fp, marks, frame );
+    REQUIRE( recs.size() == 921 );
+
+    /* 2000T frames are 16 bytes, which (in content) is 4 FSINGL */
+    std::vector< std::int32_t > numbers( recs.size() );
+    std::vector< float > values( recs.size() * 4 );
+    char* const columns[] = { reinterpret_cast< char* >( values.data() ) };
+
+    dl::decode_frames( recs,
+                       { { DLIS_FSINGL, 4 } },
+                       numbers.data(),
+                       columns );
+
+    for( std::size_t i = 0; i < numbers.size(); ++i ) {
+        INFO( "frame " << i );
+        CHECK( numbers[ i ] == std::int32_t( i + 1 ) );
+    }
+
+    frame.id = "no-such-frame";
+    CHECK( dl::fdata( *fp, marks, frame ).empty() );
+}
+
+TEST_CASE("FDATA records are indexed by frame number", "[frame]") {
+    auto fp = dl::open_mmap( sample );
+    char sul[ 80 ];
+    fp->read( sul, sizeof( sul ) );
+    const auto marks = dl::index( *fp );
+
+    const auto frames = dl::index_fdata( *fp, marks );
+    REQUIRE( frames.size() == 2 );
+
+    const auto& f800 = frames[ 0 ].frame.id == "800T" ? frames[ 0 ]
+                                                      : frames[ 1 ];
+    const auto& f2000 = frames[ 0 ].frame.id == "800T" ? frames[ 1 ]
+                                                       : frames[ 0 ];
+    CHECK( f800.entries.size() == 2301 );
+    CHECK( f2000.entries.size() == 921 );
+    CHECK( f2000.ascending );
+
+    const auto all = dl::fdata( *fp, marks, f2000.frame );
+
+    SECTION("entries point to the records of the frame numbers") {
+        for( std::size_t i = 0; i < f2000.entries.size(); ++i ) {
+            INFO( "entry " << i );
+            const auto& entry = f2000.entries[ i ];
+
+            fp->setpos( marks[ entry.mark ] );
+            const auto rec = dl::catrecord( *fp, marks[ entry.mark ].residual );
+            CHECK( rec.size() == all[ i ].size() );
+
+            dl::obname name;
+            std::int32_t frameno;
+            dl::iflr_header( rec.begin(), rec.end(), name, frameno );
+            CHECK( name == f2000.frame );
+            CHECK( entry.frameno == frameno );
+        }
+
+        /* only headers are read, which works the same without mmap */
+        auto stdio = dl::open_stdio( sample );
+        const auto bystdio = dl::index_fdata( *stdio, marks );
+        REQUIRE( bystdio.size() == frames.size() );
+        for( std::size_t i = 0; i < frames.size(); ++i ) {
+            const auto& lhs = frames[ i ].entries;
+            const auto& rhs = bystdio[ i ].entries;
+            REQUIRE( lhs.size() == rhs.size() );
+            for( std::size_t k = 0; k < lhs.size(); ++k ) {
+                CHECK( lhs[ k ].frameno == rhs[ k ].frameno );
+                CHECK( lhs[ k ].mark == rhs[ k ].mark );
+            }
+        }
+
+        CHECK( dl::find_frame( f2000, 1 ) == 0 );
+        CHECK( dl::find_frame( f2000, 500 ) == 499 );
+        CHECK( dl::find_frame( f2000, 921 ) == 920 );
+        CHECK( dl::find_frame( f2000, 922 ) == f2000.entries.size() );
+        CHECK( dl::find_frame( f2000, 0 ) == f2000.entries.size() );
+    }
+
+    SECTION("frame numbers select ranges of records") {
+        const auto range = dl::frame_range( f2000, 10, 19 );
+        CHECK( range.first == 9 );
+        CHECK( range.second == 19 );
+
+        const auto recs = dl::fdata( *fp, marks, f2000,
+                                     range.first, range.second );
+        REQUIRE( recs.size() == 10 );
+        for( std::size_t i = 0; i < recs.size(); ++i ) {
+            CHECK( recs[ i ].size() == all[ i + 9 ].size() );
+            CHECK( std::memcmp( recs[ i ].data(),
+                                all[ i + 9 ].data(),
+                                recs[ i ].size() ) == 0 );
+        }
+
+        const auto none = dl::frame_range( f2000, 5000, 6000 );
+        CHECK( none.first == none.second );
+
+        const auto reversed = dl::frame_range( f2000, 19, 10 );
+        CHECK( reversed.first == reversed.second );
+
+        CHECK_THROWS_AS( dl::fdata( *fp, marks, f2000, 0, 922 ),
+                         std::invalid_argument );
+    }
+
+    SECTION("frames are decoded in batches") {
+        std::vector< std::int32_t > numbers;
+        std::vector< float > values;
+        std::size_t batches = 0;
+
+        dl::decode_batches( *fp, marks, f2000, 0, f2000.entries.size(),
+                            { { DLIS_FSINGL, 4 } }, { 0 }, 100,
+            [&]( const dl::frame_batch& batch ) {
+                CHECK( batch.first == batches * 100 );
+                CHECK( batch.size() <= 100 );
+                REQUIRE( batch.columns.size() == 1 );
+                CHECK( batch.columns[ 0 ].size()
+                    == batch.size() * 4 * sizeof( float ) );
+
+                numbers.insert( numbers.end(), batch.numbers.begin(),
+                                               batch.numbers.end() );
+                const auto* xs = reinterpret_cast< const float* >(
+                    batch.columns[ 0 ].data()
+                );
+                values.insert( values.end(), xs, xs + batch.size() * 4 );
+                ++batches;
+            }
+        );
+
+        CHECK( batches == 10 );
+        std::vector< std::int32_t > expected( all.size() );
+        std::vector< float > full( all.size() * 4 );
+        char* const columns[] = { reinterpret_cast< char* >( full.data() ) };
+        dl::decode_frames( all, { { DLIS_FSINGL, 4 } }, expected.data(),
+                           columns );
+        CHECK( numbers == expected );
+        CHECK( std::memcmp( values.data(), full.data(),
+                            full.size() * sizeof( float ) ) == 0 );
+
+        /* reading ahead makes the same batches */
+        std::vector< std::int32_t > ahead;
+        dl::decode_batches( *fp, marks, f2000, 0, f2000.entries.size(),
+                            { { DLIS_FSINGL, 4 } }, { 0 }, 100,
+            [&]( const dl::frame_batch& batch ) {
+                ahead.insert( ahead.end(), batch.numbers.begin(),
+                                           batch.numbers.end() );
+            },
+            nullptr,
+            16
+        );
+        CHECK( ahead == expected );
+
+        CHECK_THROWS_AS(
+            dl::decode_batches( *fp, marks, f2000, 0, 1,
+                                { { DLIS_FSINGL, 4 } }, { 0 }, 0,
+                                []( const dl::frame_batch& ) {} ),
+            std::invalid_argument
+        );
+    }
+
+    SECTION("index values select ranges of records") {
+        std::vector< std::int32_t > numbers( all.size() );
+        std::vector< float > values( all.size() * 4 );
+        char* const columns[] = { reinterpret_cast< char* >( values.data() ) };
+        dl::decode_frames( all,
+                           { { DLIS_FSINGL, 4 } },
+                           { 0 },
+                           numbers.data(),
+                           columns );
+
+        /* the index is the first value of every frame */
+        std::vector< double > index;
+        for( std::size_t i = 0; i < all.size(); ++i )
+            index.push_back( values[ i * 4 ] );
+
+        const auto lo = index[ 100 ];
+        const auto hi = index[ 200 ];
+        const auto range = dl::index_range( *fp, marks, f2000, DLIS_FSINGL,
+                                            std::min( lo, hi ),
+                                            std::max( lo, hi ) );
+
+        std::size_t expected = 0;
+        for( const auto x : index )
+            if( x >= std::min( lo, hi ) && x <= std::max( lo, hi ) )
+                ++expected;
+
+        CHECK( range.second - range.first == expected );
+        CHECK( range.first <= 100 );
+        CHECK( range.second >= 201 );
+
+        CHECK_THROWS_AS(
+            dl::index_range( *fp, marks, f2000, DLIS_ASCII, lo, hi ),
+            std::invalid_argument
+        );
+    }
+}
+
+TEST_CASE("out of order frame numbers are not ranges", "[frame]") {
+    dl::fdata_index index;
+    index.frame.id = "800T";
+    index.entries = { { 3, 0 }, { 1, 1 }, { 5, 2 }, { 2, 3 }, { 1, 4 } };
+    index.ascending = false;
+
+    CHECK_THROWS_AS( dl::frame_range( index, 1, 3 ), std::invalid_argument );
+
+    CHECK( dl::find_frame( index, 3 ) == 0 );
+    CHECK( dl::find_frame( index, 1 ) == 1 );
+    CHECK( dl::find_frame( index, 2 ) == 3 );
+    CHECK( dl::find_frame( index, 4 ) == index.entries.size() );
+}
+
+TEST_CASE("frames are cached in compressed chunks", "[frame][framecache]") {
+    auto fp = dl::open_mmap( sample );
+    char sul[ 80 ];
+    fp->read( sul, sizeof( sul ) );
+    const auto marks = dl::index( *fp );
+
+    const auto frames = dl::index_fdata( *fp, marks );
+    REQUIRE( frames.size() == 2 );
+    const auto& f2000 = frames[ 0 ].frame.id == "800T" ? frames[ 1 ]
+                                                       : frames[ 0 ];
+    const auto n = f2000.entries.size();
+
+    const auto all = dl::fdata( *fp, marks, f2000.frame );
+    std::vector< std::int32_t > expected( n );
+    std::vector< float > full( n * 4 );
+    char* const columns[] = { reinterpret_cast< char* >( full.data() ) };
+    dl::decode_frames( all, { { DLIS_FSINGL, 4 } }, expected.data(), columns );
+
+    const std::string path = "dlisio-frame-test.frames";
+    dl::write_framecache( path, *fp, marks, f2000, 0, n,
+                          { { DLIS_FSINGL, 4 } }, { { 2, 2 } }, 100 );
+
+    SECTION("the frames round-trip") {
+        dl::framecache cache( path );
+        CHECK( cache.size() == n );
+        CHECK( cache.chunks() == 10 );
+        REQUIRE( cache.channels().size() == 1 );
+        CHECK( cache.channels()[ 0 ].reprc == DLIS_FSINGL );
+        CHECK( cache.channels()[ 0 ].count == 4 );
+        CHECK( cache.dims()[ 0 ] == std::vector< std::size_t >{ 2, 2 } );
+
+        std::vector< std::int32_t > numbers( n );
+        std::vector< float > values( n * 4 );
+        char* const out[] = { reinterpret_cast< char* >( values.data() ) };
+        cache.read( 0, n, { 0 }, numbers.data(), out );
+        CHECK( numbers == expected );
+        CHECK( std::memcmp( values.data(), full.data(),
+                            full.size() * sizeof( float ) ) == 0 );
+
+        /* the filtered curves are smaller than the decoded frames */
+        const auto raw = n * (sizeof( std::int32_t ) + 4 * sizeof( float ));
+        CHECK( slurp( path ).size() < raw );
+    }
+
+    SECTION("partial reads only decompress the chunks they need") {
+        dl::framecache cache( path );
+        const auto before = cache.file().count.bytes;
+
+        std::vector< float > values( 10 * 4 );
+        char* const out[] = { reinterpret_cast< char* >( values.data() ) };
+        cache.read( 150, 160, { 0 }, nullptr, out );
+        CHECK( std::memcmp( values.data(), full.data() + 150 * 4,
+                            values.size() * sizeof( float ) ) == 0 );
+
+        const auto chunk = cache.file().count.bytes - before;
+        cache.read( 195, 205, { 0 }, nullptr, out );
+        CHECK( std::memcmp( values.data(), full.data() + 195 * 4,
+                            values.size() * sizeof( float ) ) == 0 );
+        CHECK( cache.file().count.bytes - before - chunk > chunk );
+
+        char* const empty[] = { nullptr };
+        CHECK_NOTHROW( cache.read( 10, 10, { 0 }, nullptr, empty ) );
+        CHECK_THROWS_AS( cache.read( 0, n + 1, { 0 }, nullptr, out ),
+                         std::invalid_argument );
+        CHECK_THROWS_AS( cache.read( 0, 1, { 1 }, nullptr, out ),
+                         std::invalid_argument );
+    }
+
+    SECTION("ranges are found like in the index") {
+        dl::framecache cache( path );
+        const auto pairs = std::vector< std::pair< int, int > >{
+            { 10, 19 }, { 1, 921 }, { 95, 105 }, { 5000, 6000 }, { 19, 10 },
+        };
+
+        for( const auto& p : pairs ) {
+            INFO( "frames " << p.first << " to " << p.second );
+            const auto lhs = cache.frame_range( p.first, p.second );
+            const auto rhs = dl::frame_range( f2000, p.first, p.second );
+            CHECK( lhs.second - lhs.first == rhs.second - rhs.first );
+            if( rhs.first != rhs.second ) CHECK( lhs == rhs );
+        }
+
+        for( const auto i : { 0, 100, 199, 500 } ) {
+            INFO( "frames " << i << " to " << i + 100 );
+            const double a = full[ i * 4 ];
+            const double b = full[ std::min< std::size_t >( i + 100, n - 1 )
+                                 * 4 ];
+            const auto lo = std::min( a, b );
+            const auto hi = std::max( a, b );
+            const auto lhs = cache.index_range( lo, hi );
+            const auto rhs = dl::index_range( *fp, marks, f2000, DLIS_FSINGL,
+                                              lo, hi );
+            CHECK( lhs == rhs );
+        }
+    }
+
+    SECTION("broken caches are rejected") {
+        const auto xs = slurp( path );
+        const std::string broken = "dlisio-frame-test-broken.frames";
+
+        spill( broken, xs.substr( 0, xs.size() - 1 ) );
+        CHECK_THROWS_AS( dl::framecache( broken ), std::invalid_argument );
+
+        spill( broken, xs.substr( 0, 20 ) );
+        CHECK_THROWS_AS( dl::framecache( broken ), std::invalid_argument );
+
+        auto magic = xs;
+        magic[ 0 ] = 'X';
+        spill( broken, magic );
+        CHECK_THROWS_AS( dl::framecache( broken ), std::invalid_argument );
+
+        std::remove( broken.c_str() );
+        CHECK_THROWS_AS( dl::framecache( broken ), dl::io_error );
+    }
+
+    SECTION("channels must be fixed-size and match their dims") {
+        CHECK_THROWS_AS(
+            dl::write_framecache( path, *fp, marks, f2000, 0, n,
+                                  { { DLIS_ASCII, 4 } }, {}, 100 ),
+            std::invalid_argument
+        );
+        CHECK_THROWS_AS(
+            dl::write_framecache( path, *fp, marks, f2000, 0, n,
+                                  { { DLIS_FSINGL, 4 } }, { { 3 } }, 100 ),
+            std::invalid_argument
+        );
+    }
+
+    std::remove( path.c_str() );
+}
@@ -0,0 +1,68 @@
+#ifndef DLISIO_TEST_HELPERS_HPP
+#define DLISIO_TEST_HELPERS_HPP
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <dlisio/ext/io.hpp>
+
+/*
+ * Helpers shared by the tests, for making records from bytes in memory and
+ * moving bytes in and out of files
+ */
+
+/*
+ * A record of a copy of the bytes, which the record holds on to
+ */
+inline dl::record make_record( const std::string& xs ) {
+    auto mem = std::make_shared< std::string >( xs );
+    const auto* begin = mem->data();
+    const auto* end = begin + mem->size();
+    return dl::record( begin, end, std::move( mem ) );
+}
+
+inline dl::record make_record( const std::vector< unsigned char >& xs ) {
+    return make_record( std::string( xs.begin(), xs.end() ) );
+}
+
+/*
+ * The contents of the file at path
+ */
+inline std::string slurp( const std::string& path ) {
+    auto fp = dl::open_mmap( path );
+    return std::string( fp->data(), fp->data() + fp->size() );
+}
+
+/*
+ * Write xs to the file at path, replacing it
+ */
+inline void spill( const std::string& path, const std::string& xs ) {
+    std::unique_ptr< std::FILE, decltype( &std::fclose ) > fp(
+        std::fopen( path.c_str(), "wb" ),
+        &std::fclose
+    );
+    REQUIRE( fp );
+    REQUIRE( std::fwrite( xs.data(), 1, xs.size(), fp.get() ) == xs.size() );
+}
+
+/*
+ * A file with the contents, which is removed when it goes out of scope
+ */
+struct tempfile {
+    explicit tempfile( const std::string& contents,
+                       std::string path = "dlisio-io-test.dlis" ) :
+        path( std::move( path ) ) {
+        spill( this->path, contents );
+    }
+
+    ~tempfile() { std::remove( this->path.c_str() ); }
+
+    std::string path;
+};
+
+#endif //DLISIO_TEST_HELPERS_HPP
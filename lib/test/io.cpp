@@ -0,0 +1,1209 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/stat.h>
+#endif
+
+#include <catch2/catch.hpp>
+
+#include <dlisio/dlisio.h>
+#include <dlisio/ext/cache.hpp>
+#include <dlisio/ext/eflr.hpp>
+#include <dlisio/ext/index.hpp>
+#include <dlisio/ext/io.hpp>
+#include <dlisio/ext/lru.hpp>
+#include <dlisio/ext/readahead.hpp>
+#include <dlisio/ext/stats.hpp>
+
+#include "helpers.hpp"
+
+namespace {
+
+const std::string sample = DLISIO_TEST_DATA
+                         "/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS";
+
+const std::string sample2 = DLISIO_TEST_DATA
+                          "/206_05a-_3_DWL_DWL_WIRE_258276501.DLIS";
+
+const std::string sul = "   1"
+                        "V1.00"
+                        "RECORD"
+                        " 8192"
+                        "Default Storage Set                     "
+                        "                    ";
+
+/*
+ * Build visible records (VRL + segments) in memory. The segments are given as
+ * attributes + body, and the header is computed.
+ */
+struct segment {
+    std::uint8_t attrs;
+    std::uint8_t type;
+    std::vector< char > body;
+};
+
+std::string vrecord( const std::vector< segment >& segments ) {
+    std::string segs;
+    for( const auto& seg : segments ) {
+        const auto len = seg.body.size() + 4;
+        segs.push_back( char( len >> 8 ) );
+        segs.push_back( char( len & 0xFF ) );
+        segs.push_back( char( seg.attrs ) );
+        segs.push_back( char( seg.type ) );
+        segs.append( seg.body.begin(), seg.body.end() );
+    }
+
+    const auto len = segs.size() + 4;
+    std::string vrl;
+    vrl.push_back( char( len >> 8 ) );
+    vrl.push_back( char( len & 0xFF ) );
+    vrl.push_back( char( 0xFF ) );
+    vrl.push_back( char( 0x01 ) );
+    return vrl + segs;
+}
+
+using opener = std::unique_ptr< dl::stream >(*)( const std::string& );
+
+std::string str( const dl::record& rec ) {
+    return std::string( rec.begin(), rec.end() );
+}
+
+std::vector< dl::bookmark > serial( dl::stream& fp ) {
+    char buffer[ 80 ];
+    fp.read( buffer, sizeof( buffer ) );
+
+    std::vector< dl::bookmark > bookmarks;
+    int remaining = 0;
+    while( !fp.eof() )
+        bookmarks.push_back( dl::mark( fp, remaining ) );
+
+    return bookmarks;
+}
+
+}
+
+TEST_CASE("stdio and mmap index the same file identically", "[io]") {
+    auto stdio = dl::open_stdio( sample );
+    auto mmap  = dl::open_mmap( sample );
+
+    const auto x = serial( *stdio );
+    const auto y = serial( *mmap );
+
+    REQUIRE( x.size() == 3252 );
+    REQUIRE( x.size() == y.size() );
+
+    for( std::size_t i = 0; i < x.size(); ++i ) {
+        INFO( "record " << i );
+        CHECK( x[ i ].tell        == y[ i ].tell );
+        CHECK( x[ i ].residual    == y[ i ].residual );
+        CHECK( x[ i ].isexplicit  == y[ i ].isexplicit );
+        CHECK( x[ i ].isencrypted == y[ i ].isencrypted );
+        CHECK( x[ i ].type        == y[ i ].type );
+        CHECK( x[ i ].length      == y[ i ].length );
+    }
+
+    for( std::size_t i = 0; i < x.size(); ++i ) {
+        INFO( "record " << i );
+        stdio->setpos( x[ i ] );
+        mmap->setpos( y[ i ] );
+        const auto rx = dl::catrecord( *stdio, x[ i ].residual );
+        const auto ry = dl::catrecord( *mmap,  y[ i ].residual );
+        CHECK( str( rx ) == str( ry ) );
+    }
+}
+
+TEST_CASE("segments split across visible records are concatenated", "[io]") {
+    const std::uint8_t succ = 0xA0; // explicit, has-successor
+    const std::uint8_t pred = 0xC0; // explicit, has-predecessor
+    const std::uint8_t padd = 0x01;
+    const std::uint8_t chck = 0x04;
+    const std::uint8_t tlen = 0x02;
+
+    const std::string contents = sul
+        + vrecord( {
+            { 0x80, 3, { 'a', 'b', 'c', 'd' } },
+            { succ | padd, 3, { 'e', 'f', 0x00, 0x02 } },
+        } )
+        + vrecord( {
+            { pred | chck | tlen, 3, { 'g', 'h', 'X', 'X', 'Y', 'Y' } },
+        } );
+
+    tempfile f( contents );
+
+    const opener openers[] = { dl::open_stdio, dl::open_mmap, dl::open_pread };
+    for( const auto open : openers ) {
+        auto fp = open( f.path );
+        const auto marks = serial( *fp );
+
+        REQUIRE( marks.size() == 2 );
+        CHECK( marks[ 0 ].type == 3 );
+        CHECK( marks[ 0 ].length == 4 );
+        CHECK( marks[ 1 ].length == 4 + 6 );
+        CHECK( marks[ 0 ].tell == 80 );
+        CHECK( marks[ 0 ].residual == 0 );
+        CHECK( marks[ 1 ].tell == 80 + 4 + 8 );
+        CHECK( marks[ 1 ].residual == 8 );
+
+        fp->setpos( marks[ 0 ] );
+        const auto fst = dl::catrecord( *fp, marks[ 0 ].residual );
+        CHECK( str( fst ) == "abcd" );
+
+        fp->setpos( marks[ 1 ] );
+        const auto snd = dl::catrecord( *fp, marks[ 1 ].residual );
+        CHECK( str( snd ) == "efgh" );
+    }
+}
+
+TEST_CASE("single-segment records are not copied", "[io]") {
+    const std::uint8_t succ = 0xA0; // explicit, has-successor
+    const std::uint8_t pred = 0xC0; // explicit, has-predecessor
+
+    const std::string contents = sul
+        + vrecord( {
+            { 0x80 | 0x04 | 0x01, 0, { 'a', 'b', 'c', 0x00, 0x02, 0x00, 0x00 } },
+            { succ, 0, { 'd', 'e' } },
+            { pred, 0, { 'f' } },
+        } );
+
+    tempfile f( contents );
+    auto fp = dl::open_mmap( f.path );
+    const auto marks = serial( *fp );
+    REQUIRE( marks.size() == 2 );
+
+    fp->setpos( marks[ 0 ] );
+    const auto fst = dl::catrecord( *fp, marks[ 0 ].residual );
+    fp->setpos( marks[ 0 ] );
+    const auto again = dl::catrecord( *fp, marks[ 0 ].residual );
+    CHECK( str( fst ) == "abc" );
+    CHECK( fst.data() == again.data() );
+
+    fp->setpos( marks[ 1 ] );
+    const auto snd = dl::catrecord( *fp, marks[ 1 ].residual );
+    CHECK( str( snd ) == "def" );
+
+    /* views outlive the stream they came from */
+    fp.reset();
+    CHECK( str( fst ) == "abc" );
+}
+
+TEST_CASE("segment trailers longer than the segment are rejected", "[io]") {
+    const std::uint8_t succ = 0xA0; // explicit, has-successor
+    const std::uint8_t pred = 0xC0; // explicit, has-predecessor
+
+    /*
+     * stdio, and segments with successors, are copied rather than viewed,
+     * and must be checked all the same
+     */
+    const std::string contents = sul
+        + vrecord( { { 0x80 | 0x01, 0, { 'a', 'b', 0x05 } } } )
+        + vrecord( {
+            { succ, 0, { 'c', 'd' } },
+            { pred | 0x04 | 0x02, 0, { 'e', 'f', 'g' } },
+        } )
+        + vrecord( {
+            { succ | 0x04 | 0x01, 0, { 'h', 'i' } },
+            { pred, 0, { 'j' } },
+        } );
+
+    tempfile f( contents );
+
+    const opener openers[] = { dl::open_stdio, dl::open_mmap, dl::open_pread };
+    for( const auto open : openers ) {
+        auto fp = open( f.path );
+        const auto marks = serial( *fp );
+        REQUIRE( marks.size() == 3 );
+
+        for( const auto& mark : marks ) {
+            fp->setpos( mark );
+            CHECK_THROWS_AS( dl::catrecord( *fp, mark.residual ),
+                             std::invalid_argument );
+        }
+    }
+}
+
+TEST_CASE("segments shorter than their header are rejected", "[io]") {
+    const std::uint8_t succ = 0xA0; // explicit, has-successor
+    const std::uint8_t pred = 0xC0; // explicit, has-predecessor
+
+    /* a successor, then a segment with length 2 */
+    auto contents = sul + vrecord( {
+        { succ, 0, { 'a', 'b' } },
+        { pred, 0, { 'c', 'd' } },
+    } );
+    contents[ 80 + 4 + 6 + 1 ] = 0x02;
+
+    tempfile f( contents );
+
+    const opener openers[] = { dl::open_stdio, dl::open_mmap, dl::open_pread };
+    for( const auto open : openers ) {
+        auto fp = open( f.path );
+        dl::bookmark m;
+        m.tell = 80;
+        m.residual = 0;
+        fp->setpos( m );
+        CHECK_THROWS_AS( dl::catrecord( *fp, m.residual ),
+                         std::invalid_argument );
+    }
+}
+
+TEST_CASE("truncated records raise eof_error", "[io]") {
+    const auto rec = vrecord( { { 0x80, 3, { 'a', 'b', 'c', 'd' } } } );
+    tempfile f( sul + rec.substr( 0, rec.size() - 2 ) );
+
+    const opener openers[] = { dl::open_stdio, dl::open_mmap, dl::open_pread };
+    for( const auto open : openers ) {
+        auto fp = open( f.path );
+        char buffer[ 80 ];
+        fp->read( buffer, sizeof( buffer ) );
+
+        int remaining = 0;
+        dl::bookmark m;
+        CHECK_NOTHROW( m = dl::mark( *fp, remaining ) );
+
+        fp->setpos( m );
+        CHECK_THROWS_AS( dl::catrecord( *fp, m.residual ), dl::eof_error );
+    }
+}
+
+TEST_CASE("unopenable files raise io_error", "[io]") {
+    CHECK_THROWS_AS( dl::open_stdio( "no-such-file.dlis" ), dl::io_error );
+    CHECK_THROWS_AS( dl::open_mmap(  "no-such-file.dlis" ), dl::io_error );
+    CHECK_THROWS_AS( dl::open(       "no-such-file.dlis" ), dl::io_error );
+
+    /* empty files cannot be mapped, but are fine to open with stdio */
+    tempfile f( "" );
+    CHECK_THROWS_AS( dl::open_mmap( f.path ), dl::io_error );
+    CHECK_NOTHROW( dl::open_stdio( f.path ) );
+    CHECK_NOTHROW( dl::open( f.path ) );
+}
+
+namespace {
+
+/*
+ * The outcome of indexing a file, including the warnings and the exception
+ * (if any), so that the serial and parallel indexers can be compared
+ */
+struct outcome {
+    std::vector< dl::bookmark > marks;
+    std::vector< std::string > warnings;
+    std::string error;
+};
+
+outcome run( const std::string& path, int threads, long long chunksize ) {
+    outcome out;
+    auto fp = dl::open_mmap( path );
+    char buffer[ 80 ];
+    fp->read( buffer, sizeof( buffer ) );
+
+    const auto warn = [&out]( const std::string& msg ) {
+        out.warnings.push_back( msg );
+    };
+
+    try {
+        out.marks = dl::index( *fp, threads, warn, chunksize );
+    } catch( const dl::eof_error& ) {
+        out.error = "eof";
+    } catch( const dl::io_error& ) {
+        out.error = "io";
+    } catch( const std::invalid_argument& ) {
+        out.error = "invalid";
+    }
+
+    return out;
+}
+
+void compare( const std::string& path, long long chunksize ) {
+    const auto x = run( path, 1, chunksize );
+    const auto y = run( path, 4, chunksize );
+
+    CHECK( x.error == y.error );
+    CHECK( x.warnings == y.warnings );
+    REQUIRE( x.marks.size() == y.marks.size() );
+
+    for( std::size_t i = 0; i < x.marks.size(); ++i ) {
+        INFO( "record " << i );
+        CHECK( x.marks[ i ].tell        == y.marks[ i ].tell );
+        CHECK( x.marks[ i ].residual    == y.marks[ i ].residual );
+        CHECK( x.marks[ i ].isexplicit  == y.marks[ i ].isexplicit );
+        CHECK( x.marks[ i ].isencrypted == y.marks[ i ].isencrypted );
+        CHECK( x.marks[ i ].type        == y.marks[ i ].type );
+        CHECK( x.marks[ i ].length      == y.marks[ i ].length );
+    }
+}
+
+/*
+ * Records that span visible records, and with bodies that look like visible
+ * record labels, to trip up the chunk resynchronisation
+ */
+std::string synthetic( int records ) {
+    const std::uint8_t succ = 0xA0; // explicit, has-successor
+    const std::uint8_t pred = 0xC0; // explicit, has-predecessor
+    const std::vector< char > fake = {
+        0x00, 0x10, char( 0xFF ), 0x01, 0x00, 0x0C, 0x00, 0x00,
+    };
+
+    std::string contents = sul;
+    for( int i = 0; i < records; ++i ) {
+        contents += vrecord( {
+            { 0x80, 3, fake },
+            { succ, 3, { 'a', 'b' } },
+        } );
+        contents += vrecord( {
+            { pred, 3, fake },
+            { 0x00, 0, { char( 0xFF ), 0x01 } },
+        } );
+    }
+
+    return contents;
+}
+
+}
+
+TEST_CASE("parallel index is identical to serial on sample files", "[index]") {
+    for( const auto& path : { sample, sample2 } ) {
+        INFO( path );
+        CHECK( run( path, 1, 4096 ).marks.size() > 3000 );
+        compare( path, 4096 );
+    }
+}
+
+TEST_CASE("parallel index handles spanning records and fake labels",
+          "[index]") {
+    tempfile f( synthetic( 200 ) );
+    const auto x = run( f.path, 1, 64 );
+    CHECK( x.marks.size() == 600 );
+    compare( f.path, 64 );
+}
+
+TEST_CASE("parallel index warns like the serial index", "[index]") {
+    auto contents = synthetic( 200 );
+    /* bump the version of a visible record in the middle */
+    const auto stride = (contents.size() - sul.size()) / 200;
+    contents[ sul.size() + 100 * stride + 3 ] = 0x02;
+
+    tempfile f( contents );
+    const auto x = run( f.path, 1, 64 );
+    CHECK( !x.warnings.empty() );
+    compare( f.path, 64 );
+}
+
+TEST_CASE("parallel index fails like the serial index", "[index]") {
+    const auto contents = synthetic( 100 );
+    for( std::size_t cut = 1; cut < 40; ++cut ) {
+        INFO( "truncated by " << cut );
+        tempfile f( contents.substr( 0, contents.size() - cut ) );
+        compare( f.path, 64 );
+    }
+}
+
+TEST_CASE("index rejects segments shorter than their header", "[index]") {
+    const auto contents = synthetic( 200 );
+    const auto stride = (contents.size() - sul.size()) / 200;
+
+    /* a length of 0 used to re-read the same segment header forever */
+    for( const char len : { 0x00, 0x02 } ) {
+        INFO( "segment length " << int( len ) );
+        auto corrupt = contents;
+        corrupt[ sul.size() + 100 * stride + 4 ] = 0x00;
+        corrupt[ sul.size() + 100 * stride + 5 ] = len;
+
+        tempfile f( corrupt );
+        CHECK( run( f.path, 1, 64 ).error == "invalid" );
+        compare( f.path, 64 );
+    }
+}
+
+TEST_CASE("scanned index is the same as marking record by record",
+          "[index]") {
+    tempfile f( synthetic( 200 ) );
+    for( const auto& path : { sample, sample2, f.path } ) {
+        INFO( path );
+        auto fp = dl::open_stdio( path );
+        const auto x = serial( *fp );
+        const auto y = run( path, 1, 1 << 30 );
+
+        CHECK( y.error.empty() );
+        REQUIRE( x.size() == y.marks.size() );
+        for( std::size_t i = 0; i < x.size(); ++i ) {
+            INFO( "record " << i );
+            CHECK( x[ i ].tell     == y.marks[ i ].tell );
+            CHECK( x[ i ].residual == y.marks[ i ].residual );
+            CHECK( x[ i ].type     == y.marks[ i ].type );
+            CHECK( x[ i ].length   == y.marks[ i ].length );
+        }
+    }
+}
+
+TEST_CASE("scan groups segments into records", "[index]") {
+    const std::uint8_t succ = 0xA0; // explicit, has-successor
+    const std::uint8_t pred = 0xC0; // explicit, has-predecessor
+
+    const std::string contents = sul
+        + vrecord( {
+            { 0x80 | 0x04 | 0x01, 3, { 'a', 'b', 0x01, 0x00, 0x00 } },
+            { succ | 0x02, 3, { 'c', 'd', 0x00, 0x06 } },
+        } )
+        + vrecord( {
+            { pred | 0x01, 3, { 'e', 0x01 } },
+            { 0x00, 0, { 'f' } },
+        } );
+
+    tempfile f( contents );
+    auto fp = dl::open_mmap( f.path );
+
+    dl::skeleton segs;
+    const auto state = dl::scan( fp->data(), fp->size(), 80, 0, true, segs );
+    CHECK( state.end == dl::scanend::eof );
+    CHECK( state.pos == fp->size() );
+
+    REQUIRE( segs.size() == 4 );
+    CHECK( segs.offset[ 0 ] == 80 + 4 );
+    CHECK( segs.offset[ 1 ] == 80 + 4 + 9 );
+    CHECK( segs.offset[ 2 ] == 80 + 21 + 4 );
+    CHECK( segs.offset[ 3 ] == 80 + 21 + 4 + 6 );
+    CHECK( segs.length == std::vector< int >{ 5, 4, 2, 1 } );
+    CHECK( segs.type == std::vector< std::uint8_t >{ 3, 3, 3, 0 } );
+    CHECK( segs.tell[ 0 ] == 80 );
+    CHECK( segs.tell[ 2 ] == 80 + 21 );
+    CHECK( segs.residual[ 1 ] == 8 );
+    CHECK( !(segs.attrs[ 0 ] & DLIS_SEGATTR_SUCCSEG) );
+    CHECK(  (segs.attrs[ 1 ] & DLIS_SEGATTR_SUCCSEG) );
+
+    segs.clear();
+    const auto one = dl::scan( fp->data(), fp->size(), 80, 0, true, segs,
+                               LLONG_MAX, 1 );
+    CHECK( one.end == dl::scanend::records );
+    CHECK( segs.size() == 1 );
+
+    const auto marks = serial( *fp );
+    REQUIRE( marks.size() == 3 );
+    const auto recs = dl::catrecords( *fp, marks );
+    CHECK( str( recs[ 0 ] ) == "ab" );
+    CHECK( str( recs[ 1 ] ) == "cde" );
+    CHECK( str( recs[ 2 ] ) == "f" );
+
+    /* single-segment records are still views */
+    fp->setpos( marks[ 0 ] );
+    CHECK( recs[ 0 ].data() == dl::catrecord( *fp, 0 ).data() );
+}
+
+TEST_CASE("sidecar index round-trips", "[cache]") {
+    auto fp = dl::open_mmap( sample );
+    const auto marks = serial( *fp );
+
+    dl::sidecar sc;
+    sc.key = dl::fingerprint( sample );
+    sc.sul = sul;
+    sc.bookmarks = marks;
+
+    const std::string path = "dlisio-io-test.idx";
+    dl::write_sidecar( path, sc );
+
+    dl::sidecar out;
+    const auto ok = dl::read_sidecar( path, sc.key, out );
+
+    SECTION("matching key") {
+        REQUIRE( ok );
+        CHECK( out.sul == sul );
+        REQUIRE( out.bookmarks.size() == marks.size() );
+        for( std::size_t i = 0; i < marks.size(); ++i ) {
+            INFO( "record " << i );
+            CHECK( out.bookmarks[ i ].tell        == marks[ i ].tell );
+            CHECK( out.bookmarks[ i ].residual    == marks[ i ].residual );
+            CHECK( out.bookmarks[ i ].isexplicit  == marks[ i ].isexplicit );
+            CHECK( out.bookmarks[ i ].isencrypted == marks[ i ].isencrypted );
+            CHECK( out.bookmarks[ i ].type        == marks[ i ].type );
+            CHECK( out.bookmarks[ i ].length      == marks[ i ].length );
+        }
+    }
+
+    SECTION("stale key") {
+        auto key = sc.key;
+        key.mtime += 1;
+        CHECK_FALSE( dl::read_sidecar( path, key, out ) );
+
+        key = sc.key;
+        key.hash ^= 1;
+        CHECK_FALSE( dl::read_sidecar( path, key, out ) );
+    }
+
+    SECTION("another file") {
+        const auto key = dl::fingerprint( sample2 );
+        CHECK( key != sc.key );
+        CHECK_FALSE( dl::read_sidecar( path, key, out ) );
+    }
+
+    SECTION("truncated") {
+        std::string contents;
+        {
+            std::unique_ptr< std::FILE, decltype( &std::fclose ) > f(
+                std::fopen( path.c_str(), "rb" ),
+                &std::fclose
+            );
+            char c;
+            while( std::fread( &c, 1, 1, f.get() ) ) contents.push_back( c );
+        }
+
+        tempfile f( contents.substr( 0, contents.size() - 1 ) );
+        CHECK_FALSE( dl::read_sidecar( f.path, sc.key, out ) );
+    }
+
+    SECTION("missing") {
+        CHECK_FALSE( dl::read_sidecar( "no-such-file.idx", sc.key, out ) );
+    }
+
+    std::remove( path.c_str() );
+}
+
+TEST_CASE("sidecar indices of tiny records are accepted", "[cache]") {
+    /* records of nothing but a LRSH, in a single visible record */
+    dl::sidecar sc;
+    sc.key.size = 80 + 4 + 4 * 64;
+    sc.sul = sul;
+    sc.bookmarks.resize( 64 );
+
+    const std::string path = "dlisio-io-test-tiny.idx";
+    dl::write_sidecar( path, sc );
+
+    dl::sidecar out;
+    CHECK( dl::read_sidecar( path, sc.key, out ) );
+    CHECK( out.bookmarks.size() == 64 );
+
+    /* but not more records than there is room for */
+    auto key = sc.key;
+    key.size = 4 * 64 - 1;
+    sc.key = key;
+    dl::write_sidecar( path, sc );
+    CHECK_FALSE( dl::read_sidecar( path, key, out ) );
+
+    std::remove( path.c_str() );
+}
+
+#ifndef _WIN32
+TEST_CASE("sidecar keys tell apart rewrites within a second", "[cache]") {
+    tempfile f( sul );
+
+    /* the same second, 1ms apart, as an in-place patch could be */
+    struct timespec times[ 2 ];
+    times[ 0 ].tv_sec  = times[ 1 ].tv_sec  = 1500000000;
+    times[ 0 ].tv_nsec = times[ 1 ].tv_nsec = 1000000;
+    REQUIRE( utimensat( AT_FDCWD, f.path.c_str(), times, 0 ) == 0 );
+    const auto before = dl::fingerprint( f.path );
+
+    times[ 0 ].tv_nsec = times[ 1 ].tv_nsec = 2000000;
+    REQUIRE( utimensat( AT_FDCWD, f.path.c_str(), times, 0 ) == 0 );
+    const auto after = dl::fingerprint( f.path );
+
+    CHECK( before.size == after.size );
+    CHECK( before.hash == after.hash );
+    CHECK( before != after );
+}
+#endif
+
+TEST_CASE("sidecar indices can be written concurrently", "[cache]") {
+    auto fp = dl::open_mmap( sample );
+
+    dl::sidecar sc;
+    sc.key = dl::fingerprint( sample );
+    sc.sul = sul;
+    sc.bookmarks = serial( *fp );
+
+    CHECK( dl::tempname( "x.idx" ) != dl::tempname( "x.idx" ) );
+
+    const std::string path = "dlisio-io-test-concurrent.idx";
+    std::vector< std::thread > writers;
+    std::vector< int > failed( 8, 0 );
+    for( std::size_t i = 0; i < failed.size(); ++i ) {
+        writers.emplace_back( [&, i] {
+            try {
+                for( int k = 0; k < 10; ++k ) dl::write_sidecar( path, sc );
+            } catch( ... ) {
+                failed[ i ] = 1;
+            }
+        } );
+    }
+    for( auto& t : writers ) t.join();
+
+    CHECK( std::count( failed.begin(), failed.end(), 1 ) == 0 );
+
+    dl::sidecar out;
+    CHECK( dl::read_sidecar( path, sc.key, out ) );
+    CHECK( out.bookmarks.size() == sc.bookmarks.size() );
+    std::remove( path.c_str() );
+}
+
+namespace {
+
+/*
+ * Feed the file to a reader in chunks of n bytes, and take the records as
+ * they complete
+ */
+std::vector< std::pair< dl::bookmark, std::string > >
+stream_records( const std::string& contents, std::size_t n ) {
+    dl::record_reader reader;
+    std::vector< std::pair< dl::bookmark, std::string > > records;
+
+    dl::bookmark mark;
+    dl::record rec;
+    for( std::size_t i = 0; i < contents.size(); i += n ) {
+        const auto len = std::min( n, contents.size() - i );
+        reader.feed( contents.data() + i, len );
+        while( reader.next( mark, rec ) )
+            records.emplace_back( mark, str( rec ) );
+    }
+
+    CHECK( !reader.partial() );
+    CHECK( reader.pending() == 0 );
+    CHECK( reader.tell() == (long long)contents.size() );
+    return records;
+}
+
+}
+
+TEST_CASE("streamed records are the same as indexed records", "[io][stream]") {
+    const auto contents = slurp( sample );
+    auto fp = dl::open_mmap( sample );
+    const auto marks = serial( *fp );
+
+    for( const std::size_t n : { 1, 3, 4, 81, 4096, 1 << 20 } ) {
+        INFO( "chunk size " << n );
+        const auto records = stream_records( contents, n );
+        REQUIRE( records.size() == marks.size() );
+
+        for( std::size_t i = 0; i < marks.size(); i += (n < 4 ? 53 : 1) ) {
+            INFO( "record " << i );
+            const auto& m = records[ i ].first;
+            CHECK( m.tell        == marks[ i ].tell );
+            CHECK( m.residual    == marks[ i ].residual );
+            CHECK( m.type        == marks[ i ].type );
+            CHECK( m.isexplicit  == marks[ i ].isexplicit );
+            CHECK( m.isencrypted == marks[ i ].isencrypted );
+            CHECK( m.length      == marks[ i ].length );
+
+            fp->setpos( marks[ i ] );
+            const auto rec = dl::catrecord( *fp, marks[ i ].residual );
+            CHECK( records[ i ].second == str( rec ) );
+        }
+    }
+}
+
+TEST_CASE("streamed segments are concatenated across visible records",
+          "[io][stream]") {
+    const std::uint8_t succ = 0xA0; // explicit, has-successor
+    const std::uint8_t pred = 0xC0; // explicit, has-predecessor
+    const std::uint8_t padd = 0x01;
+    const std::uint8_t chck = 0x04;
+    const std::uint8_t tlen = 0x02;
+
+    const std::string contents = sul
+        + vrecord( {
+            { 0x80, 3, { 'a', 'b', 'c', 'd' } },
+            { succ | padd, 3, { 'e', 'f', 0x00, 0x02 } },
+        } )
+        + vrecord( {
+            { pred | chck | tlen, 3, { 'g', 'h', 'X', 'X', 'Y', 'Y' } },
+        } );
+
+    for( std::size_t n = 1; n <= contents.size(); ++n ) {
+        INFO( "chunk size " << n );
+        const auto records = stream_records( contents, n );
+        REQUIRE( records.size() == 2 );
+        CHECK( records[ 0 ].second == "abcd" );
+        CHECK( records[ 1 ].second == "efgh" );
+        CHECK( records[ 1 ].first.tell == 80 + 4 + 8 );
+        CHECK( records[ 1 ].first.residual == 8 );
+    }
+}
+
+TEST_CASE("streaming holds back incomplete records", "[io][stream]") {
+    const std::string contents = sul
+        + vrecord( { { 0x80, 3, { 'a', 'b', 'c', 'd' } } } );
+
+    dl::record_reader reader;
+    dl::bookmark mark;
+    dl::record rec;
+
+    reader.feed( contents.data(), 79 );
+    CHECK( reader.sul().empty() );
+    CHECK( reader.partial() );
+
+    reader.feed( contents.data() + 79, contents.size() - 80 );
+    CHECK( reader.sul() == sul );
+    CHECK( reader.partial() );
+    CHECK( !reader.next( mark, rec ) );
+
+    reader.feed( contents.data() + contents.size() - 1, 1 );
+    CHECK( !reader.partial() );
+    REQUIRE( reader.next( mark, rec ) );
+    CHECK( str( rec ) == "abcd" );
+    CHECK( !reader.next( mark, rec ) );
+}
+
+TEST_CASE("streaming rejects malformed segments", "[io][stream]") {
+    const auto contents = sul
+        + vrecord( { { 0x80 | 0x01, 0, { 'a', 'b', 0x05 } } } );
+
+    dl::record_reader reader;
+    CHECK_THROWS_AS( reader.feed( contents.data(), contents.size() ),
+                     std::invalid_argument );
+}
+
+TEST_CASE("batched reads are the same as single reads", "[io][batch]") {
+    const opener openers[] = { dl::open_stdio, dl::open_mmap, dl::open_pread };
+    for( const auto open : openers ) {
+        auto fp = open( sample );
+        const auto marks = serial( *fp );
+
+        /*
+         * every record, in reverse, and then a sparse selection with
+         * duplicates, so that both large blocks and gaps are exercised
+         */
+        auto batch = std::vector< dl::bookmark >( marks.rbegin(),
+                                                  marks.rend() );
+        for( std::size_t i = 0; i < marks.size(); i += 211 ) {
+            batch.push_back( marks[ i ] );
+            batch.push_back( marks[ i ] );
+        }
+
+        const auto recs = dl::catrecords( *fp, batch );
+        REQUIRE( recs.size() == batch.size() );
+
+        for( std::size_t i = 0; i < batch.size(); ++i ) {
+            INFO( "record " << i );
+            fp->setpos( batch[ i ] );
+            const auto rec = dl::catrecord( *fp, batch[ i ].residual );
+            CHECK( str( recs[ i ] ) == str( rec ) );
+        }
+    }
+}
+
+TEST_CASE("batched reads of spanning records are concatenated",
+          "[io][batch]") {
+    const std::uint8_t succ = 0xA0; // explicit, has-successor
+    const std::uint8_t pred = 0xC0; // explicit, has-predecessor
+
+    const std::string contents = sul
+        + vrecord( {
+            { 0x80, 3, { 'a', 'b', 'c', 'd' } },
+            { succ, 3, { 'e', 'f' } },
+        } )
+        + vrecord( {
+            { pred, 3, { 'g', 'h' } },
+            { 0x80, 3, { 'i' } },
+        } );
+
+    tempfile f( contents );
+    auto fp = dl::open_stdio( f.path );
+    const auto marks = serial( *fp );
+    REQUIRE( marks.size() == 3 );
+
+    const auto recs = dl::catrecords( *fp, { marks[ 2 ],
+                                             marks[ 1 ],
+                                             marks[ 0 ] } );
+    CHECK( str( recs[ 0 ] ) == "i" );
+    CHECK( str( recs[ 1 ] ) == "efgh" );
+    CHECK( str( recs[ 2 ] ) == "abcd" );
+}
+
+TEST_CASE("record prefixes are the start of the record", "[io]") {
+    const std::uint8_t succ = 0xA0; // explicit, has-successor
+    const std::uint8_t pred = 0xC0; // explicit, has-predecessor
+    const std::uint8_t padd = 0x01;
+
+    const std::string contents = sul
+        + vrecord( {
+            { 0x80, 3, { 'a', 'b', 'c', 'd' } },
+            { succ | padd, 3, { 'e', 'f', 0x00, 0x02 } },
+        } )
+        + vrecord( {
+            { pred, 3, { 'g', 'h' } },
+        } );
+
+    tempfile f( contents );
+
+    const opener openers[] = { dl::open_stdio, dl::open_mmap, dl::open_pread };
+    for( const auto open : openers ) {
+        auto fp = open( f.path );
+        const auto marks = serial( *fp );
+        REQUIRE( marks.size() == 2 );
+
+        for( std::size_t n = 0; n <= 6; ++n ) {
+            INFO( "prefix of " << n << " bytes" );
+            fp->setpos( marks[ 1 ] );
+            const auto rec = dl::catprefix( *fp, marks[ 1 ].residual, n );
+            CHECK( str( rec ) == std::string( "efgh" ).substr( 0, n ) );
+        }
+
+        fp->setpos( marks[ 0 ] );
+        const auto fst = dl::catprefix( *fp, marks[ 0 ].residual, 2 );
+        CHECK( str( fst ) == "ab" );
+    }
+
+    auto fp = dl::open_mmap( sample );
+    const auto marks = serial( *fp );
+    for( std::size_t i = 0; i < marks.size(); i += 7 ) {
+        INFO( "record " << i );
+        fp->setpos( marks[ i ] );
+        const auto rec = dl::catrecord( *fp, marks[ i ].residual );
+        fp->setpos( marks[ i ] );
+        const auto pre = dl::catprefix( *fp, marks[ i ].residual, 16 );
+        CHECK( str( pre ) == str( rec ).substr( 0, 16 ) );
+    }
+}
+
+TEST_CASE("pread indexes the same as stdio", "[io][pread]") {
+    auto stdio = dl::open_stdio( sample );
+    auto pread = dl::open_pread( sample );
+
+    const auto x = serial( *stdio );
+    const auto y = serial( *pread );
+    REQUIRE( x.size() == y.size() );
+
+    for( std::size_t i = 0; i < x.size(); ++i ) {
+        INFO( "record " << i );
+        CHECK( x[ i ].tell   == y[ i ].tell );
+        CHECK( x[ i ].length == y[ i ].length );
+
+        stdio->setpos( x[ i ] );
+        pread->setpos( y[ i ] );
+        const auto rx = dl::catrecord( *stdio, x[ i ].residual );
+        const auto ry = dl::catrecord( *pread, y[ i ].residual );
+        CHECK( str( rx ) == str( ry ) );
+    }
+}
+
+TEST_CASE("cursors read concurrently", "[io][pread]") {
+    CHECK( !dl::open_stdio( sample )->cursor() );
+
+    const opener openers[] = { dl::open_mmap, dl::open_pread };
+    for( const auto open : openers ) {
+        auto fp = open( sample );
+        const auto marks = serial( *fp );
+
+        std::vector< std::string > expected;
+        for( const auto& m : marks ) {
+            fp->setpos( m );
+            expected.push_back( str( dl::catrecord( *fp, m.residual ) ) );
+        }
+
+        /*
+         * every thread reads all records with a cursor of its own, in
+         * different orders, and the cursors outlive the stream
+         */
+        const int threads = 4;
+        std::vector< std::unique_ptr< dl::stream > > cursors;
+        for( int t = 0; t < threads; ++t )
+            cursors.push_back( fp->cursor() );
+        fp.reset();
+
+        std::vector< int > mismatches( threads, 0 );
+        std::vector< std::thread > workers;
+        for( int t = 0; t < threads; ++t ) {
+            workers.emplace_back( [&, t] {
+                auto& cur = *cursors[ t ];
+                for( std::size_t k = 0; k < marks.size(); ++k ) {
+                    const auto i = (k * (2 * t + 1)) % marks.size();
+                    cur.setpos( marks[ i ] );
+                    const auto rec = dl::catrecord( cur, marks[ i ].residual );
+                    if( str( rec ) != expected[ i ] ) ++mismatches[ t ];
+                }
+            });
+        }
+
+        for( auto& worker : workers ) worker.join();
+        for( int t = 0; t < threads; ++t ) CHECK( mismatches[ t ] == 0 );
+    }
+}
+
+TEST_CASE("pread rejects files that are not regular", "[io][pread]") {
+    CHECK_THROWS_AS( dl::open_pread( "no-such-file.dlis" ), dl::io_error );
+#ifndef _WIN32
+    CHECK_THROWS_AS( dl::open_pread( "/dev/null" ), dl::io_error );
+#endif
+}
+
+TEST_CASE("records read ahead are the same as batched reads",
+          "[io][readahead]") {
+    const opener openers[] = { dl::open_stdio, dl::open_mmap, dl::open_pread };
+    for( const auto open : openers ) {
+        auto fp = open( sample );
+        const auto marks = serial( *fp );
+        const auto recs = dl::catrecords( *fp, marks );
+
+        for( const std::size_t depth : { 0, 1, 7, 64 } ) {
+            for( const int threads : { 1, 3 } ) {
+                INFO( "depth " << depth << ", threads " << threads );
+                dl::readahead ahead( *fp, marks, depth, threads );
+                CHECK( ahead.size() == marks.size() );
+
+                std::size_t mismatches = 0;
+                for( std::size_t i = 0; i < recs.size(); ++i ) {
+                    if( str( ahead.next() ) != str( recs[ i ] ) ) ++mismatches;
+                }
+                CHECK( mismatches == 0 );
+                CHECK( ahead.done() );
+                CHECK_THROWS_AS( ahead.next(), std::out_of_range );
+            }
+        }
+    }
+}
+
+TEST_CASE("read-ahead errors belong to the record that has them",
+          "[io][readahead]") {
+    const std::string contents = sul
+        + vrecord( { { 0x80, 0, { 'a', 'b' } } } )
+        + vrecord( { { 0x80 | 0x01, 0, { 'c', 0x05 } } } )
+        + vrecord( { { 0x80, 0, { 'd' } } } );
+
+    tempfile f( contents );
+    const opener openers[] = { dl::open_stdio, dl::open_mmap, dl::open_pread };
+    for( const auto open : openers ) {
+        auto fp = open( f.path );
+        const auto marks = serial( *fp );
+        REQUIRE( marks.size() == 3 );
+
+        dl::readahead ahead( *fp, marks, 4, 1 );
+        CHECK( str( ahead.next() ) == "ab" );
+        CHECK_THROWS( ahead.next() );
+        CHECK( str( ahead.next() ) == "d" );
+    }
+}
+
+TEST_CASE("read-ahead warnings belong to the record that has them",
+          "[io][readahead]") {
+    auto third = vrecord( { { 0x80, 0, { 'e' } } } );
+    third[ 3 ] = 0x02; // VRL version 2
+
+    const std::string contents = sul
+        + vrecord( { { 0x80, 0, { 'a', 'b' } } } )
+        + vrecord( { { 0x80, 0, { 'c', 'd' } } } )
+        + third;
+
+    tempfile f( contents );
+    const opener openers[] = { dl::open_stdio, dl::open_mmap, dl::open_pread };
+    for( const auto open : openers ) {
+        auto fp = open( f.path );
+        const auto marks = serial( *fp );
+        REQUIRE( marks.size() == 3 );
+
+        std::vector< std::size_t > warned;
+        std::size_t taken = 0;
+        const auto warn = [&]( const std::string& ) {
+            warned.push_back( taken );
+        };
+
+        dl::readahead ahead( *fp, marks, 4, 1, warn );
+        for( ; taken < marks.size(); ++taken ) ahead.next();
+        CHECK( warned == std::vector< std::size_t >{ 2 } );
+    }
+}
+
+TEST_CASE("read-ahead can be abandoned with reads in flight",
+          "[io][readahead]") {
+    auto fp = dl::open_pread( sample );
+    const auto marks = serial( *fp );
+
+    dl::readahead ahead( *fp, marks, 8, 2 );
+    ahead.next();
+    ahead.next();
+    CHECK( ahead.taken() == 2 );
+}
+
+TEST_CASE("record cache evicts the least recently used", "[io][lru]") {
+    auto fp = dl::open_mmap( sample );
+    const auto marks = serial( *fp );
+    const auto recs = dl::catrecords( *fp, marks );
+
+    /* room for the first two records, but not the third */
+    const auto budget = recs[ 0 ].size() + recs[ 1 ].size()
+                      + recs[ 2 ].size() - 1;
+    REQUIRE( recs[ 2 ].size() >= recs[ 0 ].size() );
+    dl::record_cache cache( budget );
+
+    dl::record rec;
+    CHECK( !cache.find( marks[ 0 ], rec ) );
+    cache.insert( marks[ 0 ], recs[ 0 ] );
+    cache.insert( marks[ 1 ], recs[ 1 ] );
+
+    REQUIRE( cache.find( marks[ 0 ], rec ) );
+    CHECK( str( rec ) == str( recs[ 0 ] ) );
+
+    /* 1 is now the least recently used, and is evicted to make room */
+    cache.insert( marks[ 2 ], recs[ 2 ] );
+    CHECK( !cache.find( marks[ 1 ], rec ) );
+    CHECK( cache.find( marks[ 0 ], rec ) );
+    CHECK( cache.find( marks[ 2 ], rec ) );
+
+    auto count = cache.counts();
+    CHECK( count.hits == 3 );
+    CHECK( count.misses == 2 );
+    CHECK( count.evictions == 1 );
+    CHECK( count.entries == 2 );
+    CHECK( count.bytes == recs[ 0 ].size() + recs[ 2 ].size() );
+    CHECK( count.bytes <= cache.budget() );
+
+    cache.resize( recs[ 2 ].size() );
+    count = cache.counts();
+    CHECK( count.entries == 1 );
+    CHECK( cache.find( marks[ 2 ], rec ) );
+
+    /* records larger than the budget aren't cached at all */
+    cache.resize( 1 );
+    cache.insert( marks[ 0 ], recs[ 0 ] );
+    CHECK( cache.counts().entries == 0 );
+
+    /* a budget of 0 disables the cache */
+    cache.resize( 0 );
+    cache.reset_counts();
+    cache.insert( marks[ 0 ], recs[ 0 ] );
+    CHECK( !cache.find( marks[ 0 ], rec ) );
+    CHECK( cache.counts().misses == 0 );
+}
+
+TEST_CASE("record cache keeps parsed sets with their records", "[io][lru]") {
+    auto fp = dl::open_mmap( sample );
+    const auto marks = serial( *fp );
+    REQUIRE( marks[ 0 ].isexplicit );
+
+    fp->setpos( marks[ 0 ] );
+    const auto rec = dl::catrecord( *fp, marks[ 0 ].residual );
+    auto parsed = std::make_shared< const dl::set >( dl::parse_set( rec ) );
+
+    dl::record_cache cache( 1 << 20 );
+    CHECK( !cache.findset( marks[ 0 ] ) );
+    cache.insert( marks[ 0 ], rec );
+    const auto recbytes = cache.counts().bytes;
+
+    /* the set and the record are looked up, and counted, once */
+    dl::record found;
+    bool hasrecord = false;
+    cache.reset_counts();
+    CHECK( !cache.findset( marks[ 0 ], found, hasrecord ) );
+    CHECK( hasrecord );
+    CHECK( found.data() == rec.data() );
+    CHECK( cache.counts().misses == 1 );
+    CHECK( cache.counts().hits == 0 );
+
+    cache.insert( marks[ 0 ], parsed );
+    CHECK( cache.findset( marks[ 0 ], found, hasrecord ) == parsed );
+    CHECK( !hasrecord );
+    CHECK( cache.counts().hits == 1 );
+
+    /* the set shares the bytes of the record, which are only charged once */
+    const auto count = cache.counts();
+    CHECK( count.entries == 1 );
+    CHECK( count.bytes > recbytes );
+    CHECK( count.bytes < 2 * recbytes + 4096 );
+
+    CHECK( cache.findset( marks[ 0 ] ) == parsed );
+    dl::record again;
+    REQUIRE( cache.find( marks[ 0 ], again ) );
+    CHECK( again.data() == rec.data() );
+
+    cache.clear();
+    CHECK( cache.counts().bytes == 0 );
+    CHECK( !cache.findset( marks[ 0 ] ) );
+    CHECK( parsed->objects.size() > 0 );
+}
+
+TEST_CASE("record cache is shared by threads", "[io][lru]") {
+    auto fp = dl::open_mmap( sample );
+    const auto marks = serial( *fp );
+    const auto recs = dl::catrecords( *fp, marks );
+
+    dl::record_cache cache( 64 * 1024 );
+    std::vector< std::thread > threads;
+    std::vector< int > mismatches( 4, 0 );
+    for( int t = 0; t < 4; ++t ) {
+        threads.emplace_back( [&, t] {
+            for( std::size_t i = t; i < 2000; i += 3 ) {
+                const auto k = i % 50;
+                dl::record rec;
+                if( !cache.find( marks[ k ], rec ) ) {
+                    cache.insert( marks[ k ], recs[ k ] );
+                    continue;
+                }
+                if( str( rec ) != str( recs[ k ] ) ) ++mismatches[ t ];
+            }
+        });
+    }
+    for( auto& t : threads ) t.join();
+
+    CHECK( mismatches == std::vector< int >( 4, 0 ) );
+    const auto count = cache.counts();
+    CHECK( count.hits + count.misses > 0 );
+    CHECK( count.bytes <= cache.budget() );
+}
+
+TEST_CASE("reads, segments and records are counted", "[io][stats]") {
+    const std::uint8_t succ = 0xA0; // explicit, has-successor
+    const std::uint8_t pred = 0xC0; // explicit, has-predecessor
+
+    const std::string contents = sul
+        + vrecord( {
+            { 0x80, 3, { 'a', 'b', 'c', 'd' } },
+            { succ, 3, { 'e', 'f' } },
+        } )
+        + vrecord( {
+            { pred, 3, { 'g', 'h' } },
+        } );
+
+    tempfile f( contents );
+
+    const opener openers[] = { dl::open_stdio, dl::open_mmap, dl::open_pread };
+    for( const auto open : openers ) {
+        auto fp = open( f.path );
+        const auto marks = serial( *fp );
+        for( const auto& m : marks ) {
+            fp->setpos( m );
+            dl::catrecord( *fp, m.residual );
+        }
+
+        const auto count = dl::counted( *fp );
+        if( !dl::stats::enabled() ) {
+            CHECK( count.segments == 0 );
+            continue;
+        }
+
+        CHECK( count.indexed == 2 );
+        CHECK( count.segments == 6 );
+        CHECK( count.records == 2 );
+        CHECK( count.concatenated == 1 );
+        CHECK( count.seeks >= 2 );
+        CHECK( count.bytes >= contents.size() - 80 );
+    }
+
+    CHECK( dl::counted( *dl::open_mmap( f.path ) ).reads == 0 );
+}
+
+TEST_CASE("cursors add to the totals of their stream", "[io][stats]") {
+    if( !dl::stats::enabled() ) return;
+
+    auto fp = dl::open_mmap( sample );
+    const auto marks = serial( *fp );
+    const auto indexed = dl::counted( *fp ).indexed;
+    CHECK( indexed == marks.size() );
+
+    {
+        auto cursor = fp->cursor();
+        cursor->setpos( marks.front() );
+        dl::index( *cursor, 4, nullptr, 1 << 16 );
+        CHECK( dl::counted( *fp ).indexed == indexed );
+    }
+
+    const auto count = dl::counted( *fp );
+    CHECK( count.indexed == 2 * indexed );
+    CHECK( count.reads == 0 );
+
+    fp->totals()->reset();
+    fp->count = dl::counters();
+    CHECK( dl::counted( *fp ).indexed == 0 );
+}
@@ -0,0 +1,171 @@
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <dlisio/ext/index.hpp>
+#include <dlisio/ext/io.hpp>
+#include <dlisio/ext/load.hpp>
+#include <dlisio/ext/pool.hpp>
+
+namespace {
+
+const std::string sample = DLISIO_TEST_DATA
+                         "/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS";
+
+const std::string sample2 = DLISIO_TEST_DATA
+                          "/206_05a-_3_DWL_DWL_WIRE_258276501.DLIS";
+
+/*
+ * A task that fans out into a tree of tasks, the way a file fans out into
+ * logical files and frames
+ */
+void fanout( dl::pool& workers, std::atomic< int >& count, int depth ) {
+    ++count;
+    if( depth == 0 ) return;
+
+    for( int i = 0; i < 4; ++i ) {
+        workers.submit( [&workers, &count, depth] {
+            fanout( workers, count, depth - 1 );
+        });
+    }
+}
+
+dl::bookmark mark( int type, bool isexplicit ) {
+    dl::bookmark m;
+    m.type = type;
+    m.isexplicit = isexplicit;
+    return m;
+}
+
+}
+
+TEST_CASE("the pool runs all tasks, also those submitted by tasks",
+          "[pool]") {
+    for( const int threads : { 1, 2, 8 } ) {
+        INFO( "threads " << threads );
+        dl::pool workers( threads );
+        CHECK( workers.size() == std::size_t( threads ) );
+
+        std::atomic< int > count( 0 );
+        workers.submit( [&] { fanout( workers, count, 5 ); } );
+        workers.wait();
+
+        /* 1 + 4 + 16 + ... + 4^5 */
+        CHECK( count == 1365 );
+
+        /* the pool can be reused after wait */
+        workers.submit( [&] { ++count; } );
+        workers.wait();
+        CHECK( count == 1366 );
+    }
+}
+
+TEST_CASE("the pool rethrows the first failure from wait", "[pool]") {
+    dl::pool workers( 4 );
+    std::atomic< int > count( 0 );
+
+    for( int i = 0; i < 100; ++i ) {
+        workers.submit( [&count, i] {
+            ++count;
+            if( i % 10 == 0 ) throw std::runtime_error( "task failed" );
+        });
+    }
+
+    CHECK_THROWS_AS( workers.wait(), std::runtime_error );
+    CHECK( count == 100 );
+    CHECK_NOTHROW( workers.wait() );
+}
+
+TEST_CASE("logical files start at FILE-HEADER records", "[load]") {
+    const std::vector< dl::bookmark > marks = {
+        mark( 0, true ),  // FILE-HEADER
+        mark( 1, true ),
+        mark( 0, false ), // FDATA, not a FILE-HEADER
+        mark( 0, true ),  // FILE-HEADER
+        mark( 3, true ),
+    };
+
+    const auto files = dl::logical_files( marks );
+    REQUIRE( files.size() == 2 );
+    CHECK( files[ 0 ].first == 0 );
+    CHECK( files[ 0 ].second == 3 );
+    CHECK( files[ 1 ].first == 3 );
+    CHECK( files[ 1 ].second == 5 );
+
+    /* records before the first FILE-HEADER are a logical file too */
+    const std::vector< dl::bookmark > headless = {
+        mark( 1, true ),
+        mark( 0, true ),
+    };
+    const auto split = dl::logical_files( headless );
+    REQUIRE( split.size() == 2 );
+    CHECK( split[ 0 ].second == 1 );
+
+    CHECK( dl::logical_files( {} ).empty() );
+}
+
+TEST_CASE("files are loaded in parallel, in order", "[load]") {
+    const std::vector< std::string > paths = {
+        sample,
+        "no-such-file.dlis",
+        sample2,
+        sample,
+    };
+
+    const auto files = dl::load( paths, 4 );
+    REQUIRE( files.size() >= paths.size() );
+
+    CHECK( files[ 0 ].path == sample );
+    CHECK( files[ 0 ].index == 0 );
+    CHECK( !files[ 0 ].error );
+    CHECK( files[ 1 ].path == "no-such-file.dlis" );
+    CHECK( files[ 1 ].error );
+    CHECK( files.back().path == sample );
+
+    auto fp = dl::open_mmap( sample );
+    char sul[ 80 ];
+    fp->read( sul, sizeof( sul ) );
+    const auto marks = dl::index( *fp );
+
+    std::size_t records = 0;
+    for( const auto& lf : files )
+        if( lf.path == sample ) records += lf.bookmarks.size();
+    CHECK( records == 2 * marks.size() );
+
+    const auto& lf = files[ 0 ];
+    CHECK( lf.sul == std::string( sul, sizeof( sul ) ) );
+    CHECK( !lf.sets.empty() );
+
+    bool found = false;
+    for( const auto& frame : lf.frames ) {
+        if( frame.name.id != "800T" ) continue;
+        found = true;
+        CHECK( !frame.error );
+        CHECK( frame.numbers.size() == 2301 );
+        CHECK( frame.columns.size() == frame.channels.size() );
+        for( std::size_t i = 1; i < frame.numbers.size(); ++i )
+            CHECK( frame.numbers[ i - 1 ] < frame.numbers[ i ] );
+    }
+    CHECK( found );
+}
+
+TEST_CASE("frames loaded in parallel are the same as serial", "[load]") {
+    const auto serial = dl::load( { sample }, 1 );
+    const auto parallel = dl::load( { sample }, 8 );
+    REQUIRE( serial.size() == parallel.size() );
+
+    for( std::size_t i = 0; i < serial.size(); ++i ) {
+        REQUIRE( serial[ i ].frames.size() == parallel[ i ].frames.size() );
+        for( std::size_t k = 0; k < serial[ i ].frames.size(); ++k ) {
+            const auto& x = serial[ i ].frames[ k ];
+            const auto& y = parallel[ i ].frames[ k ];
+            CHECK( x.name == y.name );
+            CHECK( x.numbers == y.numbers );
+            CHECK( x.columns == y.columns );
+        }
+    }
+}
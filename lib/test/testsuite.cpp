@@ -1,2 +1,7 @@
+/*
+ * The bundled catch2 sizes its alternate signal stack with SIGSTKSZ, which is
+ * no longer a compile-time constant on recent glibc
+ */
+#define CATCH_CONFIG_NO_POSIX_SIGNALS
 #define CATCH_CONFIG_MAIN
 #include <catch2/catch.hpp>
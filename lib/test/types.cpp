@@ -1,10 +1,14 @@
 #include <array>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <limits>
 #include <string>
+#include <vector>
 
 #include <catch2/catch.hpp>
 
+#include <dlisio/dlisio.h>
 #include <dlisio/types.h>
 
 TEST_CASE("signed short (8-bit)", "[type]") {
@@ -444,7 +448,7 @@ TEST_CASE("complex and validated single precision floats", "[type]") {
     };
 
     SECTION("validaed single precision float") {
-        for( std::size_t i = 0; i < inputs.size() / sizeof( float ); ++i ) {
+        for( std::size_t i = 0; i + 1 < inputs.size() / sizeof( float ); ++i ) {
             const char* xs = (char*)inputs.data() + i * sizeof( float );
             float v, a;
             float x, y;
@@ -457,7 +461,7 @@ TEST_CASE("complex and validated single precision floats", "[type]") {
     }
 
     SECTION("two-way validated single precision float") {
-        for( std::size_t i = 0; i < inputs.size() / sizeof( float ); ++i ) {
+        for( std::size_t i = 0; i + 2 < inputs.size() / sizeof( float ); ++i ) {
             const char* xs = (char*)inputs.data() + i * sizeof( float );
             float v, a, b;
             float x, y, z;
@@ -472,7 +476,7 @@ TEST_CASE("complex and validated single precision floats", "[type]") {
     }
 
     SECTION("single precision complex float") {
-        for( std::size_t j = 0; j < inputs.size() / sizeof( float ); ++j ) {
+        for( std::size_t j = 0; j + 1 < inputs.size() / sizeof( float ); ++j ) {
             const char* xs = (char*)inputs.data() + j * sizeof( float );
             float r, i;
             float x, y;
@@ -497,7 +501,7 @@ TEST_CASE("complex and validaed double precision floats", "[type]") {
     };
 
     SECTION("validaed double precision float") {
-        for( std::size_t i = 0; i < inputs.size() / sizeof( double ); ++i ) {
+        for( std::size_t i = 0; i + 1 < inputs.size() / sizeof( double ); ++i ) {
             const char* xs = (char*)inputs.data() + i * sizeof( double );
             double v, a;
             double x, y;
@@ -510,7 +514,7 @@ TEST_CASE("complex and validaed double precision floats", "[type]") {
     }
 
     SECTION("two-way validaed double precision float") {
-        for( std::size_t i = 0; i < inputs.size() / sizeof( double ); ++i ) {
+        for( std::size_t i = 0; i + 2 < inputs.size() / sizeof( double ); ++i ) {
             const char* xs = (char*)inputs.data() + i * sizeof( double );
             double v, a, b;
             double x, y, z;
@@ -525,7 +529,7 @@ TEST_CASE("complex and validaed double precision floats", "[type]") {
     }
 
     SECTION("double precision complex float") {
-        for( std::size_t j = 0; j < inputs.size() / sizeof( double ); ++j ) {
+        for( std::size_t j = 0; j + 1 < inputs.size() / sizeof( double ); ++j ) {
             const char* xs = (char*)inputs.data() + j * sizeof( double );
             double r, i;
             double x, y;
@@ -598,6 +602,61 @@ TEST_CASE("identifier (var-length string)", "[type]") {
     }
 }
 
+TEST_CASE("object names are views of the same values as the copies",
+          "[type]") {
+    /* origins of all three widths, the largest of each, and empty names */
+    const std::vector< std::string > origins = {
+        std::string( "\x00", 1 ),
+        "\x7F",
+        std::string( "\x80\x80", 2 ),
+        "\xBF\xFF",
+        std::string( "\xC0\x00\x40\x00", 4 ),
+        "\xFF\xFF\xFF\xFF",
+    };
+    const std::vector< std::string > ids = { "", "A", "CHANNEL-1" };
+
+    for( const auto& origin : origins ) {
+        for( const auto& id : ids ) {
+            const auto name = origin + "\x02" + char( id.size() ) + id;
+            const auto in = std::string( "\x04TYPE" ) + name + "pad!..";
+            INFO( "origin width " << origin.size() << ", id '" << id << "'" );
+
+            std::int32_t orig, len;
+            std::uint8_t copy;
+            char buffer[ 256 ];
+            const auto* end = dlis_obname( name.data(), &orig, &copy,
+                                                        &len, buffer );
+
+            std::int32_t vorig, vlen;
+            std::uint8_t vcopy;
+            const char* view;
+            /* the view reads up to 6 bytes ahead, so give it room */
+            const auto padded = name + std::string( 6, '\0' );
+            const auto* vend = dlis_obname_view( padded.data(), &vorig,
+                                                                &vcopy,
+                                                                &vlen,
+                                                                &view );
+            CHECK( vend - padded.data() == end - name.data() );
+            CHECK( vend == padded.data() + name.size() );
+            CHECK( vorig == orig );
+            CHECK( vcopy == 2 );
+            CHECK( vlen == len );
+            CHECK( std::string( view, vlen ) == id );
+            CHECK( view == vend - vlen );
+
+            std::int32_t typelen;
+            const char* type;
+            const auto* rend = dlis_objref_view( in.data(), &typelen, &type,
+                                                 &vorig, &vcopy,
+                                                 &vlen, &view );
+            CHECK( rend == in.data() + in.size() - 6 );
+            CHECK( std::string( type, typelen ) == "TYPE" );
+            CHECK( vorig == orig );
+            CHECK( std::string( view, vlen ) == id );
+        }
+    }
+}
+
 TEST_CASE("ascii (var-length string)", "[type]") {
     std::int32_t len;
 
@@ -705,3 +764,274 @@ TEST_CASE("date-time", "[type]") {
     CHECK( S  == 15 );
     CHECK( MS == 620 );
 }
+
+namespace {
+
+/*
+ * The original, table- and pow-based conversions, as references for the bulk
+ * versions
+ */
+float reference_isingl( const unsigned char* xs ) {
+    static const std::uint32_t ieeemax = 0x7FFFFFFF;
+    static const std::uint32_t iemaxib = 0x611FFFFF;
+    static const std::uint32_t ieminib = 0x21200000;
+
+    static const std::uint32_t it[8] = {
+        0x21800000, 0x21400000, 0x21000000, 0x21000000,
+        0x20c00000, 0x20c00000, 0x20c00000, 0x20c00000 };
+    static const std::uint32_t mt[8] = { 8, 4, 2, 2, 1, 1, 1, 1 };
+
+    std::uint32_t u = std::uint32_t( xs[ 0 ] ) << 24
+                    | std::uint32_t( xs[ 1 ] ) << 16
+                    | std::uint32_t( xs[ 2 ] ) << 8
+                    | std::uint32_t( xs[ 3 ] );
+
+    std::uint32_t manthi = u & 0X00FFFFFF;
+    std::uint32_t ix     = manthi >> 21;
+    std::uint32_t iexp   = ( ( u & 0x7f000000 ) - it[ix] ) << 1;
+    manthi = manthi * mt[ix] + iexp;
+    std::uint32_t inabs  = u & 0X7FFFFFFF;
+    if ( inabs > iemaxib ) manthi = ieeemax;
+    manthi = manthi | ( u & 0x80000000 );
+    u = ( inabs < ieminib ) ? 0 : manthi;
+
+    float out;
+    std::memcpy( &out, &u, sizeof( out ) );
+    return out;
+}
+
+float reference_vsingl( const unsigned char* x ) {
+    std::uint32_t v = std::uint32_t(x[1]) << 24
+                    | std::uint32_t(x[0]) << 16
+                    | std::uint32_t(x[3]) << 8
+                    | std::uint32_t(x[2]) << 0
+                    ;
+
+    std::uint32_t sign_bit = v & 0x80000000;
+    std::uint32_t frac_bits = v & 0x007FFFFF;
+    std::uint32_t exp_bits = (v & 0x7F800000) >> 23;
+
+    float sign = sign_bit ? -1.0 : 1.0;
+    float exponent = float( exp_bits );
+    float significand = frac_bits / float( 0x00800000 );
+
+    if (exp_bits)
+        return sign * (0.5 + significand) * std::pow(2.0f, exponent - 128.0f);
+    else if (!sign_bit)
+        return 0;
+    else
+        return std::nanf("");
+}
+
+float reference_fshort( const unsigned char* xs ) {
+    std::uint16_t v = std::uint16_t( xs[ 0 ] ) << 8 | xs[ 1 ];
+
+    std::uint16_t sign_bit = v & 0x8000;
+    std::uint16_t exp_bits = v & 0x000F;
+    std::uint16_t frac_bits = (v & 0xFFF0) >> 4;
+    if( sign_bit )
+        frac_bits = (~frac_bits & 0x0FFF) + 1;
+
+    float sign = sign_bit ? -1.0 : 1.0;
+    float exponent = float( exp_bits );
+    float fractional = frac_bits / float( 0x0800 );
+
+    return sign * fractional * std::pow( 2.0f, exponent );
+}
+
+/* deterministic noise, with some hand-picked edge cases at the front */
+std::vector< unsigned char > noise( std::size_t n ) {
+    std::vector< unsigned char > xs = {
+        0x00, 0x00, 0x00, 0x00,
+        0x80, 0x00, 0x00, 0x00,
+        0x7F, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF,
+        0x00, 0x80, 0x00, 0x00,
+        0x40, 0x80, 0x00, 0x00,
+        0x21, 0x1F, 0xFF, 0xFF,
+        0x61, 0x20, 0x00, 0x00,
+    };
+
+    std::uint32_t state = 2463534242u;
+    while( xs.size() < n ) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        xs.push_back( state & 0xFF );
+    }
+
+    xs.resize( n );
+    return xs;
+}
+
+/* bitwise equal, or both NaN */
+bool same( float x, float y ) {
+    if( std::isnan( x ) && std::isnan( y ) ) return true;
+    std::uint32_t a, b;
+    std::memcpy( &a, &x, sizeof( a ) );
+    std::memcpy( &b, &y, sizeof( b ) );
+    return a == b;
+}
+
+bool same( double x, double y ) {
+    if( std::isnan( x ) && std::isnan( y ) ) return true;
+    std::uint64_t a, b;
+    std::memcpy( &a, &x, sizeof( a ) );
+    std::memcpy( &b, &y, sizeof( b ) );
+    return a == b;
+}
+
+template< typename T >
+bool same( T x, T y ) {
+    return x == y;
+}
+
+/*
+ * Check the bulk decoder against the scalar one, both for contiguous input
+ * (where the SIMD paths kick in) and strided, and for lengths that don't fill
+ * a whole vector. Components is the number of output values per input value
+ */
+template< typename T, int Components, typename Scalar, typename Bulk >
+void check_bulk( std::size_t size, Scalar scalar, Bulk bulk ) {
+    const std::size_t n = 1003;
+
+    for( const std::size_t stride : { size, size + 3 } ) {
+        INFO( "stride " << stride );
+        const auto src = noise( n * stride );
+        const auto* xs = reinterpret_cast< const char* >( src.data() );
+
+        std::vector< T > expected( n * Components );
+        for( std::size_t i = 0; i < n; ++i )
+            scalar( xs + i * stride, expected.data() + i * Components );
+
+        for( const std::size_t len : { n, std::size_t( 7 ), std::size_t( 0 ) } ) {
+            INFO( "values " << len );
+            std::vector< T > result( n * Components );
+            const auto* end = bulk( xs, stride, len, result.data() );
+            CHECK( end == xs + len * stride );
+
+            for( std::size_t i = 0; i < len * Components; ++i ) {
+                INFO( "value " << i );
+                CHECK( same( result[ i ], expected[ i ] ) );
+            }
+        }
+    }
+}
+
+template< typename T, const char* (*F)( const char*, T* ) >
+void scalar1( const char* xs, T* out ) { F( xs, out ); }
+
+template< typename T, const char* (*F)( const char*, T*, T* ) >
+void scalar2( const char* xs, T* out ) { F( xs, out, out + 1 ); }
+
+template< typename T, const char* (*F)( const char*, T*, T*, T* ) >
+void scalar3( const char* xs, T* out ) { F( xs, out, out + 1, out + 2 ); }
+
+/*
+ * The decoders that have a vector kernel for every instruction set
+ */
+void check_bulk_all() {
+    check_bulk< std::int16_t,  1 >( 2, scalar1< std::int16_t,  dlis_snorm  >, dlis_snorm_n  );
+    check_bulk< std::int32_t,  1 >( 4, scalar1< std::int32_t,  dlis_slong  >, dlis_slong_n  );
+    check_bulk< std::uint16_t, 1 >( 2, scalar1< std::uint16_t, dlis_unorm  >, dlis_unorm_n  );
+    check_bulk< std::uint32_t, 1 >( 4, scalar1< std::uint32_t, dlis_ulong  >, dlis_ulong_n  );
+    check_bulk< float,  1 >( 4, scalar1< float,  dlis_fsingl >, dlis_fsingl_n );
+    check_bulk< double, 1 >( 8, scalar1< double, dlis_fdoubl >, dlis_fdoubl_n );
+    check_bulk< double, 2 >( 16, scalar2< double, dlis_fdoub1 >, dlis_fdoub1_n );
+}
+
+/*
+ * n random IBM and VAX floats, and every short float
+ */
+void check_references( std::size_t n ) {
+    {
+        INFO( "isingl" );
+        const auto src = noise( n * 4 );
+        std::vector< float > result( n );
+        dlis_isingl_n( (const char*)src.data(), 4, n, result.data() );
+        for( std::size_t i = 0; i < n; ++i ) {
+            INFO( "value " << i );
+            CHECK( same( result[ i ], reference_isingl( src.data() + i * 4 ) ) );
+        }
+    }
+
+    {
+        INFO( "vsingl" );
+        const auto src = noise( n * 4 );
+        std::vector< float > result( n );
+        dlis_vsingl_n( (const char*)src.data(), 4, n, result.data() );
+        for( std::size_t i = 0; i < n; ++i ) {
+            INFO( "value " << i );
+            CHECK( same( result[ i ], reference_vsingl( src.data() + i * 4 ) ) );
+        }
+    }
+
+    {
+        INFO( "fshort, exhaustively" );
+        std::vector< unsigned char > src;
+        for( std::uint32_t v = 0; v < 0x10000; ++v ) {
+            src.push_back( v >> 8 );
+            src.push_back( v & 0xFF );
+        }
+
+        std::vector< float > result( 0x10000 );
+        dlis_fshort_n( (const char*)src.data(), 2, 0x10000, result.data() );
+        for( std::size_t i = 0; i < 0x10000; ++i ) {
+            INFO( "value " << i );
+            CHECK( same( result[ i ], reference_fshort( src.data() + i * 2 ) ) );
+        }
+    }
+}
+
+}
+
+TEST_CASE("bulk decoders are identical to the scalar decoders", "[type][bulk]") {
+    check_bulk< std::int8_t,   1 >( 1, scalar1< std::int8_t,   dlis_sshort >, dlis_sshort_n );
+    check_bulk< std::int16_t,  1 >( 2, scalar1< std::int16_t,  dlis_snorm  >, dlis_snorm_n  );
+    check_bulk< std::int32_t,  1 >( 4, scalar1< std::int32_t,  dlis_slong  >, dlis_slong_n  );
+    check_bulk< std::uint8_t,  1 >( 1, scalar1< std::uint8_t,  dlis_ushort >, dlis_ushort_n );
+    check_bulk< std::uint16_t, 1 >( 2, scalar1< std::uint16_t, dlis_unorm  >, dlis_unorm_n  );
+    check_bulk< std::uint32_t, 1 >( 4, scalar1< std::uint32_t, dlis_ulong  >, dlis_ulong_n  );
+    check_bulk< std::uint8_t,  1 >( 1, scalar1< std::uint8_t,  dlis_status >, dlis_status_n );
+
+    check_bulk< float,  1 >( 2, scalar1< float,  dlis_fshort >, dlis_fshort_n );
+    check_bulk< float,  1 >( 4, scalar1< float,  dlis_fsingl >, dlis_fsingl_n );
+    check_bulk< float,  1 >( 4, scalar1< float,  dlis_isingl >, dlis_isingl_n );
+    check_bulk< float,  1 >( 4, scalar1< float,  dlis_vsingl >, dlis_vsingl_n );
+    check_bulk< double, 1 >( 8, scalar1< double, dlis_fdoubl >, dlis_fdoubl_n );
+
+    check_bulk< float,  2 >(  8, scalar2< float,  dlis_fsing1 >, dlis_fsing1_n );
+    check_bulk< float,  3 >( 12, scalar3< float,  dlis_fsing2 >, dlis_fsing2_n );
+    check_bulk< float,  2 >(  8, scalar2< float,  dlis_csingl >, dlis_csingl_n );
+    check_bulk< double, 2 >( 16, scalar2< double, dlis_fdoub1 >, dlis_fdoub1_n );
+    check_bulk< double, 3 >( 24, scalar3< double, dlis_fdoub2 >, dlis_fdoub2_n );
+    check_bulk< double, 2 >( 16, scalar2< double, dlis_cdoubl >, dlis_cdoubl_n );
+}
+
+TEST_CASE("every supported instruction set gives the same results",
+          "[type][bulk][simd]") {
+    const int original = dlis_simd_level();
+    REQUIRE( dlis_simd_supported( original ) );
+    CHECK( dlis_simd_supported( DLIS_SIMD_SCALAR ) );
+    CHECK( !dlis_simd_supported( -1 ) );
+    CHECK( !dlis_simd_supported( 100 ) );
+    CHECK( dlis_simd_set( 100 ) != DLIS_OK );
+    CHECK( dlis_simd_level() == original );
+
+    for( int level = DLIS_SIMD_SCALAR; level <= DLIS_SIMD_NEON; ++level ) {
+        if( !dlis_simd_supported( level ) ) continue;
+
+        INFO( "level " << level );
+        REQUIRE( dlis_simd_set( level ) == DLIS_OK );
+        CHECK( dlis_simd_level() == level );
+        check_bulk_all();
+        check_references( 1 << 12 );
+    }
+
+    REQUIRE( dlis_simd_set( original ) == DLIS_OK );
+}
+
+TEST_CASE("IBM, VAX and short floats match the original conversions",
+          "[type][bulk]") {
+    check_references( 1 << 16 );
+}
@@ -1,17 +1,175 @@
 __version__ = '0.0.0'
 
+import collections
+
+try:
+    from collections.abc import Mapping
+except ImportError:
+    from collections import Mapping
+
 from . import core
 
-def load(path):
-    return dlis(path)
+# lazily decoded attributes read like the dicts of eagerly decoded ones
+Mapping.register(core.attribute)
+
+def load(path, mmap = True, cache = None, shared_symbols = False,
+         record_cache = 0, backend = None):
+    """Open a DLIS file
+
+    Parameters
+    ----------
+    path : str
+    mmap : bool
+        Memory-map the file. Otherwise, or if the file can't be mapped, it's
+        read with positional reads (pread), which many threads can do at the
+        same time, and if that fails too, e.g. for pipes, with stdio
+    cache : str, optional
+        Path to a sidecar index file. If it exists and was built from this
+        version of the file (same size, modification time and header), the
+        index is read from it and the file is not scanned. Otherwise the file
+        is indexed, and the sidecar is (re)written
+    shared_symbols : bool
+        Share the table of interned labels, units and names with other files
+        opened with shared_symbols, rather than having one per file. This
+        saves memory when many similar files are open at the same time, but
+        the shared table is never freed
+    record_cache : int
+        Keep up to this many bytes of recently read records, and their parsed
+        sets, in memory, so that reading the same records again and again with
+        raw_record and eflr doesn't re-read and re-parse them. 0 (default)
+        disables the cache. Hits and misses are counted in stats()
+    backend : {'mmap', 'pread', 'stdio'}, optional
+        Read the file with this backend, and fail if it can't be opened with
+        it, rather than picking one from mmap. Mostly for testing
+
+    Returns
+    -------
+    dlis : dlisio.dlis
+
+    Examples
+    --------
+    Reuse the index across runs
+
+    >>> with dlisio.load(path, cache = path + '.idx') as f:
+    ...     pass
+    """
+    return dlis(path, mmap = mmap, cache = cache,
+                shared_symbols = shared_symbols,
+                record_cache = record_cache,
+                backend = backend)
+
+def load_many(paths, threads = 0):
+    """Load many files at once, in parallel
+
+    Index the files, split them into logical files, parse their explicitly
+    formatted records and decode the curves of their frames, all on a pool of
+    threads. Large files are split into tasks per logical file and frame, so
+    that the threads stay busy even when the files are of very different
+    sizes.
+
+    One broken file doesn't fail the rest. Errors are reported per logical
+    file, and per frame, rather than raised.
+
+    Parameters
+    ----------
+    paths : list of str
+    threads : int
+        the number of threads, 0 means one per core
+
+    Returns
+    -------
+    files : list of dict
+        one dict per logical file, in order by path and position in the file,
+        with the keys path, index (of the logical file in the file), sul,
+        bookmarks, sets (the explicitly formatted records, as from
+        dlisio.core.eflr), frames and error (the message, or None). frames
+        maps frame names to dicts with the keys channels and error, and, if
+        error is None, frameno and curves, like dlis.curves returns them
+
+    Examples
+    --------
+    >>> for lf in dlisio.load_many(paths):
+    ...     if lf['error'] is not None:
+    ...         print(lf['path'], lf['error'])
+    """
+    files = core.load(list(paths), threads = threads)
+
+    for lf in files:
+        for frame in lf['frames'].values():
+            if frame['error'] is not None: continue
+            curves = zip(frame['channels'], frame['curves'])
+            frame['curves'] = collections.OrderedDict(curves)
+
+    return files
+
+def stream(source, chunksize = 65536):
+    """Read the logical records of a DLIS file incrementally
+
+    Read the file from source as it arrives, and yield the logical records
+    once their last segment is in, without indexing the file first. Only the
+    record being assembled is kept in memory, which makes this suitable for
+    files that are still being written, or that come over pipes and sockets.
+
+    Parameters
+    ----------
+    source : file-like or callable
+        either an object with a read(n) method, like a file or socket.makefile,
+        or a function that takes a size and returns at most that many bytes.
+        Reading stops when it returns no bytes. To follow a growing file, let
+        it block until more data is available
+    chunksize : int
+        the number of bytes to ask for at a time
+
+    Yields
+    ------
+    bookmark : dlisio.core.bookmark
+        the bookmark record would have in the index of the complete file
+    record : memoryview
+        the logical record, with segment headers and trailers stripped
+
+    Raises
+    ------
+    EOFError
+        if the source ends in the middle of a record
+
+    Examples
+    --------
+    Count the records coming over a pipe
+
+    >>> import sys
+    >>> n = sum(1 for _ in dlisio.stream(sys.stdin.buffer))
+    """
+    read = source if callable(source) else source.read
+
+    reader = core.stream()
+    while True:
+        chunk = read(chunksize)
+        if not chunk: break
+
+        reader.feed(chunk)
+        while True:
+            rec = reader.next()
+            if rec is None: break
+            yield rec
+
+    if reader.partial:
+        msg = 'stream ended in the middle of a record (at byte {})'
+        raise EOFError(msg.format(reader.tell))
 
 class dlis(object):
-    def __init__(self, path):
-        self.fp = core.file(path)
-        self.sul, self.bookmarks = self.fp.mkindex()
+    def __init__(self, path, mmap = True, cache = None,
+                 shared_symbols = False, record_cache = 0, backend = None):
+        self.fp = core.file(path, mmap = mmap,
+                                  shared_symbols = shared_symbols,
+                                  backend = backend or '')
+        self.sul, self.bookmarks = self.fp.mkindex(cache = cache or '')
+        if record_cache: self.fp.cache_records(record_cache)
+
+        # the FDATA records by frame and frame number, for selective reads
+        self._fdata = None
 
     def raw_record(self, i):
-        """Get a raw record (as bytes)
+        """Get a raw record (as a memoryview)
 
         Read the logical record i, but make no attempt to parse it. Use this if
         the file for some reason is not read correctly, to either debug or
@@ -23,7 +181,9 @@ class dlis(object):
 
         Returns
         -------
-        record : bytes
+        record : memoryview
+            a read-only view of the record. Single-segment records in
+            memory-mapped files are not copied. Use bytes(record) for a copy
 
         Notes
         -----
@@ -34,6 +194,311 @@ class dlis(object):
         """
         return self.fp.raw_record(self.bookmarks[i])
 
+    def raw_records(self, indices):
+        """Get many raw records at once
+
+        Like raw_record, but the records are read in file order, and records
+        that are close together are read in one go. This is a lot faster than
+        calling raw_record in a loop, in particular on network file systems.
+
+        Parameters
+        ----------
+        indices : iterable of int
+
+        Returns
+        -------
+        records : list of memoryview
+            in the order of indices
+
+        Examples
+        --------
+        >>> channels = f.raw_records(f.records([3], True))
+        """
+        return self.fp.raw_records([self.bookmarks[i] for i in indices])
+
+    def records(self, types = None, explicit = None):
+        """Find logical records by type
+
+        Select records from the index, without reading them. The logical
+        record type is recorded when the file is indexed.
+
+        Parameters
+        ----------
+        types : iterable of int, optional
+            logical record types to include, e.g. 0 (FILE-HEADER), 1 (ORIGIN),
+            3 (CHANNEL) and 4 (FRAME) for explicitly formatted records. If
+            None, all types are included
+        explicit : bool, optional
+            only include explicitly (True) or implicitly (False) formatted
+            records. If None, both are included
+
+        Returns
+        -------
+        records : list of int
+            the indices of the matching records, suitable for raw_record and
+            bookmarks
+
+        Examples
+        --------
+        Read all CHANNEL sets
+
+        >>> channels = [f.raw_record(i) for i in f.records([3], True)]
+        """
+        if types is not None:
+            types = frozenset(types)
+
+        def match(mark):
+            if explicit is not None and bool(mark.explicit) != explicit:
+                return False
+            return types is None or mark.type in types
+
+        return [i for i, mark in enumerate(self.bookmarks) if match(mark)]
+
+    def fdata_index(self):
+        """The FDATA records by frame and frame number
+
+        The index is built on first use, by reading only the short header
+        (frame name and frame number) of every FDATA record, and then kept
+        for the lifetime of the file.
+
+        Returns
+        -------
+        index : dict
+            frame name (origin, copy, id) -> dlisio.core.fdata_index, with
+            the frame numbers of the records (framenos), and find(n) and
+            frame_range(first, last) to look them up by binary search
+
+        Examples
+        --------
+        >>> index = f.fdata_index()[(2, 0, '800T')]
+        >>> i = index.find(100)
+        """
+        if self._fdata is None:
+            indices = self.fp.fdata_index(self.bookmarks)
+            self._fdata = { x.frame: x for x in indices }
+        return self._fdata
+
+    def curves(self, frame, channels = None, frames = None, index = None):
+        """Read the curves of a frame
+
+        Decode all FDATA records of the frame into one array per channel. The
+        channels, their representation codes and dimensions, are read from the
+        FRAME and CHANNEL sets of the file.
+
+        Reading can be limited to some of the channels, and to a range of the
+        frames, which is a lot faster than reading all and slicing after. The
+        channels that aren't selected are skipped without being decoded, and
+        the records outside the range are never read. The frame range is
+        found through an index of the FDATA records by frame number, which is
+        built on the first selective read of the file and then reused.
+
+        Parameters
+        ----------
+        frame : str or tuple
+            the frame name, either as (origin, copy, id), or just the id if
+            it's unique
+        channels : list of str or tuple, optional
+            the channels to read, by (origin, copy, id) or just id, in the
+            order they should be returned. Defaults to all
+        frames : tuple of int, optional
+            (first, last), read only the frames with frame numbers in
+            [first, last]. If the frame numbers are out of order, all the
+            frames are read and then filtered on frame number
+        index : tuple of float, optional
+            (lo, hi), read only the frames where the index channel (the first
+            channel of the frame, e.g. depth or time) is in [lo, hi]. The index
+            must be monotonic, and the range is found by binary search
+
+        Returns
+        -------
+        frameno : numpy.ndarray
+            the frame number of each row
+        curves : collections.OrderedDict
+            channel name (origin, copy, id) -> numpy.ndarray, in frame order.
+            Each array has one row per frame, and channels with a dimension
+            other than [1] have their dimension as the remaining axes.
+            Validated values (e.g. FSING1) get an extra innermost axis for
+            (V, A[, B]), and complex values a complex dtype
+
+        Examples
+        --------
+        >>> frameno, curves = f.curves('800T')
+
+        Read two channels between depths 1000 and 2000
+
+        >>> _, curves = f.curves('800T', ['TDEP', 'GR'], index = (1000, 2000))
+        """
+        selection, framerange, indexrange = channels, frames, index
+        frame, names, reprc, dims = self._layout(frame)
+
+        if selection is None and framerange is None and indexrange is None:
+            frameno, columns = self.fp.frames(self.bookmarks, frame,
+                                              reprc, dims)
+            return frameno, collections.OrderedDict(zip(names, columns))
+
+        positions = list(range(len(names)))
+        if selection is not None:
+            positions = []
+            for name in selection:
+                if isinstance(name, tuple):
+                    matches = [x for x in names if x == name]
+                else:
+                    matches = [x for x in names if x[2] == name]
+
+                if len(matches) != 1:
+                    msg = 'expected exactly one channel {} in frame {}, ' \
+                          'found {}'
+                    raise ValueError(msg.format(name, frame, len(matches)))
+                positions.append(names.index(matches[0]))
+
+        # frames without any FDATA records have no entry in the index
+        fdata = self.fdata_index().get(frame) or core.fdata_index()
+
+        # out of order frame numbers are not a range of records, and are
+        # filtered after reading instead
+        begin, end = 0, len(fdata)
+        if framerange is not None and fdata.ascending:
+            first, last = fdata.frame_range(*framerange)
+            begin, end = max(begin, first), min(end, last)
+
+        if indexrange is not None and names:
+            lo, hi = indexrange
+            first, last = self.fp.index_range(self.bookmarks, fdata,
+                                              reprc[0], lo, hi)
+            begin, end = max(begin, first), min(end, last)
+
+        end = max(begin, end)
+        frameno, columns = self.fp.select(self.bookmarks, fdata, begin, end,
+                                          reprc, dims, positions)
+
+        if framerange is not None and not fdata.ascending:
+            first, last = framerange
+            keep = (frameno >= first) & (frameno <= last)
+            frameno = frameno[keep]
+            columns = [column[keep] for column in columns]
+
+        selected = [names[i] for i in positions]
+        return frameno, collections.OrderedDict(zip(selected, columns))
+
+    def cache_curves(self, frame, path, rows = 8192):
+        """Write the curves of a frame to a frame cache
+
+        Decode all FDATA records of the frame, and write them to a chunked,
+        compressed, columnar file at path, to read them again without going
+        back to this file. The curves are stored rows frames to a chunk, and
+        reads decompress only the chunks and channels they need.
+
+        Parameters
+        ----------
+        frame : str or tuple
+            the frame name, like for curves
+        path : str
+            where to write the cache. It's written next to path first, and
+            then moved into place
+        rows : int, optional
+            frames per chunk
+
+        Returns
+        -------
+        names : list of tuple
+            the channels of the frame, in the order they are in the cache
+
+        Examples
+        --------
+        Read the curves between depths 1000 and 2000 from the cache
+
+        >>> names = f.cache_curves('800T', 'curves.frm')
+        >>> cache = dlisio.core.framecache('curves.frm')
+        >>> begin, end = cache.index_range(1000, 2000)
+        >>> frameno, columns = cache.read(begin, end)
+        """
+        frame, names, reprc, dims = self._layout(frame)
+        fdata = self.fdata_index().get(frame) or core.fdata_index()
+        self.fp.cache_frames(path, self.bookmarks, fdata, 0, len(fdata),
+                             reprc, dims, rows)
+        return names
+
+    def _layout(self, frame):
+        """The frame name, and the names, representation codes and
+        dimensions of its channels, from the FRAME and CHANNEL sets
+        """
+        # sets are recognised by their set type, not by the record type, the
+        # same way dlisio.load does, as not all files use the standard types
+        frames, channels = {}, {}
+        marks = [self.bookmarks[i] for i in self.records(explicit = True)]
+
+        # only a few attributes are needed, so decode them on demand
+        for rec in self.fp.eflrs(marks, lazy = True):
+            if rec is None: continue
+            if rec.get('type') == 'FRAME':   frames.update(rec['objects'])
+            if rec.get('type') == 'CHANNEL': channels.update(rec['objects'])
+
+        if not isinstance(frame, tuple):
+            candidates = [name for name in frames if name[2] == frame]
+            if len(candidates) != 1:
+                msg = 'expected exactly one frame named {}, found {}'
+                raise ValueError(msg.format(frame, len(candidates)))
+            frame = candidates[0]
+
+        def attribute(obj, label, default = None):
+            for attr in obj:
+                if attr.get('label') == label and attr['value'] is not None:
+                    return attr['value']
+            return default
+
+        if frame not in frames:
+            raise ValueError('no frame {}'.format(frame))
+
+        names = attribute(frames[frame], 'CHANNELS', [])
+        reprc, dims = [], []
+        for name in names:
+            if name not in channels:
+                raise ValueError('no channel {} (in frame {})'.format(name, frame))
+
+            ch = channels[name]
+            code = attribute(ch, 'REPRESENTATION-CODE')
+            if not code:
+                msg = 'channel {} can not be decoded into a column ' \
+                      '(in frame {})'
+                raise ValueError(msg.format(name, frame))
+
+            reprc.append(code[0])
+            dims.append(attribute(ch, 'DIMENSION', [1]))
+
+        return frame, names, reprc, dims
+
+    def stats(self, reset = False):
+        """The work done reading the file so far
+
+        Count the bytes read, read calls and seeks, the segments visited and
+        the records read, indexed, concatenated across segments, parsed and
+        decoded, and time indexing, reading, parsing and decoding, to tell if
+        reading the file is bound by I/O or by parsing.
+
+        Parameters
+        ----------
+        reset : bool
+            reset the counters after reading them
+
+        Returns
+        -------
+        stats : dict
+            the counters, and the times in seconds. If dlisio is built without
+            statistics, stats['enabled'] is False and everything is 0, except
+            the counts of the record cache (cache-hits, cache-misses,
+            cache-evictions, cache-bytes and cache-entries), which are always
+            counted
+
+        Examples
+        --------
+        >>> s = f.stats()
+        >>> s['read-time'], s['parse-time']
+        (0.0021, 0.0173)
+        """
+        stats = self.fp.stats()
+        if reset: self.fp.reset_stats()
+        return stats
+
     def close(self):
         """Close the file
 
@@ -1,19 +1,31 @@
-#include <bitset>
-#include <cerrno>
+#include <algorithm>
 #include <cstdint>
-#include <cstdio>
 #include <cstring>
 #include <exception>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
 #include <dlisio/dlisio.h>
 #include <dlisio/types.h>
+#include <dlisio/ext/cache.hpp>
+#include <dlisio/ext/eflr.hpp>
+#include <dlisio/ext/frame.hpp>
+#include <dlisio/ext/framecache.hpp>
+#include <dlisio/ext/index.hpp>
+#include <dlisio/ext/intern.hpp>
+#include <dlisio/ext/io.hpp>
+#include <dlisio/ext/load.hpp>
+#include <dlisio/ext/lru.hpp>
+#include <dlisio/ext/stats.hpp>
 
 namespace py = pybind11;
 using namespace py::literals;
@@ -22,19 +34,6 @@ using namespace py::literals;
 
 namespace {
 
-/*
- * for some reason, pybind does not defined IOError, so make a quick
- * regular-looking exception like that and register its translation
- */
-struct io_error : public std::runtime_error {
-    using std::runtime_error::runtime_error;
-    explicit io_error( int no ) : runtime_error( std::strerror( no ) ) {}
-};
-
-struct eof_error : public std::runtime_error {
-    using std::runtime_error::runtime_error;
-};
-
 void runtime_warning( const char* msg ) {
     int err = PyErr_WarnEx( PyExc_RuntimeWarning, msg, 1 );
     if( err ) throw py::error_already_set();
@@ -49,18 +48,6 @@ void user_warning( const std::string& msg ) {
     user_warning( msg.c_str() );
 }
 
-/*
- * automate the read-bytes-throw-if-fails, at least for now. file error
- * reporting isn't very sophisticated, but doesn't have to be yet.
- */
-void getbytes( char* buffer, std::size_t nmemb, std::FILE* fd ) {
-    const auto read = std::fread( buffer, 1, nmemb, fd );
-    if( read != nmemb ) {
-        if( std::feof( fd ) ) throw eof_error( "unexpected EOF" );
-        throw io_error( errno );
-    }
-}
-
 py::dict SUL( const char* buffer ) {
     char id[ 61 ] = {};
     int seqnum, major, minor, layout;
@@ -103,173 +90,383 @@ py::dict SUL( const char* buffer ) {
                      "id"_a =  id );
 }
 
-struct bookmark {
-    std::fpos_t pos;
+/*
+ * The Python objects of interned identifiers and object names, by handle, so
+ * that the labels, units and names that repeat across objects and records
+ * are the same str and tuple objects. The strings are also interned by
+ * Python, which makes dict lookups with them pointer comparisons.
+ *
+ * Only used with the GIL held.
+ */
+class pysymbols {
+public:
+    py::object str( const char* first, const char* last );
+    py::object str( const dl::span& s ) { return this->str( s.first, s.last ); }
+
+    py::object obname( std::int32_t origin,
+                       std::uint8_t copy,
+                       const char* first,
+                       const char* last );
 
     /*
-     * the remaining bytes of the "previous" visible record. if 0, the current
-     * object is the visible record label
+     * Shared by all files opened with shared_symbols, and by the free
+     * eflr(). It is never freed, and lives as long as the process.
      */
-    int residual = 0;
+    static const std::shared_ptr< pysymbols >& process();
 
-    int isexplicit = 0;
-    int isencrypted = 0;
+private:
+    dl::symbols table;
+    std::vector< py::object > strs;
+    std::vector< py::object > names;
 
     /*
-     * only pos is used for seeking and repositioning - tell is used only for
-     * __repr__ and debugging purposes
+     * The str of the already interned identifier [first, last)
      */
-    long long tell = 0;
-};
-
-struct segheader {
-    std::uint8_t attrs;
-    int len;
-    int type;
+    py::object str( dl::symbols::handle,
+                    const char* first,
+                    const char* last );
 };
 
-segheader segment_header( std::FILE* fp ) {
-    char buffer[ 4 ];
-    getbytes( buffer, 4, fp );
-
-    segheader seg;
-    const auto err = dlis_lrsh( buffer, &seg.len, &seg.attrs, &seg.type );
-    if( err ) throw py::value_error( "unable to parse "
-                                     "logical record segment header" );
-    return seg;
+/*
+ * Handles are dense, so the side tables are only ever extended by one. They
+ * are resized before the object is made, so that a failed conversion (e.g.
+ * invalid UTF-8) leaves the tables consistent, and is retried next time
+ */
+py::object pysymbols::str( const char* first, const char* last ) {
+    return this->str( this->table.intern( first, last ), first, last );
 }
 
-int visible_length( std::FILE* fp ) {
-    char buffer[ 4 ];
-    getbytes( buffer, 4, fp );
+py::object pysymbols::str( dl::symbols::handle h,
+                           const char* first,
+                           const char* last ) {
+    if( h >= this->strs.size() ) this->strs.resize( h + 1 );
 
-    int len, version;
-    const auto err = dlis_vrl( buffer, &len, &version );
-    if( err ) throw py::value_error( "unable to parse visible record label" );
+    auto& obj = this->strs[ h ];
+    if( !obj ) {
+        PyObject* s = py::str( first, last - first ).release().ptr();
+        PyUnicode_InternInPlace( &s );
+        obj = py::reinterpret_steal< py::object >( s );
+    }
 
-    if( version != 1 ) {
-        std::string msg = "VRL DLIS not v1, was " + std::to_string( version );
-        runtime_warning( msg.c_str() );
+    return obj;
+}
+
+py::object pysymbols::obname( std::int32_t origin,
+                              std::uint8_t copy,
+                              const char* first,
+                              const char* last ) {
+    /* the identifier is interned once, for both the str and the name */
+    const auto id = this->table.intern( first, last );
+    const auto h = this->table.intern( origin, copy, id );
+    if( h >= this->names.size() ) this->names.resize( h + 1 );
+
+    auto& obj = this->names[ h ];
+    if( !obj ) {
+        auto s = this->str( id, first, last );
+        obj = py::make_tuple( origin, int( copy ), std::move( s ) );
     }
+    return obj;
+}
 
-    return len;
+const std::shared_ptr< pysymbols >& pysymbols::process() {
+    /*
+     * leaked on purpose, as the objects can't be released after the
+     * interpreter is finalized
+     */
+    static auto* syms = new std::shared_ptr< pysymbols >( new pysymbols() );
+    return *syms;
 }
 
+/*
+ * The file operations run without the GIL, so that files can be read in
+ * parallel from Python threads. Python objects are only built once the GIL is
+ * reacquired, and the warnings emitted along the way are collected and
+ * emitted then, too.
+ */
 class file {
 public:
-    explicit file( const std::string& path );
+    file( const std::string& path,
+          bool mmap,
+          bool shared_symbols,
+          const std::string& backend );
 
-    operator std::FILE*() const {
-        if( this->fp ) return this->fp.get();
+    dl::stream& get() const {
+        if( this->fp ) return *this->fp;
         throw py::value_error( "I/O operation on closed file" );
     }
 
-    void close() { this->fp.reset(); }
-    bool eof();
+    void close() {
+        py::gil_scoped_release release;
+        std::lock_guard< std::mutex > guard( this->mutex );
+        this->fp.reset();
+        this->records.clear();
+    }
 
-    py::tuple mkindex();
-    py::bytes raw_record( const bookmark& );
-    py::dict eflr( const bookmark& );
+    bool eof() {
+        return this->nogil( []( dl::stream& fd, const dl::warning_handler& ) {
+            return fd.eof();
+        });
+    }
 
+    py::dict stats();
+    void reset_stats();
+    void cache_records( std::size_t budget, bool sets );
+
+    py::tuple mkindex( int threads, const std::string& cache );
+    py::memoryview raw_record( const dl::bookmark& );
+    py::dict eflr( const dl::bookmark&, bool lazy );
+    py::list raw_records( const std::vector< dl::bookmark >& );
+    py::list eflrs( const std::vector< dl::bookmark >&, bool lazy );
+    py::tuple frames( const std::vector< dl::bookmark >&,
+                      const py::tuple& name,
+                      const std::vector< int >& reprc,
+                      const std::vector< std::vector< py::ssize_t > >& dims );
+
+    std::vector< dl::fdata_index >
+    fdata_index( const std::vector< dl::bookmark >& );
+    py::tuple index_range( const std::vector< dl::bookmark >&,
+                           const dl::fdata_index&,
+                           int reprc,
+                           double lo,
+                           double hi );
+    py::tuple select( const std::vector< dl::bookmark >&,
+                      const dl::fdata_index&,
+                      std::size_t begin,
+                      std::size_t end,
+                      const std::vector< int >& reprc,
+                      const std::vector< std::vector< py::ssize_t > >& dims,
+                      const std::vector< std::size_t >& channels );
+    void cache_frames( const std::string& path,
+                       const std::vector< dl::bookmark >&,
+                       const dl::fdata_index&,
+                       std::size_t begin,
+                       std::size_t end,
+                       const std::vector< int >& reprc,
+                       const std::vector< std::vector< py::ssize_t > >& dims,
+                       std::size_t rows );
 
 private:
-    struct fcloser {
-        void operator()( std::FILE* x ) {
-            if( x ) std::fclose( x );
-        }
-    };
+    std::string path;
+    std::unique_ptr< dl::stream > fp;
 
-    std::unique_ptr< std::FILE, fcloser > fp;
-};
+    /*
+     * The work done on the file, which is still available after close()
+     */
+    std::shared_ptr< dl::stats > totals;
 
-file::file( const std::string& path ) :
-    fp( std::fopen( path.c_str(), "rb" ) ) {
+    /*
+     * The records read by raw_record and eflr, and, if cachesets is set,
+     * their parsed sets. It's disabled until given a budget
+     */
+    dl::record_cache records;
+    bool cachesets = false;
 
-    if( !this->fp ) throw io_error( errno );
-}
+    dl::record cached( const dl::bookmark& );
+    dl::record uncached( const dl::bookmark& );
 
-bool iseof( std::FILE* fp ) {
-    int c = std::fgetc( fp );
+    /*
+     * Shared with the lazy attributes of the file, which may outlive it
+     */
+    std::shared_ptr< pysymbols > syms;
 
-    if( c == EOF ) return true;
-    else c = std::ungetc( c, fp );
+    /*
+     * Memory-mapped and pread files are read through cursors, which have
+     * positions of their own, so operations on them run concurrently. The
+     * mutex only guards making the cursor, against close(). Operations on
+     * stdio files share the stream position, and hold the mutex throughout.
+     *
+     * The mutex is only ever taken without the GIL, so that a thread waiting
+     * for it never blocks the thread holding it
+     */
+    std::mutex mutex;
+
+    template< typename F >
+    auto locked( F f, const dl::warning_handler& warn )
+        -> decltype( f( std::declval< dl::stream& >(), warn ) )
+    {
+        py::gil_scoped_release release;
+        std::unique_lock< std::mutex > guard( this->mutex );
+        const auto cursor = this->get().cursor();
+        if( !cursor ) return f( this->get(), warn );
+
+        guard.unlock();
+        return f( *cursor, warn );
+    }
 
-    if( c == EOF ) return true;
-    return std::feof( fp );
-}
+    /*
+     * Call f( stream, warn ) with the GIL released and the file locked, then
+     * emit the warnings it reported, also when it fails
+     */
+    template< typename F >
+    auto nogil( F f )
+        -> decltype( f( std::declval< dl::stream& >(), dl::warning_handler() ) )
+    {
+        std::vector< std::string > msgs;
+        const dl::warning_handler warn = [&msgs]( const std::string& msg ) {
+            msgs.push_back( msg );
+        };
 
-bool file::eof() {
-    return iseof( *this );
+        try {
+            auto result = this->locked( f, warn );
+            for( const auto& msg : msgs ) runtime_warning( msg.c_str() );
+            return result;
+        } catch( ... ) {
+            for( const auto& msg : msgs ) runtime_warning( msg.c_str() );
+            throw;
+        }
+    }
+};
+
+/*
+ * Open with the first backend that can, like dl::open, or, if a backend
+ * (mmap, pread or stdio) is given, with that one, without falling back,
+ * which is mostly for testing them all
+ */
+std::unique_ptr< dl::stream > open_file( const std::string& path,
+                                         bool mmap,
+                                         const std::string& backend ) {
+    if( backend == "mmap" )  return dl::open_mmap( path );
+    if( backend == "pread" ) return dl::open_pread( path );
+    if( backend == "stdio" ) return dl::open_stdio( path );
+    if( !backend.empty() )
+        throw py::value_error( "unknown backend '" + backend + "', "
+                               "expected mmap, pread or stdio" );
+
+    return dl::open( path, mmap );
 }
 
-bookmark mark( std::FILE* fp, int& remaining ) {
-    bookmark mark;
-    mark.residual = remaining;
+file::file( const std::string& path,
+            bool mmap,
+            bool shared_symbols,
+            const std::string& backend ) :
+    path( path ),
+    fp( open_file( path, mmap, backend ) ),
+    totals( this->fp->totals() ),
+    syms( shared_symbols ? pysymbols::process()
+                         : std::make_shared< pysymbols >() )
+{}
 
-    auto err = std::fgetpos( fp, &mark.pos );
-    if( err ) throw io_error( errno );
+/*
+ * The work done on the file so far, with the times in seconds. Operations
+ * that are still running aren't counted until they're done
+ */
+py::dict file::stats() {
+    dl::counters count;
+    {
+        py::gil_scoped_release release;
+        std::lock_guard< std::mutex > guard( this->mutex );
+        count = this->fp ? dl::counted( *this->fp ) : this->totals->get();
+    }
 
-    /*
-     * TODO: use _ftell64 or similar on Windows, to handle >2G files.
-     * It's not necessary for repositioning, but helps diagnostics
-     */
-    mark.tell = std::ftell( fp );
-    if( mark.tell == -1 ) throw io_error( errno );
+    const auto seconds = []( std::uint64_t ns ) { return ns * 1e-9; };
+
+    py::dict d;
+    d["enabled"]      = dl::stats::enabled();
+    d["bytes"]        = count.bytes;
+    d["reads"]        = count.reads;
+    d["seeks"]        = count.seeks;
+    d["segments"]     = count.segments;
+    d["indexed"]      = count.indexed;
+    d["records"]      = count.records;
+    d["concatenated"] = count.concatenated;
+    d["sets"]         = count.sets;
+    d["frames"]       = count.frames;
+    d["index-time"]   = seconds( count.index_ns );
+    d["read-time"]    = seconds( count.read_ns );
+    d["parse-time"]   = seconds( count.parse_ns );
+    d["decode-time"]  = seconds( count.decode_ns );
+
+    /* the record cache counts regardless of DLISIO_STATS */
+    const auto cached = this->records.counts();
+    d["cache-hits"]      = cached.hits;
+    d["cache-misses"]    = cached.misses;
+    d["cache-evictions"] = cached.evictions;
+    d["cache-bytes"]     = cached.bytes;
+    d["cache-entries"]   = cached.entries;
+    return d;
+}
 
-    while( true ) {
+void file::reset_stats() {
+    py::gil_scoped_release release;
+    std::lock_guard< std::mutex > guard( this->mutex );
+    this->totals->reset();
+    if( this->fp ) this->fp->count = dl::counters();
+    this->records.reset_counts();
+}
 
-        /*
-         * if remaining = 0 this is at the VRL, skip the inner-loop and read it
-         */
-        while( remaining > 0 ) {
-            auto seg = segment_header( fp );
-            remaining -= seg.len;
-
-            int has_predecessor = 0;
-            int has_successor = 0;
-            int has_encryption_packet = 0;
-            int has_checksum = 0;
-            int has_trailing_length = 0;
-            int has_padding = 0;
-            dlis_segment_attributes( seg.attrs, &mark.isexplicit,
-                                                &has_predecessor,
-                                                &has_successor,
-                                                &mark.isencrypted,
-                                                &has_encryption_packet,
-                                                &has_checksum,
-                                                &has_trailing_length,
-                                                &has_padding );
-
-            seg.len -= 4; // size of LRSH
-            err = std::fseek( fp, seg.len, SEEK_CUR );
-            if( err ) throw io_error( errno );
-
-            if( !has_successor ) return mark;
-        }
+/*
+ * Keep the records read by raw_record and eflr in memory, up to budget
+ * bytes, and their parsed sets too if sets is true. A budget of 0 turns the
+ * cache off, and empties it
+ */
+void file::cache_records( std::size_t budget, bool sets ) {
+    /* cachesets is only touched with the GIL held */
+    this->cachesets = sets;
 
-        /* if remaining is 0, then we're at a VRL */
-        remaining = visible_length( fp ) - 4;
-    }
+    py::gil_scoped_release release;
+    this->records.resize( budget );
+    if( budget == 0 ) this->records.clear();
 }
 
-py::tuple file::mkindex() {
-    std::FILE* fd = *this;
+py::tuple file::mkindex( int threads, const std::string& cache ) {
+    /* threads = 0 means one per core, if it can be determined */
+    if( threads <= 0 )
+        threads = std::max( 1u, std::thread::hardware_concurrency() );
 
-    char buffer[ 80 ];
-    getbytes( buffer, sizeof( buffer ), fd );
-    auto sul = SUL( buffer );
+    /*
+     * The key is computed before the file is indexed, so that if the file is
+     * modified while indexing the sidecar is stale (and rebuilt) next time
+     */
+    dl::sidecar sc;
+    const auto cached = this->nogil(
+        [&]( dl::stream& fd, const dl::warning_handler& ) -> bool {
+            if( !cache.empty() ) {
+                const auto key = dl::fingerprint( this->path );
+                if( dl::read_sidecar( cache, key, sc ) ) return true;
+                sc.key = key;
+            }
 
-    std::vector< bookmark > bookmarks;
-    int remaining = 0;
+            char buffer[ 80 ];
+            fd.setpos( dl::bookmark() );
+            fd.read( buffer, sizeof( buffer ) );
+            sc.sul.assign( buffer, sizeof( buffer ) );
+            return false;
+        });
+
+    auto sul = SUL( sc.sul.data() );
+    if( cached ) return py::make_tuple( sul, sc.bookmarks );
+
+    const auto bookmarks = this->nogil(
+        [&]( dl::stream& fd, const dl::warning_handler& warn ) {
+            /* the records start right after the storage unit label */
+            dl::bookmark start;
+            start.tell = 80;
+            fd.setpos( start );
+            sc.bookmarks = dl::index( fd, threads, warn );
+
+            /*
+             * Failing to write the cache (e.g. read-only archives) is not an
+             * error, the index is still good for this run
+             */
+            if( !cache.empty() ) {
+                try {
+                    dl::write_sidecar( cache, sc );
+                } catch( const dl::io_error& e ) {
+                    warn( "unable to write index cache " + cache
+                        + ": " + e.what() );
+                }
+            }
 
-    while( !iseof( fd ) )
-        bookmarks.push_back( mark( fd, remaining ) );
+            return std::move( sc.bookmarks );
+        });
 
     return py::make_tuple( sul, bookmarks );
 }
 
 py::object conv( int reprc, py::buffer b ) {
-    const auto* xs = static_cast< const char* >( b.request().ptr );
+    const auto info = b.request();
+    const auto* xs = static_cast< const char* >( info.ptr );
+    const auto* end = xs + info.size * info.itemsize;
     switch( reprc ) {
         case DLIS_FSHORT: return py::cast( fshort( xs ) );
         case DLIS_FSINGL: return py::cast( fsingl( xs ) );
@@ -294,8 +491,8 @@ py::object conv( int reprc, py::buffer b ) {
         case DLIS_DTIME:  return            dtime( xs )  ;
         case DLIS_STATUS: return py::cast( status( xs ) );
         case DLIS_ORIGIN: return py::cast( origin( xs ) );
-        case DLIS_OBNAME: return py::cast( obname( xs ) );
-        case DLIS_OBJREF: return py::cast( objref( xs ) );
+        case DLIS_OBNAME: return py::cast( obname( xs, end ) );
+        case DLIS_OBJREF: return py::cast( objref( xs, end ) );
         case DLIS_UNITS:  return py::cast(  ident( xs ) );
 
         default:
@@ -304,9 +501,69 @@ py::object conv( int reprc, py::buffer b ) {
     }
 }
 
-py::list getarray( const char*& xs, int count, int reprc ) {
+/*
+ * An identifier, as in the record
+ */
+dl::span identspan( const char*& xs ) noexcept {
+    std::int32_t len;
+    dl::span s;
+    s.first = dlis_ident( xs, &len, nullptr ) - len;
+    s.last = s.first + len;
+    xs = s.last;
+    return s;
+}
+
+py::object obname( const char*& xs, const char* end, pysymbols& syms ) {
+    std::int32_t orig;
+    std::uint8_t copy;
+    dl::span id;
+    xs = dl::obname_view( xs, end, orig, copy, id );
+    return syms.obname( orig, copy, id.first, id.last );
+}
+
+py::object objref( const char*& xs, const char* end, pysymbols& syms ) {
+    std::int32_t orig;
+    std::uint8_t copy;
+    dl::span type, id;
+    xs = dl::objref_view( xs, end, type, orig, copy, id );
+    return py::make_tuple( syms.str( type ),
+                           orig,
+                           int( copy ),
+                           syms.str( id ) );
+}
+
+py::list getarray( const char*& xs,
+                   const char* end,
+                   int count,
+                   int reprc,
+                   pysymbols& syms ) {
     py::list l;
 
+    /*
+     * identifiers and object names are interned, as they're mostly
+     * references to other objects, and repeat a lot
+     */
+    switch( reprc ) {
+        case DLIS_IDENT:
+        case DLIS_UNITS:
+            for( int i = 0; i < count; ++i )
+                l.append( syms.str( identspan( xs ) ) );
+            return l;
+
+        case DLIS_OBNAME:
+            for( int i = 0; i < count; ++i )
+                l.append( obname( xs, end, syms ) );
+            return l;
+
+        case DLIS_OBJREF:
+            for( int i = 0; i < count; ++i )
+                l.append( objref( xs, end, syms ) );
+            return l;
+
+        default:
+            break;
+    }
+
     for( int i = 0; i < count; ++i ) {
         switch( reprc ) {
             case DLIS_FSHORT: l.append( fshort( xs ) ); break;
@@ -327,14 +584,10 @@ py::list getarray( const char*& xs, int count, int reprc ) {
             case DLIS_UNORM:  l.append(  unorm( xs ) ); break;
             case DLIS_ULONG:  l.append(  ulong( xs ) ); break;
             case DLIS_UVARI:  l.append(  uvari( xs ) ); break;
-            case DLIS_IDENT:  l.append(  ident( xs ) ); break;
             case DLIS_ASCII:  l.append(  ascii( xs ) ); break;
             case DLIS_DTIME:  l.append(  dtime( xs ) ); break;
             case DLIS_STATUS: l.append( status( xs ) ); break;
             case DLIS_ORIGIN: l.append( origin( xs ) ); break;
-            case DLIS_OBNAME: l.append( obname( xs ) ); break;
-            case DLIS_OBJREF: l.append( objref( xs ) ); break;
-            case DLIS_UNITS:  l.append(  ident( xs ) ); break;
 
             default:
                 throw py::value_error( "unknown representation code "
@@ -345,343 +598,749 @@ py::list getarray( const char*& xs, int count, int reprc ) {
     return l;
 }
 
-struct setattr {
-    int type, name;
-};
-
-setattr set_attributes( const char*& cur ) {
-    std::uint8_t attr;
-    std::memcpy( &attr, cur, sizeof( std::uint8_t ) );
-    cur += sizeof( std::uint8_t );
+py::object getvalue( const dl::value& v, pysymbols& syms ) {
+    if( !v.present ) return py::none();
+    const char* cur = v.bytes.first;
+    return getarray( cur, v.bytes.last, v.count, v.reprc, syms );
+}
 
-    int role;
-    dlis_component( attr, &role );
+/*
+ * An attribute with its value decoded on first access, and cached. Otherwise
+ * it reads like the dict of an attribute, with the same keys.
+ *
+ * It holds on to the bytes of the record, like the memoryviews of
+ * raw_record, so it stays valid after the file is closed.
+ */
+class lazyattribute {
+public:
+    lazyattribute( py::dict fields,
+                   const dl::value& val,
+                   const dl::record& rec,
+                   std::shared_ptr< pysymbols > syms ) :
+        fields( std::move( fields ) ),
+        val( val ),
+        rec( rec ),
+        syms( std::move( syms ) )
+    {}
+
+    py::object getitem( const py::object& key ) {
+        if( !this->fields.contains( key ) )
+            throw py::key_error( py::repr( key ) );
+
+        if( isvalue( key ) ) this->decode();
+        return this->fields[ key ];
+    }
 
-    switch( role ) {
-        case DLIS_ROLE_RDSET:
-        case DLIS_ROLE_RSET:
-        case DLIS_ROLE_SET:
-            break;
+    py::object get( const py::object& key, const py::object& fallback ) {
+        if( !this->fields.contains( key ) ) return fallback;
+        return this->getitem( key );
+    }
 
-        default:
-            throw py::value_error(
-                std::string("first item in EFLR not SET, RSET or RDSET, was ")
-                + dlis_component_str( role )
-                + "(" + std::bitset< sizeof( attr ) >( role ).to_string() + ")"
-            );
+    bool contains( const py::object& key ) const {
+        return this->fields.contains( key );
     }
 
-    setattr flags;
-    const auto err = dlis_component_set( attr, role, &flags.type, &flags.name );
+    std::size_t size() const noexcept {
+        return this->fields.size();
+    }
 
-    switch( err ) {
-        case DLIS_OK:
-            break;
+    py::object keys() const {
+        return this->fields.attr( "keys" )();
+    }
 
-        case DLIS_INCONSISTENT:
-            user_warning( "SET:type not set, but must be non-null." );
-            flags.type = 1;
-            break;
+    bool decoded() const noexcept {
+        return this->done;
+    }
 
-        default:
-            throw std::runtime_error( "unhandled error in dlis_component_set" );
+    const py::dict& dict() {
+        this->decode();
+        return this->fields;
     }
 
-    return flags;
-}
+private:
+    py::dict fields;
+    dl::value val;
+    dl::record rec;
+    std::shared_ptr< pysymbols > syms;
+    bool done = false;
+
+    static bool isvalue( const py::object& key ) {
+        return PyUnicode_Check( key.ptr() )
+            && PyUnicode_CompareWithASCIIString( key.ptr(), "value" ) == 0;
+    }
 
-struct attribattr {
-    int label;
-    int count;
-    int reprc;
-    int units;
-    int value;
-    int object = 0;
-    int absent = 0;
-    int invariant = 0;
+    void decode() {
+        if( this->done ) return;
+        this->fields[ "value" ] = getvalue( this->val, *this->syms );
+        this->done = true;
+    }
 };
 
-attribattr attrib_attributes( const char*& cur ) {
-    std::uint8_t attr;
-    std::memcpy( &attr, cur, sizeof( std::uint8_t ) );
+/*
+ * The values are validated when the set is parsed, so that decoding them
+ * later can't fail on malformed records, only on e.g. invalid UTF-8
+ */
+py::object getattribute( const dl::attribute& attr,
+                         const dl::set& set,
+                         const std::shared_ptr< pysymbols >& syms,
+                         bool lazy ) {
+    py::dict d( "count"_a = attr.count,
+                "reprc"_a = attr.reprc,
+                "value"_a = py::none(),
+                "label"_a = syms->str( attr.label ) );
+
+    if( attr.hasunits ) d["units"] = syms->str( attr.units );
+    if( lazy ) return py::cast( lazyattribute( d, attr.val, set.bytes, syms ) );
+
+    d["value"] = getvalue( attr.val, *syms );
+    return std::move( d );
+}
 
-    int role;
-    dlis_component( attr, &role );
+py::list getattributes( const dl::arena_vector< dl::attribute >& attrs,
+                        const dl::set& set,
+                        const std::shared_ptr< pysymbols >& syms,
+                        bool lazy ) {
+    py::list l;
+    for( const auto& attr : attrs )
+        l.append( getattribute( attr, set, syms, lazy ) );
+    return l;
+}
 
-    attribattr flags;
-    switch( role ) {
-        case DLIS_ROLE_ABSATR:
-            flags.absent= 1;
-            break;
+/*
+ * The attributes an object doesn't set itself are the template defaults, and
+ * share their dicts with the template, as do the invariant attributes
+ */
+py::dict eflr( const dl::set& set,
+               const std::shared_ptr< pysymbols >& syms,
+               bool lazy ) {
+    py::dict record;
+    if( set.hastype ) record["type"] = syms->str( set.type );
+    if( set.hasname ) record["name"] = syms->str( set.name );
 
-        case DLIS_ROLE_OBJECT:
-            flags.object = 1;
-            break;
+    const auto& tmpl = set.tmpl;
+    const auto attributes = getattributes( tmpl.attributes, set, syms, lazy );
+    const auto invariants = getattributes( tmpl.invariants, set, syms, lazy );
 
-        case DLIS_ROLE_INVATR:
-            flags.invariant = 1;
+    py::dict objects;
+    for( const auto& obj : set.objects ) {
+        py::list row;
+        for( std::size_t i = 0; i < set.tmpl.attributes.size(); ++i ) {
+            if( i < obj.size ) row.append( getattribute( set.at( obj, i ),
+                                                         set,
+                                                         syms,
+                                                         lazy ) );
+            else               row.append( attributes[ i ] );
+        }
 
-        case DLIS_ROLE_ATTRIB:
-            break;
+        for( const auto& invariant : invariants )
+            row.append( invariant );
 
-        default:
-            throw py::value_error(
-                std::string("expected ATTRIB, INVATR, or OBJECT, was ")
-                + dlis_component_str( role )
-                + "(" + std::bitset< sizeof( attr ) >( role ).to_string() + ")"
-            );
+        objects[ syms->obname( obj.origin, obj.copy, obj.id.first,
+                                                     obj.id.last ) ] = row;
     }
 
-    /*
-     * only consume the component tag if it is not object, because if it is
-     * then the next function assumes its there
-     */
-    if( role != DLIS_ROLE_OBJECT )
-        cur += sizeof( std::uint8_t );
+    record["template-attribute"] = attributes;
+    record["template-invariant"] = invariants;
+    record["objects"] = objects;
+    return record;
+}
 
-    if( flags.object || flags.absent ) return flags;
+/*
+ * Parse the record, and emit the warnings as UserWarning
+ */
+dl::set parse_set( const dl::record& rec ) {
+    std::vector< std::string > msgs;
+    const auto warn = [&msgs]( const std::string& msg ) {
+        msgs.push_back( msg );
+    };
 
-    const auto err = dlis_component_attrib( attr, role, &flags.label,
-                                                        &flags.count,
-                                                        &flags.reprc,
-                                                        &flags.units,
-                                                        &flags.value );
+    try {
+        auto set = dl::parse_set( rec, warn );
+        for( const auto& msg : msgs ) user_warning( msg );
+        return set;
+    } catch( ... ) {
+        for( const auto& msg : msgs ) user_warning( msg );
+        throw;
+    }
+}
 
-    if( !err ) return flags;
+dl::record readrecord( dl::stream& fd,
+                       const dl::bookmark& mark,
+                       const dl::warning_handler& warn ) {
+    fd.setpos( mark );
+    return dl::catrecord( fd, mark.residual, warn );
+}
 
-    // all sources for this error should've been checked, so
-    // something is REALLY wrong if we end up here
-    throw std::runtime_error( "unhandled error in dlis_component_attrib" );
+/*
+ * Records that are re-read from the cache don't report the warnings from
+ * reading them again
+ */
+dl::record file::cached( const dl::bookmark& m ) {
+    dl::record rec;
+    if( this->records.find( m, rec ) ) return rec;
+    return this->uncached( m );
 }
 
-void object_attributes( const char*& cur ) {
-    std::uint8_t attr;
-    std::memcpy( &attr, cur, sizeof( std::uint8_t ) );
+/*
+ * Read the record, which is known not to be cached, and cache it
+ */
+dl::record file::uncached( const dl::bookmark& m ) {
+    auto rec = this->nogil(
+        [&]( dl::stream& fd, const dl::warning_handler& warn ) {
+            return readrecord( fd, m, warn );
+        });
+    this->records.insert( m, rec );
+    return rec;
+}
 
-    cur += sizeof( std::uint8_t );
+py::memoryview file::raw_record( const dl::bookmark& m ) {
+    auto rec = this->cached( m );
 
-    int role;
-    dlis_component( attr, &role );
+    /*
+     * the memoryview holds on to the record, which in turn keeps the
+     * underlying (possibly memory-mapped) bytes alive, also past close()
+     */
+    return py::memoryview( py::cast( std::move( rec ) ) );
+}
+
+py::dict file::eflr( const dl::bookmark& mark, bool lazy ) {
+    if( mark.isencrypted ) return py::none();
 
-    if( role != DLIS_ROLE_OBJECT )
-        throw py::value_error( std::string("expected OBJECT, was ")
-                             + dlis_component_str( role ) );
+    /*
+     * With sets cached, look up the set and the record in one go, so that a
+     * call counts one hit or miss, not one for each
+     */
+    const bool sets = this->cachesets;
+    std::shared_ptr< const dl::set > set;
+    dl::record rec;
+    bool hasrecord = false;
+    if( sets ) {
+        set = this->records.findset( mark, rec, hasrecord );
+        if( set ) return ::eflr( *set, this->syms, lazy );
+        if( !hasrecord ) rec = this->uncached( mark );
+    } else {
+        rec = this->cached( mark );
+    }
 
-    int obname;
-    const auto err = dlis_component_object( attr, role, &obname );
+    dl::counters count;
+    py::dict d;
+    {
+        dl::timer t( count.parse_ns );
+        set = std::make_shared< const dl::set >( parse_set( rec ) );
+        d = ::eflr( *set, this->syms, lazy );
+    }
+    count.sets = 1;
+    this->totals->add( count );
 
-    if( err ) user_warning( "OBJECT:name not set, but must be non-null" );
+    if( sets ) this->records.insert( mark, std::move( set ) );
+    return d;
 }
 
-struct object_template {
-    std::vector< py::dict > attribute;
-    std::vector< py::dict > invariant;
-};
-
-object_template explicit_template( const char*& cur, const char* end ) {
-    object_template cols;
+py::list file::raw_records( const std::vector< dl::bookmark >& marks ) {
+    auto recs = this->nogil(
+        [&]( dl::stream& fd, const dl::warning_handler& warn ) {
+            return dl::catrecords( fd, marks, warn );
+        });
 
-    while( true ) {
-        if( cur >= end )
-            throw py::value_error( "unexpected end-of-record in template" );
+    py::list l;
+    for( auto& rec : recs )
+        l.append( py::memoryview( py::cast( std::move( rec ) ) ) );
+    return l;
+}
 
-        auto flags = attrib_attributes( cur );
+/*
+ * Encrypted records are None, like for eflr(), and are not read at all
+ */
+py::list file::eflrs( const std::vector< dl::bookmark >& marks, bool lazy ) {
+    std::vector< dl::bookmark > plain;
+    for( const auto& mark : marks )
+        if( !mark.isencrypted ) plain.push_back( mark );
 
-        if( flags.object ) return cols;
+    const auto recs = this->nogil(
+        [&]( dl::stream& fd, const dl::warning_handler& warn ) {
+            return dl::catrecords( fd, plain, warn );
+        });
 
-        if( flags.absent ) {
-            user_warning( "ABSATR in object template - skipping" );
-            continue;
+    dl::counters count;
+    py::list l;
+    {
+        dl::timer t( count.parse_ns );
+        auto rec = recs.begin();
+        for( const auto& mark : marks ) {
+            if( mark.isencrypted ) l.append( py::none() );
+            else l.append( ::eflr( parse_set( *rec++ ), this->syms, lazy ) );
         }
+    }
+    count.sets = recs.size();
+    this->totals->add( count );
+    return l;
+}
 
-        int count = 1;
-        int reprc = DLIS_IDENT;
-        /* set the global defaults unconditionally */
-        py::dict col( "count"_a = count,
-                      "reprc"_a = reprc,
-                      "value"_a = py::none() );
-
-        if( !flags.label ) {
-            user_warning( "ATTRIB:label not set, but must be non-null" );
-            flags.label = 1;
-        }
+py::dtype column_dtype( int reprc ) {
+    switch( reprc ) {
+        case DLIS_FSHORT:
+        case DLIS_FSINGL:
+        case DLIS_FSING1:
+        case DLIS_FSING2:
+        case DLIS_ISINGL:
+        case DLIS_VSINGL: return py::dtype::of< float >();
+        case DLIS_FDOUBL:
+        case DLIS_FDOUB1:
+        case DLIS_FDOUB2: return py::dtype::of< double >();
+        case DLIS_CSINGL: return py::dtype( "complex64" );
+        case DLIS_CDOUBL: return py::dtype( "complex128" );
+        case DLIS_SSHORT: return py::dtype::of< std::int8_t >();
+        case DLIS_SNORM:  return py::dtype::of< std::int16_t >();
+        case DLIS_SLONG:  return py::dtype::of< std::int32_t >();
+        case DLIS_USHORT: return py::dtype::of< std::uint8_t >();
+        case DLIS_UNORM:  return py::dtype::of< std::uint16_t >();
+        case DLIS_ULONG:  return py::dtype::of< std::uint32_t >();
+        case DLIS_STATUS: return py::dtype::of< std::uint8_t >();
 
-                          col["label"] = ident( cur );
-        if( flags.count ) col["count"] = count = uvari( cur );
-        if( flags.reprc ) col["reprc"] = reprc = ushort( cur );
-        if( flags.units ) col["units"] = ident( cur );
-        if( flags.value ) col["value"] = getarray( cur, count, reprc );
+        default:
+            throw py::value_error( "representation code "
+                                 + std::to_string( reprc )
+                                 + " can not be decoded into a column" );
+    }
+}
 
-        if( flags.invariant ) cols.invariant.push_back( std::move( col ) );
-        else                  cols.attribute.push_back( std::move( col ) );
+/*
+ * validated values are decoded as (V, A) or (V, A, B), into an extra,
+ * innermost axis
+ */
+py::ssize_t column_components( int reprc ) noexcept {
+    switch( reprc ) {
+        case DLIS_FSING1: return 2;
+        case DLIS_FSING2: return 3;
+        case DLIS_FDOUB1: return 2;
+        case DLIS_FDOUB2: return 3;
+        default:          return 1;
     }
 }
 
-py::dict deepcopy( const py::dict& d ) {
-    return py::reinterpret_steal< py::dict >( PyDict_Copy( d.ptr() ) );
+std::vector< dl::channel_layout >
+channel_layouts( const std::vector< int >& reprc,
+                 const std::vector< std::vector< py::ssize_t > >& dims ) {
+    if( reprc.size() != dims.size() )
+        throw py::value_error( "reprc and dims must be the same length" );
+
+    std::vector< dl::channel_layout > channels;
+    for( std::size_t i = 0; i < reprc.size(); ++i ) {
+        std::size_t count = 1;
+        for( const auto dim : dims[ i ] ) {
+            if( dim < 0 ) throw py::value_error( "negative dimension" );
+            count *= dim;
+        }
+        channels.push_back( { reprc[ i ], count } );
+    }
+    return channels;
 }
 
-template< typename T >
-std::vector< T > deepcopy( const std::vector< T >& xs ) {
-    std::vector< T > ys;
-    ys.reserve( xs.size() );
+/*
+ * Allocate the column of a channel with rows rows. Channels with dimension
+ * [1] are plain 1-dimensional arrays of (rows,)
+ */
+template< typename Dims >
+py::array make_column( py::ssize_t rows, int reprc, const Dims& dims ) {
+    std::vector< py::ssize_t > shape = { rows };
+    if( !(dims.size() == 1 && dims[ 0 ] == 1) )
+        shape.insert( shape.end(), dims.begin(), dims.end() );
 
-    for( const auto& x : xs )
-        ys.push_back( deepcopy( x ) );
+    const auto components = column_components( reprc );
+    if( components > 1 ) shape.push_back( components );
 
-    return ys;
+    return py::array( column_dtype( reprc ), shape );
 }
 
-py::dict eflr( const char* cur, const char* end ) {
-    if( std::distance( cur, end ) == 0 )
-        throw py::value_error( "eflr must be non-empty" );
+/*
+ * Allocate the columns of the selected channels up front, and decode the
+ * records straight into them
+ */
+py::tuple decode_columns(
+        dl::stats& totals,
+        const std::vector< dl::record >& recs,
+        const std::vector< int >& reprc,
+        const std::vector< std::vector< py::ssize_t > >& dims,
+        const std::vector< std::size_t >& selection ) {
+    const auto channels = channel_layouts( reprc, dims );
+    const auto rows = py::ssize_t( recs.size() );
+
+    py::array_t< std::int32_t > numbers( rows );
+    py::list columns;
+    std::vector< char* > dsts;
+
+    for( const auto i : selection ) {
+        if( i >= reprc.size() )
+            throw py::index_error( "channel " + std::to_string( i )
+                                 + " out of range" );
+
+        auto column = make_column( rows, reprc[ i ], dims[ i ] );
+        dsts.push_back( static_cast< char* >( column.mutable_data() ) );
+        columns.append( column );
+    }
 
-    py::dict record;
-    auto set = set_attributes( cur );
-    if( cur >= end ) {
-        throw py::value_error( "unexpected end-of-record "
-                                 "after SET component" );
+    auto* frameno = numbers.mutable_data();
+    {
+        py::gil_scoped_release release;
+        dl::counters count;
+        {
+            dl::timer t( count.decode_ns );
+            dl::decode_frames( recs,
+                               channels,
+                               selection,
+                               frameno,
+                               dsts.data() );
+        }
+        count.frames = recs.size();
+        totals.add( count );
     }
 
-    if( set.type ) record["type"] = ident( cur );
-    if( set.name ) record["name"] = ident( cur );
+    return py::make_tuple( numbers, columns );
+}
 
-    auto tmpl = explicit_template( cur, end );
+py::tuple file::frames( const std::vector< dl::bookmark >& marks,
+                        const py::tuple& name,
+                        const std::vector< int >& reprc,
+                        const std::vector< std::vector< py::ssize_t > >& dims ) {
+    dl::obname frame;
+    frame.origin = name[ 0 ].cast< std::int32_t >();
+    frame.copy   = name[ 1 ].cast< std::uint8_t >();
+    frame.id     = name[ 2 ].cast< std::string >();
 
-    if( cur >= end )
-        throw py::value_error( "unexpected end-of-record after template" );
+    std::vector< std::size_t > all( reprc.size() );
+    for( std::size_t i = 0; i < all.size(); ++i ) all[ i ] = i;
 
-    py::dict objects;
-    while( true ) {
-        if( cur == end ) break;
+    const auto recs = this->nogil(
+        [&]( dl::stream& fd, const dl::warning_handler& warn ) {
+            return dl::fdata( fd, marks, frame, warn );
+        });
 
-        object_attributes( cur );
+    return decode_columns( *this->totals, recs, reprc, dims, all );
+}
 
-        /*
-         * just assume obname. objects have to specify it, and if it is unset
-         * then UserWarning has already been emitted
-         */
-        auto name = obname( cur );
+std::vector< dl::fdata_index >
+file::fdata_index( const std::vector< dl::bookmark >& marks ) {
+    return this->nogil(
+        [&]( dl::stream& fd, const dl::warning_handler& warn ) {
+            return dl::index_fdata( fd, marks, warn );
+        });
+}
 
-        /*
-         * each object is a row in a table of attributes. If the object is cut
-         * short (terminated by a new object), use the defaults from the template
-         */
-        auto row = deepcopy( tmpl.attribute );
+py::tuple file::index_range( const std::vector< dl::bookmark >& marks,
+                             const dl::fdata_index& index,
+                             int reprc,
+                             double lo,
+                             double hi ) {
+    const auto range = this->nogil(
+        [&]( dl::stream& fd, const dl::warning_handler& warn ) {
+            return dl::index_range( fd, marks, index, reprc, lo, hi, warn );
+        });
+
+    return py::make_tuple( range.first, range.second );
+}
 
-        for( auto& cell : row ) {
-            if( cur == end ) break;
+py::tuple file::select( const std::vector< dl::bookmark >& marks,
+                        const dl::fdata_index& index,
+                        std::size_t begin,
+                        std::size_t end,
+                        const std::vector< int >& reprc,
+                        const std::vector< std::vector< py::ssize_t > >& dims,
+                        const std::vector< std::size_t >& channels ) {
+    const auto recs = this->nogil(
+        [&]( dl::stream& fd, const dl::warning_handler& warn ) {
+            return dl::fdata( fd, marks, index, begin, end, warn );
+        });
+
+    return decode_columns( *this->totals, recs, reprc, dims, channels );
+}
 
-            auto flags = attrib_attributes( cur );
+void file::cache_frames( const std::string& path,
+                         const std::vector< dl::bookmark >& marks,
+                         const dl::fdata_index& index,
+                         std::size_t begin,
+                         std::size_t end,
+                         const std::vector< int >& reprc,
+                         const std::vector< std::vector< py::ssize_t > >& dims,
+                         std::size_t rows ) {
+    const auto channels = channel_layouts( reprc, dims );
+    std::vector< std::vector< std::size_t > > shape;
+    for( const auto& dim : dims )
+        shape.emplace_back( dim.begin(), dim.end() );
+
+    this->nogil( [&]( dl::stream& fd, const dl::warning_handler& warn ) {
+        dl::write_framecache( path, fd, marks, index, begin, end,
+                              channels, shape, rows, warn );
+        return 0;
+    });
+}
 
-            if( flags.object ) break;
+/*
+ * The message of a failure, or None
+ */
+py::object message( const std::exception_ptr& e ) {
+    if( !e ) return py::none();
+
+    try {
+        std::rethrow_exception( e );
+    } catch( const std::exception& x ) {
+        return py::str( x.what() );
+    } catch( ... ) {
+        return py::str( "unknown error" );
+    }
+}
 
-            if( flags.absent ) {
-                cell["value"] = py::none();
-                continue;
-            }
+/*
+ * The decoded columns of a frame, as arrays shaped like file.frames makes
+ * them. The columns are already decoded, and only copied
+ */
+py::tuple frame_arrays( const dl::frame_columns& frame ) {
+    const auto rows = py::ssize_t( frame.numbers.size() );
+    py::array_t< std::int32_t > numbers( rows );
+    std::copy( frame.numbers.begin(),
+               frame.numbers.end(),
+               numbers.mutable_data() );
+
+    py::list columns;
+    for( std::size_t i = 0; i < frame.columns.size(); ++i ) {
+        auto column = make_column( rows, frame.reprc[ i ], frame.dims[ i ] );
+        const auto& src = frame.columns[ i ];
+        std::memcpy( column.mutable_data(), src.data(), src.size() );
+        columns.append( column );
+    }
 
-            if( flags.label ) {
-                user_warning( "ATTRIB:label set, but must be null - was "
-                            + ident( cur ) );
-            }
+    return py::make_tuple( numbers, columns );
+}
+
+/*
+ * Load the files on a pool of threads, without the GIL, then convert the
+ * logical files to dicts. The symbols are shared by all the files, as they
+ * are loaded together
+ */
+py::list load( const std::vector< std::string >& paths, int threads ) {
+    std::vector< dl::logical_file > files;
+    {
+        py::gil_scoped_release release;
+        files = dl::load( paths, threads );
+    }
 
-            if( flags.count ) cell["count"] = uvari( cur );
-            if( flags.reprc ) cell["reprc"] = ushort( cur );
-            if( flags.units ) cell["units"] = ident( cur );
-            if( flags.value ) {
-                /*
-                 * count/repr can both be set by this label, and by the
-                 * template, so the simplest thing is to just look them up in
-                 * the dict
-                 */
-                auto count = cell["count"].cast< int >();
-                auto reprc = cell["reprc"].cast< int >();
-                cell["value"] = getarray( cur, count, reprc );
+    const auto syms = std::make_shared< pysymbols >();
+    py::list result;
+    for( const auto& lf : files ) {
+        for( const auto& msg : lf.warnings ) runtime_warning( msg.c_str() );
+
+        py::list sets;
+        for( const auto& set : lf.sets )
+            sets.append( eflr( set, syms, false ) );
+
+        py::dict frames;
+        for( const auto& frame : lf.frames ) {
+            const auto name = syms->obname( frame.name.origin,
+                                            frame.name.copy,
+                                            frame.name.id.data(),
+                                            frame.name.id.data()
+                                          + frame.name.id.size() );
+
+            py::list channels;
+            for( const auto& ch : frame.channels )
+                channels.append( syms->obname( ch.origin,
+                                               ch.copy,
+                                               ch.id.data(),
+                                               ch.id.data() + ch.id.size() ) );
+
+            py::dict entry;
+            entry["channels"] = channels;
+            entry["error"] = message( frame.error );
+            if( !frame.error ) {
+                const auto arrays = frame_arrays( frame );
+                entry["frameno"] = arrays[ 0 ];
+                entry["curves"] = arrays[ 1 ];
             }
+            frames[ name ] = entry;
         }
 
-        /* patch invariant-attributes onto the record */
-        row.insert( row.end(), tmpl.invariant.begin(), tmpl.invariant.end() );
-        auto pyname = py::make_tuple( std::get< 0 >( name ),
-                                      std::get< 1 >( name ),
-                                      std::get< 2 >( name ) );
-        objects[pyname] = row;
+        py::dict d;
+        d["path"] = lf.path;
+        d["index"] = lf.index;
+        d["sul"] = lf.sul.size() < 80 ? py::object( py::none() )
+                                      : py::object( SUL( lf.sul.data() ) );
+        d["bookmarks"] = lf.bookmarks;
+        d["sets"] = sets;
+        d["frames"] = frames;
+        d["error"] = message( lf.error );
+        result.append( d );
     }
 
-    record["template-attribute"] = tmpl.attribute;
-    record["template-invariant"] = tmpl.invariant;
-    record["objects"] = objects;
-    return record;
+    return result;
 }
 
-std::vector< char > catrecord( std::FILE* fp, int remaining ) {
+/*
+ * The incremental reader, for files that can't be indexed up front. Like for
+ * file, the reader is only used without the GIL, and warnings are emitted
+ * after
+ */
+class streamreader {
+public:
+    void feed( py::buffer b ) {
+        const auto info = b.request();
+        const auto* ptr = static_cast< const char* >( info.ptr );
+        const auto len = std::size_t( info.size * info.itemsize );
+
+        std::vector< std::string > msgs;
+        const dl::warning_handler warn = [&msgs]( const std::string& msg ) {
+            msgs.push_back( msg );
+        };
 
-    std::vector< char > cat;
-    cat.reserve( 8192 );
+        try {
+            this->locked( [&]( dl::record_reader& r ) {
+                r.feed( ptr, len, warn );
+                return 0;
+            });
+            for( const auto& msg : msgs ) runtime_warning( msg.c_str() );
+        } catch( ... ) {
+            for( const auto& msg : msgs ) runtime_warning( msg.c_str() );
+            throw;
+        }
+    }
 
-    while( true ) {
+    /*
+     * The next complete record as (bookmark, memoryview), or None
+     */
+    py::object next() {
+        dl::bookmark mark;
+        dl::record rec;
+        const auto found = this->locked( [&]( dl::record_reader& r ) {
+            return r.next( mark, rec );
+        });
+
+        if( !found ) return py::none();
+        return py::make_tuple(
+            mark,
+            py::memoryview( py::cast( std::move( rec ) ) )
+        );
+    }
 
-        while( remaining > 0 ) {
+    py::object sul() {
+        const auto label = this->locked( []( dl::record_reader& r ) {
+            return r.sul();
+        });
 
-            auto seg = segment_header( fp );
-            remaining -= seg.len;
+        if( label.empty() ) return py::none();
+        return SUL( label.data() );
+    }
 
-            int explicit_formatting = 0;
-            int has_predecessor = 0;
-            int has_successor = 0;
-            int is_encrypted = 0;
-            int has_encryption_packet = 0;
-            int has_checksum = 0;
-            int has_trailing_length = 0;
-            int has_padding = 0;
-            dlis_segment_attributes( seg.attrs, &explicit_formatting,
-                                                &has_predecessor,
-                                                &has_successor,
-                                                &is_encrypted,
-                                                &has_encryption_packet,
-                                                &has_checksum,
-                                                &has_trailing_length,
-                                                &has_padding );
+    std::size_t pending() {
+        return this->locked( []( dl::record_reader& r ) {
+            return r.pending();
+        });
+    }
 
+    long long tell() {
+        return this->locked( []( dl::record_reader& r ) { return r.tell(); } );
+    }
 
-            seg.len -= 4; // size of LRSH
-            const auto prevsize = cat.size();
-            cat.resize( prevsize + seg.len );
-            getbytes( cat.data() + prevsize, seg.len, fp );
+    bool partial() {
+        return this->locked( []( dl::record_reader& r ) {
+            return r.partial();
+        });
+    }
 
-            if( has_trailing_length ) cat.erase( cat.end() - 2, cat.end() );
-            if( has_checksum )        cat.erase( cat.end() - 2, cat.end() );
-            if( has_padding ) {
-                std::uint8_t padbytes = 0;
-                dlis_ushort( cat.data() + cat.size() - 1, &padbytes );
-                cat.erase( cat.end() - padbytes, cat.end() );
-            }
+private:
+    dl::record_reader reader;
+    std::mutex mutex;
+
+    template< typename F >
+    auto locked( F f ) -> decltype( f( std::declval< dl::record_reader& >() ) )
+    {
+        py::gil_scoped_release release;
+        std::lock_guard< std::mutex > guard( this->mutex );
+        return f( this->reader );
+    }
+};
 
-            if( !has_successor ) return cat;
-        }
+/*
+ * A frame cache, read without the GIL. The cache is only used by one thread
+ * at a time, which the mutex guards
+ */
+class framecache {
+public:
+    explicit framecache( const std::string& path ) {
+        py::gil_scoped_release release;
+        this->cache.reset( new dl::framecache( path ) );
+    }
 
-        remaining = visible_length( fp ) - 4;
+    std::size_t size() const noexcept { return this->cache->size(); }
+    std::size_t chunks() const noexcept { return this->cache->chunks(); }
+
+    py::tuple frame_range( std::int32_t first, std::int32_t last ) {
+        const auto range = this->locked( [=]( dl::framecache& c ) {
+            return c.frame_range( first, last );
+        });
+        return py::make_tuple( range.first, range.second );
     }
-}
 
-py::bytes file::raw_record( const bookmark& m ) {
-    std::FILE* fd = *this;
-    auto err = std::fsetpos( fd, &m.pos );
-    if( err ) throw io_error( errno );
+    py::tuple index_range( double lo, double hi ) {
+        const auto range = this->locked( [=]( dl::framecache& c ) {
+            return c.index_range( lo, hi );
+        });
+        return py::make_tuple( range.first, range.second );
+    }
 
-    auto cat = catrecord( fd, m.residual );
-    return py::bytes( cat.data(), cat.size() );
-}
+    /*
+     * The frames [begin, end) of the channels, by position, or all, as
+     * (frameno, columns) shaped like file.select makes them
+     */
+    py::tuple read( std::size_t begin,
+                    std::size_t end,
+                    py::object channels ) {
+        const auto& layout = this->cache->channels();
+        const auto& dims = this->cache->dims();
+
+        std::vector< std::size_t > selection;
+        if( channels.is_none() ) {
+            for( std::size_t i = 0; i < layout.size(); ++i )
+                selection.push_back( i );
+        } else {
+            selection = channels.cast< std::vector< std::size_t > >();
+        }
 
-py::dict file::eflr( const bookmark& mark ) {
-    if( mark.isencrypted ) return py::none();
-    auto err = std::fsetpos( *this, &mark.pos );
-    if( err ) throw io_error( errno );
+        if( begin > end || end > this->cache->size() )
+            throw py::index_error( "frames out of range" );
+
+        const auto rows = py::ssize_t( end - begin );
+        py::array_t< std::int32_t > numbers( rows );
+        py::list columns;
+        std::vector< char* > dsts;
+        for( const auto i : selection ) {
+            if( i >= layout.size() )
+                throw py::index_error( "channel " + std::to_string( i )
+                                     + " out of range" );
+
+            auto column = make_column( rows, layout[ i ].reprc, dims[ i ] );
+            dsts.push_back( static_cast< char* >( column.mutable_data() ) );
+            columns.append( column );
+        }
 
-    auto cat = catrecord( *this, mark.residual );
-    return ::eflr( cat.data(), cat.data() + cat.size() );
-}
+        auto* frameno = numbers.mutable_data();
+        this->locked( [&]( dl::framecache& c ) {
+            c.read( begin, end, selection, frameno, dsts.data() );
+            return 0;
+        });
+
+        return py::make_tuple( numbers, columns );
+    }
+
+private:
+    std::unique_ptr< dl::framecache > cache;
+    std::mutex mutex;
+
+    template< typename F >
+    auto locked( F f ) -> decltype( f( std::declval< dl::framecache& >() ) )
+    {
+        py::gil_scoped_release release;
+        std::lock_guard< std::mutex > guard( this->mutex );
+        return f( *this->cache );
+    }
+};
 
 }
 
@@ -691,17 +1350,19 @@ PYBIND11_MODULE(core, m) {
     py::register_exception_translator( []( std::exception_ptr p ) {
         try {
             if( p ) std::rethrow_exception( p );
-        } catch( const io_error& e ) {
+        } catch( const dl::io_error& e ) {
             PyErr_SetString( PyExc_IOError, e.what() );
-        } catch( const eof_error& e ) {
+        } catch( const dl::eof_error& e ) {
             PyErr_SetString( PyExc_EOFError, e.what() );
         }
     });
 
-    py::class_< bookmark >( m, "bookmark" )
-        .def_readwrite( "encrypted", &bookmark::isencrypted )
-        .def_readwrite( "explicit",  &bookmark::isexplicit )
-        .def( "__repr__", []( const bookmark& m ) {
+    py::class_< dl::bookmark >( m, "bookmark" )
+        .def_readwrite( "encrypted", &dl::bookmark::isencrypted )
+        .def_readwrite( "explicit",  &dl::bookmark::isexplicit )
+        .def_readonly(  "type",      &dl::bookmark::type )
+        .def_readonly(  "length",    &dl::bookmark::length )
+        .def( "__repr__", []( const dl::bookmark& m ) {
             auto pos = " pos=" + std::to_string( m.tell );
             auto enc = std::string(" encrypted=") +
                      (m.isencrypted ? "True": "False");
@@ -711,6 +1372,24 @@ PYBIND11_MODULE(core, m) {
         })
     ;
 
+    /*
+     * records are only exposed through the (read-only) buffer protocol, and
+     * are immutable views of the file
+     */
+    py::class_< dl::record >( m, "record", py::buffer_protocol() )
+        .def_buffer( []( const dl::record& rec ) {
+            return py::buffer_info(
+                const_cast< char* >( rec.data() ),
+                sizeof( char ),
+                py::format_descriptor< unsigned char >::format(),
+                1,
+                { py::ssize_t( rec.size() ) },
+                { py::ssize_t( sizeof( char ) ) },
+                true
+            );
+        })
+    ;
+
     m.def( "sul", []( const std::string& b ) {
         if( b.size() < 80 ) {
             throw py::value_error(
@@ -720,22 +1399,148 @@ PYBIND11_MODULE(core, m) {
         return SUL( b.data() );
     } );
 
-    m.def( "eflr", []( py::buffer b ) {
+    m.def( "eflr", []( py::buffer b, bool lazy ) {
         const auto info = b.request();
         const auto len = info.size * info.itemsize;
-        const auto ptr = static_cast< char* >( info.ptr );
-        return eflr( ptr, ptr + len );
-    } );
+        const auto ptr = static_cast< const char* >( info.ptr );
+
+        /*
+         * the record doesn't own the buffer, but b outlives the set, which
+         * is converted before returning. Lazy attributes outlive b, and
+         * need their own copy
+         */
+        auto rec = dl::record( ptr, ptr + len, nullptr );
+        if( lazy ) {
+            using buffer = std::vector< char >;
+            auto mem = std::make_shared< buffer >( ptr, ptr + len );
+            rec = dl::record( mem->data(), mem->data() + len, mem );
+        }
+
+        return eflr( parse_set( rec ), pysymbols::process(), lazy );
+    }, py::arg( "buffer" ), py::arg( "lazy" ) = false );
 
     m.def( "conv", conv );
+    m.def( "load", load, py::arg( "paths" ), py::arg( "threads" ) = 0 );
+
+    py::class_< lazyattribute >( m, "attribute" )
+        .def( "__getitem__",  &lazyattribute::getitem )
+        .def( "__contains__", &lazyattribute::contains )
+        .def( "__len__",      &lazyattribute::size )
+        .def( "__iter__", []( const lazyattribute& attr ) {
+            return py::iter( attr.keys() );
+        })
+        .def( "get",  &lazyattribute::get,
+                      py::arg( "key" ),
+                      py::arg( "default" ) = py::none() )
+        .def( "keys", &lazyattribute::keys )
+        .def_property_readonly( "decoded", &lazyattribute::decoded )
+        .def( "__eq__", []( lazyattribute& attr, py::object other ) {
+            if( !py::isinstance< lazyattribute >( other ) )
+                return attr.dict().equal( other );
+
+            auto& rhs = other.cast< lazyattribute& >();
+            return attr.dict().equal( rhs.dict() );
+        })
+        .def( "__repr__", []( lazyattribute& attr ) {
+            return "dlisio.core.attribute(" + std::string(
+                py::str( py::repr( attr.dict() ) ) ) + ")";
+        })
+    ;
+
+    py::class_< dl::fdata_index >( m, "fdata_index" )
+        .def( py::init<>() )
+        .def_property_readonly( "frame", []( const dl::fdata_index& x ) {
+            return py::make_tuple( x.frame.origin, x.frame.copy, x.frame.id );
+        })
+        .def_readonly( "ascending", &dl::fdata_index::ascending )
+        .def_property_readonly( "framenos", []( const dl::fdata_index& x ) {
+            py::array_t< std::int32_t > numbers( x.entries.size() );
+            auto* dst = numbers.mutable_data();
+            for( const auto& entry : x.entries ) *dst++ = entry.frameno;
+            return numbers;
+        })
+        .def( "__len__", []( const dl::fdata_index& x ) {
+            return x.entries.size();
+        })
+        .def( "find", []( const dl::fdata_index& x, std::int32_t frameno ) {
+            const auto i = dl::find_frame( x, frameno );
+            if( i == x.entries.size() ) return py::object( py::none() );
+            return py::object( py::int_( i ) );
+        })
+        .def( "frame_range", []( const dl::fdata_index& x,
+                                 std::int32_t first,
+                                 std::int32_t last ) {
+            const auto range = dl::frame_range( x, first, last );
+            return py::make_tuple( range.first, range.second );
+        })
+        .def( "__repr__", []( const dl::fdata_index& x ) {
+            return "<dlisio.core.fdata_index frame=" + x.frame.id
+                 + " records=" + std::to_string( x.entries.size() ) + ">";
+        })
+    ;
+
+    py::class_< streamreader >( m, "stream" )
+        .def( py::init<>() )
+        .def( "feed", &streamreader::feed )
+        .def( "next", &streamreader::next )
+        .def_property_readonly( "sul",     &streamreader::sul )
+        .def_property_readonly( "pending", &streamreader::pending )
+        .def_property_readonly( "tell",    &streamreader::tell )
+        .def_property_readonly( "partial", &streamreader::partial )
+    ;
 
     py::class_< file >( m, "file" )
-        .def( py::init< const std::string& >() )
+        .def( py::init< const std::string&,
+                        bool,
+                        bool,
+                        const std::string& >(),
+              py::arg( "path" ),
+              py::arg( "mmap" ) = true,
+              py::arg( "shared_symbols" ) = false,
+              py::arg( "backend" ) = "" )
         .def( "close", &file::close )
         .def( "eof",   &file::eof )
-
-        .def( "mkindex",   &file::mkindex )
+        .def( "stats", &file::stats )
+        .def( "reset_stats", &file::reset_stats )
+        .def( "cache_records", &file::cache_records,
+                               py::arg( "budget" ),
+                               py::arg( "sets" ) = true )
+
+        .def( "mkindex",    &file::mkindex,
+                            py::arg( "threads" ) = 0,
+                            py::arg( "cache" ) = "" )
         .def( "raw_record", &file::raw_record )
-        .def( "eflr",       &file::eflr )
+        .def( "eflr",       &file::eflr,
+                            py::arg( "mark" ),
+                            py::arg( "lazy" ) = false )
+        .def( "raw_records", &file::raw_records )
+        .def( "eflrs",       &file::eflrs,
+                             py::arg( "marks" ),
+                             py::arg( "lazy" ) = false )
+        .def( "frames",     &file::frames )
+        .def( "fdata_index", &file::fdata_index )
+        .def( "index_range", &file::index_range )
+        .def( "select",      &file::select )
+        .def( "cache_frames", &file::cache_frames,
+                              py::arg( "path" ),
+                              py::arg( "marks" ),
+                              py::arg( "index" ),
+                              py::arg( "begin" ),
+                              py::arg( "end" ),
+                              py::arg( "reprc" ),
+                              py::arg( "dims" ),
+                              py::arg( "rows" ) = 8192 )
+        ;
+
+    py::class_< framecache >( m, "framecache" )
+        .def( py::init< const std::string& >() )
+        .def( "__len__", &framecache::size )
+        .def_property_readonly( "chunks", &framecache::chunks )
+        .def( "frame_range", &framecache::frame_range )
+        .def( "index_range", &framecache::index_range )
+        .def( "read", &framecache::read,
+                      py::arg( "begin" ),
+                      py::arg( "end" ),
+                      py::arg( "channels" ) = py::none() )
         ;
 }
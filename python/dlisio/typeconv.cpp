@@ -158,34 +158,25 @@ long origin( const char*& xs ) noexcept {
     return x;
 }
 
-std::tuple< long, int, std::string > obname( const char*& xs ) {
-    char str[ 256 ];
-    std::int32_t len;
-
+std::tuple< long, int, std::string > obname( const char*& xs,
+                                             const char* end ) {
+    dl::span str;
     std::int32_t orig;
     std::uint8_t copy;
 
-    xs = dlis_obname( xs, &orig, &copy, &len, str );
-    return std::make_tuple( orig, copy, std::string( str, str + len ) );
+    xs = dl::obname_view( xs, end, orig, copy, str );
+    return std::make_tuple( orig, copy, str.str() );
 }
 
-std::tuple< std::string, long, int, std::string > objref( const char*& xs ) {
-    char strid[ 256 ];
-    char strobj[ 256 ];
-    std::int32_t lenid;
-    std::int32_t lenobj;
-
+std::tuple< std::string, long, int, std::string > objref( const char*& xs,
+                                                          const char* end ) {
+    dl::span id;
+    dl::span obj;
     std::int32_t orig;
     std::uint8_t copy;
 
-    xs = dlis_objref( xs,
-                      &lenid, strid,
-                      &orig, &copy, &lenobj, strobj );
-
-    return std::make_tuple(
-        std::string( strid, strid + lenid ),
-        orig, copy, std::string( strobj, strobj + lenobj )
-    );
+    xs = dl::objref_view( xs, end, id, orig, copy, obj );
+    return std::make_tuple( id.str(), orig, copy, obj.str() );
 }
 
 int status( const char*& xs ) noexcept {
@@ -31,11 +31,14 @@ class BuildExt(build_ext):
         if ct == 'unix':
             opts.append('-DVERSION_INFO="{}"'.format(distver))
             opts.append('-fvisibility=hidden')
+            opts.append('-pthread')
         elif ct == 'msvc':
             opts.append('/DVERSION_INFO=\\"{}\\"'.format(distver))
 
         for ext in self.extensions:
             ext.extra_compile_args = opts
+            if ct == 'unix':
+                ext.extra_link_args = ['-pthread']
         build_ext.build_extensions(self)
 
 setup(
@@ -49,15 +52,16 @@ setup(
         Extension('dlisio.core',
             sources = ['dlisio/core.cpp'],
             include_dirs = ['../lib/include',
+                            '../lib/extension/include',
                             get_pybind_include(),
                             get_pybind_include(user=True),
             ],
-            libraries = ['dlisio'],
+            libraries = ['dlisio-extension', 'dlisio'],
         )
     ],
     platforms = 'any',
-    install_requires = [],
-    setup_requires = ['setuptools >= 28', 'pytest-runner', 'pybind11 >= 2.2'],
-    tests_require = ['pytest', 'hypothesis'],
+    install_requires = ['numpy'],
+    setup_requires = ['setuptools >= 28', 'pytest-runner', 'pybind11 >= 2.6'],
+    tests_require = ['pytest', 'hypothesis', 'numpy'],
     cmdclass = {'build_ext': BuildExt },
 )
@@ -32,6 +32,299 @@ def test_file_properties():
     with dlisio.load('data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS') as f:
         assert len(f.bookmarks) == 3252
 
+backends = ['mmap', 'pread', 'stdio']
+
+@pytest.mark.parametrize('backend', ['pread', 'stdio'])
+def test_backends_equivalent(backend):
+    path = 'data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS'
+    with dlisio.load(path, backend = 'mmap') as mapped:
+        with dlisio.load(path, backend = backend) as other:
+            assert len(mapped.bookmarks) == len(other.bookmarks)
+            for i in range(len(mapped.bookmarks)):
+                assert mapped.raw_record(i) == other.raw_record(i)
+
+def test_mmap_false_reads_with_pread():
+    path = 'data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS'
+    with dlisio.load(path, mmap = False) as f:
+        with dlisio.load(path, backend = 'pread') as pread:
+            assert len(f.bookmarks) == len(pread.bookmarks)
+            assert bytes(f.raw_record(0)) == bytes(pread.raw_record(0))
+
+    with pytest.raises(ValueError):
+        dlisio.load(path, backend = 'no-such-backend')
+
+def test_index_threads():
+    path = 'data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS'
+    _, serial = dlisio.core.file(path).mkindex(threads = 1)
+    _, parallel = dlisio.core.file(path).mkindex(threads = 4)
+    assert len(serial) == len(parallel) == 3252
+    for x, y in zip(serial, parallel):
+        assert x.encrypted == y.encrypted
+
+def test_index_cache(tmpdir):
+    path = 'data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS'
+    cache = str(tmpdir.join('index'))
+
+    with dlisio.load(path) as f:
+        sul, ref = f.sul, f.bookmarks
+
+    with dlisio.load(path, cache = cache) as f:
+        assert len(f.bookmarks) == len(ref)
+
+    with dlisio.load(path, cache = cache) as f:
+        assert len(f.bookmarks) == len(ref)
+        assert f.sul == sul
+        for x, y in zip(ref, f.bookmarks):
+            assert repr(x) == repr(y)
+            assert x.type == y.type
+
+def test_records_by_type():
+    with dlisio.load('data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS') as f:
+        assert len(f.records()) == len(f.bookmarks)
+
+        channels = f.records(types = [3], explicit = True)
+        assert channels
+        for i in channels:
+            assert f.bookmarks[i].type == 3
+            assert f.bookmarks[i].explicit
+            assert len(f.raw_record(i)) <= f.bookmarks[i].length
+
+        implicit = f.records(explicit = False)
+        assert implicit
+        assert not set(channels) & set(implicit)
+        assert all(not f.bookmarks[i].explicit for i in implicit)
+
+def test_curves():
+    with dlisio.load('data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS') as f:
+        frameno, curves = f.curves('800T')
+        assert len(frameno) == 2301
+        assert (frameno[1:] > frameno[:-1]).all()
+        assert curves
+        for curve in curves.values():
+            assert len(curve) == len(frameno)
+
+        with pytest.raises(ValueError):
+            f.curves('no-such-frame')
+
+def test_curves_selection():
+    with dlisio.load('data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS') as f:
+        frameno, curves = f.curves('800T')
+        names = list(curves.keys())
+
+        subset = [names[-1][2], names[0]]
+        _, selected = f.curves('800T', channels = subset)
+        assert list(selected.keys()) == [names[-1], names[0]]
+        assert (selected[names[0]] == curves[names[0]]).all()
+
+        n, part = f.curves('800T', frames = (10, 19))
+        assert list(n) == list(range(10, 20))
+        for name, curve in part.items():
+            assert (curve == curves[name][9:19]).all()
+
+        index = curves[names[0]]
+        lo, hi = sorted([index[100], index[200]])
+        n, part = f.curves('800T', channels = [names[0]], index = (lo, hi))
+        assert len(n) == ((index >= lo) & (index <= hi)).sum()
+        assert ((part[names[0]] >= lo) & (part[names[0]] <= hi)).all()
+
+        n, _ = f.curves('800T', frames = (5000, 6000))
+        assert len(n) == 0
+
+        with pytest.raises(ValueError):
+            f.curves('800T', channels = ['no-such-channel'])
+
+def test_cache_curves(tmpdir):
+    path = str(tmpdir.join('800T.frm'))
+    with dlisio.load('data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS') as f:
+        frameno, curves = f.curves('800T')
+        names = f.cache_curves('800T', path, rows = 100)
+        assert names == list(curves.keys())
+
+    cache = dlisio.core.framecache(path)
+    assert len(cache) == len(frameno)
+    assert cache.chunks == (len(frameno) + 99) // 100
+
+    n, columns = cache.read(0, len(cache))
+    assert (n == frameno).all()
+    for name, column in zip(names, columns):
+        assert (column == curves[name]).all()
+
+    begin, end = cache.frame_range(10, 19)
+    n, columns = cache.read(begin, end, [len(names) - 1])
+    assert list(n) == list(range(10, 20))
+    assert (columns[0] == curves[names[-1]][9:19]).all()
+
+    index = curves[names[0]]
+    lo, hi = sorted([index[100], index[200]])
+    begin, end = cache.index_range(lo, hi)
+    assert end - begin == ((index >= lo) & (index <= hi)).sum()
+
+    with pytest.raises(IndexError):
+        cache.read(0, len(cache) + 1)
+
+    with pytest.raises(ValueError):
+        dlisio.core.framecache('data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS')
+
+def test_fdata_index():
+    with dlisio.load('data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS') as f:
+        index = f.fdata_index()
+        assert f.fdata_index() is index
+
+        fdata = index[(2, 0, '800T')]
+        assert len(fdata) == 2301
+        assert fdata.ascending
+        assert (fdata.framenos[1:] > fdata.framenos[:-1]).all()
+
+        i = fdata.find(fdata.framenos[100])
+        assert i == 100
+        assert fdata.find(-1) is None
+
+def test_load_many():
+    path = 'data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS'
+    files = dlisio.load_many([path, 'no-such-file.dlis', path], threads = 4)
+
+    assert files[0]['path'] == path
+    assert files[0]['error'] is None
+    assert files[1]['path'] == 'no-such-file.dlis'
+    assert files[1]['error'] is not None
+    assert files[-1]['path'] == path
+
+    with dlisio.load(path) as f:
+        assert files[0]['sul'] == f.sul
+        frameno, curves = f.curves('800T')
+
+    frame = [v for k, v in files[0]['frames'].items() if k[2] == '800T'][0]
+    assert frame['error'] is None
+    assert (frame['frameno'] == frameno).all()
+    assert list(frame['curves'].keys()) == list(curves.keys())
+    for name, curve in curves.items():
+        assert (frame['curves'][name] == curve).all()
+
+@pytest.mark.parametrize('backend', backends)
+def test_read_from_threads(backend):
+    import threading
+    path = 'data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS'
+    with dlisio.load(path, backend = backend) as f:
+        ref = [bytes(f.raw_record(i)) for i in range(len(f.bookmarks))]
+
+        # threads share the file, and must not interfere with each others reads
+        errors = []
+        def read(offset):
+            try:
+                for i in range(offset, len(ref), 4):
+                    assert bytes(f.raw_record(i)) == ref[i]
+            except Exception as e:
+                errors.append(e)
+
+        threads = [threading.Thread(target = read, args = (i,)) for i in range(4)]
+        for t in threads: t.start()
+        for t in threads: t.join()
+        assert not errors
+
+def test_stream_records():
+    path = 'data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS'
+    with dlisio.load(path) as f:
+        with open(path, 'rb') as fp:
+            records = list(dlisio.stream(fp, chunksize = 1000))
+
+        assert len(records) == len(f.bookmarks)
+        for i in [0, 1, 2, 100, 3000, len(f.bookmarks) - 1]:
+            mark, rec = records[i]
+            assert mark.tell == f.bookmarks[i].tell
+            assert bytes(rec) == bytes(f.raw_record(i))
+
+def test_stream_from_callable():
+    path = 'data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS'
+    with open(path, 'rb') as fp:
+        contents = fp.read()
+
+    # the label, the first visible record label, and half a segment header
+    truncated = contents[:80 + 4 + 2]
+    chunks = [truncated[i:i+7] for i in range(0, len(truncated), 7)]
+    source = iter(chunks)
+    read = lambda n: next(source, b'')
+
+    with pytest.raises(EOFError):
+        for _ in dlisio.stream(read): pass
+
+@pytest.mark.parametrize('backend', backends)
+def test_batched_records(backend):
+    path = 'data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS'
+    with dlisio.load(path, backend = backend) as f:
+        indices = [3000, 5, 6, 7, 5, 0, len(f.bookmarks) - 1]
+        records = f.raw_records(indices)
+        assert [bytes(x) for x in records] == [bytes(f.raw_record(i))
+                                               for i in indices]
+
+        marks = [m for m in f.bookmarks[:30] if m.explicit]
+        eflrs = f.fp.eflrs(marks)
+        for mark, rec in zip(marks, eflrs):
+            if mark.encrypted: assert rec is None
+            else:              assert rec == f.fp.eflr(mark)
+
+@pytest.mark.parametrize('backend', backends)
+def test_stats(backend):
+    path = 'data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS'
+    with dlisio.load(path, backend = backend) as f:
+        marks = [m for m in f.bookmarks[:30] if m.explicit and not m.encrypted]
+        f.fp.eflrs(marks)
+
+    # the counters outlive the file
+    stats = f.stats(reset = True)
+    if not stats['enabled']:
+        assert stats['bytes'] == 0
+        return
+
+    assert stats['indexed'] == len(f.bookmarks)
+    assert stats['records'] == len(marks)
+    assert stats['sets'] == len(marks)
+    assert stats['bytes'] > 0
+    assert stats['segments'] >= stats['indexed'] + stats['records']
+    assert stats['parse-time'] > 0
+    assert f.stats()['indexed'] == 0
+
+@pytest.mark.parametrize('backend', backends)
+def test_record_cache(backend):
+    path = 'data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS'
+    with dlisio.load(path, backend = backend,
+                     record_cache = 1 << 20) as f:
+        mark = f.bookmarks[0]
+        assert mark.explicit
+
+        # start from an empty cache, whatever load() has already read
+        f.fp.cache_records(0)
+        f.fp.cache_records(1 << 20)
+        f.stats(reset = True)
+
+        first = f.fp.eflr(mark)
+        assert f.fp.eflr(mark) == first
+        assert bytes(f.raw_record(0)) == bytes(f.raw_record(0))
+
+        stats = f.stats()
+        assert stats['cache-hits'] == 3
+        assert stats['cache-misses'] == 1
+        assert stats['cache-entries'] == 1
+        assert 0 < stats['cache-bytes'] <= 1 << 20
+
+        f.fp.cache_records(0)
+        f.raw_record(0)
+        assert f.stats()['cache-entries'] == 0
+
+    # closing the file empties the cache
+    assert f.stats()['cache-bytes'] == 0
+
+def test_raw_record_is_readonly_view():
+    with dlisio.load('data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS') as f:
+        rec = f.raw_record(0)
+        assert isinstance(rec, memoryview)
+        assert rec.readonly
+
+        with pytest.raises(TypeError):
+            rec[0] = 0
+
+    # the record outlives the file it was read from
+    assert bytes(rec)
+
 @given(st.integers(min_value = 0, max_value = 3251))
 def test_get_raw_record(i):
     with dlisio.load('data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS') as f:
@@ -216,6 +509,50 @@ def test_bytes_file_eflr_equivalent(i):
         assert explicit == implicit
 
 
+def test_eflr_labels_and_names_are_interned():
+    with dlisio.load('data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS') as f:
+        a = f.fp.eflr(f.bookmarks[9])
+        b = f.fp.eflr(f.bookmarks[11])
+        assert a['type'] is b['type']
+
+        la = { x['label']: x['label'] for x in a['template-attribute'] }
+        lb = [ x['label'] for x in b['template-attribute'] ]
+        common = [ x for x in lb if x in la ]
+        assert len(common) > 0
+        assert all(x is la[x] for x in common)
+
+        again = f.fp.eflr(f.bookmarks[9])
+        assert list(again['objects'].keys())[0] is list(a['objects'].keys())[0]
+
+def test_lazy_eflr_equivalent():
+    eager = dlisio.core.eflr(stdrecord)
+    lazy = dlisio.core.eflr(stdrecord, lazy = True)
+
+    objects = lazy['objects']
+    assert not any(a.decoded for attrs in objects.values() for a in attrs)
+
+    time = objects[(0, 0, 'TIME')][0]
+    assert time['label'] == 'LONG-NAME'
+    assert not time.decoded
+    assert time['value'] == [(0, 0, '1')]
+    assert time.decoded
+
+    for name, attrs in objects.items():
+        assert attrs == eager['objects'][name]
+
+    assert isinstance(time, dlisio.Mapping)
+    assert dict(time) == eager['objects'][(0, 0, 'TIME')][0]
+    assert time.get('no-such-key', 'none') == 'none'
+    with pytest.raises(KeyError):
+        _ = time['no-such-key']
+
+def test_lazy_eflr_outlives_file():
+    with dlisio.load('data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS') as f:
+        eager = f.fp.eflr(f.bookmarks[9])
+        lazy = f.fp.eflr(f.bookmarks[9], lazy = True)
+
+    assert lazy['objects'] == eager['objects']
+
 def test_read_eflr_metadata():
     with dlisio.load('data/206_05a-_3_DWL_DWL_WIRE_258276498.DLIS') as f:
         record = f.fp.eflr(f.bookmarks[2])